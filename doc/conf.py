@@ -217,6 +217,7 @@ latex_domain_indices = False
 # (source start file, name, description, authors, manual section).
 man_pages = [
     ('reference', 'knot.conf', 'Knot DNS configuration file', author, 5),
+    ('man_kbench', 'kbench', 'DNS server benchmark utility', author, 1),
     ('man_kdig', 'kdig', 'Advanced DNS lookup utility', author, 1),
     ('man_keymgr', 'keymgr', ' DNSSEC key management utility', author, 8),
     ('man_khost', 'khost', 'Simple DNS lookup utility', author, 1),
@@ -226,6 +227,7 @@ man_pages = [
     ('man_knotd', 'knotd', 'Knot DNS server daemon', author, 8),
     ('man_knsec3hash', 'knsec3hash', "Simple utility to compute NSEC3 hash", author, 1),
     ('man_knsupdate', 'knsupdate', 'Dynamic DNS update utility', author, 1),
+    ('man_ktapstat', 'ktapstat', 'dnstap capture analysis utility', author, 1),
     ('man_kzonecheck', 'kzonecheck', 'Knot DNS zone check tool', author, 1),
 ]
 
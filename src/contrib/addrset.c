@@ -0,0 +1,237 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "contrib/addrset.h"
+#include "contrib/macros.h"
+#include "contrib/sockaddr.h"
+#include "libknot/errcode.h"
+
+#define ADDR_MAXLEN 16
+
+/*! \brief Closed interval of addresses in network byte order. */
+typedef struct {
+	uint8_t min[ADDR_MAXLEN];
+	uint8_t max[ADDR_MAXLEN];
+} interval_t;
+
+/*! \brief Intervals of one address family. */
+typedef struct {
+	interval_t *items;
+	size_t count;
+	size_t capacity;
+	size_t len;        /*!< Address length. */
+} family_t;
+
+struct addrset {
+	family_t ipv4;
+	family_t ipv6;
+};
+
+static family_t *get_family(const addrset_t *set, int family)
+{
+	switch (family) {
+	case AF_INET:  return (family_t *)&set->ipv4;
+	case AF_INET6: return (family_t *)&set->ipv6;
+	default:       return NULL;
+	}
+}
+
+static interval_t *append(family_t *fam)
+{
+	if (fam->count == fam->capacity) {
+		size_t capacity = MAX(2 * fam->capacity, 8);
+		interval_t *items = realloc(fam->items, capacity * sizeof(interval_t));
+		if (items == NULL) {
+			return NULL;
+		}
+		fam->items = items;
+		fam->capacity = capacity;
+	}
+
+	interval_t *item = &fam->items[fam->count++];
+	memset(item, 0, sizeof(*item));
+
+	return item;
+}
+
+addrset_t *addrset_new(void)
+{
+	addrset_t *set = calloc(1, sizeof(*set));
+	if (set == NULL) {
+		return NULL;
+	}
+
+	set->ipv4.len = IPV4_PREFIXLEN / 8;
+	set->ipv6.len = IPV6_PREFIXLEN / 8;
+
+	return set;
+}
+
+int addrset_add_net(addrset_t *set, const struct sockaddr *addr, unsigned prefix)
+{
+	if (set == NULL || addr == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	family_t *fam = get_family(set, addr->sa_family);
+	if (fam == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	size_t len = 0;
+	const uint8_t *raw = sockaddr_raw(addr, &len);
+
+	interval_t *item = append(fam);
+	if (item == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	/* Clear host bits for the minimum, set them for the maximum. */
+	prefix = MIN(prefix, len * 8);
+	for (size_t i = 0; i < len; i++) {
+		unsigned bits = (prefix > i * 8) ? MIN(prefix - i * 8, 8) : 0;
+		uint8_t mask = (bits == 0) ? 0 : (uint8_t)(0xff << (8 - bits));
+		item->min[i] = raw[i] & mask;
+		item->max[i] = raw[i] | ~mask;
+	}
+
+	return KNOT_EOK;
+}
+
+int addrset_add_range(addrset_t *set, const struct sockaddr *min,
+                      const struct sockaddr *max)
+{
+	if (set == NULL || min == NULL || max == NULL ||
+	    min->sa_family != max->sa_family) {
+		return KNOT_EINVAL;
+	}
+
+	family_t *fam = get_family(set, min->sa_family);
+	if (fam == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	size_t len = 0;
+	const uint8_t *raw_min = sockaddr_raw(min, &len);
+	const uint8_t *raw_max = sockaddr_raw(max, &len);
+
+	/* Inverted range is empty. */
+	if (memcmp(raw_min, raw_max, len) > 0) {
+		return KNOT_EOK;
+	}
+
+	interval_t *item = append(fam);
+	if (item == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	memcpy(item->min, raw_min, len);
+	memcpy(item->max, raw_max, len);
+
+	return KNOT_EOK;
+}
+
+static int interval_cmp(const void *a, const void *b)
+{
+	return memcmp(((const interval_t *)a)->min, ((const interval_t *)b)->min,
+	              ADDR_MAXLEN);
+}
+
+/*! \brief Sorts the intervals and merges overlapping ones. */
+static void build_family(family_t *fam)
+{
+	if (fam->count == 0) {
+		return;
+	}
+
+	qsort(fam->items, fam->count, sizeof(interval_t), interval_cmp);
+
+	size_t last = 0;
+	for (size_t i = 1; i < fam->count; i++) {
+		interval_t *cur = &fam->items[last];
+		const interval_t *next = &fam->items[i];
+		if (memcmp(next->min, cur->max, fam->len) <= 0) {
+			if (memcmp(next->max, cur->max, fam->len) > 0) {
+				memcpy(cur->max, next->max, fam->len);
+			}
+		} else {
+			fam->items[++last] = *next;
+		}
+	}
+	fam->count = last + 1;
+}
+
+void addrset_build(addrset_t *set)
+{
+	if (set == NULL) {
+		return;
+	}
+
+	build_family(&set->ipv4);
+	build_family(&set->ipv6);
+}
+
+bool addrset_match(const addrset_t *set, const struct sockaddr *addr)
+{
+	if (set == NULL || addr == NULL) {
+		return false;
+	}
+
+	const family_t *fam = get_family(set, addr->sa_family);
+	if (fam == NULL || fam->count == 0) {
+		return false;
+	}
+
+	size_t len = 0;
+	const uint8_t *raw = sockaddr_raw(addr, &len);
+
+	/* Find the last interval starting at or before the address. */
+	size_t lo = 0, hi = fam->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (memcmp(fam->items[mid].min, raw, len) <= 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo > 0 && memcmp(raw, fam->items[lo - 1].max, len) <= 0;
+}
+
+size_t addrset_size(const addrset_t *set)
+{
+	if (set == NULL) {
+		return 0;
+	}
+
+	return set->ipv4.count + set->ipv6.count;
+}
+
+void addrset_free(addrset_t *set)
+{
+	if (set == NULL) {
+		return;
+	}
+
+	free(set->ipv4.items);
+	free(set->ipv6.items);
+	free(set);
+}
@@ -0,0 +1,92 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Compiled set of IP networks and address ranges.
+ *
+ * Networks and ranges are converted to address intervals which are sorted
+ * and merged per address family, a lookup is a binary search over them.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <sys/socket.h>
+
+/*! \brief Set of IPv4 and IPv6 addresses. */
+typedef struct addrset addrset_t;
+
+/*!
+ * \brief Creates an empty address set.
+ *
+ * \return Address set or NULL on error.
+ */
+addrset_t *addrset_new(void);
+
+/*!
+ * \brief Adds a network to the set.
+ *
+ * \param set     Address set.
+ * \param addr    Network address.
+ * \param prefix  Network prefix length (longer means the full address).
+ *
+ * \return KNOT_E*
+ */
+int addrset_add_net(addrset_t *set, const struct sockaddr *addr, unsigned prefix);
+
+/*!
+ * \brief Adds an address range to the set.
+ *
+ * \param set  Address set.
+ * \param min  First address of the range.
+ * \param max  Last address of the range.
+ *
+ * \return KNOT_E*
+ */
+int addrset_add_range(addrset_t *set, const struct sockaddr *min,
+                      const struct sockaddr *max);
+
+/*!
+ * \brief Prepares the set for lookups, must be called after the additions.
+ *
+ * \param set  Address set.
+ */
+void addrset_build(addrset_t *set);
+
+/*!
+ * \brief Checks if the address (port is ignored) belongs to the set.
+ *
+ * \param set   Built address set.
+ * \param addr  Address to check.
+ *
+ * \return True if the address is in the set.
+ */
+bool addrset_match(const addrset_t *set, const struct sockaddr *addr);
+
+/*!
+ * \brief Returns number of disjoint intervals in the set.
+ *
+ * \param set  Built address set.
+ */
+size_t addrset_size(const addrset_t *set);
+
+/*!
+ * \brief Frees the address set.
+ *
+ * \param set  Address set.
+ */
+void addrset_free(addrset_t *set);
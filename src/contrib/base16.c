@@ -0,0 +1,160 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contrib/base16.h"
+#include "contrib/cpu.h"
+#include "libknot/errcode.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*! \brief Maximal length of binary input to Base16 encoding. */
+#define MAX_BIN_DATA_LEN	(INT32_MAX / 2)
+
+/*! \brief Base16 alphabet. */
+static const uint8_t base16_enc[] = "0123456789ABCDEF";
+
+#ifdef CPU_X86_SIMD
+/*! \brief Encodes whole 16-byte blocks, returns the number of consumed bytes. */
+CPU_TARGET_SSSE3
+static uint32_t encode_ssse3(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	const __m128i alphabet = _mm_loadu_si128((const __m128i *)base16_enc);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	uint32_t done = 0;
+
+	while (in_len - done >= 16) {
+		__m128i data = _mm_loadu_si128((const __m128i *)(in + done));
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(data, 4), nibble);
+		__m128i lo = _mm_and_si128(data, nibble);
+		hi = _mm_shuffle_epi8(alphabet, hi);
+		lo = _mm_shuffle_epi8(alphabet, lo);
+		_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *)(out + 16), _mm_unpackhi_epi8(hi, lo));
+		out += 32;
+		done += 16;
+	}
+
+	return done;
+}
+
+/*! \brief Encodes whole 32-byte blocks, returns the number of consumed bytes. */
+CPU_TARGET_AVX2
+static uint32_t encode_avx2(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	const __m256i alphabet = _mm256_broadcastsi128_si256(
+	        _mm_loadu_si128((const __m128i *)base16_enc));
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	uint32_t done = 0;
+
+	while (in_len - done >= 32) {
+		__m256i data = _mm256_loadu_si256((const __m256i *)(in + done));
+		// Interleaving works within 16-byte lanes, swap the middle quarters.
+		data = _mm256_permute4x64_epi64(data, 0xD8);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(data, 4), nibble);
+		__m256i lo = _mm256_and_si256(data, nibble);
+		hi = _mm256_shuffle_epi8(alphabet, hi);
+		lo = _mm256_shuffle_epi8(alphabet, lo);
+		_mm256_storeu_si256((__m256i *)out, _mm256_unpacklo_epi8(hi, lo));
+		_mm256_storeu_si256((__m256i *)(out + 32), _mm256_unpackhi_epi8(hi, lo));
+		out += 64;
+		done += 32;
+	}
+
+	return done + encode_ssse3(in + done, in_len - done, out);
+}
+#endif /* CPU_X86_SIMD */
+
+/*!
+ * \brief Encodes leading blocks using the best available vector code.
+ *
+ * \return Number of consumed input bytes.
+ */
+static uint32_t encode_simd(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+#ifdef CPU_X86_SIMD
+	unsigned features = cpu_features();
+	if (features & CPU_AVX2) {
+		return encode_avx2(in, in_len, out);
+	}
+	if (features & CPU_SSSE3) {
+		return encode_ssse3(in, in_len, out);
+	}
+#endif
+	return 0;
+}
+
+int32_t base16_encode(const uint8_t  *in,
+                      const uint32_t in_len,
+                      uint8_t        *out,
+                      const uint32_t out_len)
+{
+	// Checking inputs.
+	if (in == NULL || out == NULL) {
+		return KNOT_EINVAL;
+	}
+	if (in_len > MAX_BIN_DATA_LEN || out_len < in_len * 2) {
+		return KNOT_ERANGE;
+	}
+
+	const uint8_t	*stop = in + in_len;
+	uint8_t		*text = out;
+
+	// Vectorized encoding of the leading bulk of data.
+	uint32_t done = encode_simd(in, in_len, text);
+	in += done;
+	text += done * 2;
+
+	// Encoding loop takes 1 byte and creates 2 characters.
+	while (in < stop) {
+		text[0] = base16_enc[in[0] >> 4];
+		text[1] = base16_enc[in[0] & 0x0F];
+		text += 2;
+		in += 1;
+	}
+
+	return (text - out);
+}
+
+int32_t base16_encode_alloc(const uint8_t  *in,
+                            const uint32_t in_len,
+                            uint8_t        **out)
+{
+	// Checking inputs.
+	if (out == NULL) {
+		return KNOT_EINVAL;
+	}
+	if (in_len > MAX_BIN_DATA_LEN) {
+		return KNOT_ERANGE;
+	}
+
+	// Compute output buffer length.
+	uint32_t out_len = in_len * 2;
+
+	// Allocate output buffer.
+	*out = malloc(out_len);
+	if (*out == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	// Encode data.
+	int32_t ret = base16_encode(in, in_len, *out, out_len);
+	if (ret < 0) {
+		free(*out);
+	}
+
+	return ret;
+}
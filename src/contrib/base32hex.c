@@ -15,10 +15,13 @@
  */
 
 #include "contrib/base32hex.h"
+#include "contrib/cpu.h"
 #include "libknot/errcode.h"
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 /*! \brief Maximal length of binary input to Base32hex encoding. */
 #define MAX_BIN_DATA_LEN	((INT32_MAX / 8) * 5)
@@ -80,6 +83,238 @@ static const uint8_t base32hex_dec[256] = {
 	[ 42] = KO, ['U'] = 30, [128] = KO, [171] = KO, [214] = KO,
 };
 
+#ifdef CPU_X86_SIMD
+/*
+ * Vectorized Base32hex processes two 5-byte blocks (16 characters) in each
+ * 16-byte lane. Each 5-bit group is extracted from the 16-bit big-endian word
+ * containing it, shifted to the top by a multiplication and then down.
+ */
+
+/*! \brief Splits 10 input bytes into 5-bit indices and translates them. */
+CPU_TARGET_SSSE3
+static inline __m128i enc_block_ssse3(__m128i in)
+{
+	const __m128i words = _mm_setr_epi8(1, 0, 1, 0, 2, 1, 2, 1,
+	                                    3, 2, 4, 3, 4, 3, 4, 3);
+	const __m128i mult = _mm_setr_epi16(1, 32, 4, 128, 16, 2, 64, 2048);
+
+	__m128i b0 = _mm_shuffle_epi8(in, words);
+	__m128i b1 = _mm_shuffle_epi8(in, _mm_add_epi8(words, _mm_set1_epi8(5)));
+	b0 = _mm_srli_epi16(_mm_mullo_epi16(b0, mult), 11);
+	b1 = _mm_srli_epi16(_mm_mullo_epi16(b1, mult), 11);
+	__m128i idx = _mm_packus_epi16(b0, b1);
+
+	// Indices 0-9 map to '0'-'9', 10-31 to 'A'-'V'.
+	__m128i alpha = _mm_cmpgt_epi8(idx, _mm_set1_epi8(9));
+	idx = _mm_add_epi8(idx, _mm_set1_epi8('0'));
+	return _mm_add_epi8(idx, _mm_and_si128(alpha, _mm_set1_epi8('A' - '9' - 1)));
+}
+
+/*! \brief Translates characters to 5-bit values, fails on a non-alphabet one. */
+CPU_TARGET_SSSE3
+static inline bool dec_translate_ssse3(__m128i in, __m128i *out)
+{
+	// Lower case letters are accepted, digits are not affected.
+	__m128i lower = _mm_or_si128(in, _mm_set1_epi8(0x20));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)),
+	                              _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), in));
+	__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+	                              _mm_cmpgt_epi8(_mm_set1_epi8('v' + 1), lower));
+	if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF) {
+		return false;
+	}
+
+	__m128i offset = _mm_add_epi8(_mm_set1_epi8('a' - 10),
+	                              _mm_and_si128(digit, _mm_set1_epi8('0' - 'a' + 10)));
+	*out = _mm_sub_epi8(lower, offset);
+	return true;
+}
+
+/*! \brief Packs 5-bit values (8 in each 64-bit lane) to 10 output bytes. */
+CPU_TARGET_SSSE3
+static inline __m128i dec_reshuffle_ssse3(__m128i val)
+{
+	// 10-bit pairs, 20-bit quadruples, 40-bit blocks.
+	__m128i t = _mm_maddubs_epi16(val, _mm_set1_epi16(0x0120));
+	t = _mm_madd_epi16(t, _mm_set1_epi32(0x00010400));
+	__m128i hi = _mm_and_si128(t, _mm_set_epi32(0, -1, 0, -1));
+	t = _mm_or_si128(_mm_slli_epi64(hi, 20), _mm_srli_epi64(t, 32));
+	return _mm_shuffle_epi8(t, _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8,
+	                                         -1, -1, -1, -1, -1, -1));
+}
+
+CPU_TARGET_SSSE3
+static inline void store10_ssse3(uint8_t *out, __m128i val)
+{
+	_mm_storel_epi64((__m128i *)out, val);
+	uint16_t rest = _mm_extract_epi16(val, 4);
+	memcpy(out + 8, &rest, sizeof(rest));
+}
+
+/*! \brief Encodes whole 10-byte blocks, returns the number of consumed bytes. */
+CPU_TARGET_SSSE3
+static uint32_t encode_ssse3(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	uint32_t done = 0;
+
+	// Loads 16 bytes, uses 10 of them.
+	while (in_len - done >= 16) {
+		__m128i data = _mm_loadu_si128((const __m128i *)(in + done));
+		_mm_storeu_si128((__m128i *)out, enc_block_ssse3(data));
+		out += 16;
+		done += 10;
+	}
+
+	return done;
+}
+
+/*! \brief Decodes valid 16-char blocks, returns the number of consumed chars. */
+CPU_TARGET_SSSE3
+static uint32_t decode_ssse3(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	uint32_t done = 0;
+
+	while (in_len - done >= 16) {
+		__m128i data = _mm_loadu_si128((const __m128i *)(in + done));
+		if (!dec_translate_ssse3(data, &data)) {
+			break;
+		}
+		store10_ssse3(out, dec_reshuffle_ssse3(data));
+		out += 10;
+		done += 16;
+	}
+
+	return done;
+}
+
+CPU_TARGET_AVX2
+static inline __m256i enc_block_avx2(__m256i in)
+{
+	const __m256i words = _mm256_broadcastsi128_si256(
+	        _mm_setr_epi8(1, 0, 1, 0, 2, 1, 2, 1, 3, 2, 4, 3, 4, 3, 4, 3));
+	const __m256i mult = _mm256_broadcastsi128_si256(
+	        _mm_setr_epi16(1, 32, 4, 128, 16, 2, 64, 2048));
+
+	__m256i b0 = _mm256_shuffle_epi8(in, words);
+	__m256i b1 = _mm256_shuffle_epi8(in, _mm256_add_epi8(words, _mm256_set1_epi8(5)));
+	b0 = _mm256_srli_epi16(_mm256_mullo_epi16(b0, mult), 11);
+	b1 = _mm256_srli_epi16(_mm256_mullo_epi16(b1, mult), 11);
+	__m256i idx = _mm256_packus_epi16(b0, b1);
+
+	__m256i alpha = _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(9));
+	idx = _mm256_add_epi8(idx, _mm256_set1_epi8('0'));
+	return _mm256_add_epi8(idx, _mm256_and_si256(alpha, _mm256_set1_epi8('A' - '9' - 1)));
+}
+
+CPU_TARGET_AVX2
+static inline bool dec_translate_avx2(__m256i in, __m256i *out)
+{
+	__m256i lower = _mm256_or_si256(in, _mm256_set1_epi8(0x20));
+	__m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+	                                 _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+	__m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+	                                 _mm256_cmpgt_epi8(_mm256_set1_epi8('v' + 1), lower));
+	if (_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) != -1) {
+		return false;
+	}
+
+	__m256i offset = _mm256_add_epi8(_mm256_set1_epi8('a' - 10),
+	                                 _mm256_and_si256(digit, _mm256_set1_epi8('0' - 'a' + 10)));
+	*out = _mm256_sub_epi8(lower, offset);
+	return true;
+}
+
+CPU_TARGET_AVX2
+static inline __m256i dec_reshuffle_avx2(__m256i val)
+{
+	__m256i t = _mm256_maddubs_epi16(val, _mm256_set1_epi16(0x0120));
+	t = _mm256_madd_epi16(t, _mm256_set1_epi32(0x00010400));
+	__m256i hi = _mm256_and_si256(t, _mm256_set1_epi64x(0xFFFFFFFF));
+	t = _mm256_or_si256(_mm256_slli_epi64(hi, 20), _mm256_srli_epi64(t, 32));
+	return _mm256_shuffle_epi8(t, _mm256_broadcastsi128_si256(
+	        _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8,
+	                      -1, -1, -1, -1, -1, -1)));
+}
+
+CPU_TARGET_AVX2
+static uint32_t encode_avx2(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	uint32_t done = 0;
+
+	// Loads 2x16 bytes at offsets 0 and 10, uses 20 bytes.
+	while (in_len - done >= 26) {
+		const uint8_t *pos = in + done;
+		__m256i data = _mm256_inserti128_si256(
+		        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)pos)),
+		        _mm_loadu_si128((const __m128i *)(pos + 10)), 1);
+		_mm256_storeu_si256((__m256i *)out, enc_block_avx2(data));
+		out += 32;
+		done += 20;
+	}
+
+	return done + encode_ssse3(in + done, in_len - done, out);
+}
+
+CPU_TARGET_AVX2
+static uint32_t decode_avx2(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	uint32_t done = 0;
+
+	while (in_len - done >= 32) {
+		__m256i data = _mm256_loadu_si256((const __m256i *)(in + done));
+		if (!dec_translate_avx2(data, &data)) {
+			return done;
+		}
+		data = dec_reshuffle_avx2(data);
+		store10_ssse3(out, _mm256_castsi256_si128(data));
+		store10_ssse3(out + 10, _mm256_extracti128_si256(data, 1));
+		out += 20;
+		done += 32;
+	}
+
+	return done + decode_ssse3(in + done, in_len - done, out);
+}
+#endif /* CPU_X86_SIMD */
+
+/*!
+ * \brief Encodes whole 5-byte groups using the best available vector code.
+ *
+ * \return Number of consumed input bytes (multiple of 5).
+ */
+static uint32_t encode_simd(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+#ifdef CPU_X86_SIMD
+	unsigned features = cpu_features();
+	if (features & CPU_AVX2) {
+		return encode_avx2(in, in_len, out);
+	}
+	if (features & CPU_SSSE3) {
+		return encode_ssse3(in, in_len, out);
+	}
+#endif
+	return 0;
+}
+
+/*!
+ * \brief Decodes leading blocks without padding and invalid characters using
+ *        the best available vector code.
+ *
+ * \return Number of consumed input characters (multiple of 8).
+ */
+static uint32_t decode_simd(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+#ifdef CPU_X86_SIMD
+	unsigned features = cpu_features();
+	if (features & CPU_AVX2) {
+		return decode_avx2(in, in_len, out);
+	}
+	if (features & CPU_SSSE3) {
+		return decode_ssse3(in, in_len, out);
+	}
+#endif
+	return 0;
+}
+
 int32_t base32hex_encode(const uint8_t  *in,
                          const uint32_t in_len,
                          uint8_t        *out,
@@ -97,6 +332,11 @@ int32_t base32hex_encode(const uint8_t  *in,
 	const uint8_t	*stop = in + in_len - rest_len;
 	uint8_t		*text = out;
 
+	// Vectorized encoding of the leading bulk of data.
+	uint32_t done = encode_simd(in, stop - in, text);
+	in += done;
+	text += (done / 5) * 8;
+
 	// Encoding loop takes 5 bytes and creates 8 characters.
 	while (in < stop) {
 		text[0] = base32hex_enc[in[0] >> 3];
@@ -213,6 +453,14 @@ int32_t base32hex_decode(const uint8_t  *in,
 	uint8_t		pad_len = 0;
 	uint8_t		c1, c2, c3, c4, c5, c6, c7, c8;
 
+	// Vectorized decoding of the leading bulk of data, the last block
+	// (possibly padded) and invalid characters are left for the loop below.
+	if (in_len > 8) {
+		uint32_t done = decode_simd(in, in_len - 8, bin);
+		in += done;
+		bin += (done / 8) * 5;
+	}
+
 	// Decoding loop takes 8 characters and creates 5 bytes.
 	while (in < stop) {
 		// Filling and transforming 8 Base32hex chars.
@@ -21,6 +21,9 @@
  * \note Input Base32hex string can contain a-v characters. These characters
  *       are considered as A-V equivalent.
  *
+ * \note The zone file parser (zscanner) doesn't use these functions, it
+ *       decodes Base32hex RDATA in its own state machine.
+ *
  * \addtogroup contrib
  * @{
  */
@@ -18,6 +18,9 @@
  *
  * \brief Base64 implementation (RFC 4648).
  *
+ * \note The zone file parser (zscanner) doesn't use these functions, it
+ *       decodes Base64 RDATA in its own state machine.
+ *
  * \addtogroup contrib
  * @{
  */
@@ -0,0 +1,55 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contrib/cpu.h"
+
+/*! \brief Feature detection not yet done. */
+#define UNKNOWN	(~0U)
+
+static unsigned detected = UNKNOWN;
+static unsigned allowed = ~0U;
+
+static unsigned detect(void)
+{
+	unsigned features = 0;
+
+#ifdef CPU_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3")) {
+		features |= CPU_SSSE3;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		features |= CPU_AVX2;
+	}
+#endif
+
+	return features;
+}
+
+unsigned cpu_features(void)
+{
+	// Concurrent detection is harmless, the result is always the same.
+	if (detected == UNKNOWN) {
+		detected = detect();
+	}
+
+	return detected & allowed;
+}
+
+void cpu_features_limit(unsigned mask)
+{
+	allowed = mask;
+}
@@ -0,0 +1,60 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief CPU feature detection for vectorized code paths.
+ *
+ * \addtogroup contrib
+ * @{
+ */
+
+#pragma once
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+/*! \brief SSSE3 and AVX2 code paths are compiled in. */
+#define CPU_X86_SIMD
+/*! \brief Function compiled for SSSE3 capable CPUs. */
+#define CPU_TARGET_SSSE3	__attribute__((target("ssse3")))
+/*! \brief Function compiled for AVX2 capable CPUs. */
+#define CPU_TARGET_AVX2		__attribute__((target("avx2")))
+
+#include <immintrin.h>
+#endif
+
+/*! \brief CPU features usable by the vectorized code. */
+enum cpu_feature {
+	CPU_SSSE3 = 1 << 0,
+	CPU_AVX2  = 1 << 1,
+};
+
+/*!
+ * \brief Returns the supported CPU features (see \a cpu_feature).
+ *
+ * The result is limited by the mask set with \a cpu_features_limit.
+ */
+unsigned cpu_features(void);
+
+/*!
+ * \brief Restricts the features used by the vectorized code.
+ *
+ * \note Intended for testing and benchmarking of the fallback code paths.
+ *
+ * \param mask  Allowed features, zero for scalar code only.
+ */
+void cpu_features_limit(unsigned mask);
+
+/*! @} */
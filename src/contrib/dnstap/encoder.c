@@ -0,0 +1,252 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libknot/errcode.h"
+#include "contrib/dnstap/convert.h"
+#include "contrib/dnstap/encoder.h"
+#include "contrib/dnstap/fields.h"
+
+/*! \brief Field key, all the used field numbers fit into one byte. */
+#define KEY(field, type)	(uint8_t)((field) << 3 | (type))
+
+static size_t varint_size(uint64_t val)
+{
+	size_t size = 1;
+	while (val >= 0x80) {
+		val >>= 7;
+		size++;
+	}
+	return size;
+}
+
+static uint8_t *put_varint(uint8_t *pos, uint64_t val)
+{
+	while (val >= 0x80) {
+		*pos++ = (val & 0x7F) | 0x80;
+		val >>= 7;
+	}
+	*pos++ = val;
+	return pos;
+}
+
+static uint8_t *put_uint(uint8_t *pos, unsigned field, uint64_t val)
+{
+	*pos++ = KEY(field, DT_WIRE_VARINT);
+	return put_varint(pos, val);
+}
+
+static uint8_t *put_fixed32(uint8_t *pos, unsigned field, uint32_t val)
+{
+	*pos++ = KEY(field, DT_WIRE_FIXED32);
+	for (int i = 0; i < 4; i++) {
+		*pos++ = val >> (8 * i);
+	}
+	return pos;
+}
+
+static uint8_t *put_bytes_key(uint8_t *pos, unsigned field, size_t len)
+{
+	*pos++ = KEY(field, DT_WIRE_BYTES);
+	return put_varint(pos, len);
+}
+
+static uint8_t *put_bytes(uint8_t *pos, unsigned field, const void *data,
+                          size_t len)
+{
+	pos = put_bytes_key(pos, field, len);
+	if (len > 0) {
+		memcpy(pos, data, len);
+	}
+	return pos + len;
+}
+
+static uint8_t *put_address(uint8_t *pos, unsigned field,
+                            const struct sockaddr *sa)
+{
+	if (sa == NULL) {
+		return pos;
+	}
+
+	const void *addr = NULL;
+	size_t addr_len = 0;
+
+	if (sa->sa_family == AF_INET) {
+		const struct sockaddr_in *sai = (const struct sockaddr_in *)sa;
+		addr = &sai->sin_addr.s_addr;
+		addr_len = sizeof(sai->sin_addr);
+	} else if (sa->sa_family == AF_INET6) {
+		const struct sockaddr_in6 *sai6 = (const struct sockaddr_in6 *)sa;
+		addr = &sai6->sin6_addr.s6_addr;
+		addr_len = sizeof(sai6->sin6_addr);
+	}
+
+	return put_bytes(pos, field, addr, addr_len);
+}
+
+static uint8_t *put_port(uint8_t *pos, unsigned field, const struct sockaddr *sa)
+{
+	if (sa == NULL) {
+		return pos;
+	}
+
+	uint16_t port = 0;
+
+	if (sa->sa_family == AF_INET) {
+		port = ntohs(((const struct sockaddr_in *)sa)->sin_port);
+	} else if (sa->sa_family == AF_INET6) {
+		port = ntohs(((const struct sockaddr_in6 *)sa)->sin6_port);
+	}
+
+	return put_uint(pos, field, port);
+}
+
+static uint8_t *put_time(uint8_t *pos, unsigned sec_field, unsigned nsec_field,
+                         const struct timeval *tv)
+{
+	if (tv == NULL) {
+		return pos;
+	}
+
+	pos = put_uint(pos, sec_field, tv->tv_sec);
+	return put_fixed32(pos, nsec_field, tv->tv_usec * 1000);
+}
+
+int dt_encoder_init(dt_encoder_t *enc, const char *identity, const char *version)
+{
+	if (enc == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	size_t identity_len = (identity != NULL) ? strlen(identity) : 0;
+	size_t version_len = (version != NULL) ? strlen(version) : 0;
+
+	size_t max_len = 2 * (1 + varint_size(SIZE_MAX)) + identity_len + version_len;
+	enc->header = malloc(max_len);
+	if (enc->header == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	/* Empty fields are omitted as in the module. */
+	uint8_t *pos = enc->header;
+	if (identity_len > 0) {
+		pos = put_bytes(pos, DT_DNSTAP_IDENTITY, identity, identity_len);
+	}
+	if (version_len > 0) {
+		pos = put_bytes(pos, DT_DNSTAP_VERSION, version, version_len);
+	}
+	enc->header_len = pos - enc->header;
+
+	return KNOT_EOK;
+}
+
+void dt_encoder_deinit(dt_encoder_t *enc)
+{
+	if (enc == NULL) {
+		return;
+	}
+
+	free(enc->header);
+	enc->header = NULL;
+	enc->header_len = 0;
+}
+
+size_t dt_encoder_max_size(const dt_encoder_t *enc, size_t len_wire)
+{
+	return enc->header_len + DT_ENCODER_OVERHEAD + len_wire;
+}
+
+int dt_encode(const dt_encoder_t           *enc,
+              uint8_t                      *buf,
+              size_t                       *buf_len,
+              const Dnstap__Message__Type  type,
+              const struct sockaddr        *query_sa,
+              const struct sockaddr        *response_sa,
+              const int                    protocol,
+              const void                   *wire,
+              const size_t                 len_wire,
+              const struct timeval         *qtime,
+              const struct timeval         *rtime)
+{
+	if (enc == NULL || buf == NULL || buf_len == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (*buf_len < dt_encoder_max_size(enc, len_wire)) {
+		return KNOT_ESPACE;
+	}
+
+	/*
+	 * Small fields of the Message in the field number order, as serialized
+	 * by protobuf-c. The query message goes before the response time,
+	 * the response message after it.
+	 */
+	uint8_t fields[DT_ENCODER_OVERHEAD];
+	uint8_t *pos = put_uint(fields, DT_MSG_TYPE, type);
+
+	const struct sockaddr *source = query_sa ? query_sa : response_sa;
+	int family = (source != NULL) ? dt_family_encode(source->sa_family) : 0;
+	if (family != 0) {
+		pos = put_uint(pos, DT_MSG_SOCKET_FAMILY, family);
+	}
+	int proto = dt_protocol_encode(protocol);
+	if (proto != 0) {
+		pos = put_uint(pos, DT_MSG_SOCKET_PROTOCOL, proto);
+	}
+
+	pos = put_address(pos, DT_MSG_QUERY_ADDRESS, query_sa);
+	pos = put_address(pos, DT_MSG_RESPONSE_ADDRESS, response_sa);
+	pos = put_port(pos, DT_MSG_QUERY_PORT, query_sa);
+	pos = put_port(pos, DT_MSG_RESPONSE_PORT, response_sa);
+	pos = put_time(pos, DT_MSG_QUERY_TIME_SEC, DT_MSG_QUERY_TIME_NSEC, qtime);
+	size_t split = pos - fields;
+	pos = put_time(pos, DT_MSG_RESPONSE_TIME_SEC, DT_MSG_RESPONSE_TIME_NSEC, rtime);
+	size_t fields_len = pos - fields;
+
+	unsigned wire_field = 0;
+	if (dt_message_type_is_query(type)) {
+		wire_field = DT_MSG_QUERY_MESSAGE;
+	} else if (dt_message_type_is_response(type)) {
+		wire_field = DT_MSG_RESPONSE_MESSAGE;
+	}
+	if (wire_field != DT_MSG_QUERY_MESSAGE) {
+		split = fields_len;
+	}
+
+	size_t msg_len = fields_len;
+	if (wire_field != 0) {
+		msg_len += 1 + varint_size(len_wire) + len_wire;
+	}
+
+	/* Dnstap: identity, version, message, type. */
+	memcpy(buf, enc->header, enc->header_len);
+	pos = put_bytes_key(buf + enc->header_len, DT_DNSTAP_MESSAGE, msg_len);
+	memcpy(pos, fields, split);
+	pos += split;
+	if (wire_field != 0) {
+		pos = put_bytes(pos, wire_field, wire, len_wire);
+	}
+	memcpy(pos, fields + split, fields_len - split);
+	pos += fields_len - split;
+	pos = put_uint(pos, DT_DNSTAP_TYPE, DNSTAP__DNSTAP__TYPE__MESSAGE);
+
+	*buf_len = pos - buf;
+
+	return KNOT_EOK;
+}
@@ -0,0 +1,95 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Direct dnstap frame serialization.
+ *
+ * Serializes dnstap messages into a caller supplied buffer without
+ * intermediate protobuf-c structures and allocations. The output is
+ * equivalent to dt_message_fill() followed by dt_pack().
+ *
+ * \addtogroup dnstap
+ * @{
+ */
+
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "contrib/dnstap/dnstap.pb-c.h"
+
+/*! \brief Upper bound of the frame size besides the identity, version and wire. */
+#define DT_ENCODER_OVERHEAD	128
+
+/*! \brief Dnstap frame encoder. */
+typedef struct {
+	uint8_t *header;   /*!< Serialized identity and version fields. */
+	size_t header_len;
+} dt_encoder_t;
+
+/*!
+ * \brief Initializes the encoder.
+ *
+ * \param enc       Encoder to initialize.
+ * \param identity  Server identity (optional).
+ * \param version   Server version (optional).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int dt_encoder_init(dt_encoder_t *enc, const char *identity, const char *version);
+
+/*!
+ * \brief Deinitializes the encoder.
+ */
+void dt_encoder_deinit(dt_encoder_t *enc);
+
+/*!
+ * \brief Returns the maximum size of a frame with the given wire length.
+ */
+size_t dt_encoder_max_size(const dt_encoder_t *enc, size_t len_wire);
+
+/*!
+ * \brief Serializes a dnstap message frame.
+ *
+ * \see dt_message_fill() for the message parameters.
+ *
+ * \param enc      Encoder.
+ * \param buf      Output buffer.
+ * \param buf_len  Output buffer size, the frame size on return.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ESPACE
+ */
+int dt_encode(const dt_encoder_t           *enc,
+              uint8_t                      *buf,
+              size_t                       *buf_len,
+              const Dnstap__Message__Type  type,
+              const struct sockaddr        *query_sa,
+              const struct sockaddr        *response_sa,
+              const int                    protocol,
+              const void                   *wire,
+              const size_t                 len_wire,
+              const struct timeval         *qtime,
+              const struct timeval         *rtime);
+
+/*! @} */
@@ -0,0 +1,109 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libknot/errcode.h"
+#include "contrib/dnstap/fields.h"
+
+/*! \brief Reads a varint, returns NULL if malformed. */
+static const uint8_t *get_varint(const uint8_t *pos, const uint8_t *end,
+                                 uint64_t *val)
+{
+	*val = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		if (pos >= end) {
+			return NULL;
+		}
+		uint8_t byte = *pos++;
+		*val |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return pos;
+		}
+	}
+
+	return NULL;
+}
+
+static uint64_t get_fixed(const uint8_t *pos, unsigned size)
+{
+	uint64_t val = 0;
+	for (unsigned i = 0; i < size; i++) {
+		val |= (uint64_t)pos[i] << (8 * i);
+	}
+	return val;
+}
+
+int dt_fields_get(const uint8_t *msg, size_t len, uint32_t mask,
+                  dt_field_t *fields)
+{
+	if (msg == NULL || fields == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	for (unsigned i = 0; i <= DT_FIELD_MAX; i++) {
+		if (mask & DT_FIELD(i)) {
+			fields[i].present = false;
+		}
+	}
+
+	const uint8_t *pos = msg;
+	const uint8_t *end = msg + len;
+	while (pos < end && mask != 0) {
+		uint64_t key;
+		pos = get_varint(pos, end, &key);
+		if (pos == NULL) {
+			return KNOT_EMALF;
+		}
+
+		uint64_t number = key >> 3;
+		dt_field_t field = { .present = true };
+
+		switch (key & 0x07) {
+		case DT_WIRE_VARINT:
+			pos = get_varint(pos, end, &field.num);
+			if (pos == NULL) {
+				return KNOT_EMALF;
+			}
+			break;
+		case DT_WIRE_FIXED64:
+		case DT_WIRE_FIXED32:
+			field.len = ((key & 0x07) == DT_WIRE_FIXED64) ? 8 : 4;
+			if ((size_t)(end - pos) < field.len) {
+				return KNOT_EMALF;
+			}
+			field.num = get_fixed(pos, field.len);
+			pos += field.len;
+			break;
+		case DT_WIRE_BYTES:
+			pos = get_varint(pos, end, &field.num);
+			if (pos == NULL || (uint64_t)(end - pos) < field.num) {
+				return KNOT_EMALF;
+			}
+			field.data = pos;
+			field.len = field.num;
+			pos += field.len;
+			break;
+		default:
+			return KNOT_EMALF;
+		}
+
+		if (number <= DT_FIELD_MAX && (mask & DT_FIELD(number))) {
+			fields[number] = field;
+			mask &= ~DT_FIELD(number);
+		}
+	}
+
+	return KNOT_EOK;
+}
@@ -0,0 +1,102 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Lazy access to the serialized dnstap fields.
+ *
+ * The field numbers correspond to dnstap.proto. The fields are decoded
+ * in place, without protobuf-c and without any allocation.
+ *
+ * \addtogroup dnstap
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \brief Protobuf wire types. */
+enum {
+	DT_WIRE_VARINT  = 0,
+	DT_WIRE_FIXED64 = 1,
+	DT_WIRE_BYTES   = 2,
+	DT_WIRE_FIXED32 = 5
+};
+
+/*! \brief Fields of the Dnstap message. */
+enum {
+	DT_DNSTAP_IDENTITY = 1,
+	DT_DNSTAP_VERSION  = 2,
+	DT_DNSTAP_EXTRA    = 3,
+	DT_DNSTAP_MESSAGE  = 14,
+	DT_DNSTAP_TYPE     = 15
+};
+
+/*! \brief Fields of the Message message. */
+enum {
+	DT_MSG_TYPE               = 1,
+	DT_MSG_SOCKET_FAMILY      = 2,
+	DT_MSG_SOCKET_PROTOCOL    = 3,
+	DT_MSG_QUERY_ADDRESS      = 4,
+	DT_MSG_RESPONSE_ADDRESS   = 5,
+	DT_MSG_QUERY_PORT         = 6,
+	DT_MSG_RESPONSE_PORT      = 7,
+	DT_MSG_QUERY_TIME_SEC     = 8,
+	DT_MSG_QUERY_TIME_NSEC    = 9,
+	DT_MSG_QUERY_MESSAGE      = 10,
+	DT_MSG_QUERY_ZONE         = 11,
+	DT_MSG_RESPONSE_TIME_SEC  = 12,
+	DT_MSG_RESPONSE_TIME_NSEC = 13,
+	DT_MSG_RESPONSE_MESSAGE   = 14
+};
+
+/*! \brief Highest supported field number. */
+#define DT_FIELD_MAX	31
+
+/*! \brief Field bit for the field mask. */
+#define DT_FIELD(field)	(1U << (field))
+
+/*! \brief Decoded field, the bytes point into the serialized message. */
+typedef struct {
+	bool present;
+	uint64_t num;          /*!< Varint or fixed-size value. */
+	const uint8_t *data;   /*!< Length-delimited value. */
+	size_t len;
+} dt_field_t;
+
+/*!
+ * \brief Decodes the requested fields of a serialized message.
+ *
+ * The decoding stops as soon as all the requested fields are found,
+ * the first occurrence of a repeated field is used. Other fields are
+ * only skipped.
+ *
+ * \param msg     Serialized message.
+ * \param len     Message length.
+ * \param mask    Requested fields, combination of DT_FIELD().
+ * \param fields  Output indexed by the field number (DT_FIELD_MAX + 1 items).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_EMALF
+ */
+int dt_fields_get(const uint8_t *msg, size_t len, uint32_t mask,
+                  dt_field_t *fields);
+
+/*! @} */
@@ -0,0 +1,242 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libknot/errcode.h"
+#include "contrib/dnstap/mmap_reader.h"
+#include "contrib/wire.h"
+
+/* Frame Streams control frames. */
+#define FSTRM_CONTROL_START		0x02
+#define FSTRM_CONTROL_STOP		0x03
+#define FSTRM_FIELD_CONTENT_TYPE	0x01
+
+/*! \brief Content type of dnstap, as DNSTAP_CONTENT_TYPE. */
+#define CONTENT_TYPE	"protobuf:dnstap.Dnstap"
+
+/*! \brief Frame Streams frame. */
+typedef struct {
+	const uint8_t *data;
+	size_t len;
+	bool control;
+} frame_t;
+
+static int read_frame(const dt_mmap_reader_t *reader, size_t *offset,
+                      frame_t *frame)
+{
+	size_t rest = reader->size - *offset;
+	const uint8_t *pos = reader->data + *offset;
+
+	if (rest == 0) {
+		return KNOT_EOF;
+	}
+	if (rest < sizeof(uint32_t)) {
+		return KNOT_EMALF;
+	}
+
+	/* Data frame, or an escape followed by a control frame. */
+	uint32_t len = wire_read_u32(pos);
+	size_t header = sizeof(uint32_t);
+	frame->control = (len == 0);
+	if (frame->control) {
+		if (rest < 2 * sizeof(uint32_t)) {
+			return KNOT_EMALF;
+		}
+		len = wire_read_u32(pos + header);
+		header += sizeof(uint32_t);
+		if (len < sizeof(uint32_t)) {
+			return KNOT_EMALF;
+		}
+	}
+
+	if (rest - header < len) {
+		return KNOT_EMALF;
+	}
+
+	frame->data = pos + header;
+	frame->len = len;
+	*offset += header + len;
+
+	return KNOT_EOK;
+}
+
+static bool is_stop(const frame_t *frame)
+{
+	return frame->control && wire_read_u32(frame->data) == FSTRM_CONTROL_STOP;
+}
+
+/*! \brief Checks the content type fields of the start frame, if any. */
+static bool check_start(const frame_t *frame)
+{
+	if (!frame->control || wire_read_u32(frame->data) != FSTRM_CONTROL_START) {
+		return false;
+	}
+
+	bool match = true;
+	size_t pos = sizeof(uint32_t);
+	while (frame->len - pos >= 2 * sizeof(uint32_t)) {
+		uint32_t type = wire_read_u32(frame->data + pos);
+		uint32_t len = wire_read_u32(frame->data + pos + sizeof(uint32_t));
+		pos += 2 * sizeof(uint32_t);
+		if (frame->len - pos < len) {
+			return false;
+		}
+
+		if (type == FSTRM_FIELD_CONTENT_TYPE) {
+			match = (len == strlen(CONTENT_TYPE) &&
+			         memcmp(frame->data + pos, CONTENT_TYPE, len) == 0);
+			if (match) {
+				break;
+			}
+		}
+		pos += len;
+	}
+
+	return match;
+}
+
+int dt_mmap_reader_open(dt_mmap_reader_t *reader, const char *path)
+{
+	if (reader == NULL || path == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	memset(reader, 0, sizeof(*reader));
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return KNOT_EFILE;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return KNOT_EFILE;
+	}
+
+	/* Empty file can't be mapped and has no start frame anyway. */
+	if (st.st_size == 0) {
+		close(fd);
+		return KNOT_EMALF;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return KNOT_EFILE;
+	}
+
+	(void)madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+	reader->data = data;
+	reader->size = st.st_size;
+
+	frame_t frame;
+	size_t offset = 0;
+	if (read_frame(reader, &offset, &frame) != KNOT_EOK ||
+	    !check_start(&frame)) {
+		dt_mmap_reader_close(reader);
+		return KNOT_EMALF;
+	}
+	reader->start = offset;
+
+	return KNOT_EOK;
+}
+
+void dt_mmap_reader_close(dt_mmap_reader_t *reader)
+{
+	if (reader == NULL || reader->data == NULL) {
+		return;
+	}
+
+	munmap((void *)reader->data, reader->size);
+	memset(reader, 0, sizeof(*reader));
+}
+
+int dt_mmap_reader_next(const dt_mmap_reader_t *reader, size_t *offset,
+                        const uint8_t **data, size_t *len)
+{
+	if (reader == NULL || offset == NULL || data == NULL || len == NULL ||
+	    *offset > reader->size) {
+		return KNOT_EINVAL;
+	}
+
+	for (;;) {
+		frame_t frame;
+		size_t next = *offset;
+		int ret = read_frame(reader, &next, &frame);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		if (!frame.control) {
+			*offset = next;
+			*data = frame.data;
+			*len = frame.len;
+			return KNOT_EOK;
+		}
+
+		/* Stay on the stop frame. */
+		if (is_stop(&frame)) {
+			return KNOT_EOF;
+		}
+		*offset = next;
+	}
+}
+
+void dt_mmap_reader_split(const dt_mmap_reader_t *reader, size_t count,
+                          size_t *bounds)
+{
+	if (reader == NULL || count == 0 || bounds == NULL) {
+		return;
+	}
+
+	size_t offset = reader->start;
+	size_t span = reader->size - reader->start;
+	bounds[0] = offset;
+
+	/*
+	 * Hop over the frame headers until the next range boundary. A boundary
+	 * must follow a data frame, otherwise the reading of the previous range
+	 * would skip the control frames and read beyond the boundary.
+	 */
+	bool after_data = true;
+	for (size_t i = 1; i < count; i++) {
+		size_t target = reader->start + span / count * i;
+		while (offset < target || !after_data) {
+			frame_t frame;
+			size_t next = offset;
+			if (read_frame(reader, &next, &frame) != KNOT_EOK ||
+			    is_stop(&frame)) {
+				/* The range with the end stops the reading. */
+				offset = reader->size;
+				after_data = true;
+				break;
+			}
+			offset = next;
+			after_data = !frame.control;
+		}
+		bounds[i] = offset;
+	}
+
+	bounds[count] = reader->size;
+}
@@ -0,0 +1,89 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Memory-mapped dnstap file reader.
+ *
+ * Reads the Frame Streams file directly from a memory mapping. The frames
+ * are returned in place, without copying and without libfstrm. A frame
+ * position is a plain offset, so that the file can be split into ranges
+ * processed in parallel.
+ *
+ * \addtogroup dnstap
+ * @{
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \brief Memory-mapped dnstap file. */
+typedef struct {
+	const uint8_t *data;   /*!< File mapping. */
+	size_t size;           /*!< File size. */
+	size_t start;          /*!< Offset of the first data frame. */
+} dt_mmap_reader_t;
+
+/*!
+ * \brief Maps a dnstap file and checks its start frame.
+ *
+ * \param reader  Reader to initialize.
+ * \param path    File path.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_EFILE   if the file can't be opened or mapped.
+ * \retval KNOT_EMALF   if the file isn't a dnstap Frame Streams file.
+ */
+int dt_mmap_reader_open(dt_mmap_reader_t *reader, const char *path);
+
+/*!
+ * \brief Unmaps the file.
+ */
+void dt_mmap_reader_close(dt_mmap_reader_t *reader);
+
+/*!
+ * \brief Returns the data frame at the given offset and moves the offset.
+ *
+ * Control frames are skipped, the stop frame ends the reading.
+ *
+ * \param reader  Reader.
+ * \param offset  Frame offset, initially the reader start offset.
+ * \param frame   Frame data pointing into the mapping.
+ * \param len     Frame length.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EOF    if there are no more frames.
+ * \retval KNOT_EMALF  if the frame is truncated or malformed.
+ */
+int dt_mmap_reader_next(const dt_mmap_reader_t *reader, size_t *offset,
+                        const uint8_t **frame, size_t *len);
+
+/*!
+ * \brief Splits the frames into ranges of similar size.
+ *
+ * The range \a i spans from \a bounds[i] to \a bounds[i + 1].
+ *
+ * \param reader  Reader.
+ * \param count   Number of the ranges.
+ * \param bounds  Range offsets (count + 1 items).
+ */
+void dt_mmap_reader_split(const dt_mmap_reader_t *reader, size_t count,
+                          size_t *bounds);
+
+/*! @} */
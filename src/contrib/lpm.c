@@ -0,0 +1,331 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "contrib/lpm.h"
+#include "contrib/macros.h"
+#include "contrib/sockaddr.h"
+#include "libknot/errcode.h"
+
+#define STRIDE	8
+#define SLOTS	(1 << STRIDE)
+
+/*! \brief Binary trie node, index 0 is the root and means no child. */
+typedef struct {
+	uint32_t child[2];
+	uint16_t value;
+} bnode_t;
+
+/*! \brief Result for all stride bits or a link to the next stride. */
+typedef struct {
+	uint32_t child;
+	uint16_t value;
+	uint8_t scope;
+} slot_t;
+
+/*! \brief Result for a lookup ending inside the stride. */
+typedef struct {
+	uint16_t value;
+	uint8_t scope;
+} part_t;
+
+/*!
+ * \brief Compiled stride node.
+ *
+ * The partial results are indexed as a heap, the result for the first
+ * \a n stride bits \a b is at the index (1 << n) | b.
+ */
+typedef struct {
+	slot_t slot[SLOTS];
+	part_t part[SLOTS];
+} node_t;
+
+/*! \brief Networks of one address family. */
+typedef struct {
+	bnode_t *bnodes;
+	size_t bcount;
+	size_t bcapacity;
+	node_t *nodes;     /*!< Compiled trie, the first node is the root. */
+	size_t count;
+	size_t capacity;
+	unsigned bits;     /*!< Address length in bits. */
+} family_t;
+
+struct lpm {
+	family_t ipv4;
+	family_t ipv6;
+};
+
+/*! \brief Result of a binary trie walk. */
+typedef struct {
+	uint32_t node;     /*!< Node reached after all the bits or 0. */
+	uint16_t value;
+	uint8_t scope;
+} walk_t;
+
+static family_t *get_family(const lpm_t *lpm, int family)
+{
+	switch (family) {
+	case AF_INET:  return (family_t *)&lpm->ipv4;
+	case AF_INET6: return (family_t *)&lpm->ipv6;
+	default:       return NULL;
+	}
+}
+
+static int family_init(family_t *fam, unsigned bits)
+{
+	fam->bnodes = calloc(1, sizeof(bnode_t));
+	if (fam->bnodes == NULL) {
+		return KNOT_ENOMEM;
+	}
+	fam->bcount = 1;
+	fam->bcapacity = 1;
+	fam->bits = bits;
+
+	return KNOT_EOK;
+}
+
+static void family_deinit(family_t *fam)
+{
+	free(fam->bnodes);
+	free(fam->nodes);
+}
+
+static uint32_t bnode_append(family_t *fam)
+{
+	if (fam->bcount == fam->bcapacity) {
+		size_t capacity = MAX(2 * fam->bcapacity, 16);
+		bnode_t *bnodes = realloc(fam->bnodes, capacity * sizeof(bnode_t));
+		if (bnodes == NULL) {
+			return 0;
+		}
+		fam->bnodes = bnodes;
+		fam->bcapacity = capacity;
+	}
+
+	memset(&fam->bnodes[fam->bcount], 0, sizeof(bnode_t));
+
+	return fam->bcount++;
+}
+
+static uint32_t node_append(family_t *fam)
+{
+	if (fam->count == fam->capacity) {
+		size_t capacity = MAX(2 * fam->capacity, 4);
+		node_t *nodes = realloc(fam->nodes, capacity * sizeof(node_t));
+		if (nodes == NULL) {
+			return UINT32_MAX;
+		}
+		fam->nodes = nodes;
+		fam->capacity = capacity;
+	}
+
+	return fam->count++;
+}
+
+/*!
+ * \brief Walks the binary trie along the leading \a len bits of \a byte.
+ *
+ * If the walk stops on a missing child, the result depends on one more bit
+ * if the node has the other child, otherwise the node already decides it.
+ */
+static walk_t walk(const family_t *fam, uint32_t node, unsigned depth,
+                   uint16_t value, uint8_t byte, unsigned len)
+{
+	for (unsigned i = 0; ; i++) {
+		const bnode_t *bnode = &fam->bnodes[node];
+		if (bnode->value != LPM_NONE) {
+			value = bnode->value;
+		}
+
+		if (i == len) {
+			return (walk_t){ node, value, depth + i };
+		}
+
+		unsigned bit = (byte >> (7 - i)) & 1;
+		if (bnode->child[bit] == 0) {
+			bool branch = (bnode->child[!bit] != 0);
+			return (walk_t){ 0, value, depth + i + branch };
+		}
+		node = bnode->child[bit];
+	}
+}
+
+static bool has_children(const family_t *fam, uint32_t node)
+{
+	const bnode_t *bnode = &fam->bnodes[node];
+	return bnode->child[0] != 0 || bnode->child[1] != 0;
+}
+
+/*! \brief Compiles the stride starting at the given binary trie node. */
+static uint32_t compile(family_t *fam, uint32_t bnode, unsigned depth,
+                        uint16_t value)
+{
+	uint32_t idx = node_append(fam);
+	if (idx == UINT32_MAX) {
+		return idx;
+	}
+
+	for (unsigned len = 0; len < STRIDE; len++) {
+		for (unsigned bits = 0; bits < (1U << len); bits++) {
+			uint8_t byte = (len == 0) ? 0 : bits << (STRIDE - len);
+			walk_t res = walk(fam, bnode, depth, value, byte, len);
+			part_t *part = &fam->nodes[idx].part[(1U << len) | bits];
+			part->value = res.value;
+			part->scope = res.scope;
+		}
+	}
+
+	for (unsigned byte = 0; byte < SLOTS; byte++) {
+		walk_t res = walk(fam, bnode, depth, value, byte, STRIDE);
+		uint32_t child = 0;
+		if (res.node != 0 && has_children(fam, res.node)) {
+			child = compile(fam, res.node, depth + STRIDE, res.value);
+			if (child == UINT32_MAX) {
+				return child;
+			}
+		}
+
+		// Reallocation may have moved the nodes.
+		slot_t *slot = &fam->nodes[idx].slot[byte];
+		slot->child = child;
+		slot->value = res.value;
+		slot->scope = res.scope;
+	}
+
+	return idx;
+}
+
+lpm_t *lpm_new(void)
+{
+	lpm_t *lpm = calloc(1, sizeof(*lpm));
+	if (lpm == NULL) {
+		return NULL;
+	}
+
+	if (family_init(&lpm->ipv4, IPV4_PREFIXLEN) != KNOT_EOK ||
+	    family_init(&lpm->ipv6, IPV6_PREFIXLEN) != KNOT_EOK) {
+		lpm_free(lpm);
+		return NULL;
+	}
+
+	return lpm;
+}
+
+int lpm_add(lpm_t *lpm, const struct sockaddr *addr, unsigned prefix,
+            uint16_t value)
+{
+	if (lpm == NULL || addr == NULL || value == LPM_NONE) {
+		return KNOT_EINVAL;
+	}
+
+	family_t *fam = get_family(lpm, addr->sa_family);
+	if (fam == NULL || prefix > fam->bits) {
+		return KNOT_EINVAL;
+	}
+
+	size_t len = 0;
+	const uint8_t *raw = sockaddr_raw(addr, &len);
+
+	uint32_t node = 0;
+	for (unsigned i = 0; i < prefix; i++) {
+		unsigned bit = (raw[i / 8] >> (7 - i % 8)) & 1;
+		if (fam->bnodes[node].child[bit] == 0) {
+			uint32_t child = bnode_append(fam);
+			if (child == 0) {
+				return KNOT_ENOMEM;
+			}
+			fam->bnodes[node].child[bit] = child;
+		}
+		node = fam->bnodes[node].child[bit];
+	}
+
+	if (fam->bnodes[node].value != LPM_NONE) {
+		return KNOT_EEXIST;
+	}
+	fam->bnodes[node].value = value;
+
+	return KNOT_EOK;
+}
+
+int lpm_build(lpm_t *lpm)
+{
+	if (lpm == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	family_t *fams[] = { &lpm->ipv4, &lpm->ipv6 };
+	for (size_t i = 0; i < sizeof(fams) / sizeof(*fams); i++) {
+		family_t *fam = fams[i];
+		fam->count = 0;
+		if (compile(fam, 0, 0, LPM_NONE) == UINT32_MAX) {
+			fam->count = 0;
+			return KNOT_ENOMEM;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+uint16_t lpm_lookup(const lpm_t *lpm, int family, const uint8_t *addr,
+                    unsigned len, unsigned *scope)
+{
+	const family_t *fam = (lpm != NULL) ? get_family(lpm, family) : NULL;
+	if (fam == NULL || fam->count == 0 || addr == NULL) {
+		if (scope != NULL) {
+			*scope = 0;
+		}
+		return LPM_NONE;
+	}
+
+	len = MIN(len, fam->bits);
+
+	const node_t *node = fam->nodes;
+	for (unsigned depth = 0; ; depth += STRIDE) {
+		unsigned rest = len - depth;
+		if (rest < STRIDE) {
+			unsigned bits = (rest == 0) ? 0 : addr[depth / 8] >> (STRIDE - rest);
+			const part_t *part = &node->part[(1U << rest) | bits];
+			if (scope != NULL) {
+				*scope = part->scope;
+			}
+			return part->value;
+		}
+
+		const slot_t *slot = &node->slot[addr[depth / 8]];
+		if (slot->child == 0) {
+			if (scope != NULL) {
+				*scope = slot->scope;
+			}
+			return slot->value;
+		}
+		node = &fam->nodes[slot->child];
+	}
+}
+
+void lpm_free(lpm_t *lpm)
+{
+	if (lpm == NULL) {
+		return;
+	}
+
+	family_deinit(&lpm->ipv4);
+	family_deinit(&lpm->ipv6);
+	free(lpm);
+}
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Compiled longest-prefix match table of IP networks.
+ *
+ * Networks are inserted into a binary trie which is compiled into a trie
+ * with 8-bit strides. A lookup reads at most one node per address byte.
+ * Besides the matching value, a lookup returns the scope, the number of
+ * leading address bits which determine the result.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+/*! \brief No matching network. */
+#define LPM_NONE	0
+
+/*! \brief Longest-prefix match table of IPv4 and IPv6 networks. */
+typedef struct lpm lpm_t;
+
+/*!
+ * \brief Creates an empty table.
+ *
+ * \return Table or NULL on error.
+ */
+lpm_t *lpm_new(void);
+
+/*!
+ * \brief Adds a network to the table.
+ *
+ * \param lpm     Table.
+ * \param addr    Network address.
+ * \param prefix  Network prefix length.
+ * \param value   Value returned for the network (not LPM_NONE).
+ *
+ * \retval KNOT_EEXIST if the network is already present.
+ * \return KNOT_E*
+ */
+int lpm_add(lpm_t *lpm, const struct sockaddr *addr, unsigned prefix,
+            uint16_t value);
+
+/*!
+ * \brief Compiles the table for lookups, must be called after the additions.
+ *
+ * \param lpm  Table.
+ *
+ * \return KNOT_E*
+ */
+int lpm_build(lpm_t *lpm);
+
+/*!
+ * \brief Finds the value of the longest network matching the address prefix.
+ *
+ * \param lpm     Built table.
+ * \param family  Address family.
+ * \param addr    Address in network byte order.
+ * \param len     Number of valid leading address bits.
+ * \param scope   Number of leading bits the result depends on (optional).
+ *
+ * \return Value of the matching network or LPM_NONE.
+ */
+uint16_t lpm_lookup(const lpm_t *lpm, int family, const uint8_t *addr,
+                    unsigned len, unsigned *scope);
+
+/*!
+ * \brief Frees the table.
+ *
+ * \param lpm  Table.
+ */
+void lpm_free(lpm_t *lpm);
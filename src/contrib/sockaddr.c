@@ -347,5 +347,14 @@ bool sockaddr_range_match(const struct sockaddr *sa,
 		return false;
 	}
 
-	return sockaddr_cmp(sa, ss_min) >= 0 && sockaddr_cmp(sa, ss_max) <= 0;
+	/* Compare raw addresses in network byte order, ignore ports. */
+	size_t len = 0;
+	const uint8_t *raw = sockaddr_raw(sa, &len);
+	const uint8_t *raw_min = sockaddr_raw(ss_min, &len);
+	const uint8_t *raw_max = sockaddr_raw(ss_max, &len);
+	if (raw == NULL) {
+		return false;
+	}
+
+	return memcmp(raw, raw_min, len) >= 0 && memcmp(raw, raw_max, len) <= 0;
 }
@@ -219,6 +219,21 @@ int dnssec_kasp_zone_list(dnssec_kasp_t *kasp, dnssec_list_t **list);
  */
 int dnssec_kasp_zone_exists(dnssec_kasp_t *kasp, const char *zone_name);
 
+/*!
+ * Get the last modification time of zone data in the KASP.
+ *
+ * \param[in]  kasp       KASP instance.
+ * \param[in]  zone_name  Name of the zone.
+ * \param[out] mtime      Modification time of the zone data.
+ *
+ * \return Error code.
+ * \retval DNSSEC_EOK                    Modification time retrieved.
+ * \retval DNSSEC_NOT_FOUND              Zone doesn't exist.
+ * \retval DNSSEC_NOT_IMPLEMENTED_ERROR  Not supported by the KASP store.
+ */
+int dnssec_kasp_zone_mtime(dnssec_kasp_t *kasp, const char *zone_name,
+			   time_t *mtime);
+
 /*!
  * KASP key timing information.
  */
@@ -391,6 +406,21 @@ int dnssec_kasp_policy_list(dnssec_kasp_t *kasp, dnssec_list_t **list);
  */
 int dnssec_kasp_policy_exists(dnssec_kasp_t *kasp, const char *policy_name);
 
+/*!
+ * Get the last modification time of a policy in the KASP.
+ *
+ * \param[in]  kasp         KASP instance.
+ * \param[in]  policy_name  Name of the policy.
+ * \param[out] mtime        Modification time of the policy.
+ *
+ * \return Error code.
+ * \retval DNSSEC_EOK                    Modification time retrieved.
+ * \retval DNSSEC_NOT_FOUND              Policy doesn't exist.
+ * \retval DNSSEC_NOT_IMPLEMENTED_ERROR  Not supported by the KASP store.
+ */
+int dnssec_kasp_policy_mtime(dnssec_kasp_t *kasp, const char *policy_name,
+			     time_t *mtime);
+
 typedef struct dnssec_kasp_keystore {
 	char *name;
 	char *backend;
@@ -436,12 +466,14 @@ typedef struct dnssec_kasp_store_functions {
 	int (*zone_remove)(void *ctx, const char *zone_name);
 	int (*zone_list)(void *ctx, dnssec_list_t *zone_names);
 	int (*zone_exists)(void *ctx, const char *zone_name);
+	int (*zone_mtime)(void *ctx, const char *zone_name, time_t *mtime);
 	// policy serialization/deserialization
 	int (*policy_load)(void *ctx, dnssec_kasp_policy_t *policy);
 	int (*policy_save)(void *ctx, const dnssec_kasp_policy_t *policy);
 	int (*policy_remove)(void *ctx, const char *name);
 	int (*policy_list)(void *ctx, dnssec_list_t *policy_names);
 	int (*policy_exists)(void *ctx, const char *name);
+	int (*policy_mtime)(void *ctx, const char *name, time_t *mtime);
 	// keystore serialization/deserialization
 	int (*keystore_load)(void *ctx, dnssec_kasp_keystore_t *keystore);
 	int (*keystore_save)(void *ctx, const dnssec_kasp_keystore_t *keystore);
@@ -88,6 +88,34 @@ static int entity_exists(const char *entity, void *_ctx, const char *name)
 	return file_exists(config);
 }
 
+static int entity_mtime(const char *entity, void *_ctx, const char *name,
+			time_t *mtime)
+{
+	assert(entity);
+	assert(_ctx);
+	assert(name);
+	assert(mtime);
+
+	kasp_dir_ctx_t *ctx = _ctx;
+
+	_cleanup_free_ char *config = file_from_entity(ctx->path, entity, name);
+	if (!config) {
+		return DNSSEC_ENOMEM;
+	}
+
+	struct stat st;
+	if (stat(config, &st) != 0) {
+		if (errno == ENOENT) {
+			return DNSSEC_NOT_FOUND;
+		}
+		return dnssec_errno_to_error(errno);
+	}
+
+	*mtime = st.st_mtime;
+
+	return DNSSEC_EOK;
+}
+
 static int entity_list(const char *entity, void *_ctx, dnssec_list_t *names)
 {
 	assert(entity);
@@ -188,6 +216,11 @@ static int kasp_dir_zone_exists(void *ctx, const char *name)
 	return entity_exists(ENTITY_ZONE, ctx, name);
 }
 
+static int kasp_dir_zone_mtime(void *ctx, const char *name, time_t *mtime)
+{
+	return entity_mtime(ENTITY_ZONE, ctx, name, mtime);
+}
+
 static int kasp_dir_zone_list(void *ctx, dnssec_list_t *names)
 {
 	return entity_list(ENTITY_ZONE, ctx, names);
@@ -215,6 +248,11 @@ static int kasp_dir_policy_exists(void *ctx, const char *name)
 	return entity_exists(ENTITY_POLICY, ctx, name);
 }
 
+static int kasp_dir_policy_mtime(void *ctx, const char *name, time_t *mtime)
+{
+	return entity_mtime(ENTITY_POLICY, ctx, name, mtime);
+}
+
 static int kasp_dir_policy_list(void *ctx, dnssec_list_t *names)
 {
 	return entity_list(ENTITY_POLICY, ctx, names);
@@ -275,7 +313,9 @@ const dnssec_kasp_store_functions_t *dnssec_kasp_dir_api(void)
 		.close     = kasp_dir_close,
 		.base_path = kasp_dir_base_path,
 		ENTITY_CALLBACKS(zone),
+		.zone_mtime = kasp_dir_zone_mtime,
 		ENTITY_CALLBACKS(policy),
+		.policy_mtime = kasp_dir_policy_mtime,
 		ENTITY_CALLBACKS(keystore),
 	};
 
@@ -193,6 +193,21 @@ int dnssec_kasp_zone_exists(dnssec_kasp_t *kasp, const char *zone_name)
 	return kasp->functions->zone_exists(kasp->ctx, zone_name);
 }
 
+_public_
+int dnssec_kasp_zone_mtime(dnssec_kasp_t *kasp, const char *zone_name,
+			   time_t *mtime)
+{
+	if (!kasp || !zone_name || !mtime) {
+		return DNSSEC_EINVAL;
+	}
+
+	if (!kasp->functions->zone_mtime) {
+		return DNSSEC_NOT_IMPLEMENTED_ERROR;
+	}
+
+	return kasp->functions->zone_mtime(kasp->ctx, zone_name, mtime);
+}
+
 _public_
 int dnssec_kasp_policy_load(dnssec_kasp_t *kasp, const char *name,
 			    dnssec_kasp_policy_t **policy_ptr)
@@ -270,6 +285,21 @@ int dnssec_kasp_policy_exists(dnssec_kasp_t *kasp, const char *policy_name)
 	return kasp->functions->policy_exists(kasp->ctx, policy_name);
 }
 
+_public_
+int dnssec_kasp_policy_mtime(dnssec_kasp_t *kasp, const char *policy_name,
+			     time_t *mtime)
+{
+	if (!kasp || !policy_name || !mtime) {
+		return DNSSEC_EINVAL;
+	}
+
+	if (!kasp->functions->policy_mtime) {
+		return DNSSEC_NOT_IMPLEMENTED_ERROR;
+	}
+
+	return kasp->functions->policy_mtime(kasp->ctx, policy_name, mtime);
+}
+
 _public_
 int dnssec_kasp_keystore_load(dnssec_kasp_t *kasp, const char *name,
 			     dnssec_kasp_keystore_t **keystore_ptr)
@@ -146,6 +146,17 @@ static int mock_policy_exists(void *ctx, const char *name)
 	return DNSSEC_EOK;
 }
 
+static bool mock_policy_mtime_ok = false;
+static int mock_policy_mtime(void *ctx, const char *name, time_t *mtime)
+{
+	mock_policy_mtime_ok = ctx == MOCK_CTX && streq(name, "edited") && mtime;
+	if (mtime) {
+		*mtime = 7654321;
+	}
+
+	return DNSSEC_EOK;
+}
+
 static bool mock_keystore_load_ok = false;
 static int mock_keystore_load(void *ctx, dnssec_kasp_keystore_t *keystore)
 {
@@ -195,6 +206,17 @@ static int mock_keystore_exists(void *ctx, const char *name)
 	return DNSSEC_EOK;
 }
 
+static bool mock_zone_mtime_ok = false;
+static int mock_zone_mtime(void *ctx, const char *name, time_t *mtime)
+{
+	mock_zone_mtime_ok = ctx == MOCK_CTX && streq(name, "old.name") && mtime;
+	if (mtime) {
+		*mtime = 1234567;
+	}
+
+	return DNSSEC_EOK;
+}
+
 static const dnssec_kasp_store_functions_t MOCK = {
 	.open            = mock_policy_policy_open,
 	.close           = mock_policy_close,
@@ -203,11 +225,13 @@ static const dnssec_kasp_store_functions_t MOCK = {
 	.zone_remove     = mock_zone_remove,
 	.zone_list       = mock_zone_list,
 	.zone_exists     = mock_zone_exists,
+	.zone_mtime      = mock_zone_mtime,
 	.policy_load     = mock_policy_load,
 	.policy_save     = mock_policy_save,
 	.policy_remove   = mock_policy_remove,
 	.policy_list     = mock_policy_list,
 	.policy_exists   = mock_policy_exists,
+	.policy_mtime    = mock_policy_mtime,
 	.keystore_load   = mock_keystore_load,
 	.keystore_save   = mock_keystore_save,
 	.keystore_remove = mock_keystore_remove,
@@ -261,6 +285,14 @@ static void test_zone(dnssec_kasp_t *kasp)
 	r = dnssec_kasp_zone_exists(kasp, "cool.name");
 	ok(r == DNSSEC_EOK, "zone exists, call");
 	ok(mock_zone_exists_ok, "zone exists, input");
+
+	// modification time
+
+	time_t mtime = 0;
+	r = dnssec_kasp_zone_mtime(kasp, "old.name", &mtime);
+	ok(r == DNSSEC_EOK, "zone mtime, call");
+	ok(mock_zone_mtime_ok, "zone mtime, input");
+	ok(mtime == 1234567, "zone mtime, output");
 }
 
 static void test_policy(dnssec_kasp_t *kasp)
@@ -309,6 +341,14 @@ static void test_policy(dnssec_kasp_t *kasp)
 	r = dnssec_kasp_policy_exists(kasp, "superstrict");
 	ok(r == DNSSEC_EOK, "policy exists, call");
 	ok(mock_policy_exists_ok, "policy exists, input");
+
+	// modification time
+
+	time_t mtime = 0;
+	r = dnssec_kasp_policy_mtime(kasp, "edited", &mtime);
+	ok(r == DNSSEC_EOK, "policy mtime, call");
+	ok(mock_policy_mtime_ok, "policy mtime, input");
+	ok(mtime == 7654321, "policy mtime, output");
 }
 
 static void test_keystore(dnssec_kasp_t *kasp)
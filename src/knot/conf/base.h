@@ -108,8 +108,8 @@ typedef struct {
 		int32_t srv_max_tcp_clients;
 		int32_t srv_rate_limit_slip;
 		int32_t ctl_timeout;
+		bool srv_cookies;
 		conf_val_t srv_nsid;
-		conf_val_t srv_rate_limit_whitelist;
 	} cache;
 
 	/*! List of active query modules. */
@@ -703,6 +703,44 @@ bool conf_addr_range_match(
 	return false;
 }
 
+addrset_t *conf_addr_set(
+	conf_val_t *range)
+{
+	if (range == NULL) {
+		return NULL;
+	}
+
+	addrset_t *set = addrset_new();
+	if (set == NULL) {
+		return NULL;
+	}
+
+	while (range->code == KNOT_EOK) {
+		int mask;
+		struct sockaddr_storage min, max;
+
+		int ret;
+		min = conf_addr_range(range, &max, &mask);
+		if (max.ss_family == AF_UNSPEC) {
+			ret = addrset_add_net(set, (struct sockaddr *)&min,
+			                      (mask < 0) ? IPV6_PREFIXLEN : mask);
+		} else {
+			ret = addrset_add_range(set, (struct sockaddr *)&min,
+			                        (struct sockaddr *)&max);
+		}
+		if (ret != KNOT_EOK) {
+			addrset_free(set);
+			return NULL;
+		}
+
+		conf_val_next(range);
+	}
+
+	addrset_build(set);
+
+	return set;
+}
+
 char* conf_abs_path(
 	conf_val_t *val,
 	const char *base_dir)
@@ -29,6 +29,7 @@
 
 #include "knot/conf/base.h"
 #include "knot/conf/scheme.h"
+#include "contrib/addrset.h"
 
 #define CONF_XFERS	10
 
@@ -515,6 +516,17 @@ bool conf_addr_range_match(
 	const struct sockaddr_storage *addr
 );
 
+/*!
+ * Compiles address ranges/network blocks into an address set.
+ *
+ * \param[in] range  Address range/network block.
+ *
+ * \return Built address set (empty if no value) or NULL on error.
+ */
+addrset_t *conf_addr_set(
+	conf_val_t *range
+);
+
 /*!
  * Gets the absolute string value of the item.
  *
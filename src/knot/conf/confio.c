@@ -814,6 +814,10 @@ static void upd_changes(
 		if (flags & CONF_IO_FRLD_ZONE) {
 			conf()->io.flags |= CONF_IO_FRLD_ZONES;
 		}
+		// Recompile just with query config changes.
+		if (flags & CONF_IO_FRLD_CACHE) {
+			conf()->io.flags |= CONF_IO_FRLD_CACHES;
+		}
 		return;
 	}
 
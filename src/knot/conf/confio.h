@@ -38,6 +38,8 @@
 #define CONF_IO_FRLD_MOD	YP_FUSR8  /*!< Reload global modules. */
 #define CONF_IO_FRLD_ZONE	YP_FUSR9  /*!< Reload a specific zone. */
 #define CONF_IO_FRLD_ZONES	YP_FUSR10 /*!< Reload all zones. */
+#define CONF_IO_FRLD_CACHE	YP_FUSR11 /*!< Recompile a specific zone query config. */
+#define CONF_IO_FRLD_CACHES	YP_FUSR12 /*!< Recompile all zones query config. */
 #define CONF_IO_FRLD_ALL	(CONF_IO_FRLD_SRV | CONF_IO_FRLD_LOG | \
 				 CONF_IO_FRLD_MOD | CONF_IO_FRLD_ZONES)
 
@@ -23,6 +23,7 @@
 #include "knot/conf/confio.h"
 #include "knot/conf/tools.h"
 #include "knot/common/log.h"
+#include "knot/server/numa.h"
 #include "knot/server/rrl.h"
 #include "knot/updates/acl.h"
 #include "libknot/rrtype/opt.h"
@@ -40,11 +41,13 @@
 #endif
 #include "knot/modules/whoami/whoami.h"
 #include "knot/modules/noudp/noudp.h"
+#include "knot/modules/subnet_view/subnet_view.h"
 
 #define HOURS(x)	((x) * 3600)
 #define DAYS(x)		((x) * HOURS(24))
 
 #define FMOD		(YP_FMULTI | CONF_IO_FRLD_MOD | CONF_IO_FRLD_ZONES)
+#define FCACHES		(YP_FMULTI | CONF_IO_FRLD_CACHES)
 
 static const knot_lookup_t keystore_backends[] = {
 	{ KEYSTORE_BACKEND_PEM,    "pem" },
@@ -87,6 +90,13 @@ static const knot_lookup_t serial_policies[] = {
 	{ 0, NULL }
 };
 
+static const knot_lookup_t thread_placements[] = {
+	{ NUMA_PLACEMENT_NONE,   "none" },
+	{ NUMA_PLACEMENT_LINEAR, "linear" },
+	{ NUMA_PLACEMENT_NUMA,   "numa" },
+	{ 0, NULL }
+};
+
 static const knot_lookup_t log_severities[] = {
 	{ LOG_UPTO(LOG_CRIT),    "critical" },
 	{ LOG_UPTO(LOG_ERR),     "error" },
@@ -107,6 +117,7 @@ static const yp_item_t desc_server[] = {
 	{ C_UDP_WORKERS,          YP_TINT,  YP_VINT = { 1, 255, YP_NIL } },
 	{ C_TCP_WORKERS,          YP_TINT,  YP_VINT = { 1, 255, YP_NIL } },
 	{ C_BG_WORKERS,           YP_TINT,  YP_VINT = { 1, 255, YP_NIL } },
+	{ C_THREAD_PLACEMENT,     YP_TOPT,  YP_VOPT = { thread_placements, NUMA_PLACEMENT_NUMA } },
 	{ C_ASYNC_START,          YP_TBOOL, YP_VNONE },
 	{ C_TCP_HSHAKE_TIMEOUT,   YP_TINT,  YP_VINT = { 0, INT32_MAX, 5, YP_STIME } },
 	{ C_TCP_IDLE_TIMEOUT,     YP_TINT,  YP_VINT = { 0, INT32_MAX, 20, YP_STIME } },
@@ -121,11 +132,16 @@ static const yp_item_t desc_server[] = {
 	{ C_MAX_IPV6_UDP_PAYLOAD, YP_TINT,  YP_VINT = { KNOT_EDNS_MIN_UDP_PAYLOAD,
 	                                                KNOT_EDNS_MAX_UDP_PAYLOAD,
 	                                                4096, YP_SSIZE } },
+	{ C_UDP_GRO,              YP_TBOOL, YP_VNONE },
 	{ C_RATE_LIMIT,           YP_TINT,  YP_VINT = { 0, INT32_MAX, 0 } },
 	{ C_RATE_LIMIT_SLIP,      YP_TINT,  YP_VINT = { 0, RRL_SLIP_MAX, 1 } },
 	{ C_RATE_LIMIT_TBL_SIZE,  YP_TINT,  YP_VINT = { 1, INT32_MAX, 393241 } },
 	{ C_RATE_LIMIT_WHITELIST, YP_TDATA, YP_VDATA = { 0, NULL, addr_range_to_bin,
 	                                                 addr_range_to_txt }, YP_FMULTI },
+	{ C_COOKIES,              YP_TBOOL, YP_VNONE },
+	{ C_COOKIE_LIFETIME,      YP_TINT,  YP_VINT = { 1, INT32_MAX / 1000, 93600, YP_STIME } },
+	{ C_JOURNAL_SYNC_LATENCY, YP_TINT,  YP_VINT = { -1, 60000, -1 } },
+	{ C_DDNS_BATCH_WINDOW,    YP_TINT,  YP_VINT = { 0, 60000, 0 } },
 	{ C_LISTEN,               YP_TADDR, YP_VADDR = { 53 }, YP_FMULTI },
 	{ C_COMMENT,              YP_TSTR,  YP_VNONE },
 	{ NULL }
@@ -134,6 +150,7 @@ static const yp_item_t desc_server[] = {
 static const yp_item_t desc_control[] = {
 	{ C_LISTEN,  YP_TSTR, YP_VSTR = { "knot.sock" } },
 	{ C_TIMEOUT, YP_TINT, YP_VINT = { 0, INT32_MAX / 1000, 5, YP_STIME } },
+	{ C_WORKERS, YP_TINT, YP_VINT = { 1, 255, 4 } },
 	{ C_COMMENT, YP_TSTR, YP_VNONE },
 	{ NULL }
 };
@@ -190,8 +207,9 @@ static const yp_item_t desc_policy[] = {
 
 static const yp_item_t desc_key[] = {
 	{ C_ID,      YP_TDNAME, YP_VNONE },
-	{ C_ALG,     YP_TOPT,   YP_VOPT = { tsig_key_algs, DNSSEC_TSIG_UNKNOWN } },
-	{ C_SECRET,  YP_TB64,   YP_VNONE },
+	{ C_ALG,     YP_TOPT,   YP_VOPT = { tsig_key_algs, DNSSEC_TSIG_UNKNOWN },
+	                        CONF_IO_FRLD_CACHES },
+	{ C_SECRET,  YP_TB64,   YP_VNONE, CONF_IO_FRLD_CACHES },
 	{ C_COMMENT, YP_TSTR,   YP_VNONE },
 	{ NULL }
 };
@@ -199,33 +217,34 @@ static const yp_item_t desc_key[] = {
 static const yp_item_t desc_acl[] = {
 	{ C_ID,      YP_TSTR,  YP_VNONE, CONF_IO_FREF },
 	{ C_ADDR,    YP_TDATA, YP_VDATA = { 0, NULL, addr_range_to_bin,
-	                                    addr_range_to_txt }, YP_FMULTI },
-	{ C_KEY,     YP_TREF,  YP_VREF = { C_KEY }, YP_FMULTI, { check_ref } },
-	{ C_ACTION,  YP_TOPT,  YP_VOPT = { acl_actions, ACL_ACTION_NONE }, YP_FMULTI },
-	{ C_DENY,    YP_TBOOL, YP_VNONE },
+	                                    addr_range_to_txt }, FCACHES },
+	{ C_KEY,     YP_TREF,  YP_VREF = { C_KEY }, FCACHES, { check_ref } },
+	{ C_ACTION,  YP_TOPT,  YP_VOPT = { acl_actions, ACL_ACTION_NONE }, FCACHES },
+	{ C_DENY,    YP_TBOOL, YP_VNONE, CONF_IO_FRLD_CACHES },
 	{ C_COMMENT, YP_TSTR,  YP_VNONE },
 	{ NULL }
 };
 
 static const yp_item_t desc_remote[] = {
 	{ C_ID,      YP_TSTR,  YP_VNONE, CONF_IO_FREF },
-	{ C_ADDR,    YP_TADDR, YP_VADDR = { 53 }, YP_FMULTI },
-	{ C_VIA,     YP_TADDR, YP_VNONE, YP_FMULTI },
-	{ C_KEY,     YP_TREF,  YP_VREF = { C_KEY }, YP_FNONE, { check_ref } },
+	{ C_ADDR,    YP_TADDR, YP_VADDR = { 53 }, FCACHES },
+	{ C_VIA,     YP_TADDR, YP_VNONE, FCACHES },
+	{ C_KEY,     YP_TREF,  YP_VREF = { C_KEY }, CONF_IO_FRLD_CACHES, { check_ref } },
 	{ C_COMMENT, YP_TSTR,  YP_VNONE },
 	{ NULL }
 };
 
-#define ZONE_ITEMS(FLAGS) \
+#define ZONE_ITEMS(FLAGS, CACHE_FLAGS) \
 	{ C_STORAGE,             YP_TSTR,  YP_VSTR = { STORAGE_DIR }, FLAGS }, \
 	{ C_FILE,                YP_TSTR,  YP_VNONE, FLAGS }, \
 	{ C_JOURNAL,             YP_TSTR,  YP_VNONE, FLAGS }, \
 	{ C_MASTER,              YP_TREF,  YP_VREF = { C_RMT }, YP_FMULTI, { check_ref } }, \
 	{ C_DDNS_MASTER,         YP_TREF,  YP_VREF = { C_RMT }, YP_FNONE, { check_ref } }, \
 	{ C_NOTIFY,              YP_TREF,  YP_VREF = { C_RMT }, YP_FMULTI, { check_ref } }, \
-	{ C_ACL,                 YP_TREF,  YP_VREF = { C_ACL }, YP_FMULTI, { check_ref } }, \
+	{ C_ACL,                 YP_TREF,  YP_VREF = { C_ACL }, YP_FMULTI | CACHE_FLAGS, \
+	                                   { check_ref } }, \
 	{ C_SEM_CHECKS,          YP_TBOOL, YP_VNONE, FLAGS }, \
-	{ C_DISABLE_ANY,         YP_TBOOL, YP_VNONE }, \
+	{ C_DISABLE_ANY,         YP_TBOOL, YP_VNONE, CACHE_FLAGS }, \
 	{ C_ZONEFILE_SYNC,       YP_TINT,  YP_VINT = { -1, INT32_MAX, 0, YP_STIME } }, \
 	{ C_IXFR_DIFF,           YP_TBOOL, YP_VNONE }, \
 	{ C_MAX_JOURNAL_SIZE,    YP_TINT,  YP_VINT = { 0, INT64_MAX, INT64_MAX, YP_SSIZE }, \
@@ -243,7 +262,7 @@ static const yp_item_t desc_remote[] = {
 
 static const yp_item_t desc_template[] = {
 	{ C_ID, YP_TSTR, YP_VNONE, CONF_IO_FREF },
-	ZONE_ITEMS(CONF_IO_FRLD_ZONES)
+	ZONE_ITEMS(CONF_IO_FRLD_ZONES, CONF_IO_FRLD_CACHES)
 	{ C_TIMER_DB,            YP_TSTR,  YP_VSTR = { "timers" }, CONF_IO_FRLD_ZONES }, \
 	{ C_GLOBAL_MODULE,       YP_TDATA, YP_VDATA = { 0, NULL, mod_id_to_bin, mod_id_to_txt }, \
 	                                   YP_FMULTI | CONF_IO_FRLD_MOD, { check_modref } }, \
@@ -253,7 +272,7 @@ static const yp_item_t desc_template[] = {
 static const yp_item_t desc_zone[] = {
 	{ C_DOMAIN, YP_TDNAME, YP_VNONE, CONF_IO_FRLD_ZONE },
 	{ C_TPL,    YP_TREF,   YP_VREF = { C_TPL }, CONF_IO_FRLD_ZONE, { check_ref } },
-	ZONE_ITEMS(CONF_IO_FRLD_ZONE)
+	ZONE_ITEMS(CONF_IO_FRLD_ZONE, CONF_IO_FRLD_CACHE)
 	{ NULL }
 };
 
@@ -282,6 +301,8 @@ const yp_item_t conf_scheme[] = {
 	{ C_MOD_ONLINE_SIGN,  YP_TGRP, YP_VGRP = { scheme_mod_online_sign }, FMOD },
 	{ C_MOD_WHOAMI,       YP_TGRP, YP_VGRP = { scheme_mod_whoami }, FMOD },
 	{ C_MOD_NOUDP,        YP_TGRP, YP_VGRP = { scheme_mod_noudp }, FMOD },
+	{ C_MOD_SUBNET_VIEW,  YP_TGRP, YP_VGRP = { scheme_mod_subnet_view }, FMOD,
+	                               { check_mod_subnet_view } },
 /***********/
 	{ C_TPL,  YP_TGRP, YP_VGRP = { desc_template }, YP_FMULTI, { check_template } },
 	{ C_ZONE, YP_TGRP, YP_VGRP = { desc_zone }, YP_FMULTI | CONF_IO_FZONE, { check_zone } },
@@ -38,7 +38,10 @@
 #define C_BG_WORKERS		"\x12""background-workers"
 #define C_COMMENT		"\x07""comment"
 #define C_CONFIG		"\x06""config"
+#define C_COOKIES		"\x07""cookies"
+#define C_COOKIE_LIFETIME	"\x16""cookie-secret-lifetime"
 #define C_CTL			"\x07""control"
+#define C_DDNS_BATCH_WINDOW	"\x11""ddns-batch-window"
 #define C_DDNS_MASTER		"\x0B""ddns-master"
 #define C_DENY			"\x04""deny"
 #define C_DISABLE_ANY		"\x0B""disable-any"
@@ -53,6 +56,7 @@
 #define C_INCL			"\x07""include"
 #define C_IXFR_DIFF		"\x15""ixfr-from-differences"
 #define C_JOURNAL		"\x07""journal"
+#define C_JOURNAL_SYNC_LATENCY	"\x14""journal-sync-latency"
 #define C_KASP_DB		"\x07""kasp-db"
 #define C_KEY			"\x03""key"
 #define C_KEYSTORE		"\x08""keystore"
@@ -97,13 +101,16 @@
 #define C_TCP_IDLE_TIMEOUT	"\x10""tcp-idle-timeout"
 #define C_TCP_REPLY_TIMEOUT	"\x11""tcp-reply-timeout"
 #define C_TCP_WORKERS		"\x0B""tcp-workers"
+#define C_THREAD_PLACEMENT	"\x10""thread-placement"
 #define C_TIMEOUT		"\x07""timeout"
 #define C_TIMER_DB		"\x08""timer-db"
 #define C_TPL			"\x08""template"
+#define C_UDP_GRO		"\x07""udp-gro"
 #define C_UDP_WORKERS		"\x0B""udp-workers"
 #define C_USER			"\x04""user"
 #define C_VERSION		"\x07""version"
 #define C_VIA			"\x03""via"
+#define C_WORKERS		"\x07""workers"
 #define C_ZONE			"\x04""zone"
 #define C_ZONEFILE_SYNC		"\x0D""zonefile-sync"
 #define C_ZSK_LIFETIME		"\x0C""zsk-lifetime"
@@ -16,10 +16,12 @@
 
 #include <string.h>
 #include <unistd.h>
+#include <urcu.h>
 
 #include "knot/common/log.h"
 #include "knot/conf/confio.h"
 #include "knot/ctl/commands.h"
+#include "knot/dnssec/key-cache.h"
 #include "knot/events/handlers.h"
 #include "knot/updates/zone-update.h"
 #include "knot/zone/timers.h"
@@ -101,11 +103,29 @@ static int get_zone(ctl_args_t *args, zone_t **zone)
 	return KNOT_EOK;
 }
 
-static int zones_apply(ctl_args_t *args, int (*fcn)(zone_t *, ctl_args_t *))
+typedef int (*zone_fcn_t)(zone_t *, ctl_args_t *);
+
+static int zone_apply(zone_t *zone, ctl_args_t *args, zone_fcn_t fcn, bool txn)
+{
+	// Serialize zone transaction commands from concurrent clients.
+	if (txn) {
+		pthread_mutex_lock(&zone->control_lock);
+	}
+
+	int ret = fcn(zone, args);
+
+	if (txn) {
+		pthread_mutex_unlock(&zone->control_lock);
+	}
+
+	return ret;
+}
+
+static int zones_apply(ctl_args_t *args, zone_fcn_t fcn, bool txn)
 {
 	// Process all configured zones if none is specified.
 	if (args->data[KNOT_CTL_IDX_ZONE] == NULL) {
-		knot_zonedb_foreach(args->server->zone_db, fcn, args);
+		knot_zonedb_foreach(args->server->zone_db, zone_apply, args, fcn, txn);
 		return KNOT_EOK;
 	}
 
@@ -115,7 +135,7 @@ static int zones_apply(ctl_args_t *args, int (*fcn)(zone_t *, ctl_args_t *))
 		zone_t *zone;
 		ret = get_zone(args, &zone);
 		if (ret == KNOT_EOK) {
-			ret = fcn(zone, args);
+			ret = zone_apply(zone, args, fcn, txn);
 		}
 		if (ret != KNOT_EOK) {
 			log_ctl_zone_str_error(args->data[KNOT_CTL_IDX_ZONE],
@@ -164,13 +184,16 @@ static int zone_status(zone_t *zone, ctl_args_t *args)
 	data[KNOT_CTL_IDX_TYPE] = "serial";
 
 	char buff[128];
-	if (zone->contents != NULL) {
-		knot_rdataset_t *soa = node_rdataset(zone->contents->apex,
+	rcu_read_lock();
+	zone_contents_t *contents = rcu_dereference(zone->contents);
+	if (contents != NULL) {
+		knot_rdataset_t *soa = node_rdataset(contents->apex,
 		                                     KNOT_RRTYPE_SOA);
 		ret = snprintf(buff, sizeof(buff), "%u", knot_soa_serial(soa));
 	} else {
 		ret = snprintf(buff, sizeof(buff), "none");
 	}
+	rcu_read_unlock();
 	if (ret < 0 || ret >= sizeof(buff)) {
 		return KNOT_ESPACE;
 	}
@@ -309,12 +332,28 @@ static int zone_sign(zone_t *zone, ctl_args_t *args)
 		return KNOT_ENOTSUP;
 	}
 
+	kdnssec_cache_invalidate(zone->dnssec_cache);
 	zone->flags |= ZONE_FORCE_RESIGN;
 	zone_events_schedule(zone, ZONE_EVENT_DNSSEC, ZONE_EVENT_NOW);
 
 	return KNOT_EOK;
 }
 
+static int zone_keys_load(zone_t *zone, ctl_args_t *args)
+{
+	UNUSED(args);
+
+	conf_val_t val = conf_zone_get(conf(), C_DNSSEC_SIGNING, zone->name);
+	if (!conf_bool(&val)) {
+		return KNOT_ENOTSUP;
+	}
+
+	kdnssec_cache_invalidate(zone->dnssec_cache);
+	zone_events_schedule(zone, ZONE_EVENT_DNSSEC, ZONE_EVENT_NOW);
+
+	return KNOT_EOK;
+}
+
 static int zone_txn_begin(zone_t *zone, ctl_args_t *args)
 {
 	UNUSED(args);
@@ -492,6 +531,87 @@ static int send_node(zone_node_t *node, void *ctx_void)
 	return KNOT_EOK;
 }
 
+typedef struct {
+	ctl_args_t *args;
+	int type_filter; // -1: no specific type, [0, 2^16]: specific type.
+	size_t len;
+	uint8_t wire[CTL_BULK_SIZE];
+} bulk_ctx_t;
+
+static bulk_ctx_t *create_bulk_ctx(ctl_args_t *args, int type_filter)
+{
+	bulk_ctx_t *ctx = mm_alloc(&args->mm, sizeof(*ctx));
+	if (ctx == NULL) {
+		return NULL;
+	}
+
+	ctx->args = args;
+	ctx->type_filter = type_filter;
+	ctx->len = 0;
+
+	return ctx;
+}
+
+static int bulk_flush(bulk_ctx_t *ctx)
+{
+	if (ctx->len == 0) {
+		return KNOT_EOK;
+	}
+
+	int ret = knot_ctl_send_bulk(ctx->args->ctl, ctx->wire, ctx->len);
+	ctx->len = 0;
+
+	return ret;
+}
+
+static int bulk_rrset(const knot_rrset_t *rrset, bulk_ctx_t *ctx)
+{
+	for (uint16_t i = 0; i < rrset->rrs.rr_count; i++) {
+		// Single record view of the RRset.
+		knot_rrset_t rr = *rrset;
+		rr.rrs.rr_count = 1;
+		rr.rrs.data = knot_rdataset_at(&rrset->rrs, i);
+
+		size_t avail = MIN(sizeof(ctx->wire) - ctx->len, UINT16_MAX);
+		int ret = knot_rrset_to_wire(&rr, ctx->wire + ctx->len, avail, NULL);
+		if (ret == KNOT_ESPACE && ctx->len > 0) {
+			ret = bulk_flush(ctx);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
+			avail = MIN(sizeof(ctx->wire), UINT16_MAX);
+			ret = knot_rrset_to_wire(&rr, ctx->wire, avail, NULL);
+		}
+		if (ret < 0) {
+			return ret;
+		}
+		ctx->len += ret;
+	}
+
+	return KNOT_EOK;
+}
+
+static int bulk_node(zone_node_t *node, void *ctx_void)
+{
+	bulk_ctx_t *ctx = ctx_void;
+
+	for (size_t i = 0; i < node->rrset_count; ++i) {
+		knot_rrset_t rrset = node_rrset_at(node, i);
+
+		// Check for requested TYPE.
+		if (ctx->type_filter != -1 && rrset.type != ctx->type_filter) {
+			continue;
+		}
+
+		int ret = bulk_rrset(&rrset, ctx);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
 static int get_owner(uint8_t *out, size_t out_len, knot_dname_t *origin,
                      ctl_args_t *args)
 {
@@ -539,8 +659,65 @@ static int get_owner(uint8_t *out, size_t out_len, knot_dname_t *origin,
 	return KNOT_EOK;
 }
 
+static int zone_read_bulk(zone_t *zone, ctl_args_t *args)
+{
+	int type_filter = -1;
+	if (args->data[KNOT_CTL_IDX_TYPE] != NULL) {
+		uint16_t type;
+		if (knot_rrtype_from_string(args->data[KNOT_CTL_IDX_TYPE], &type) != 0) {
+			return KNOT_EINVAL;
+		}
+		type_filter = type;
+	}
+
+	bulk_ctx_t *ctx = create_bulk_ctx(args, type_filter);
+	if (ctx == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+
+	// Pin the contents, sending can block on a slow client.
+	zone_contents_t *contents = zone_contents_pin(zone);
+
+	if (args->data[KNOT_CTL_IDX_OWNER] != NULL) {
+		uint8_t owner[KNOT_DNAME_MAXLEN];
+
+		ret = get_owner(owner, sizeof(owner), zone->name, args);
+		if (ret != KNOT_EOK) {
+			goto zone_read_bulk_failed;
+		}
+
+		const zone_node_t *node = zone_contents_find_node(contents, owner);
+		if (node == NULL) {
+			ret = KNOT_ENONODE;
+			goto zone_read_bulk_failed;
+		}
+
+		ret = bulk_node((zone_node_t *)node, ctx);
+	} else if (contents != NULL) {
+		ret = zone_contents_apply(contents, bulk_node, ctx);
+	}
+
+	if (ret == KNOT_EOK) {
+		ret = bulk_flush(ctx);
+	}
+
+zone_read_bulk_failed:
+	if (contents != NULL) {
+		zone_contents_unpin(zone);
+	}
+	mm_free(&args->mm, ctx);
+
+	return ret;
+}
+
 static int zone_read(zone_t *zone, ctl_args_t *args)
 {
+	if (ctl_has_flag(args->data[KNOT_CTL_IDX_FLAGS], CTL_FLAG_BULK)) {
+		return zone_read_bulk(zone, args);
+	}
+
 	send_ctx_t *ctx = create_send_ctx(zone->name, args);
 	if (ctx == NULL) {
 		return KNOT_ENOMEM;
@@ -548,6 +725,9 @@ static int zone_read(zone_t *zone, ctl_args_t *args)
 
 	int ret = KNOT_EOK;
 
+	// Pin the contents, sending can block on a slow client.
+	zone_contents_t *contents = zone_contents_pin(zone);
+
 	if (args->data[KNOT_CTL_IDX_OWNER] != NULL) {
 		uint8_t owner[KNOT_DNAME_MAXLEN];
 
@@ -556,18 +736,21 @@ static int zone_read(zone_t *zone, ctl_args_t *args)
 			goto zone_read_failed;
 		}
 
-		const zone_node_t *node = zone_contents_find_node(zone->contents, owner);
+		const zone_node_t *node = zone_contents_find_node(contents, owner);
 		if (node == NULL) {
 			ret = KNOT_ENONODE;
 			goto zone_read_failed;
 		}
 
 		ret = send_node((zone_node_t *)node, ctx);
-	} else if (zone->contents != NULL) {
-		ret = zone_contents_apply(zone->contents, send_node, ctx);
+	} else if (contents != NULL) {
+		ret = zone_contents_apply(contents, send_node, ctx);
 	}
 
 zone_read_failed:
+	if (contents != NULL) {
+		zone_contents_unpin(zone);
+	}
 	mm_free(&args->mm, ctx);
 
 	return ret;
@@ -833,12 +1016,110 @@ parser_failed:
 	return ret;
 }
 
+static int bulk_add(zone_t *zone, knot_rrset_t *rrset)
+{
+	if (knot_rrset_empty(rrset)) {
+		return KNOT_EOK;
+	}
+
+	int ret = zone_update_add(zone->control_update, rrset);
+	knot_rrset_clear(rrset, NULL);
+
+	// Silently update TTL.
+	if (ret == KNOT_ETTL) {
+		ret = KNOT_EOK;
+	}
+
+	return ret;
+}
+
+static int bulk_parse(zone_t *zone, const uint8_t *wire, size_t len,
+                      knot_rrset_t *rrset)
+{
+	size_t pos = 0;
+	while (pos < len) {
+		knot_rrset_t rr;
+		int ret = knot_rrset_rr_from_wire(wire, &pos, len, NULL, &rr, true);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		if (!knot_dname_in(zone->name, rr.owner)) {
+			knot_rrset_clear(&rr, NULL);
+			return KNOT_EOUTOFZONE;
+		}
+
+		// Merge consecutive records of the same RRset.
+		if (!knot_rrset_empty(rrset) && rrset->type == rr.type &&
+		    knot_dname_is_equal(rrset->owner, rr.owner)) {
+			ret = knot_rdataset_merge(&rrset->rrs, &rr.rrs, NULL);
+			knot_rrset_clear(&rr, NULL);
+		} else {
+			ret = bulk_add(zone, rrset);
+			*rrset = rr;
+		}
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static int zone_txn_set_bulk(zone_t *zone, ctl_args_t *args)
+{
+	// The stream belongs to one explicitly specified zone.
+	if (args->data[KNOT_CTL_IDX_ZONE] == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_rrset_t rrset;
+	knot_rrset_init_empty(&rrset);
+
+	// Process bulk units until the empty one.
+	int ret = KNOT_EOK;
+	while (true) {
+		knot_ctl_type_t type;
+		int recv_ret = knot_ctl_receive(args->ctl, &type, NULL);
+		if (recv_ret != KNOT_EOK) {
+			ret = recv_ret;
+			break;
+		}
+
+		size_t len = 0;
+		const uint8_t *wire = knot_ctl_bulk(args->ctl, &len);
+		if (type != KNOT_CTL_TYPE_BULK || wire == NULL) {
+			ret = KNOT_EMALF;
+			break;
+		}
+		if (len == 0) {
+			break;
+		}
+
+		// Skip the rest of the records after an error.
+		if (ret == KNOT_EOK) {
+			ret = bulk_parse(zone, wire, len, &rrset);
+		}
+	}
+
+	if (ret == KNOT_EOK) {
+		ret = bulk_add(zone, &rrset);
+	}
+	knot_rrset_clear(&rrset, NULL);
+
+	return ret;
+}
+
 static int zone_txn_set(zone_t *zone, ctl_args_t *args)
 {
 	if (zone->control_update == NULL) {
 		return KNOT_TXN_ENOTEXISTS;
 	}
 
+	if (ctl_has_flag(args->data[KNOT_CTL_IDX_FLAGS], CTL_FLAG_BULK)) {
+		return zone_txn_set_bulk(zone, args);
+	}
+
 	if (args->data[KNOT_CTL_IDX_OWNER] == NULL ||
 	    args->data[KNOT_CTL_IDX_TYPE]  == NULL) {
 		return KNOT_EINVAL;
@@ -931,7 +1212,8 @@ static int zone_purge(zone_t *zone, ctl_args_t *args)
 	(void)unlink(journalfile);
 	free(journalfile);
 
-	// Purge the zone timers.
+	// Purge the zone timers (pending changes are written first).
+	(void)timers_writer_flush(args->server->timers);
 	(void)remove_timer_db(args->server->timers_db, args->server->zone_db,
 	                      zone->name);
 
@@ -942,35 +1224,37 @@ static int ctl_zone(ctl_args_t *args, ctl_cmd_t cmd)
 {
 	switch (cmd) {
 	case CTL_ZONE_STATUS:
-		return zones_apply(args, zone_status);
+		return zones_apply(args, zone_status, false);
 	case CTL_ZONE_RELOAD:
-		return zones_apply(args, zone_reload);
+		return zones_apply(args, zone_reload, false);
 	case CTL_ZONE_REFRESH:
-		return zones_apply(args, zone_refresh);
+		return zones_apply(args, zone_refresh, false);
 	case CTL_ZONE_RETRANSFER:
-		return zones_apply(args, zone_retransfer);
+		return zones_apply(args, zone_retransfer, false);
 	case CTL_ZONE_FLUSH:
-		return zones_apply(args, zone_flush);
+		return zones_apply(args, zone_flush, false);
 	case CTL_ZONE_SIGN:
-		return zones_apply(args, zone_sign);
+		return zones_apply(args, zone_sign, false);
+	case CTL_ZONE_KEYS_LOAD:
+		return zones_apply(args, zone_keys_load, false);
 	case CTL_ZONE_READ:
-		return zones_apply(args, zone_read);
+		return zones_apply(args, zone_read, false);
 	case CTL_ZONE_BEGIN:
-		return zones_apply(args, zone_txn_begin);
+		return zones_apply(args, zone_txn_begin, true);
 	case CTL_ZONE_COMMIT:
-		return zones_apply(args, zone_txn_commit);
+		return zones_apply(args, zone_txn_commit, true);
 	case CTL_ZONE_ABORT:
-		return zones_apply(args, zone_txn_abort);
+		return zones_apply(args, zone_txn_abort, true);
 	case CTL_ZONE_DIFF:
-		return zones_apply(args, zone_txn_diff);
+		return zones_apply(args, zone_txn_diff, true);
 	case CTL_ZONE_GET:
-		return zones_apply(args, zone_txn_get);
+		return zones_apply(args, zone_txn_get, true);
 	case CTL_ZONE_SET:
-		return zones_apply(args, zone_txn_set);
+		return zones_apply(args, zone_txn_set, true);
 	case CTL_ZONE_UNSET:
-		return zones_apply(args, zone_txn_unset);
+		return zones_apply(args, zone_txn_unset, true);
 	case CTL_ZONE_PURGE:
-		return zones_apply(args, zone_purge);
+		return zones_apply(args, zone_purge, true);
 	default:
 		assert(0);
 		return KNOT_EINVAL;
@@ -1255,44 +1539,53 @@ static int ctl_conf_modify(ctl_args_t *args, ctl_cmd_t cmd)
 	return ret;
 }
 
+/*! Locking of a command with respect to concurrent control clients. */
+typedef enum {
+	LOCK_SHARED,    /*!< Runs concurrently with other commands. */
+	LOCK_CONF,      /*!< Shared, serialized with configuration commands. */
+	LOCK_EXCLUSIVE, /*!< Replaces the server configuration and zones. */
+} lock_t;
+
 typedef struct {
 	const char *name;
 	int (*fcn)(ctl_args_t *, ctl_cmd_t);
+	lock_t lock;
 } desc_t;
 
 static const desc_t cmd_table[] = {
 	[CTL_NONE]            = { "" },
 
-	[CTL_STATUS]          = { "status",          ctl_server },
-	[CTL_STOP]            = { "stop",            ctl_server },
-	[CTL_RELOAD]          = { "reload",          ctl_server },
-
-	[CTL_ZONE_STATUS]     = { "zone-status",     ctl_zone },
-	[CTL_ZONE_RELOAD]     = { "zone-reload",     ctl_zone },
-	[CTL_ZONE_REFRESH]    = { "zone-refresh",    ctl_zone },
-	[CTL_ZONE_RETRANSFER] = { "zone-retransfer", ctl_zone },
-	[CTL_ZONE_FLUSH]      = { "zone-flush",      ctl_zone },
-	[CTL_ZONE_SIGN]       = { "zone-sign",       ctl_zone },
-
-	[CTL_ZONE_READ]       = { "zone-read",       ctl_zone },
-	[CTL_ZONE_BEGIN]      = { "zone-begin",      ctl_zone },
-	[CTL_ZONE_COMMIT]     = { "zone-commit",     ctl_zone },
-	[CTL_ZONE_ABORT]      = { "zone-abort",      ctl_zone },
-	[CTL_ZONE_DIFF]       = { "zone-diff",       ctl_zone },
-	[CTL_ZONE_GET]        = { "zone-get",        ctl_zone },
-	[CTL_ZONE_SET]        = { "zone-set",        ctl_zone },
-	[CTL_ZONE_UNSET]      = { "zone-unset",      ctl_zone },
-	[CTL_ZONE_PURGE]      = { "zone-purge",      ctl_zone },
-
-	[CTL_CONF_LIST]       = { "conf-list",       ctl_conf_read },
-	[CTL_CONF_READ]       = { "conf-read",       ctl_conf_read },
-	[CTL_CONF_BEGIN]      = { "conf-begin",      ctl_conf_txn },
-	[CTL_CONF_COMMIT]     = { "conf-commit",     ctl_conf_txn },
-	[CTL_CONF_ABORT]      = { "conf-abort",      ctl_conf_txn },
-	[CTL_CONF_DIFF]       = { "conf-diff",       ctl_conf_read },
-	[CTL_CONF_GET]        = { "conf-get",        ctl_conf_read },
-	[CTL_CONF_SET]        = { "conf-set",        ctl_conf_modify },
-	[CTL_CONF_UNSET]      = { "conf-unset",      ctl_conf_modify },
+	[CTL_STATUS]          = { "status",          ctl_server,      LOCK_SHARED },
+	[CTL_STOP]            = { "stop",            ctl_server,      LOCK_SHARED },
+	[CTL_RELOAD]          = { "reload",          ctl_server,      LOCK_EXCLUSIVE },
+
+	[CTL_ZONE_STATUS]     = { "zone-status",     ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_RELOAD]     = { "zone-reload",     ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_REFRESH]    = { "zone-refresh",    ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_RETRANSFER] = { "zone-retransfer", ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_FLUSH]      = { "zone-flush",      ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_SIGN]       = { "zone-sign",       ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_KEYS_LOAD]  = { "zone-keys-load",  ctl_zone,        LOCK_SHARED },
+
+	[CTL_ZONE_READ]       = { "zone-read",       ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_BEGIN]      = { "zone-begin",      ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_COMMIT]     = { "zone-commit",     ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_ABORT]      = { "zone-abort",      ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_DIFF]       = { "zone-diff",       ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_GET]        = { "zone-get",        ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_SET]        = { "zone-set",        ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_UNSET]      = { "zone-unset",      ctl_zone,        LOCK_SHARED },
+	[CTL_ZONE_PURGE]      = { "zone-purge",      ctl_zone,        LOCK_SHARED },
+
+	[CTL_CONF_LIST]       = { "conf-list",       ctl_conf_read,   LOCK_CONF },
+	[CTL_CONF_READ]       = { "conf-read",       ctl_conf_read,   LOCK_CONF },
+	[CTL_CONF_BEGIN]      = { "conf-begin",      ctl_conf_txn,    LOCK_CONF },
+	[CTL_CONF_COMMIT]     = { "conf-commit",     ctl_conf_txn,    LOCK_EXCLUSIVE },
+	[CTL_CONF_ABORT]      = { "conf-abort",      ctl_conf_txn,    LOCK_CONF },
+	[CTL_CONF_DIFF]       = { "conf-diff",       ctl_conf_read,   LOCK_CONF },
+	[CTL_CONF_GET]        = { "conf-get",        ctl_conf_read,   LOCK_CONF },
+	[CTL_CONF_SET]        = { "conf-set",        ctl_conf_modify, LOCK_CONF },
+	[CTL_CONF_UNSET]      = { "conf-unset",      ctl_conf_modify, LOCK_CONF },
 };
 
 #define MAX_CTL_CODE (sizeof(cmd_table) / sizeof(desc_t) - 1)
@@ -1327,7 +1620,26 @@ int ctl_exec(ctl_cmd_t cmd, ctl_args_t *args)
 		return KNOT_EINVAL;
 	}
 
-	return cmd_table[cmd].fcn(args, cmd);
+	const desc_t *desc = &cmd_table[cmd];
+	server_t *server = args->server;
+
+	if (desc->lock == LOCK_EXCLUSIVE) {
+		pthread_rwlock_wrlock(&server->ctl_lock);
+	} else {
+		pthread_rwlock_rdlock(&server->ctl_lock);
+	}
+	if (desc->lock == LOCK_CONF) {
+		pthread_mutex_lock(&server->ctl_conf_lock);
+	}
+
+	int ret = desc->fcn(args, cmd);
+
+	if (desc->lock == LOCK_CONF) {
+		pthread_mutex_unlock(&server->ctl_conf_lock);
+	}
+	pthread_rwlock_unlock(&server->ctl_lock);
+
+	return ret;
 }
 
 bool ctl_has_flag(const char *flags, const char *flag)
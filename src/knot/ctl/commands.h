@@ -30,6 +30,10 @@
 #define CTL_FLAG_FORCE	"F"
 #define CTL_FLAG_ADD	"+"
 #define CTL_FLAG_REM	"-"
+#define CTL_FLAG_BULK	"B"
+
+/*! Preferred size of bulk units with zone records in wire format. */
+#define CTL_BULK_SIZE	(256 * 1024)
 
 /*! Control commands. */
 typedef enum {
@@ -45,6 +49,7 @@ typedef enum {
 	CTL_ZONE_RETRANSFER,
 	CTL_ZONE_FLUSH,
 	CTL_ZONE_SIGN,
+	CTL_ZONE_KEYS_LOAD,
 
 	CTL_ZONE_READ,
 	CTL_ZONE_BEGIN,
@@ -59,6 +59,7 @@ int ctl_process(knot_ctl_t *ctl, server_t *server)
 			}
 			// FALLTHROUGH
 		case KNOT_CTL_TYPE_EXTRA:
+		case KNOT_CTL_TYPE_BULK:
 			// All non-first data units should be parsed in a callback.
 			// Ignore if probable previous error.
 			continue;
@@ -141,6 +141,7 @@ int kdnssec_kasp(dnssec_kasp_t **kasp, bool legacy)
 		conf_api.open      = dnssec_kasp_dir_api()->open;
 		conf_api.close     = dnssec_kasp_dir_api()->close;
 		conf_api.base_path = dnssec_kasp_dir_api()->base_path;
+		conf_api.zone_mtime = dnssec_kasp_dir_api()->zone_mtime;
 
 		return dnssec_kasp_init_custom(kasp, &conf_api);
 	}
@@ -38,6 +38,7 @@ struct kdnssec_ctx {
 	uint32_t old_serial;
 	uint32_t new_serial;
 	bool rrsig_drop_existing;
+	bool rrsig_refresh;
 };
 
 typedef struct kdnssec_ctx kdnssec_ctx_t;
@@ -0,0 +1,210 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dnssec/error.h"
+#include "knot/dnssec/key-cache.h"
+#include "libknot/errcode.h"
+
+struct kdnssec_cache {
+	pthread_mutex_t lock;   /*!< Held while the cached data are in use. */
+	int reload;             /*!< Reload requested (atomic access). */
+	bool ctx_valid;         /*!< Signing context is loaded. */
+	bool keys_valid;        /*!< Zone keys are loaded. */
+	time_t mtime;           /*!< KASP zone modification time when loaded. */
+	time_t policy_mtime;    /*!< KASP policy modification time when loaded. */
+	time_t loaded;          /*!< Time of the load. */
+	uint32_t dnskey_ttl;    /*!< Policy DNSKEY TTL before zone adjustments. */
+	kdnssec_ctx_t ctx;
+	zone_keyset_t keyset;
+};
+
+static void cache_drop(kdnssec_cache_t *cache)
+{
+	free_zone_keys(&cache->keyset);
+	cache->keys_valid = false;
+
+	if (cache->ctx_valid) {
+		kdnssec_ctx_deinit(&cache->ctx);
+		cache->ctx_valid = false;
+	}
+}
+
+/*!
+ * \brief Check if the KASP zone and policy weren't modified since the load.
+ *
+ * Only legacy KASP stores the policy, otherwise it comes from the
+ * configuration and the cache is invalidated on reload.
+ *
+ * Modifications within the second of the load can't be detected by the
+ * modification time, such data are never considered up-to-date.
+ */
+static bool cache_fresh(kdnssec_cache_t *cache)
+{
+	const char *zone_name = dnssec_kasp_zone_get_name(cache->ctx.zone);
+
+	time_t mtime = 0;
+	int r = dnssec_kasp_zone_mtime(cache->ctx.kasp, zone_name, &mtime);
+	if (r != DNSSEC_EOK) {
+		return false;
+	}
+
+	time_t policy_mtime = 0;
+	r = dnssec_kasp_policy_mtime(cache->ctx.kasp, cache->ctx.policy->name,
+	                             &policy_mtime);
+	if (r != DNSSEC_EOK && r != DNSSEC_NOT_IMPLEMENTED_ERROR) {
+		return false;
+	}
+
+	return mtime == cache->mtime && mtime < cache->loaded &&
+	       policy_mtime == cache->policy_mtime && policy_mtime < cache->loaded;
+}
+
+static int cache_load(kdnssec_cache_t *cache, const knot_dname_t *zone_name)
+{
+	int r = kdnssec_ctx_init(&cache->ctx, zone_name);
+	if (r != KNOT_EOK) {
+		return r;
+	}
+
+	const char *kasp_name = dnssec_kasp_zone_get_name(cache->ctx.zone);
+	if (dnssec_kasp_zone_mtime(cache->ctx.kasp, kasp_name,
+	                           &cache->mtime) != DNSSEC_EOK) {
+		cache->mtime = 0;
+	}
+	if (dnssec_kasp_policy_mtime(cache->ctx.kasp, cache->ctx.policy->name,
+	                             &cache->policy_mtime) != DNSSEC_EOK) {
+		cache->policy_mtime = 0;
+	}
+
+	cache->ctx_valid = true;
+	cache->loaded = cache->ctx.now;
+	cache->dnskey_ttl = cache->ctx.policy->dnskey_ttl;
+
+	return KNOT_EOK;
+}
+
+kdnssec_cache_t *kdnssec_cache_new(void)
+{
+	kdnssec_cache_t *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&cache->lock, NULL);
+
+	return cache;
+}
+
+void kdnssec_cache_free(kdnssec_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	cache_drop(cache);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+void kdnssec_cache_invalidate(kdnssec_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	__sync_fetch_and_or(&cache->reload, 1);
+}
+
+int kdnssec_cache_acquire(kdnssec_cache_t *cache, const knot_dname_t *zone_name,
+                          kdnssec_ctx_t **ctx)
+{
+	if (cache == NULL || zone_name == NULL || ctx == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	bool reload = __sync_fetch_and_and(&cache->reload, 0);
+	if (cache->ctx_valid && (reload || !cache_fresh(cache))) {
+		cache_drop(cache);
+	}
+
+	if (!cache->ctx_valid) {
+		int r = cache_load(cache, zone_name);
+		if (r != KNOT_EOK) {
+			pthread_mutex_unlock(&cache->lock);
+			return r;
+		}
+	}
+
+	// Reset the zone-specific adjustments from the previous signing.
+	cache->ctx.now = time(NULL);
+	cache->ctx.policy->dnskey_ttl = cache->dnskey_ttl;
+
+	*ctx = &cache->ctx;
+
+	return KNOT_EOK;
+}
+
+int kdnssec_cache_keys(kdnssec_cache_t *cache, zone_keyset_t **keyset)
+{
+	if (cache == NULL || keyset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	assert(cache->ctx_valid);
+
+	kdnssec_ctx_t *ctx = &cache->ctx;
+
+	int r;
+	if (cache->keys_valid) {
+		r = update_zone_keys(ctx->zone, ctx->keystore,
+		                     ctx->policy->nsec3_enabled, ctx->now,
+		                     &cache->keyset);
+	} else {
+		r = load_zone_keys(ctx->zone, ctx->keystore,
+		                   ctx->policy->nsec3_enabled, ctx->now,
+		                   &cache->keyset);
+	}
+	if (r != KNOT_EOK) {
+		free_zone_keys(&cache->keyset);
+		cache->keys_valid = false;
+		return r;
+	}
+
+	cache->keys_valid = true;
+	*keyset = &cache->keyset;
+
+	return KNOT_EOK;
+}
+
+void kdnssec_cache_release(kdnssec_cache_t *cache, bool failed)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	if (failed) {
+		cache_drop(cache);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,92 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * \file key-cache.h
+ *
+ * \brief Cache of the DNSSEC signing context and zone keys.
+ *
+ * The signing context (KASP zone, policy, key store) and the zone keys with
+ * their imported private keys and signing contexts are kept between signing
+ * events. The cache is reloaded when the KASP zone data are modified or when
+ * explicitly invalidated.
+ *
+ * \addtogroup dnssec
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "knot/dnssec/context.h"
+#include "knot/dnssec/zone-keys.h"
+#include "libknot/dname.h"
+
+struct kdnssec_cache;
+typedef struct kdnssec_cache kdnssec_cache_t;
+
+/*!
+ * \brief Create an empty DNSSEC cache.
+ */
+kdnssec_cache_t *kdnssec_cache_new(void);
+
+/*!
+ * \brief Free the DNSSEC cache including the cached data.
+ */
+void kdnssec_cache_free(kdnssec_cache_t *cache);
+
+/*!
+ * \brief Force reload of the cached data on the next use.
+ *
+ * \note Doesn't wait for a running signing to finish.
+ */
+void kdnssec_cache_invalidate(kdnssec_cache_t *cache);
+
+/*!
+ * \brief Acquire the cached signing context, load it if not valid.
+ *
+ * The cache is locked until released by \a kdnssec_cache_release.
+ *
+ * \param cache      DNSSEC cache.
+ * \param zone_name  Name of the zone.
+ * \param ctx        Signing context with the current time set.
+ *
+ * \return Error code, KNOT_EOK if successful (the cache is locked).
+ */
+int kdnssec_cache_acquire(kdnssec_cache_t *cache, const knot_dname_t *zone_name,
+                          kdnssec_ctx_t **ctx);
+
+/*!
+ * \brief Get the zone keys of the acquired signing context.
+ *
+ * Loads the keys or updates their state for the current time.
+ *
+ * \param cache   Acquired DNSSEC cache.
+ * \param keyset  Zone keys.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int kdnssec_cache_keys(kdnssec_cache_t *cache, zone_keyset_t **keyset);
+
+/*!
+ * \brief Release the acquired cache.
+ *
+ * \param cache   Acquired DNSSEC cache.
+ * \param failed  The signing failed, drop the cached data.
+ */
+void kdnssec_cache_release(kdnssec_cache_t *cache, bool failed);
+
+/*! @} */
@@ -19,10 +19,13 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "contrib/macros.h"
+#include "contrib/murmurhash3/murmurhash3.h"
 #include "contrib/wire_ctx.h"
 #include "dnssec/error.h"
 #include "dnssec/kasp.h"
 #include "dnssec/key.h"
+#include "dnssec/random.h"
 #include "dnssec/sign.h"
 #include "knot/dnssec/rrset-sign.h"
 #include "libknot/attribute.h"
@@ -35,6 +38,73 @@
 
 #define RRSIG_RDATA_SIGNER_OFFSET 18
 
+/*- Spreading of signature refresh -------------------------------------------*/
+
+uint32_t knot_rrsig_jitter(const dnssec_kasp_policy_t *policy)
+{
+	if (!policy) {
+		return 0;
+	}
+
+	uint32_t lifetime = policy->rrsig_lifetime;
+	uint32_t refresh = policy->rrsig_refresh_before;
+	if (lifetime <= refresh) {
+		return 0;
+	}
+
+	return MIN(refresh, lifetime - refresh) / 2;
+}
+
+/*!
+ * \brief Get the refresh delay of the RR set signatures within the jitter.
+ *
+ * The delay is stable for the RR set, so that signatures created together
+ * are refreshed at different times.
+ */
+static uint32_t refresh_delay(const knot_rrset_t *covered, uint32_t jitter)
+{
+	if (jitter == 0) {
+		return 0;
+	}
+
+	uint32_t h = hash((const char *)covered->owner,
+	                  knot_dname_size(covered->owner));
+	h ^= covered->type * 2654435761U;
+
+	return h % jitter;
+}
+
+static uint32_t clamp_time(int64_t time)
+{
+	return MIN(MAX(time, 0), UINT32_MAX);
+}
+
+uint32_t knot_rrsig_refresh_at(const knot_rrset_t *covered,
+                               const knot_rrset_t *rrsigs, size_t pos,
+                               const kdnssec_ctx_t *dnssec_ctx)
+{
+	assert(!knot_rrset_empty(covered));
+	assert(!knot_rrset_empty(rrsigs));
+	assert(dnssec_ctx);
+
+	const dnssec_kasp_policy_t *policy = dnssec_ctx->policy;
+	int64_t expire_at = knot_rrsig_sig_expiration(&rrsigs->rrs, pos);
+	uint32_t delay = refresh_delay(covered, knot_rrsig_jitter(policy));
+
+	return clamp_time(expire_at - policy->rrsig_refresh_before + delay);
+}
+
+uint32_t knot_rrsig_min_refresh_at(const kdnssec_ctx_t *dnssec_ctx)
+{
+	assert(dnssec_ctx);
+
+	const dnssec_kasp_policy_t *policy = dnssec_ctx->policy;
+	int64_t refresh_at = (int64_t)dnssec_ctx->now + policy->rrsig_lifetime -
+	                     policy->rrsig_refresh_before - knot_rrsig_jitter(policy);
+
+	return clamp_time(MAX(refresh_at, dnssec_ctx->now));
+}
+
 /*- Creating of RRSIGs -------------------------------------------------------*/
 
 /*!
@@ -292,8 +362,14 @@ int knot_sign_rrset(knot_rrset_t *rrsigs, const knot_rrset_t *covered,
 		return KNOT_EINVAL;
 	}
 
+	// spread expirations of signatures created at once
+	uint32_t jitter = knot_rrsig_jitter(dnssec_ctx->policy);
+	if (jitter > 0) {
+		jitter = dnssec_random_uint32_t() % jitter;
+	}
+
 	uint32_t sig_incept = dnssec_ctx->now;
-	uint32_t sig_expire = sig_incept + dnssec_ctx->policy->rrsig_lifetime;
+	uint32_t sig_expire = sig_incept + dnssec_ctx->policy->rrsig_lifetime - jitter;
 
 	return rrsigs_create_rdata(rrsigs, sign_ctx, covered, key, sig_incept,
 	                           sig_expire, mm);
@@ -326,27 +402,6 @@ int knot_synth_rrsig(uint16_t type, const knot_rdataset_t *rrsig_rrs,
 
 /*- Verification of signatures -----------------------------------------------*/
 
-/*!
- * \brief Check if the signature is expired.
- *
- * \param rrsigs  RR set with RRSIGs.
- * \param pos     Number of RR in the RR set.
- * \param policy  DNSSEC policy.
- *
- * \return Signature is expired or should be replaced soon.
- */
-static bool is_expired_signature(const knot_rrset_t *rrsigs, size_t pos,
-                                 uint32_t now, uint32_t refresh_before)
-{
-	assert(!knot_rrset_empty(rrsigs));
-	assert(rrsigs->type == KNOT_RRTYPE_RRSIG);
-
-	uint32_t expire_at = knot_rrsig_sig_expiration(&rrsigs->rrs, pos);
-	uint32_t expire_in = expire_at > now ? expire_at - now : 0;
-
-	return expire_in <= refresh_before;
-}
-
 int knot_check_signature(const knot_rrset_t *covered,
                     const knot_rrset_t *rrsigs, size_t pos,
                     const dnssec_key_t *key,
@@ -358,11 +413,17 @@ int knot_check_signature(const knot_rrset_t *covered,
 		return KNOT_EINVAL;
 	}
 
-	if (is_expired_signature(rrsigs, pos, dnssec_ctx->now,
-	                         dnssec_ctx->policy->rrsig_refresh_before)) {
+	// signature is expired or should be replaced soon
+	assert(rrsigs->type == KNOT_RRTYPE_RRSIG);
+	if (knot_rrsig_refresh_at(covered, rrsigs, pos, dnssec_ctx) <= dnssec_ctx->now) {
 		return DNSSEC_INVALID_SIGNATURE;
 	}
 
+	// signatures not due yet were verified when created or loaded
+	if (dnssec_ctx->rrsig_refresh) {
+		return KNOT_EOK;
+	}
+
 	// identify fields in the signature being validated
 
 	const knot_rdata_t *rr_data = knot_rdataset_at(&rrsigs->rrs, pos);
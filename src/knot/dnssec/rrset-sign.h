@@ -35,6 +35,42 @@
 #include "knot/dnssec/context.h"
 #include "libknot/rrset.h"
 
+/*!
+ * \brief Get the interval over which signature refreshes are spread.
+ *
+ * New signatures have the validity shortened by a random part of the
+ * interval. Refresh of existing signatures is delayed by a part of the
+ * interval which is stable for the covered RR set.
+ *
+ * \param policy  DNSSEC policy.
+ *
+ * \return Jitter interval in seconds.
+ */
+uint32_t knot_rrsig_jitter(const dnssec_kasp_policy_t *policy);
+
+/*!
+ * \brief Get the time when the signature should be replaced.
+ *
+ * \param covered     RR set covered by the signature.
+ * \param rrsigs      RR set with RRSIGs.
+ * \param pos         Number of RRSIG RR in 'rrsigs'.
+ * \param dnssec_ctx  DNSSEC context.
+ *
+ * \return Signature refresh time.
+ */
+uint32_t knot_rrsig_refresh_at(const knot_rrset_t *covered,
+                               const knot_rrset_t *rrsigs, size_t pos,
+                               const kdnssec_ctx_t *dnssec_ctx);
+
+/*!
+ * \brief Get the earliest refresh time of a signature created now.
+ *
+ * \param dnssec_ctx  DNSSEC context.
+ *
+ * \return Signature refresh time.
+ */
+uint32_t knot_rrsig_min_refresh_at(const kdnssec_ctx_t *dnssec_ctx);
+
 /*!
  * \brief Create RRSIG RR for given RR set.
  *
@@ -73,6 +109,9 @@ int knot_synth_rrsig(uint16_t type, const knot_rdataset_t *rrsig_rrs,
 /*!
  * \brief Check if RRSIG signature is valid.
  *
+ * During a periodic refresh, only the refresh time of the signature is
+ * checked and the signature itself is not verified.
+ *
  * \param covered     RRs covered by the signature.
  * \param rrsigs      RR set with RRSIGs.
  * \param pos         Number of RRSIG RR in 'rrsigs' to be validated.
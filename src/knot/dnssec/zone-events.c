@@ -24,21 +24,34 @@
 #include "knot/conf/conf.h"
 #include "knot/common/log.h"
 #include "knot/dnssec/context.h"
+#include "knot/dnssec/key-cache.h"
 #include "knot/dnssec/policy.h"
+#include "knot/dnssec/rrset-sign.h"
 #include "knot/dnssec/zone-events.h"
 #include "knot/dnssec/zone-keys.h"
 #include "knot/dnssec/zone-nsec.h"
 #include "knot/dnssec/zone-sign.h"
 #include "knot/zone/serial.h"
 
-static int sign_init(const zone_contents_t *zone, int flags, kdnssec_ctx_t *ctx)
+/*!
+ * \brief Number of re-sign events the refresh of signatures is spread over.
+ *
+ * Signatures due within one slice of the jitter interval are refreshed
+ * together, so that the zone isn't walked for every single RR set.
+ */
+#define RESIGN_SLICES 16
+
+static int sign_init(const zone_contents_t *zone, int flags,
+                     kdnssec_cache_t *cache, kdnssec_ctx_t **ctx_ptr)
 {
 	assert(zone);
-	assert(ctx);
+	assert(cache);
+	assert(ctx_ptr);
 
 	const knot_dname_t *zone_name = zone->apex->owner;
 
-	int r = kdnssec_ctx_init(ctx, zone_name);
+	kdnssec_ctx_t *ctx = NULL;
+	int r = kdnssec_cache_acquire(cache, zone_name, &ctx);
 	if (r != KNOT_EOK) {
 		return r;
 	}
@@ -50,6 +63,7 @@ static int sign_init(const zone_contents_t *zone, int flags, kdnssec_ctx_t *ctx)
 	// RRSIG handling
 
 	ctx->rrsig_drop_existing = flags & ZONE_SIGN_DROP_SIGNATURES;
+	ctx->rrsig_refresh = flags & ZONE_SIGN_REFRESH;
 
 	// SOA handling
 
@@ -61,6 +75,8 @@ static int sign_init(const zone_contents_t *zone, int flags, kdnssec_ctx_t *ctx)
 		ctx->new_serial = serial_next(ctx->old_serial, conf_opt(&val));
 	}
 
+	*ctx_ptr = ctx;
+
 	return KNOT_EOK;
 }
 
@@ -117,11 +133,17 @@ static int sign_update_soa(const zone_contents_t *zone, changeset_t *chset,
 }
 
 static uint32_t schedule_next(kdnssec_ctx_t *kctx, const zone_keyset_t *keyset,
-                              uint32_t zone_expire)
+                              uint32_t zone_refresh)
 {
-	// signatures refresh
+	// signatures refresh, a slice of the zone at a time, or continue
+	// immediately if the refresh was cut short
 
-	uint32_t zone_refresh = zone_expire - kctx->policy->rrsig_refresh_before;
+	uint32_t slice = knot_rrsig_jitter(kctx->policy) / RESIGN_SLICES;
+	if (zone_refresh > kctx->now) {
+		zone_refresh = MAX(zone_refresh, kctx->now + slice);
+	} else {
+		zone_refresh = kctx->now + 1;
+	}
 	assert(zone_refresh > 0);
 
 	// DNSKEY modification
@@ -145,36 +167,45 @@ static uint32_t schedule_next(kdnssec_ctx_t *kctx, const zone_keyset_t *keyset,
 	return next;
 }
 
-int knot_dnssec_zone_sign(zone_contents_t *zone, changeset_t *out_ch,
-                          zone_sign_flags_t flags, uint32_t *refresh_at)
+int knot_dnssec_zone_sign(zone_contents_t *zone, kdnssec_cache_t *cache,
+                          changeset_t *out_ch, zone_sign_flags_t flags,
+                          uint32_t *refresh_at)
 {
 	if (!zone || !out_ch || !refresh_at) {
 		return KNOT_EINVAL;
 	}
 
+	kdnssec_cache_t *tmp_cache = NULL;
+	if (cache == NULL) {
+		cache = tmp_cache = kdnssec_cache_new();
+		if (cache == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
 	int result = KNOT_ERROR;
 	const knot_dname_t *zone_name = zone->apex->owner;
-	kdnssec_ctx_t ctx = { 0 };
-	zone_keyset_t keyset = { 0 };
+	kdnssec_ctx_t *ctx = NULL;
+	zone_keyset_t *keyset = NULL;
 
 	// signing pipeline
 
-	result = sign_init(zone, flags, &ctx);
+	result = sign_init(zone, flags, cache, &ctx);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to initialize (%s)",
 		               knot_strerror(result));
-		goto done;
+		kdnssec_cache_free(tmp_cache);
+		return result;
 	}
 
-	result = sign_process_events(zone_name, &ctx);
+	result = sign_process_events(zone_name, ctx);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to process events (%s)",
 		               knot_strerror(result));
 		goto done;
 	}
 
-	result = load_zone_keys(ctx.zone, ctx.keystore,
-	                        ctx.policy->nsec3_enabled, ctx.now, &keyset);
+	result = kdnssec_cache_keys(cache, &keyset);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to load keys (%s)",
 		               knot_strerror(result));
@@ -183,16 +214,16 @@ int knot_dnssec_zone_sign(zone_contents_t *zone, changeset_t *out_ch,
 
 	log_zone_info(zone_name, "DNSSEC, signing started");
 
-	result = knot_zone_create_nsec_chain(zone, out_ch, &keyset, &ctx);
+	result = knot_zone_create_nsec_chain(zone, out_ch, keyset, ctx);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to create NSEC%s chain (%s)",
-		               ctx.policy->nsec3_enabled ? "3" : "",
+		               ctx->policy->nsec3_enabled ? "3" : "",
 		               knot_strerror(result));
 		goto done;
 	}
 
-	uint32_t zone_expire = 0;
-	result = knot_zone_sign(zone, &keyset, &ctx, out_ch, &zone_expire);
+	uint32_t zone_refresh = 0;
+	result = knot_zone_sign(zone, keyset, ctx, out_ch, &zone_refresh);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to sign zone content (%s)",
 		               knot_strerror(result));
@@ -202,12 +233,12 @@ int knot_dnssec_zone_sign(zone_contents_t *zone, changeset_t *out_ch,
 	// SOA finishing
 
 	if (changeset_empty(out_ch) &&
-	    !knot_zone_sign_soa_expired(zone, &keyset, &ctx)) {
+	    !knot_zone_sign_soa_expired(zone, keyset, ctx)) {
 		log_zone_info(zone_name, "DNSSEC, zone is up-to-date");
 		goto done;
 	}
 
-	result = sign_update_soa(zone, out_ch, &ctx, &keyset);
+	result = sign_update_soa(zone, out_ch, ctx, keyset);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to update SOA record (%s)",
 		               knot_strerror(result));
@@ -218,16 +249,17 @@ int knot_dnssec_zone_sign(zone_contents_t *zone, changeset_t *out_ch,
 
 done:
 	if (result == KNOT_EOK) {
-		*refresh_at = schedule_next(&ctx, &keyset, zone_expire);
+		*refresh_at = schedule_next(ctx, keyset, zone_refresh);
 	}
 
-	free_zone_keys(&keyset);
-	kdnssec_ctx_deinit(&ctx);
+	kdnssec_cache_release(cache, result != KNOT_EOK);
+	kdnssec_cache_free(tmp_cache);
 
 	return result;
 }
 
 int knot_dnssec_sign_changeset(const zone_contents_t *zone,
+                               kdnssec_cache_t *cache,
                                const changeset_t *in_ch,
                                changeset_t *out_ch,
                                uint32_t *refresh_at)
@@ -236,44 +268,52 @@ int knot_dnssec_sign_changeset(const zone_contents_t *zone,
 		return KNOT_EINVAL;
 	}
 
+	kdnssec_cache_t *tmp_cache = NULL;
+	if (cache == NULL) {
+		cache = tmp_cache = kdnssec_cache_new();
+		if (cache == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
 	int result = KNOT_ERROR;
 	const knot_dname_t *zone_name = zone->apex->owner;
-	kdnssec_ctx_t ctx = { 0 };
-	zone_keyset_t keyset = { 0 };
+	kdnssec_ctx_t *ctx = NULL;
+	zone_keyset_t *keyset = NULL;
 
 	// signing pipeline
 
-	result = sign_init(zone, ZONE_SIGN_KEEP_SOA_SERIAL, &ctx);
+	result = sign_init(zone, ZONE_SIGN_KEEP_SOA_SERIAL, cache, &ctx);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to initialize (%s)",
 		               knot_strerror(result));
-		goto done;
+		kdnssec_cache_free(tmp_cache);
+		return KNOT_EOK;
 	}
 
-	result = load_zone_keys(ctx.zone, ctx.keystore,
-	                        ctx.policy->nsec3_enabled, ctx.now, &keyset);
+	result = kdnssec_cache_keys(cache, &keyset);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to load keys (%s)",
 		               knot_strerror(result));
 		goto done;
 	}
 
-	result = knot_zone_sign_changeset(zone, in_ch, out_ch, &keyset, &ctx);
+	result = knot_zone_sign_changeset(zone, in_ch, out_ch, keyset, ctx);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to sign changeset (%s)",
 		               knot_strerror(result));
 		goto done;
 	}
 
-	result = knot_zone_create_nsec_chain(zone, out_ch, &keyset, &ctx);
+	result = knot_zone_create_nsec_chain(zone, out_ch, keyset, ctx);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to create NSEC%s chain (%s)",
-		               ctx.policy->nsec3_enabled ? "3" : "",
+		               ctx->policy->nsec3_enabled ? "3" : "",
 		               knot_strerror(result));
 		goto done;
 	}
 
-	result = knot_zone_sign_nsecs_in_changeset(&keyset, &ctx, out_ch);
+	result = knot_zone_sign_nsecs_in_changeset(keyset, ctx, out_ch);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to sign changeset (%s)",
 		               knot_strerror(result));
@@ -282,7 +322,7 @@ int knot_dnssec_sign_changeset(const zone_contents_t *zone,
 
 	// update SOA
 
-	result = sign_update_soa(zone, out_ch, &ctx, &keyset);
+	result = sign_update_soa(zone, out_ch, ctx, keyset);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to update SOA record (%s)",
 		               knot_strerror(result));
@@ -291,12 +331,12 @@ int knot_dnssec_sign_changeset(const zone_contents_t *zone,
 
 	// schedule next resigning (only new signatures are made)
 
-	*refresh_at = ctx.now + ctx.policy->rrsig_lifetime - ctx.policy->rrsig_refresh_before;
+	*refresh_at = knot_rrsig_min_refresh_at(ctx);
 	assert(refresh_at > 0);
 
 done:
-	free_zone_keys(&keyset);
-	kdnssec_ctx_deinit(&ctx);
+	kdnssec_cache_release(cache, result != KNOT_EOK);
+	kdnssec_cache_free(tmp_cache);
 
 	return KNOT_EOK;
 }
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include "knot/dnssec/key-cache.h"
 #include "knot/zone/zone.h"
 #include "knot/updates/changesets.h"
 
@@ -35,6 +36,7 @@ enum zone_sign_flags {
 	ZONE_SIGN_NONE = 0,
 	ZONE_SIGN_DROP_SIGNATURES = (1 << 0),
 	ZONE_SIGN_KEEP_SOA_SERIAL = (1 << 1),
+	ZONE_SIGN_REFRESH = (1 << 2),
 };
 
 typedef enum zone_sign_flags zone_sign_flags_t;
@@ -44,19 +46,22 @@ typedef enum zone_sign_flags zone_sign_flags_t;
  *        and NSEC(3) records will not be changed.
  *
  * \param zone         Zone contents to be signed.
+ * \param cache        DNSSEC cache of the zone (can be NULL).
  * \param out_ch       New records will be added to this changeset.
  * \param flags        Zone signing flags.
  * \param refresh_at   Signature refresh time of the oldest signature in zone.
  *
  * \return Error code, KNOT_EOK if successful.
  */
-int knot_dnssec_zone_sign(zone_contents_t *zone, changeset_t *out_ch,
-                          zone_sign_flags_t flags, uint32_t *refresh_at);
+int knot_dnssec_zone_sign(zone_contents_t *zone, kdnssec_cache_t *cache,
+                          changeset_t *out_ch, zone_sign_flags_t flags,
+                          uint32_t *refresh_at);
 
 /*!
  * \brief Sign changeset created by DDNS or zone-diff.
  *
  * \param zone            Zone contents to be signed.
+ * \param cache           DNSSEC cache of the zone (can be NULL).
  * \param in_ch           Changeset created bvy DDNS or zone-diff
  * \param out_ch          New records will be added to this changeset.
  * \param refresh_at      Signature refresh time of the new signatures.
@@ -64,6 +69,7 @@ int knot_dnssec_zone_sign(zone_contents_t *zone, changeset_t *out_ch,
  * \return Error code, KNOT_EOK if successful.
  */
 int knot_dnssec_sign_changeset(const zone_contents_t *zone,
+                               kdnssec_cache_t *cache,
                                const changeset_t *in_ch,
                                changeset_t *out_ch,
                                uint32_t *refresh_at);
@@ -29,24 +29,13 @@
 /*!
  * \brief Get key feature flags from key parameters.
  */
-static int set_key(dnssec_kasp_key_t *kasp_key, time_t now, zone_key_t *zone_key)
+static void set_key_state(const dnssec_kasp_key_t *kasp_key, time_t now,
+                          zone_key_t *zone_key)
 {
 	assert(kasp_key);
 	assert(zone_key);
 
-	dnssec_kasp_key_timing_t *timing = &kasp_key->timing;
-
-	// cryptographic context
-
-	dnssec_sign_ctx_t *ctx = NULL;
-	int r = dnssec_sign_new(&ctx, kasp_key->key);
-	if (r != DNSSEC_EOK) {
-		return r;
-	}
-
-	zone_key->id = kasp_key->id;
-	zone_key->key = kasp_key->key;
-	zone_key->ctx = ctx;
+	const dnssec_kasp_key_timing_t *timing = &kasp_key->timing;
 
 	// next event computation
 
@@ -77,6 +66,29 @@ static int set_key(dnssec_kasp_key_t *kasp_key, time_t now, zone_key_t *zone_key
 	                      (timing->retire == 0 || now < timing->retire);
 	zone_key->is_public = timing->publish <= now &&
 	                      (timing->remove == 0 || now < timing->remove);
+}
+
+/*!
+ * \brief Initialize zone key and its cryptographic context.
+ */
+static int set_key(dnssec_kasp_key_t *kasp_key, time_t now, zone_key_t *zone_key)
+{
+	assert(kasp_key);
+	assert(zone_key);
+
+	// cryptographic context
+
+	dnssec_sign_ctx_t *ctx = NULL;
+	int r = dnssec_sign_new(&ctx, kasp_key->key);
+	if (r != DNSSEC_EOK) {
+		return r;
+	}
+
+	zone_key->id = kasp_key->id;
+	zone_key->key = kasp_key->key;
+	zone_key->ctx = ctx;
+
+	set_key_state(kasp_key, now, zone_key);
 
 	return KNOT_EOK;
 }
@@ -300,6 +312,69 @@ int load_zone_keys(dnssec_kasp_zone_t *zone, dnssec_keystore_t *store,
 	return DNSSEC_EOK;
 }
 
+/*!
+ * \brief Check if the keyset was created from the current KASP zone keys.
+ */
+static bool keyset_matches(dnssec_list_t *kasp_keys, const zone_keyset_t *keyset)
+{
+	if (keyset->count == 0 || keyset->count != dnssec_list_size(kasp_keys)) {
+		return false;
+	}
+
+	size_t i = 0;
+	dnssec_list_foreach(item, kasp_keys) {
+		dnssec_kasp_key_t *kasp_key = dnssec_item_get(item);
+		if (keyset->keys[i].key != kasp_key->key) {
+			return false;
+		}
+		i += 1;
+	}
+
+	return true;
+}
+
+/*!
+ * \brief Update state of loaded zone keys, reload them if the key set changed.
+ */
+int update_zone_keys(dnssec_kasp_zone_t *zone, dnssec_keystore_t *store,
+                     bool nsec3_enabled, time_t now, zone_keyset_t *keyset)
+{
+	if (!zone || !store || !keyset) {
+		return KNOT_EINVAL;
+	}
+
+	const char *zone_name = dnssec_kasp_zone_get_name(zone);
+
+	dnssec_list_t *kasp_keys = dnssec_kasp_zone_get_keys(zone);
+	if (!keyset_matches(kasp_keys, keyset)) {
+		free_zone_keys(keyset);
+		return load_zone_keys(zone, store, nsec3_enabled, now, keyset);
+	}
+
+	size_t i = 0;
+	dnssec_list_foreach(item, kasp_keys) {
+		dnssec_kasp_key_t *kasp_key = dnssec_item_get(item);
+		set_key_state(kasp_key, now, &keyset->keys[i]);
+		i += 1;
+	}
+
+	int r = prepare_and_check_keys(zone_name, nsec3_enabled, keyset);
+	if (r != KNOT_EOK) {
+		log_zone_str_error(zone_name, "DNSSEC, keys validation failed (%s)",
+		                   knot_strerror(r));
+		return r;
+	}
+
+	r = load_private_keys(store, keyset);
+	if (r != KNOT_EOK) {
+		log_zone_str_error(zone_name, "DNSSEC, failed to load private "
+		                   "keys (%s)", knot_strerror(r));
+		return r;
+	}
+
+	return KNOT_EOK;
+}
+
 /*!
  * \brief Free structure with zone keys and associated DNSSEC contexts.
  */
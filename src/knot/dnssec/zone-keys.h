@@ -71,6 +71,23 @@ typedef struct zone_keyset zone_keyset_t;
 int load_zone_keys(dnssec_kasp_zone_t *zone, dnssec_keystore_t *store,
                    bool nsec3_enabled, time_t now, zone_keyset_t *keyset_ptr);
 
+/*!
+ * \brief Update state of loaded zone keys for the current time.
+ *
+ * Cryptographic contexts of the keys are reused. If the keys in the KASP
+ * zone differ from the keys in the keyset, the keyset is reloaded.
+ *
+ * \param zone           KASP zone the keyset was loaded from.
+ * \param keystore       KASP key store.
+ * \param nsec3_enabled  Zone uses NSEC3 for authenticated denial.
+ * \param now            Current time.
+ * \param keyset         Zone keyset to be updated.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int update_zone_keys(dnssec_kasp_zone_t *zone, dnssec_keystore_t *store,
+                     bool nsec3_enabled, time_t now, zone_keyset_t *keyset);
+
 /*!
  * \brief Get zone key by a keytag.
  *
@@ -37,6 +37,13 @@
 #include "libknot/rrtype/soa.h"
 #include "contrib/macros.h"
 
+/*!
+ * \brief Maximal number of RR sets re-signed in one periodic refresh.
+ *
+ * The rest is left to the following refresh, which is scheduled immediately.
+ */
+#define REFRESH_MAX_RRSETS 10000
+
 typedef struct type_node {
 	node_t n;
 	uint16_t type;
@@ -197,21 +204,25 @@ static const zone_key_t *get_matching_zone_key(const knot_rrset_t *rrsigs,
 }
 
 /*!
- * \brief Note earliest expiration of a signature.
+ * \brief Note earliest refresh of a signature.
  *
+ * \param covered     RR set with covered records.
  * \param rrsigs      RR set with RRSIGs.
  * \param pos         Position of RR in rrsigs.
- * \param expires_at  Current earliest expiration, will be updated.
+ * \param dnssec_ctx  DNSSEC context.
+ * \param refresh_at  Current earliest refresh, will be updated.
  */
-static void note_earliest_expiration(const knot_rrset_t *rrsigs, size_t pos,
-                                     uint32_t *expires_at)
+static void note_earliest_refresh(const knot_rrset_t *covered,
+                                  const knot_rrset_t *rrsigs, size_t pos,
+                                  const kdnssec_ctx_t *dnssec_ctx,
+                                  uint32_t *refresh_at)
 {
 	assert(rrsigs);
-	assert(expires_at);
+	assert(refresh_at);
 
-	uint32_t current = knot_rrsig_sig_expiration(&rrsigs->rrs, pos);
-	if (current < *expires_at) {
-		*expires_at = current;
+	uint32_t current = knot_rrsig_refresh_at(covered, rrsigs, pos, dnssec_ctx);
+	if (current < *refresh_at) {
+		*refresh_at = current;
 	}
 }
 
@@ -223,7 +234,7 @@ static void note_earliest_expiration(const knot_rrset_t *rrsigs, size_t pos,
  * \param zone_keys   Zone keys.
  * \param policy      DNSSEC policy.
  * \param changeset   Changeset to be updated.
- * \param expires_at  Earliest RRSIG expiration.
+ * \param refresh_at  Earliest RRSIG refresh.
  *
  * \return Error code, KNOT_EOK if successful.
  */
@@ -232,7 +243,7 @@ static int remove_expired_rrsigs(const knot_rrset_t *covered,
                                  const zone_keyset_t *zone_keys,
                                  const kdnssec_ctx_t *dnssec_ctx,
                                  changeset_t *changeset,
-                                 uint32_t *expires_at)
+                                 uint32_t *refresh_at)
 {
 	assert(changeset);
 
@@ -265,7 +276,8 @@ static int remove_expired_rrsigs(const knot_rrset_t *covered,
 			                         key->key, key->ctx, dnssec_ctx);
 			if (result == KNOT_EOK) {
 				// valid signature
-				note_earliest_expiration(&synth_rrsig, i, expires_at);
+				note_earliest_refresh(covered, &synth_rrsig, i, dnssec_ctx,
+				                      refresh_at);
 				continue;
 			}
 
@@ -416,7 +428,7 @@ static int force_resign_rrset(const knot_rrset_t *covered,
  * \param zone_keys   Zone keys.
  * \param policy      DNSSEC policy.
  * \param changeset   Changeset to be updated.
- * \param expires_at  Current earliest expiration, will be updated.
+ * \param refresh_at  Current earliest refresh, will be updated.
  *
  * \return Error code, KNOT_EOK if successful.
  */
@@ -425,13 +437,13 @@ static int resign_rrset(const knot_rrset_t *covered,
                         const zone_keyset_t *zone_keys,
                         const kdnssec_ctx_t *dnssec_ctx,
                         changeset_t *changeset,
-                        uint32_t *expires_at)
+                        uint32_t *refresh_at)
 {
 	assert(!knot_rrset_empty(covered));
 
 	// TODO this function creates some signatures twice (for checking)
 	int result = remove_expired_rrsigs(covered, rrsigs, zone_keys,
-	                                   dnssec_ctx, changeset, expires_at);
+	                                   dnssec_ctx, changeset, refresh_at);
 	if (result != KNOT_EOK) {
 		return result;
 	}
@@ -471,6 +483,45 @@ static int remove_standalone_rrsigs(const zone_node_t *node,
 	return KNOT_EOK;
 }
 
+/*!
+ * \brief Check if any signature of the RR set has to be added or replaced.
+ *
+ * Only key tags and signature times are checked.
+ *
+ * \param covered     RR set with covered records.
+ * \param rrsigs      RR set with RRSIGs.
+ * \param zone_keys   Zone keys.
+ * \param dnssec_ctx  DNSSEC context.
+ *
+ * \return Re-signing of the RR set is due.
+ */
+static bool resign_due(const knot_rrset_t *covered,
+                       const knot_rrset_t *rrsigs,
+                       const zone_keyset_t *zone_keys,
+                       const kdnssec_ctx_t *dnssec_ctx)
+{
+	assert(dnssec_ctx->rrsig_refresh);
+
+	if (!all_signatures_exist(covered, rrsigs, zone_keys, dnssec_ctx)) {
+		return true;
+	}
+
+	uint16_t rrsigs_rdata_count = rrsigs->rrs.rr_count;
+	for (uint16_t i = 0; i < rrsigs_rdata_count; i++) {
+		if (knot_rrsig_type_covered(&rrsigs->rrs, i) != covered->type) {
+			continue;
+		}
+
+		const zone_key_t *key = get_matching_zone_key(rrsigs, i, zone_keys);
+		if (!key || !key->is_active ||
+		    knot_rrsig_refresh_at(covered, rrsigs, i, dnssec_ctx) <= dnssec_ctx->now) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /*!
  * \brief Update RRSIGs in a given node by updating changeset.
  *
@@ -478,7 +529,9 @@ static int remove_standalone_rrsigs(const zone_node_t *node,
  * \param zone_keys   Zone keys.
  * \param policy      DNSSEC policy.
  * \param changeset   Changeset to be updated.
- * \param expires_at  Current earliest expiration, will be updated.
+ * \param budget      Number of RR sets which can be re-signed (NULL if
+ *                    unlimited), will be updated.
+ * \param refresh_at  Current earliest refresh, will be updated.
  *
  * \return Error code, KNOT_EOK if successful.
  */
@@ -486,7 +539,8 @@ static int sign_node_rrsets(const zone_node_t *node,
                             const zone_keyset_t *zone_keys,
                             const kdnssec_ctx_t *dnssec_ctx,
                             changeset_t *changeset,
-                            uint32_t *expires_at)
+                            size_t *budget,
+                            uint32_t *refresh_at)
 {
 	assert(node);
 	assert(dnssec_ctx);
@@ -504,12 +558,22 @@ static int sign_node_rrsets(const zone_node_t *node,
 			continue;
 		}
 
+		if (budget != NULL &&
+		    resign_due(&rrset, &rrsigs, zone_keys, dnssec_ctx)) {
+			if (*budget == 0) {
+				// left for the next refresh
+				*refresh_at = dnssec_ctx->now;
+				continue;
+			}
+			*budget -= 1;
+		}
+
 		if (dnssec_ctx->rrsig_drop_existing) {
 			result = force_resign_rrset(&rrset, &rrsigs, zone_keys,
 			                            dnssec_ctx, changeset);
 		} else {
 			result = resign_rrset(&rrset, &rrsigs, zone_keys,
-			                      dnssec_ctx, changeset, expires_at);
+			                      dnssec_ctx, changeset, refresh_at);
 		}
 
 		if (result != KNOT_EOK) {
@@ -527,7 +591,8 @@ typedef struct node_sign_args {
 	const zone_keyset_t *zone_keys;
 	const kdnssec_ctx_t *dnssec_ctx;
 	changeset_t *changeset;
-	uint32_t expires_at;
+	size_t *budget;
+	uint32_t refresh_at;
 } node_sign_args_t;
 
 /*!
@@ -552,7 +617,8 @@ static int sign_node(zone_node_t **node, void *data)
 	}
 
 	int result = sign_node_rrsets(*node, args->zone_keys, args->dnssec_ctx,
-	                              args->changeset, &args->expires_at);
+	                              args->changeset, args->budget,
+	                              &args->refresh_at);
 	(*node)->flags &= ~NODE_FLAGS_REMOVED_NSEC;
 
 	return result;
@@ -565,7 +631,9 @@ static int sign_node(zone_node_t **node, void *data)
  * \param zone_keys   Zone keys.
  * \param policy      DNSSEC policy.
  * \param changeset   Changeset to be updated.
- * \param expires_at  Expiration time of the oldest signature in zone.
+ * \param budget      Number of RR sets which can be re-signed (NULL if
+ *                    unlimited), will be updated.
+ * \param refresh_at  Earliest signature refresh in the zone.
  *
  * \return Error code, KNOT_EOK if successful.
  */
@@ -573,7 +641,8 @@ static int zone_tree_sign(zone_tree_t *tree,
                           const zone_keyset_t *zone_keys,
                           const kdnssec_ctx_t *dnssec_ctx,
                           changeset_t *changeset,
-                          uint32_t *expires_at)
+                          size_t *budget,
+                          uint32_t *refresh_at)
 {
 	assert(zone_keys);
 	assert(dnssec_ctx);
@@ -583,11 +652,12 @@ static int zone_tree_sign(zone_tree_t *tree,
 		.zone_keys = zone_keys,
 		.dnssec_ctx = dnssec_ctx,
 		.changeset = changeset,
-		.expires_at = dnssec_ctx->now + dnssec_ctx->policy->rrsig_lifetime
+		.budget = budget,
+		.refresh_at = knot_rrsig_min_refresh_at(dnssec_ctx)
 	};
 
 	int result = zone_tree_apply(tree, sign_node, &args);
-	*expires_at = args.expires_at;
+	*refresh_at = args.refresh_at;
 
 	return result;
 }
@@ -814,7 +884,7 @@ static int add_missing_dnskeys(const knot_rrset_t *soa,
  * \param zone_keys   Zone keys.
  * \param policy      DNSSEC policy.
  * \param changeset   Changeset to be updated.
- * \param expires_at  Earliest RRSIG expiration.
+ * \param refresh_at  Earliest RRSIG refresh.
  *
  * \return Error code, KNOT_EOK if successful.
  */
@@ -824,7 +894,7 @@ static int update_dnskey_rrsigs(const knot_rrset_t *dnskeys,
                                 const zone_keyset_t *zone_keys,
                                 const kdnssec_ctx_t *dnssec_ctx,
                                 changeset_t *changeset,
-                                uint32_t *expires_at)
+                                uint32_t *refresh_at)
 {
 	assert(zone_keys);
 	assert(changeset);
@@ -852,7 +922,7 @@ static int update_dnskey_rrsigs(const knot_rrset_t *dnskeys,
 	if (dnssec_ctx->rrsig_drop_existing) {
 		result = force_resign_rrset(&new_dnskeys, rrsigs, zone_keys, dnssec_ctx, changeset);
 	} else {
-		result = resign_rrset(&new_dnskeys, rrsigs, zone_keys, dnssec_ctx, changeset, expires_at);
+		result = resign_rrset(&new_dnskeys, rrsigs, zone_keys, dnssec_ctx, changeset, refresh_at);
 	}
 
 fail:
@@ -867,7 +937,7 @@ fail:
  * \param zone_keys   Zone keys.
  * \param policy      DNSSEC policy.
  * \param changeset   Changeset to be updated.
- * \param expires_at  Earliest RRSIG expiration.
+ * \param refresh_at  Earliest RRSIG refresh.
  *
  * \return Error code, KNOT_EOK if successful.
  */
@@ -875,7 +945,7 @@ static int update_dnskeys(const zone_contents_t *zone,
                           const zone_keyset_t *zone_keys,
                           const kdnssec_ctx_t *dnssec_ctx,
                           changeset_t *changeset,
-                          uint32_t *expires_at)
+                          uint32_t *refresh_at)
 {
 	assert(zone);
 	assert(zone->apex);
@@ -902,7 +972,7 @@ static int update_dnskeys(const zone_contents_t *zone,
 	}
 
 	return update_dnskey_rrsigs(&dnskeys, &rrsigs, &soa, zone_keys,
-	                            dnssec_ctx, changeset, expires_at);
+	                            dnssec_ctx, changeset, refresh_at);
 }
 
 /*!
@@ -1115,36 +1185,40 @@ int knot_zone_sign(const zone_contents_t *zone,
                    const zone_keyset_t *zone_keys,
                    const kdnssec_ctx_t *dnssec_ctx,
                    changeset_t *changeset,
-                   uint32_t *expire_at)
+                   uint32_t *refresh_at)
 {
-	if (!zone || !zone_keys || !dnssec_ctx || !changeset || !expire_at) {
+	if (!zone || !zone_keys || !dnssec_ctx || !changeset || !refresh_at) {
 		return KNOT_EINVAL;
 	}
 
 	int result;
 
-	uint32_t dnskey_expire = UINT32_MAX;
+	uint32_t dnskey_refresh = UINT32_MAX;
 	result = update_dnskeys(zone, zone_keys, dnssec_ctx, changeset,
-	                        &dnskey_expire);
+	                        &dnskey_refresh);
 	if (result != KNOT_EOK) {
 		return result;
 	}
 
-	uint32_t normal_expire = UINT32_MAX;
+	// periodic refresh re-signs a bounded part of the zone
+	size_t budget = REFRESH_MAX_RRSETS;
+	size_t *limit = dnssec_ctx->rrsig_refresh ? &budget : NULL;
+
+	uint32_t normal_refresh = UINT32_MAX;
 	result = zone_tree_sign(zone->nodes, zone_keys, dnssec_ctx, changeset,
-	                        &normal_expire);
+	                        limit, &normal_refresh);
 	if (result != KNOT_EOK) {
 		return result;
 	}
 
-	uint32_t nsec3_expire = UINT32_MAX;
+	uint32_t nsec3_refresh = UINT32_MAX;
 	result = zone_tree_sign(zone->nsec3_nodes, zone_keys, dnssec_ctx,
-	                        changeset, &nsec3_expire);
+	                        changeset, limit, &nsec3_refresh);
 	if (result != KNOT_EOK) {
 		return result;
 	}
 
-	*expire_at = MIN(dnskey_expire, MIN(normal_expire, nsec3_expire));
+	*refresh_at = MIN(dnskey_refresh, MIN(normal_refresh, nsec3_refresh));
 
 	return KNOT_EOK;
 }
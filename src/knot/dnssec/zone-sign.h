@@ -43,14 +43,16 @@
  * \param zone_keys   Zone keys.
  * \param dnssec_ctx  DNSSEC context.
  * \param changeset   Changeset to be updated.
- * \param expire_at   Time, when the oldest signature in the zone expires.
+ * \param refresh_at  Time, when the first signature in the zone should be
+ *                    refreshed. Current time if a periodic refresh was
+ *                    not completed.
  *
  * \return Error code, KNOT_EOK if successful.
  */
 int knot_zone_sign(const zone_contents_t *zone,
                    const zone_keyset_t *zone_keys,
                    const kdnssec_ctx_t *dnssec_ctx,
-                   changeset_t *out_ch, uint32_t *expire_at);
+                   changeset_t *out_ch, uint32_t *refresh_at);
 
 /*!
  * \brief Update and sign SOA and store performed changes in changeset.
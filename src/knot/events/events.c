@@ -23,6 +23,7 @@
 #include "knot/events/events.h"
 #include "knot/events/handlers.h"
 #include "knot/events/replan.h"
+#include "knot/zone/timers.h"
 #include "knot/zone/zone.h"
 
 #define ZONE_EVENT_IMMEDIATE 1 /* Fast-track to worker queue. */
@@ -111,7 +112,18 @@ static void event_set_time(zone_events_t *events, zone_event_type_t type, time_t
 	assert(events);
 	assert(valid_event(type));
 
+	if (events->time[type] == time) {
+		return;
+	}
+
 	events->time[type] = time;
+
+	/* Stage the change for the next timers database commit. */
+	if (events->timers != NULL && timer_db_persistent(type)) {
+		zone_t *zone = events->task.ctx;
+		(void)timers_writer_stage(events->timers, zone->name, events->time,
+		                          zone->flags & ZONE_EXPIRED);
+	}
 }
 
 /*!
@@ -177,6 +189,9 @@ static void event_wrap(task_t *task)
 
 	const event_info_t *info = get_event_info(type);
 
+	/* Zone file parameters are updated only here, before the event. */
+	zone_flush_publish(zone);
+
 	/* Create a configuration copy just for this event. */
 	conf_t *conf;
 	rcu_read_lock();
@@ -234,7 +249,7 @@ int zone_events_init(zone_t *zone)
 }
 
 int zone_events_setup(struct zone *zone, worker_pool_t *workers,
-                      evsched_t *scheduler, knot_db_t *timers_db)
+                      evsched_t *scheduler, struct timers_writer *timers)
 {
 	if (!zone || !workers || !scheduler) {
 		return KNOT_EINVAL;
@@ -248,7 +263,7 @@ int zone_events_setup(struct zone *zone, worker_pool_t *workers,
 
 	zone->events.event = event;
 	zone->events.pool = workers;
-	zone->events.timers_db = timers_db;
+	zone->events.timers = timers;
 
 	return KNOT_EOK;
 }
@@ -353,6 +368,20 @@ void zone_events_start(zone_t *zone)
 	pthread_mutex_unlock(&zone->events.mx);
 }
 
+void zone_events_store_timers(zone_t *zone)
+{
+	if (!zone) {
+		return;
+	}
+
+	zone_events_t *events = &zone->events;
+
+	pthread_mutex_lock(&events->mx);
+	(void)timers_writer_stage(events->timers, zone->name, events->time,
+	                          zone->flags & ZONE_EXPIRED);
+	pthread_mutex_unlock(&events->mx);
+}
+
 time_t zone_events_get_time(const struct zone *zone, zone_event_type_t type)
 {
 	if (zone == NULL) {
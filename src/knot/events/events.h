@@ -28,6 +28,7 @@
 /* Timer special values. */
 #define ZONE_EVENT_NOW 0
 
+struct timers_writer;
 struct zone;
 
 typedef enum zone_event_type {
@@ -52,7 +53,7 @@ typedef struct zone_events {
 
 	event_t *event;			//!< Scheduler event.
 	worker_pool_t *pool;		//!< Server worker pool.
-	knot_db_t *timers_db;		//!< Persistent zone timers database.
+	struct timers_writer *timers;	//!< Persistent zone timers writer.
 
 	task_t task;			//!< Event execution context.
 	time_t time[ZONE_EVENT_COUNT];	//!< Event execution times.
@@ -76,12 +77,12 @@ int zone_events_init(struct zone *zone);
  * \param zone       Zone to setup.
  * \param workers    Worker thread pool.
  * \param scheduler  Event scheduler.
- * \param timers_db  Persistent timers database. Can be NULL.
+ * \param timers     Persistent timers writer. Can be NULL.
  *
  * \return KNOT_E*
  */
 int zone_events_setup(struct zone *zone, worker_pool_t *workers,
-                      evsched_t *scheduler, knot_db_t *timers_db);
+                      evsched_t *scheduler, struct timers_writer *timers);
 
 /*!
  * \brief Deinitialize zone events.
@@ -155,6 +156,16 @@ void zone_events_freeze(struct zone *zone);
  */
 void zone_events_start(struct zone *zone);
 
+/*!
+ * \brief Stage persistent zone timers for writing to the timers database.
+ *
+ * \note Timers are staged on every change automatically, this is needed
+ *       only if the zone state stored with the timers changes.
+ *
+ * \param zone  Zone to store timers for.
+ */
+void zone_events_store_timers(struct zone *zone);
+
 /*!
  * \brief Return time of the occurrence of the given event.
  *
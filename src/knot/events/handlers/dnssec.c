@@ -15,7 +15,6 @@
  */
 
 #include <assert.h>
-#include <urcu.h>
 
 #include "knot/common/log.h"
 #include "knot/conf/conf.h"
@@ -70,10 +69,11 @@ int event_dnssec(conf_t *conf, zone_t *zone)
 		sign_flags = ZONE_SIGN_DROP_SIGNATURES;
 	} else {
 		log_zone_info(zone->name, "DNSSEC, signing zone");
-		sign_flags = 0;
+		sign_flags = ZONE_SIGN_REFRESH;
 	}
 
-	ret = knot_dnssec_zone_sign(zone->contents, &ch, sign_flags, &refresh_at);
+	ret = knot_dnssec_zone_sign(zone->contents, zone->dnssec_cache, &ch,
+	                            sign_flags, &refresh_at);
 	if (ret != KNOT_EOK) {
 		goto done;
 	}
@@ -105,10 +105,7 @@ int event_dnssec(conf_t *conf, zone_t *zone)
 		/* Switch zone contents. */
 		zone_contents_t *old_contents = zone_switch_contents(zone, new_contents);
 		zone->flags &= ~ZONE_EXPIRED;
-		synchronize_rcu();
-		update_free_zone(&old_contents);
-
-		update_cleanup(&a_ctx);
+		zone_contents_retire(zone, &old_contents, &a_ctx);
 	}
 
 	// Schedule dependent events.
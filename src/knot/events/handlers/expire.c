@@ -15,7 +15,6 @@
  */
 
 #include <assert.h>
-#include <urcu.h>
 
 #include "contrib/trim.h"
 #include "knot/common/log.h"
@@ -28,13 +27,14 @@ int event_expire(conf_t *conf, zone_t *zone)
 {
 	assert(zone);
 
+	zone_flush_invalidate(zone);
 	zone_contents_t *expired = zone_switch_contents(zone, NULL);
-	synchronize_rcu();
 
 	/* Expire zonefile information. */
 	zone->zonefile.exists = false;
 	zone->flags |= ZONE_EXPIRED;
-	zone_contents_deep_free(&expired);
+	zone_events_store_timers(zone);
+	zone_contents_retire(zone, &expired, NULL);
 
 	log_zone_info(zone->name, "zone expired");
 
@@ -35,5 +35,6 @@ int event_flush(conf_t *conf, zone_t *zone)
 		return KNOT_EOK;
 	}
 
-	return zone_flush_journal(conf, zone);
+	/* Write the zone file without blocking other zone events. */
+	return zone_flush_journal_async(conf, zone);
 }
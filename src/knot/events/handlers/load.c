@@ -15,7 +15,6 @@
  */
 
 #include <assert.h>
-#include <urcu.h>
 
 #include "knot/common/log.h"
 #include "knot/conf/conf.h"
@@ -30,6 +29,9 @@ int event_load(conf_t *conf, zone_t *zone)
 
 	zone_contents_t *contents = NULL;
 
+	/* Don't let a running flush overwrite the zone file being loaded. */
+	zone_flush_invalidate(zone);
+
 	/* Take zone file mtime and load it. */
 	time_t mtime;
 	char *filename = conf_zonefile(conf, zone->name);
@@ -80,10 +82,7 @@ int event_load(conf_t *conf, zone_t *zone)
 	zone_contents_t *old = zone_switch_contents(zone, contents);
 	bool old_contents = (old != NULL);
 	uint32_t old_serial = zone_contents_serial(old);
-	if (old != NULL) {
-		synchronize_rcu();
-		zone_contents_deep_free(&old);
-	}
+	zone_contents_retire(zone, &old, NULL);
 
 	/* Schedule refresh after load if not already scheduled. */
 	if (zone_is_slave(conf, zone) &&
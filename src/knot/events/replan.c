@@ -103,6 +103,7 @@ static void duplicate_ddns_q(zone_t *zone, zone_t *old_zone)
 		ptrlist_add(&zone->ddns_queue, node->d, NULL);
 	}
 	zone->ddns_queue_size = old_zone->ddns_queue_size;
+	zone->ddns_queue_time = old_zone->ddns_queue_time;
 
 	// Reset the list, new zone will free the data.
 	ptrlist_free(&old_zone->ddns_queue, NULL);
@@ -17,8 +17,8 @@
 #include <sys/stat.h>
 
 #include "contrib/dnstap/dnstap.pb-c.h"
+#include "contrib/dnstap/encoder.h"
 #include "contrib/dnstap/writer.h"
-#include "contrib/dnstap/message.h"
 #include "contrib/dnstap/dnstap.h"
 #include "contrib/mempattern.h"
 #include "knot/modules/dnstap/dnstap.h"
@@ -29,6 +29,9 @@
 #define MOD_VERSION	"\x07""version"
 #define MOD_QUERIES	"\x0B""log-queries"
 #define MOD_RESPONSES	"\x0D""log-responses"
+#define MOD_RCODES	"\x0A""log-rcodes"
+#define MOD_SAMPLE	"\x0B""sample-rate"
+#define MOD_QSIZE	"\x0A""queue-size"
 
 const yp_item_t scheme_mod_dnstap[] = {
 	{ C_ID,          YP_TSTR,  YP_VNONE },
@@ -37,6 +40,10 @@ const yp_item_t scheme_mod_dnstap[] = {
 	{ MOD_VERSION,   YP_TSTR,  YP_VSTR = { "Knot DNS " PACKAGE_VERSION } },
 	{ MOD_QUERIES,   YP_TBOOL, YP_VBOOL = { true } },
 	{ MOD_RESPONSES, YP_TBOOL, YP_VBOOL = { true } },
+	{ MOD_RCODES,    YP_TOPT,  YP_VOPT = { knot_rcode_names, KNOT_RCODE_NOERROR },
+	                           YP_FMULTI },
+	{ MOD_SAMPLE,    YP_TINT,  YP_VINT = { 1, UINT32_MAX, 1 } },
+	{ MOD_QSIZE,     YP_TINT,  YP_VINT = { 2, 16384, 16 } },
 	{ C_COMMENT,     YP_TSTR,  YP_VNONE },
 	{ NULL }
 };
@@ -50,33 +57,65 @@ int check_mod_dnstap(conf_check_t *args)
 		return KNOT_EINVAL;
 	}
 
+	conf_val_t qsize = conf_rawid_get_txn(args->conf, args->txn, C_MOD_DNSTAP,
+	                                      MOD_QSIZE, args->id, args->id_len);
+	int64_t size = conf_int(&qsize);
+	if ((size & (size - 1)) != 0) {
+		args->err_str = "queue size must be a power of two";
+		return KNOT_EINVAL;
+	}
+
 	return KNOT_EOK;
 }
 
+/*! \brief Preallocated frame size, larger frames are allocated on demand. */
+#define FRAME_SIZE	2048
+
+/*! \brief Per-thread logging state. */
+typedef struct {
+	uint8_t *frames;          /*!< Preallocated frames. */
+	uint8_t *busy;            /*!< Frames owned by the I/O thread. */
+	unsigned next;            /*!< Next frame in the ring. */
+	uint32_t counter;         /*!< Transaction counter for the sampling. */
+	bool pending;             /*!< Transaction started in the begin step. */
+	bool sampled;             /*!< Transaction is logged. */
+	struct timeval qtime;     /*!< Transaction start time. */
+	size_t dropped;           /*!< Messages dropped due to a full queue. */
+} dnstap_thread_t;
+
 typedef struct {
 	struct fstrm_iothr *iothread;
-	char *identity;
-	size_t identity_len;
-	char *version;
-	size_t version_len;
+	dt_encoder_t encoder;
+	dnstap_thread_t *threads;
+	size_t thread_count;
+	size_t frame_count;       /*!< Frames per thread, also the queue size. */
+	uint8_t *frames;
+	uint8_t *busy;
+	uint32_t sample_rate;
+	uint32_t rcodes;          /*!< Bitmap of the logged RCODEs or 0 for all. */
+	bool log_queries;
+	bool log_responses;
 } dnstap_ctx_t;
 
-static int log_message(int state, const knot_pkt_t *pkt, struct query_data *qdata,
-                       dnstap_ctx_t *ctx)
+static dnstap_thread_t *get_thread(dnstap_ctx_t *ctx, struct query_data *qdata)
 {
-	if (pkt == NULL || qdata == NULL || ctx == NULL) {
-		return KNOT_STATE_FAIL;
-	}
+	unsigned id = qdata->param->thread_id;
+	return (id < ctx->thread_count) ? &ctx->threads[id] : NULL;
+}
 
-	int ret = KNOT_ERROR;
+/*! \brief Returns the frame to the ring, called from the I/O thread. */
+static void frame_release(void *frame, void *busy)
+{
+	__sync_lock_release((uint8_t *)busy);
+}
+
+static void log_message(dnstap_ctx_t *ctx, dnstap_thread_t *thr,
+                        struct query_data *qdata, const knot_pkt_t *pkt,
+                        const struct timeval *rtime)
+{
 	struct fstrm_iothr_queue *ioq =
 		fstrm_iothr_get_input_queue_idx(ctx->iothread, qdata->param->thread_id);
 
-	/* Unless we want to measure the time it takes to process each query,
-	 * we can treat Q/R times the same. */
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-
 	/* Determine query / response. */
 	Dnstap__Message__Type msgtype = DNSTAP__MESSAGE__TYPE__AUTH_QUERY;
 	if (knot_wire_get_qr(pkt->wire)) {
@@ -89,67 +128,131 @@ static int log_message(int state, const knot_pkt_t *pkt, struct query_data *qdat
 		protocol = IPPROTO_UDP;
 	}
 
-	/* Create a dnstap message. */
-	Dnstap__Message msg;
-	ret = dt_message_fill(&msg, msgtype,
-	                      (const struct sockaddr *)qdata->param->remote,
-	                      NULL, /* todo: fill me! */
-	                      protocol,
-	                      pkt->wire, pkt->size, &tv, &tv);
-	if (ret != KNOT_EOK) {
-		return KNOT_STATE_FAIL;
+	/* Use the next frame of the ring unless the message is too large. */
+	size_t size = dt_encoder_max_size(&ctx->encoder, pkt->size);
+	uint8_t *busy = NULL;
+	uint8_t *frame = NULL;
+	if (size <= FRAME_SIZE) {
+		busy = &thr->busy[thr->next];
+		if (__sync_lock_test_and_set(busy, 1) != 0) {
+			/* The I/O thread still owns the frame. */
+			thr->dropped++;
+			return;
+		}
+		frame = thr->frames + thr->next * FRAME_SIZE;
+		size = FRAME_SIZE;
+	} else {
+		frame = malloc(size);
+		if (frame == NULL) {
+			thr->dropped++;
+			return;
+		}
 	}
-	Dnstap__Dnstap dnstap = DNSTAP__DNSTAP__INIT;
-	dnstap.type = DNSTAP__DNSTAP__TYPE__MESSAGE;
-	dnstap.message = (Dnstap__Message *)&msg;
 
-	/* Set message version and identity. */
-	if (ctx->identity_len > 0) {
-		dnstap.identity.data = (uint8_t *)ctx->identity;
-		dnstap.identity.len = ctx->identity_len;
-		dnstap.has_identity = 1;
+	int ret = dt_encode(&ctx->encoder, frame, &size, msgtype,
+	                    (const struct sockaddr *)qdata->param->remote,
+	                    NULL, /* todo: fill me! */
+	                    protocol, pkt->wire, pkt->size, &thr->qtime, rtime);
+
+	/* Submit a request, never wait for the I/O thread. */
+	fstrm_res res = fstrm_res_failure;
+	if (ret == KNOT_EOK) {
+		if (busy != NULL) {
+			res = fstrm_iothr_submit(ctx->iothread, ioq, frame, size,
+			                         frame_release, busy);
+		} else {
+			res = fstrm_iothr_submit(ctx->iothread, ioq, frame, size,
+			                         fstrm_free_wrapper, NULL);
+		}
 	}
-	if (ctx->version_len > 0) {
-		dnstap.version.data = (uint8_t *)ctx->version;
-		dnstap.version.len = ctx->version_len;
-		dnstap.has_version = 1;
+	if (res != fstrm_res_success) {
+		if (busy != NULL) {
+			__sync_lock_release(busy);
+		} else {
+			free(frame);
+		}
+		thr->dropped++;
+		return;
 	}
 
-	/* Pack the message. */
-	uint8_t *frame = NULL;
-	size_t size = 0;
-	dt_pack(&dnstap, &frame, &size);
-	if (frame == NULL) {
+	if (busy != NULL) {
+		thr->next = (thr->next + 1) % ctx->frame_count;
+	}
+}
+
+/*! \brief Starts the transaction and decides if it's sampled. */
+static void transaction_begin(dnstap_ctx_t *ctx, dnstap_thread_t *thr)
+{
+	thr->pending = true;
+	thr->sampled = (thr->counter++ % ctx->sample_rate == 0);
+	if (thr->sampled) {
+		gettimeofday(&thr->qtime, NULL);
+	}
+}
+
+static int dnstap_begin(int state, knot_pkt_t *pkt, struct query_data *qdata,
+                        void *ctx)
+{
+	if (qdata == NULL || ctx == NULL) {
 		return KNOT_STATE_FAIL;
 	}
 
-	/* Submit a request. */
-	fstrm_res res = fstrm_iothr_submit(ctx->iothread, ioq, frame, size,
-	                                   fstrm_free_wrapper, NULL);
-	if (res != fstrm_res_success) {
-		free(frame);
-		state = KNOT_STATE_FAIL;
+	dnstap_ctx_t *dctx = ctx;
+	dnstap_thread_t *thr = get_thread(dctx, qdata);
+	if (thr == NULL) {
+		return state;
+	}
+
+	transaction_begin(dctx, thr);
+
+	/* Log the query now unless it depends on the resulting RCODE. */
+	if (thr->sampled && dctx->log_queries && dctx->rcodes == 0) {
+		log_message(dctx, thr, qdata, qdata->query, NULL);
 	}
 
 	return state;
 }
 
-/*! \brief Submit message - query. */
-static int dnstap_message_log_query(int state, knot_pkt_t *pkt, struct query_data *qdata,
-                                    void *ctx)
+static int dnstap_end(int state, knot_pkt_t *pkt, struct query_data *qdata,
+                      void *ctx)
 {
-	if (qdata == NULL) {
+	if (pkt == NULL || qdata == NULL || ctx == NULL) {
 		return KNOT_STATE_FAIL;
 	}
 
-	return log_message(state, qdata->query, qdata, ctx);
-}
+	dnstap_ctx_t *dctx = ctx;
+	dnstap_thread_t *thr = get_thread(dctx, qdata);
+	if (thr == NULL) {
+		return state;
+	}
 
-/*! \brief Submit message - response. */
-static int dnstap_message_log_response(int state, knot_pkt_t *pkt, struct query_data *qdata,
-                                       void *ctx)
-{
-	return log_message(state, pkt, qdata, ctx);
+	/* The begin step is skipped for malformed queries. */
+	bool query_logged = thr->pending && dctx->rcodes == 0;
+	if (!thr->pending) {
+		transaction_begin(dctx, thr);
+	}
+	thr->pending = false;
+
+	if (!thr->sampled) {
+		return state;
+	}
+
+	if (dctx->rcodes != 0 &&
+	    (qdata->rcode >= 32 || !(dctx->rcodes & (1 << qdata->rcode)))) {
+		return state;
+	}
+
+	if (dctx->log_queries && !query_logged) {
+		log_message(dctx, thr, qdata, qdata->query, NULL);
+	}
+
+	if (dctx->log_responses) {
+		struct timeval rtime;
+		gettimeofday(&rtime, NULL);
+		log_message(dctx, thr, qdata, pkt, &rtime);
+	}
+
+	return state;
 }
 
 /*! \brief Create a UNIX socket sink. */
@@ -220,6 +323,36 @@ static struct fstrm_writer* dnstap_writer(const char *path)
 	return dnstap_file_writer(path);
 }
 
+static void threads_deinit(dnstap_ctx_t *ctx)
+{
+	free(ctx->threads);
+	free(ctx->frames);
+	free(ctx->busy);
+	ctx->threads = NULL;
+	ctx->frames = NULL;
+	ctx->busy = NULL;
+}
+
+static int threads_init(dnstap_ctx_t *ctx, size_t count, size_t frame_count)
+{
+	ctx->threads = calloc(count, sizeof(dnstap_thread_t));
+	ctx->frames = malloc(count * frame_count * FRAME_SIZE);
+	ctx->busy = calloc(count, frame_count);
+	if (ctx->threads == NULL || ctx->frames == NULL || ctx->busy == NULL) {
+		threads_deinit(ctx);
+		return KNOT_ENOMEM;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		ctx->threads[i].frames = ctx->frames + i * frame_count * FRAME_SIZE;
+		ctx->threads[i].busy = ctx->busy + i * frame_count;
+	}
+	ctx->thread_count = count;
+	ctx->frame_count = frame_count;
+
+	return KNOT_EOK;
+}
+
 int dnstap_load(struct query_plan *plan, struct query_module *self,
                 const knot_dname_t *zone)
 {
@@ -232,33 +365,61 @@ int dnstap_load(struct query_plan *plan, struct query_module *self,
 	if (ctx == NULL) {
 		return KNOT_ENOMEM;
 	}
+	memset(ctx, 0, sizeof(*ctx));
 
 	conf_val_t val;
 
 	/* Set identity. */
+	char *identity = NULL;
 	val = conf_mod_get(self->config, MOD_IDENTITY, self->id);
 	if (val.code == KNOT_EOK) {
-		ctx->identity = strdup(conf_str(&val));
+		identity = strdup(conf_str(&val));
 	} else {
-		ctx->identity = sockaddr_hostname();
+		identity = sockaddr_hostname();
 	}
-	ctx->identity_len = (ctx->identity != NULL) ? strlen(ctx->identity) : 0;
 
 	/* Set version. */
 	val = conf_mod_get(self->config, MOD_VERSION, self->id);
-	ctx->version = strdup(conf_str(&val));
-	ctx->version_len = strlen(ctx->version);
+	const char *version = conf_str(&val);
+
+	/* Prepare the frame header. */
+	int ret = dt_encoder_init(&ctx->encoder, identity, version);
+	free(identity);
+	if (ret != KNOT_EOK) {
+		mm_free(self->mm, ctx);
+		return ret;
+	}
 
 	val = conf_mod_get(self->config, MOD_SINK, self->id);
 	const char *sink = conf_str(&val);
 
 	/* Set log_queries. */
 	val = conf_mod_get(self->config, MOD_QUERIES, self->id);
-	const bool log_queries = conf_bool(&val);
+	ctx->log_queries = conf_bool(&val);
 
 	/* Set log_responses. */
 	val = conf_mod_get(self->config, MOD_RESPONSES, self->id);
-	const bool log_responses = conf_bool(&val);
+	ctx->log_responses = conf_bool(&val);
+
+	/* Set RCODE filter. */
+	val = conf_mod_get(self->config, MOD_RCODES, self->id);
+	while (val.code == KNOT_EOK) {
+		ctx->rcodes |= 1 << conf_opt(&val);
+		conf_val_next(&val);
+	}
+
+	/* Set sampling. */
+	val = conf_mod_get(self->config, MOD_SAMPLE, self->id);
+	ctx->sample_rate = conf_int(&val);
+
+	/* Initialize per-thread states. */
+	val = conf_mod_get(self->config, MOD_QSIZE, self->id);
+	size_t qsize = conf_int(&val);
+	size_t qcount = conf_udp_threads(self->config) +
+	                conf_tcp_threads(self->config);
+	if (threads_init(ctx, qcount, qsize) != KNOT_EOK) {
+		goto fail;
+	}
 
 	/* Initialize the writer and the options. */
 	struct fstrm_writer *writer = dnstap_writer(sink);
@@ -272,10 +433,10 @@ int dnstap_load(struct query_plan *plan, struct query_module *self,
 		goto fail;
 	}
 
-	/* Initialize queues. */
-	size_t qcount = conf_udp_threads(self->config) +
-	                conf_tcp_threads(self->config);
+	/* Initialize queues, one producer each, sized to the frame ring. */
 	fstrm_iothr_options_set_num_input_queues(opt, qcount);
+	fstrm_iothr_options_set_input_queue_size(opt, qsize);
+	fstrm_iothr_options_set_queue_model(opt, FSTRM_IOTHR_QUEUE_MODEL_SPSC);
 
 	/* Create the I/O thread. */
 	ctx->iothread = fstrm_iothr_init(opt, &writer);
@@ -288,19 +449,17 @@ int dnstap_load(struct query_plan *plan, struct query_module *self,
 	self->ctx = ctx;
 
 	/* Hook to the query plan. */
-	if (log_queries) {
-		query_plan_step(plan, QPLAN_BEGIN, dnstap_message_log_query, self->ctx);
-	}
-	if (log_responses) {
-		query_plan_step(plan, QPLAN_END, dnstap_message_log_response, self->ctx);
+	if (ctx->log_queries || ctx->log_responses) {
+		query_plan_step(plan, QPLAN_BEGIN, dnstap_begin, self->ctx);
+		query_plan_step(plan, QPLAN_END, dnstap_end, self->ctx);
 	}
 
 	return KNOT_EOK;
 fail:
 	MODULE_ERR(C_MOD_DNSTAP, "failed to init sink '%s'", sink);
 
-	free(ctx->identity);
-	free(ctx->version);
+	dt_encoder_deinit(&ctx->encoder);
+	threads_deinit(ctx);
 	mm_free(self->mm, ctx);
 
 	return KNOT_ENOMEM;
@@ -314,9 +473,20 @@ int dnstap_unload(struct query_module *self)
 
 	dnstap_ctx_t *ctx = self->ctx;
 
+	/* Flushes the queued frames, releasing them back to the rings. */
 	fstrm_iothr_destroy(&ctx->iothread);
-	free(ctx->identity);
-	free(ctx->version);
+
+	size_t dropped = 0;
+	for (size_t i = 0; i < ctx->thread_count; i++) {
+		dropped += ctx->threads[i].dropped;
+	}
+	if (dropped > 0) {
+		log_warning("module '%.*s', dropped %zu messages",
+		            C_MOD_DNSTAP[0], C_MOD_DNSTAP + 1, dropped);
+	}
+
+	dt_encoder_deinit(&ctx->encoder);
+	threads_deinit(ctx);
 	mm_free(self->mm, ctx);
 
 	return KNOT_EOK;
@@ -0,0 +1,527 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "contrib/lpm.h"
+#include "contrib/sockaddr.h"
+#include "knot/modules/subnet_view/subnet_view.h"
+#include "knot/zone/contents.h"
+#include "zscanner/scanner.h"
+
+/* Module configuration scheme. */
+#define MOD_NET		"\x07""network"
+#define MOD_FILE	"\x04""file"
+
+const yp_item_t scheme_mod_subnet_view[] = {
+	{ C_ID,      YP_TSTR,  YP_VNONE },
+	{ MOD_NET,   YP_TDATA, YP_VDATA = { 0, NULL, addr_range_to_bin,
+	                                    addr_range_to_txt }, YP_FMULTI },
+	{ MOD_FILE,  YP_TSTR,  YP_VNONE },
+	{ C_COMMENT, YP_TSTR,  YP_VNONE },
+	{ NULL }
+};
+
+int check_mod_subnet_view(conf_check_t *args)
+{
+	// Check networks.
+	conf_val_t net = conf_rawid_get_txn(args->conf, args->txn, C_MOD_SUBNET_VIEW,
+	                                    MOD_NET, args->id, args->id_len);
+	if (net.code != KNOT_EOK) {
+		args->err_str = "no network subnet specified";
+		return KNOT_EINVAL;
+	}
+	while (net.code == KNOT_EOK) {
+		struct sockaddr_storage max;
+		int prefix;
+		conf_addr_range(&net, &max, &prefix);
+		if (max.ss_family != AF_UNSPEC) {
+			args->err_str = "network range not supported";
+			return KNOT_EINVAL;
+		}
+		conf_val_next(&net);
+	}
+
+	// Check records file.
+	conf_val_t file = conf_rawid_get_txn(args->conf, args->txn, C_MOD_SUBNET_VIEW,
+	                                     MOD_FILE, args->id, args->id_len);
+	if (file.code != KNOT_EOK) {
+		args->err_str = "no records file specified";
+		return KNOT_EINVAL;
+	}
+
+	return KNOT_EOK;
+}
+
+/*! \brief Client network of a view. */
+typedef struct {
+	struct sockaddr_storage addr;
+	unsigned prefix;
+} view_net_t;
+
+struct view_selector;
+
+/*! \brief View records and networks, context of a module instance. */
+typedef struct {
+	struct view_selector *selector;
+	zone_contents_t *contents;
+	view_net_t *nets;
+	size_t net_count;
+} view_t;
+
+/*!
+ * \brief Views of a zone, shared by all the module instances in the zone.
+ *
+ * The networks of all the views are compiled into one table, so that
+ * the longest network is selected across the views.
+ */
+typedef struct view_selector {
+	lpm_t *lpm;
+	view_t **views;    /*!< Views indexed by the table value minus one. */
+	size_t count;
+} view_selector_t;
+
+/*! \brief View records loading context. */
+typedef struct {
+	zone_contents_t *contents;
+	const knot_dname_t *zone;
+	int ret;
+} view_loader_t;
+
+static void load_record(zs_scanner_t *scanner)
+{
+	view_loader_t *loader = scanner->process.data;
+
+	knot_rrset_t rr;
+	knot_rrset_init(&rr, scanner->r_owner, scanner->r_type, scanner->r_class);
+
+	knot_rdata_t rdata[knot_rdata_array_size(scanner->r_data_length)];
+	knot_rdata_init(rdata, scanner->r_data_length, scanner->r_data,
+	                scanner->r_ttl);
+	rr.rrs.rr_count = 1;
+	rr.rrs.data = rdata;
+
+	int ret = knot_rrset_rr_to_canonical(&rr);
+	if (ret == KNOT_EOK) {
+		zone_node_t *node = NULL;
+		ret = zone_contents_add_rr(loader->contents, &rr, &node);
+	}
+	if (ret != KNOT_EOK) {
+		MODULE_ZONE_ERR(C_MOD_SUBNET_VIEW, loader->zone,
+		                "failed to add record, file '%s', line %"PRIu64" (%s)",
+		                scanner->file.name, scanner->line_counter,
+		                knot_strerror(ret));
+		loader->ret = ret;
+		scanner->state = ZS_STATE_STOP;
+	}
+}
+
+static void load_error(zs_scanner_t *scanner)
+{
+	view_loader_t *loader = scanner->process.data;
+
+	MODULE_ZONE_ERR(C_MOD_SUBNET_VIEW, loader->zone,
+	                "error in records, file '%s', line %"PRIu64" (%s)",
+	                scanner->file.name, scanner->line_counter,
+	                zs_strerror(scanner->error.code));
+	loader->ret = KNOT_EPARSEFAIL;
+	scanner->state = ZS_STATE_STOP;
+}
+
+static int view_load_records(view_t *view, const char *file,
+                             const knot_dname_t *zone)
+{
+	char *origin = knot_dname_to_str_alloc(zone);
+	if (origin == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	zs_scanner_t *scanner = malloc(sizeof(zs_scanner_t));
+	view_loader_t loader = {
+		.contents = zone_contents_new(zone),
+		.zone = zone,
+		.ret = KNOT_EOK
+	};
+	if (scanner == NULL || loader.contents == NULL) {
+		zone_contents_deep_free(&loader.contents);
+		free(scanner);
+		free(origin);
+		return KNOT_ENOMEM;
+	}
+
+	if (zs_init(scanner, origin, KNOT_CLASS_IN, 3600) != 0 ||
+	    zs_set_input_file(scanner, file) != 0 ||
+	    zs_set_processing(scanner, load_record, load_error, &loader) != 0) {
+		MODULE_ZONE_ERR(C_MOD_SUBNET_VIEW, zone,
+		                "failed to open records file '%s' (%s)",
+		                file, zs_strerror(scanner->error.code));
+		loader.ret = KNOT_EFILE;
+	} else if (zs_parse_all(scanner) != 0 && loader.ret == KNOT_EOK) {
+		MODULE_ZONE_ERR(C_MOD_SUBNET_VIEW, zone,
+		                "failed to load records file '%s' (%s)",
+		                file, zs_strerror(scanner->error.code));
+		loader.ret = KNOT_EPARSEFAIL;
+	}
+
+	zs_deinit(scanner);
+	free(scanner);
+	free(origin);
+
+	if (loader.ret != KNOT_EOK) {
+		zone_contents_deep_free(&loader.contents);
+		return loader.ret;
+	}
+
+	view->contents = loader.contents;
+
+	return KNOT_EOK;
+}
+
+static int view_load_nets(view_t *view, conf_val_t *val)
+{
+	view->nets = calloc(conf_val_count(val), sizeof(view_net_t));
+	if (view->nets == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	while (val->code == KNOT_EOK) {
+		view_net_t *net = &view->nets[view->net_count++];
+		struct sockaddr_storage max;
+		int prefix;
+		net->addr = conf_addr_range(val, &max, &prefix);
+		if (prefix < 0) {
+			// Single address.
+			prefix = (net->addr.ss_family == AF_INET) ?
+			         IPV4_PREFIXLEN : IPV6_PREFIXLEN;
+		}
+		net->prefix = prefix;
+		conf_val_next(val);
+	}
+
+	return KNOT_EOK;
+}
+
+static void view_free(view_t *view)
+{
+	zone_contents_deep_free(&view->contents);
+	free(view->nets);
+	free(view);
+}
+
+/*! \brief Compiles the networks of all the views. */
+static int selector_build(view_selector_t *selector)
+{
+	lpm_t *lpm = lpm_new();
+	if (lpm == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	for (size_t i = 0; i < selector->count; i++) {
+		const view_t *view = selector->views[i];
+		for (size_t j = 0; j < view->net_count; j++) {
+			const view_net_t *net = &view->nets[j];
+			int ret = lpm_add(lpm, (const struct sockaddr *)&net->addr,
+			                  net->prefix, i + 1);
+			if (ret != KNOT_EOK) {
+				lpm_free(lpm);
+				return ret;
+			}
+		}
+	}
+
+	int ret = lpm_build(lpm);
+	if (ret != KNOT_EOK) {
+		lpm_free(lpm);
+		return ret;
+	}
+
+	lpm_free(selector->lpm);
+	selector->lpm = lpm;
+
+	return KNOT_EOK;
+}
+
+static int put_ecs(knot_pkt_t *pkt, struct query_data *qdata,
+                   const knot_edns_client_subnet_t *ecs)
+{
+	if (knot_rrset_empty(&qdata->opt_rr)) {
+		return KNOT_EOK;
+	}
+
+	uint16_t size = knot_edns_client_subnet_size(ecs);
+
+	/* The OPT RR size was reserved before the option was added. */
+	int ret = knot_pkt_reserve(pkt, KNOT_EDNS_OPTION_HDRLEN + size);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	uint8_t *data = NULL;
+	ret = knot_edns_reserve_option(&qdata->opt_rr, KNOT_EDNS_OPTION_CLIENT_SUBNET,
+	                               size, &data, qdata->mm);
+	if (ret != KNOT_EOK) {
+		knot_pkt_reclaim(pkt, KNOT_EDNS_OPTION_HDRLEN + size);
+		return ret;
+	}
+
+	return knot_edns_client_subnet_write(data, size, ecs);
+}
+
+static int view_put(knot_pkt_t *pkt, const knot_rrset_t *rr)
+{
+	if (knot_rrset_empty(rr)) {
+		return KNOT_ENOENT;
+	}
+
+	return knot_pkt_put(pkt, KNOT_COMPR_HINT_NONE, rr, 0);
+}
+
+/*! \brief Answers from the view if the zone contents don't satisfy the query. */
+static int view_solve(int state, knot_pkt_t *pkt, struct query_data *qdata,
+                      const view_t *view)
+{
+	const zone_node_t *node = zone_contents_find_node(view->contents, qdata->name);
+	if (node == NULL) {
+		return state;
+	}
+
+	int ret = KNOT_ENOENT;
+	uint16_t qtype = knot_pkt_qtype(qdata->query);
+	if (qtype == KNOT_RRTYPE_ANY) {
+		for (uint16_t i = 0; i < node->rrset_count; i++) {
+			knot_rrset_t rr = node_rrset_at(node, i);
+			ret = view_put(pkt, &rr);
+			if (ret != KNOT_EOK) {
+				break;
+			}
+		}
+	} else {
+		knot_rrset_t rr = node_rrset(node, qtype);
+		if (knot_rrset_empty(&rr)) {
+			rr = node_rrset(node, KNOT_RRTYPE_CNAME);
+		}
+		ret = view_put(pkt, &rr);
+	}
+
+	switch (ret) {
+	case KNOT_EOK:
+		qdata->rcode = KNOT_RCODE_NOERROR;
+		return HIT;
+	case KNOT_ENOENT:
+		/* The name exists in the view, so it isn't a name error. */
+		qdata->rcode = KNOT_RCODE_NOERROR;
+		return NODATA;
+	case KNOT_ESPACE:
+		return TRUNC;
+	default:
+		return ERROR;
+	}
+}
+
+static int view_answer(int state, knot_pkt_t *pkt, struct query_data *qdata,
+                       void *ctx)
+{
+	if (pkt == NULL || qdata == NULL || ctx == NULL) {
+		return ERROR;
+	}
+
+	view_selector_t *selector = ctx;
+
+	/* Select the view by the client subnet if present. */
+	struct sockaddr_storage client;
+	unsigned client_len;
+	knot_edns_client_subnet_t ecs;
+	bool has_ecs = false;
+
+	uint8_t *opt = NULL;
+	if (qdata->query->opt_rr != NULL) {
+		opt = knot_edns_get_option(qdata->query->opt_rr,
+		                           KNOT_EDNS_OPTION_CLIENT_SUBNET);
+	}
+	if (opt != NULL) {
+		/* Malformed option or non-zero scope results in FORMERR (RFC 7871, 7.1.1). */
+		int ret = knot_edns_client_subnet_parse(&ecs, knot_edns_opt_get_data(opt),
+		                                        knot_edns_opt_get_length(opt));
+		if (ret != KNOT_EOK || ecs.scope_len != 0 ||
+		    knot_edns_client_subnet_get_addr(&client, &ecs) != KNOT_EOK) {
+			qdata->rcode = KNOT_RCODE_FORMERR;
+			return ERROR;
+		}
+		client_len = ecs.source_len;
+		has_ecs = true;
+	} else {
+		client = *qdata->param->remote;
+		client_len = IPV6_PREFIXLEN; // Limited to the address length.
+	}
+
+	size_t addr_len = 0;
+	const uint8_t *addr = sockaddr_raw((struct sockaddr *)&client, &addr_len);
+
+	unsigned scope = 0;
+	uint16_t id = lpm_lookup(selector->lpm, client.ss_family, addr,
+	                         client_len, &scope);
+
+	/* Echo the client subnet with the scope the view selection depends on. */
+	if (has_ecs) {
+		ecs.scope_len = scope;
+		if (put_ecs(pkt, qdata, &ecs) != KNOT_EOK) {
+			return ERROR;
+		}
+	}
+
+	/* Applicable when the zone contents don't satisfy the query. */
+	if (id == LPM_NONE || (state != MISS && state != NODATA)) {
+		return state;
+	}
+
+	return view_solve(state, pkt, qdata, selector->views[id - 1]);
+}
+
+/*! \brief Finds the views of the zone loaded by the other module instances. */
+static view_selector_t *selector_find(struct query_plan *plan)
+{
+	struct query_step *step = NULL;
+	WALK_LIST(step, plan->stage[QPLAN_ANSWER]) {
+		if (step->process == view_answer) {
+			return step->ctx;
+		}
+	}
+
+	return NULL;
+}
+
+int subnet_view_load(struct query_plan *plan, struct query_module *self,
+                     const knot_dname_t *zone)
+{
+	if (plan == NULL || self == NULL || zone == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	view_t *view = calloc(1, sizeof(*view));
+	if (view == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	conf_val_t val = conf_mod_get(self->config, MOD_NET, self->id);
+	int ret = view_load_nets(view, &val);
+	if (ret != KNOT_EOK) {
+		view_free(view);
+		return ret;
+	}
+
+	val = conf_zone_get(self->config, C_STORAGE, zone);
+	char *storage = conf_abs_path(&val, NULL);
+	val = conf_mod_get(self->config, MOD_FILE, self->id);
+	char *file = conf_abs_path(&val, storage);
+	free(storage);
+	ret = (file != NULL) ? view_load_records(view, file, zone) : KNOT_ENOMEM;
+	free(file);
+	if (ret != KNOT_EOK) {
+		view_free(view);
+		return ret;
+	}
+
+	/* Join the views of the other instances or create the first one. */
+	view_selector_t *selector = selector_find(plan);
+	bool first = (selector == NULL);
+	if (first) {
+		selector = calloc(1, sizeof(*selector));
+		if (selector == NULL) {
+			view_free(view);
+			return KNOT_ENOMEM;
+		}
+	}
+
+	view_t **views = realloc(selector->views,
+	                         (selector->count + 1) * sizeof(view_t *));
+	if (views == NULL) {
+		ret = KNOT_ENOMEM;
+		goto failed;
+	}
+	selector->views = views;
+	selector->views[selector->count++] = view;
+
+	ret = selector_build(selector);
+	if (ret != KNOT_EOK) {
+		selector->count--;
+		if (ret == KNOT_EEXIST) {
+			MODULE_ZONE_ERR(C_MOD_SUBNET_VIEW, zone,
+			                "duplicate network in the views");
+		}
+		goto failed;
+	}
+
+	if (first) {
+		ret = query_plan_step(plan, QPLAN_ANSWER, view_answer, selector);
+		if (ret != KNOT_EOK) {
+			selector->count--;
+			goto failed;
+		}
+	}
+
+	view->selector = selector;
+	self->ctx = view;
+
+	return KNOT_EOK;
+failed:
+	if (first) {
+		lpm_free(selector->lpm);
+		free(selector->views);
+		free(selector);
+	}
+	view_free(view);
+	return ret;
+}
+
+int subnet_view_unload(struct query_module *self)
+{
+	if (self == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	view_t *view = self->ctx;
+	view_selector_t *selector = view->selector;
+
+	/* Remove the view, the following ones move to its index. */
+	for (size_t i = 0; i < selector->count; i++) {
+		if (selector->views[i] == view) {
+			memmove(selector->views + i, selector->views + i + 1,
+			        (selector->count - i - 1) * sizeof(view_t *));
+			selector->count--;
+			break;
+		}
+	}
+	view_free(view);
+
+	/* The selector is freed with the last view. */
+	if (selector->count == 0) {
+		lpm_free(selector->lpm);
+		free(selector->views);
+		free(selector);
+		return KNOT_EOK;
+	}
+
+	/* Renumber the networks, no view is selected if that fails. */
+	int ret = selector_build(selector);
+	if (ret != KNOT_EOK) {
+		lpm_free(selector->lpm);
+		selector->lpm = NULL;
+	}
+
+	return ret;
+}
@@ -323,9 +323,8 @@ static int axfr_answer_finalize(struct answer_data *adata)
 		return rc;
 	}
 
-	conf_val_t val = conf_zone_get(adata->param->conf, C_MAX_ZONE_SIZE,
-	                               proc->contents->apex->owner);
-	int64_t size_limit = conf_int(&val);
+	int64_t size_limit = zone_conf_max_zone_size(adata->param->conf,
+	                                             adata->param->zone);
 
 	if (proc->contents->size > size_limit) {
 		AXFRIN_LOG(LOG_WARNING, "zone size exceeded");
@@ -337,7 +336,6 @@ static int axfr_answer_finalize(struct answer_data *adata)
 	zone_contents_t *old_contents =
 	                zone_switch_contents(zone, proc->contents);
 	zone->flags &= ~ZONE_EXPIRED;
-	synchronize_rcu();
 
 	if (old_contents != NULL) {
 		AXFRIN_LOG(LOG_INFO, "finished, "
@@ -355,7 +353,7 @@ static int axfr_answer_finalize(struct answer_data *adata)
 	}
 
 	/* Do not free new contents with cleanup. */
-	zone_contents_deep_free(&old_contents);
+	zone_contents_retire(zone, &old_contents, NULL);
 	proc->contents = NULL;
 
 	return KNOT_EOK;
@@ -372,9 +370,8 @@ static int axfr_answer_packet(knot_pkt_t *pkt, struct answer_data *adata)
 	proc->npkts  += 1;
 	proc->nbytes += pkt->size;
 
-	conf_val_t val = conf_zone_get(adata->param->conf, C_MAX_ZONE_SIZE,
-	                               proc->contents->apex->owner);
-	int64_t size_limit = conf_int(&val);
+	int64_t size_limit = zone_conf_max_zone_size(adata->param->conf,
+	                                             adata->param->zone);
 
 	/* Init zone creator. */
 	zcreator_t zc = {.z = proc->contents, .master = false, .ret = KNOT_EOK };
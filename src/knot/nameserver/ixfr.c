@@ -395,9 +395,8 @@ static int ixfrin_finalize(struct answer_data *adata)
 		return ret;
 	}
 
-	conf_val_t val = conf_zone_get(adata->param->conf, C_MAX_ZONE_SIZE,
-	                               ixfr->zone->name);
-	const int64_t size_limit = conf_int(&val);
+	const int64_t size_limit = zone_conf_max_zone_size(adata->param->conf,
+	                                                   ixfr->zone);
 
 	if (new_contents->size > size_limit) {
 		IXFRIN_LOG(LOG_WARNING, "zone size exceeded");
@@ -419,7 +418,6 @@ static int ixfrin_finalize(struct answer_data *adata)
 	/* Switch zone contents. */
 	zone_contents_t *old_contents = zone_switch_contents(ixfr->zone, new_contents);
 	ixfr->zone->flags &= ~ZONE_EXPIRED;
-	synchronize_rcu();
 
 	struct timeval now = {0};
 	gettimeofday(&now, NULL);
@@ -430,8 +428,7 @@ static int ixfrin_finalize(struct answer_data *adata)
 	           time_diff(&ixfr->proc.tstamp, &now) / 1000.0,
 	           ixfr->proc.npkts, ixfr->proc.nbytes);
 
-	update_free_zone(&old_contents);
-	update_cleanup(&a_ctx);
+	zone_contents_retire(ixfr->zone, &old_contents, &a_ctx);
 
 	return KNOT_EOK;
 }
@@ -610,9 +607,8 @@ static int process_ixfrin_packet(knot_pkt_t *pkt, struct answer_data *adata)
 	ixfr->proc.npkts  += 1;
 	ixfr->proc.nbytes += pkt->size;
 
-	conf_val_t val = conf_zone_get(adata->param->conf, C_MAX_ZONE_SIZE,
-	                               ixfr->zone->name);
-	const int64_t size_limit = conf_int(&val);
+	const int64_t size_limit = zone_conf_max_zone_size(adata->param->conf,
+	                                                   ixfr->zone);
 
 	// Process RRs in the message.
 	const knot_pktsection_t *answer = knot_pkt_section(pkt, KNOT_ANSWER);
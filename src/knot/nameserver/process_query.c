@@ -14,6 +14,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <time.h>
 #include <urcu.h>
 
 #include "dnssec/tsig.h"
@@ -29,6 +30,7 @@
 #include "knot/nameserver/nsec_proofs.h"
 #include "knot/nameserver/notify.h"
 #include "libknot/libknot.h"
+#include "libknot/rrtype/opt-cookie.h"
 #include "contrib/macros.h"
 #include "contrib/mempattern.h"
 
@@ -208,6 +210,56 @@ static int answer_edns_reserve(knot_pkt_t *resp, struct query_data *qdata)
 	return knot_pkt_reserve(resp, knot_edns_wire_size(&qdata->opt_rr));
 }
 
+static int answer_edns_cookie(const knot_pkt_t *query, struct query_data *qdata)
+{
+	cookie_secret_t *secrets = qdata->param->server->cookies;
+	uint8_t *opt = knot_edns_get_option(query->opt_rr, KNOT_EDNS_OPTION_COOKIE);
+	if (opt == NULL || secrets == NULL) {
+		return KNOT_EOK;
+	}
+
+	/* Malformed COOKIE option results in FORMERR (RFC 7873, 5.2.2). */
+	struct knot_dns_cookies cookies = { 0 };
+	int ret = knot_edns_opt_cookie_parse(knot_edns_opt_get_data(opt),
+	                                     knot_edns_opt_get_length(opt),
+	                                     &cookies.cc, &cookies.cc_len,
+	                                     &cookies.sc, &cookies.sc_len);
+	if (ret != KNOT_EOK) {
+		qdata->rcode = KNOT_RCODE_FORMERR;
+		return KNOT_EOK;
+	}
+
+	const struct sockaddr *remote = (const struct sockaddr *)qdata->param->remote;
+	uint32_t now = time(NULL);
+
+	/* Valid server cookie proves the client address isn't spoofed. */
+	if (cookies.sc != NULL) {
+		qdata->cookie_valid = (cookie_check(secrets, &cookies, remote, now) == KNOT_EOK);
+	}
+
+	/* Always hand out a fresh server cookie. */
+	uint8_t sc[COOKIE_SRVR_LEN];
+	uint16_t sc_len = cookie_generate(secrets, &cookies, remote, now, sc, sizeof(sc));
+	if (sc_len == 0) {
+		return KNOT_ERROR;
+	}
+
+	uint16_t data_len = knot_edns_opt_cookie_data_len(cookies.cc_len, sc_len);
+	uint8_t *data = NULL;
+	ret = knot_edns_reserve_option(&qdata->opt_rr, KNOT_EDNS_OPTION_COOKIE,
+	                               data_len, &data, qdata->mm);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	if (knot_edns_opt_cookie_write(cookies.cc, cookies.cc_len, sc, sc_len,
+	                               data, data_len) == 0) {
+		return KNOT_ERROR;
+	}
+
+	return KNOT_EOK;
+}
+
 static int answer_edns_init(const knot_pkt_t *query, knot_pkt_t *resp,
                             struct query_data *qdata)
 {
@@ -269,6 +321,14 @@ static int answer_edns_init(const knot_pkt_t *query, knot_pkt_t *resp,
 		}
 	}
 
+	/* Append DNS cookies if enabled. */
+	if (conf()->cache.srv_cookies) {
+		ret = answer_edns_cookie(query, qdata);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
 	return answer_edns_reserve(resp, qdata);
 }
 
@@ -337,6 +397,8 @@ static int prepare_answer(const knot_pkt_t *query, knot_pkt_t *resp, knot_layer_
 	/* Update maximal answer size. */
 	bool has_limit = qdata->param->proc_flags & NS_QUERY_LIMIT_SIZE;
 	if (has_limit) {
+		/* The answer buffer may be smaller than the maximal message. */
+		size_t buffer = resp->max_size;
 		resp->max_size = KNOT_WIRE_MIN_PKTSIZE;
 		if (knot_pkt_has_edns(query)) {
 			uint16_t server;
@@ -354,6 +416,7 @@ static int prepare_answer(const knot_pkt_t *query, knot_pkt_t *resp, knot_layer_
 			uint16_t transfer = MIN(client, server);
 			resp->max_size = MAX(resp->max_size, transfer);
 		}
+		resp->max_size = MIN(resp->max_size, buffer);
 	} else {
 		resp->max_size = KNOT_WIRE_MAX_PKTSIZE;
 	}
@@ -425,9 +488,14 @@ static int ratelimit_apply(int state, knot_pkt_t *pkt, knot_layer_t *ctx)
 		return state;
 	}
 
+	/* Exempt clients with a valid server cookie. */
+	if (qdata->cookie_valid) {
+		return state;
+	}
+
 	/* Exempt clients. */
-	conf_val_t *whitelist = &conf()->cache.srv_rate_limit_whitelist;
-	if (conf_addr_range_match(whitelist, qdata->param->remote)) {
+	const addrset_t *whitelist = rcu_dereference(server->rrl_whitelist);
+	if (addrset_match(whitelist, (struct sockaddr *)qdata->param->remote)) {
 		return state;
 	}
 
@@ -568,6 +636,36 @@ finish:
 	return next_state;
 }
 
+/*! \brief Checks the compiled zone ACL if available, the configuration otherwise. */
+static bool acl_check(conf_t *conf, const zone_t *zone, const knot_dname_t *zone_name,
+                      acl_action_t action, const struct sockaddr_storage *addr,
+                      knot_tsig_key_t *tsig, knot_mm_t *mm)
+{
+	if (zone != NULL && knot_dname_is_equal(zone->name, zone_name)) {
+		rcu_read_lock();
+		const zone_conf_cache_t *cache = rcu_dereference(zone->conf_cache);
+		if (cache != NULL) {
+			bool allowed = acl_match(cache->acl, action, addr, tsig);
+			/* The secret must outlive the compiled ACL. */
+			if (allowed && tsig->secret.size > 0) {
+				uint8_t *secret = mm_alloc(mm, tsig->secret.size);
+				if (secret == NULL) {
+					allowed = false;
+				} else {
+					memcpy(secret, tsig->secret.data, tsig->secret.size);
+				}
+				tsig->secret.data = secret;
+			}
+			rcu_read_unlock();
+			return allowed;
+		}
+		rcu_read_unlock();
+	}
+
+	conf_val_t acl = conf_zone_get(conf, C_ACL, zone_name);
+	return acl_allowed(conf, &acl, action, addr, tsig);
+}
+
 bool process_query_acl_check(conf_t *conf, const knot_dname_t *zone_name,
                              acl_action_t action, struct query_data *qdata)
 {
@@ -587,8 +685,8 @@ bool process_query_acl_check(conf_t *conf, const knot_dname_t *zone_name,
 	}
 
 	/* Check if authenticated. */
-	conf_val_t acl = conf_zone_get(conf, C_ACL, zone_name);
-	if (!acl_allowed(conf, &acl, action, query_source, &tsig)) {
+	if (!acl_check(conf, qdata->zone, zone_name, action, query_source,
+	               &tsig, qdata->mm)) {
 		char addr_str[SOCKADDR_STRLEN] = { 0 };
 		sockaddr_tostr(addr_str, sizeof(addr_str), (struct sockaddr *)query_source);
 		const knot_lookup_t *act = knot_lookup_by_id((knot_lookup_t *)acl_actions,
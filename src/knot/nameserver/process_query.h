@@ -62,6 +62,7 @@ struct query_data {
 	/* EDNS */
 	knot_rrset_t opt_rr;
 	uint8_t *opt_rr_pos;  /*!< Place of the OPT RR in wire. */
+	bool cookie_valid;    /*!< Query carries a valid server cookie. */
 
 	/* Extensions. */
 	void *ext;
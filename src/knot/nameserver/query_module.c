@@ -28,6 +28,7 @@
 #endif
 #include "knot/modules/whoami/whoami.h"
 #include "knot/modules/noudp/noudp.h"
+#include "knot/modules/subnet_view/subnet_view.h"
 
 /*! \note All modules should be dynamically loaded later on. */
 static_module_t MODULES[] = {
@@ -42,6 +43,7 @@ static_module_t MODULES[] = {
 #endif
 	{ C_MOD_WHOAMI,       &whoami_load,       &whoami_unload,       MOD_SCOPE_ANY, true },
 	{ C_MOD_NOUDP,        &noudp_load,        &noudp_unload,        MOD_SCOPE_ANY, true },
+	{ C_MOD_SUBNET_VIEW,  &subnet_view_load,  &subnet_view_unload,  MOD_SCOPE_ZONE },
 	{ NULL }
 };
 
@@ -131,7 +131,8 @@ static int process_bulk(zone_t *zone, list_t *requests, zone_update_t *up)
 	return KNOT_EOK;
 }
 
-static int process_normal(conf_t *conf, zone_t *zone, list_t *requests)
+static int process_normal(conf_t *conf, zone_t *zone, list_t *requests,
+                          struct timeval *t_processed)
 {
 	assert(requests);
 
@@ -150,8 +151,9 @@ static int process_normal(conf_t *conf, zone_t *zone, list_t *requests)
 		set_rcodes(requests, KNOT_RCODE_SERVFAIL);
 		return ret;
 	}
+	gettimeofday(t_processed, NULL);
 
-	// Apply changes.
+	// Apply changes (sign, store into journal, switch contents).
 	ret = zone_update_commit(conf, &up);
 	zone_update_clear(&up);
 	if (ret != KNOT_EOK) {
@@ -172,37 +174,45 @@ static int process_normal(conf_t *conf, zone_t *zone, list_t *requests)
 	return KNOT_EOK;
 }
 
-static void process_requests(conf_t *conf, zone_t *zone, list_t *requests)
+/*! \brief Process the updates, returns true if the zone was changed. */
+static bool process_requests(conf_t *conf, zone_t *zone, list_t *requests,
+                             struct timeval *t_queued)
 {
 	assert(zone);
 	assert(requests);
 
 	/* Keep original state. */
-	struct timeval t_start, t_end;
+	struct timeval t_start, t_processed, t_end;
 	gettimeofday(&t_start, NULL);
 	const uint32_t old_serial = zone_contents_serial(zone->contents);
 
 	/* Process authenticated packet. */
-	int ret = process_normal(conf, zone, requests);
+	int ret = process_normal(conf, zone, requests, &t_processed);
 	if (ret != KNOT_EOK) {
 		log_zone_error(zone->name, "DDNS, processing failed (%s)",
 		               knot_strerror(ret));
-		return;
+		return false;
 	}
 
 	/* Evaluate response. */
 	const uint32_t new_serial = zone_contents_serial(zone->contents);
 	if (new_serial == old_serial) {
 		log_zone_info(zone->name, "DDNS, finished, no changes to the zone were made");
-		return;
+		return false;
 	}
 
 	gettimeofday(&t_end, NULL);
 	log_zone_info(zone->name, "DDNS, update finished, serial %u -> %u, "
-	              "%.02f seconds", old_serial, new_serial,
-	              time_diff(&t_start, &t_end) / 1000.0);
+	              "%.02f seconds (queued %.02f, processing %.02f, commit %.02f)",
+	              old_serial, new_serial,
+	              time_diff(&t_start, &t_end) / 1000.0,
+	              time_diff(t_queued, &t_start) / 1000.0,
+	              time_diff(&t_start, &t_processed) / 1000.0,
+	              time_diff(&t_processed, &t_end) / 1000.0);
 
 	zone_events_schedule(zone, ZONE_EVENT_NOTIFY, ZONE_EVENT_NOW);
+
+	return true;
 }
 
 static int remote_forward(conf_t *conf, struct knot_request *request, conf_remote_t *remote)
@@ -326,21 +336,20 @@ static bool update_tsig_check(conf_t *conf, struct query_data *qdata, struct kno
 	return true;
 }
 
-static void send_update_response(conf_t *conf, const zone_t *zone, struct knot_request *req)
+static void send_response(struct knot_request *req, bool sign, int tcp_timeout)
 {
 	if (req->resp) {
-		if (!zone_is_slave(conf, zone)) {
+		if (sign) {
 			// Sign the response with TSIG where applicable
 			struct query_data qdata;
-			init_qdata_from_request(&qdata, zone, req, NULL);
+			init_qdata_from_request(&qdata, NULL, req, NULL);
 
 			(void)process_query_sign_response(req->resp, &qdata);
 		}
 
 		if (net_is_stream(req->fd)) {
-			int timeout = 1000 * conf->cache.srv_tcp_reply_timeout;
 			net_dns_tcp_send(req->fd, req->resp->wire, req->resp->size,
-			                 timeout);
+			                 tcp_timeout);
 		} else {
 			net_dgram_send(req->fd, req->resp->wire, req->resp->size,
 			               (struct sockaddr *)&req->remote);
@@ -348,6 +357,12 @@ static void send_update_response(conf_t *conf, const zone_t *zone, struct knot_r
 	}
 }
 
+static void send_update_response(conf_t *conf, const zone_t *zone, struct knot_request *req)
+{
+	send_response(req, !zone_is_slave(conf, zone),
+	              1000 * conf->cache.srv_tcp_reply_timeout);
+}
+
 static void free_request(struct knot_request *req)
 {
 	close(req->fd);
@@ -367,6 +382,64 @@ static void send_update_responses(conf_t *conf, const zone_t *zone, list_t *upda
 	ptrlist_free(updates, NULL);
 }
 
+/*! \brief DDNS responses waiting for the journal synchronization. */
+typedef struct {
+	list_t updates;
+	knot_dname_t *zone;
+	int tcp_timeout;
+} synced_responses_t;
+
+static void send_synced_responses(int ret, void *ctx)
+{
+	synced_responses_t *synced = ctx;
+
+	/* Not acknowledged, the changes may be lost. */
+	if (ret != KNOT_EOK) {
+		log_zone_error(synced->zone, "DDNS, failed to synchronize journal (%s)",
+		               knot_strerror(ret));
+		set_rcodes(&synced->updates, KNOT_RCODE_SERVFAIL);
+	}
+
+	ptrnode_t *node = NULL, *nxt = NULL;
+	WALK_LIST_DELSAFE(node, nxt, synced->updates) {
+		struct knot_request *req = node->d;
+		send_response(req, true, synced->tcp_timeout);
+		free_request(req);
+	}
+	ptrlist_free(&synced->updates, NULL);
+
+	knot_dname_free(&synced->zone, NULL);
+	free(synced);
+}
+
+/*! \brief Hand the responses over to the journal synchronization. */
+static int send_responses_synced(conf_t *conf, zone_t *zone, list_t *updates)
+{
+	synced_responses_t *synced = malloc(sizeof(*synced));
+	if (synced == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	synced->zone = knot_dname_copy(zone->name, NULL);
+	if (synced->zone == NULL) {
+		free(synced);
+		return KNOT_ENOMEM;
+	}
+	synced->tcp_timeout = 1000 * conf->cache.srv_tcp_reply_timeout;
+	init_list(&synced->updates);
+	add_tail_list(&synced->updates, updates);
+
+	int ret = zone_journal_sync(conf, zone, send_synced_responses, synced);
+	if (ret != KNOT_EOK) {
+		init_list(updates);
+		add_tail_list(updates, &synced->updates);
+		knot_dname_free(&synced->zone, NULL);
+		free(synced);
+	}
+
+	return ret;
+}
+
 static int init_update_responses(conf_t *conf, const zone_t *zone, list_t *updates,
                                  size_t *update_count)
 {
@@ -436,7 +509,8 @@ void updates_execute(conf_t *conf, zone_t *zone)
 {
 	/* Get list of pending updates. */
 	list_t updates;
-	size_t update_count = zone_update_dequeue(zone, &updates);
+	struct timeval t_queued;
+	size_t update_count = zone_update_dequeue(zone, &updates, &t_queued);
 	if (update_count == 0) {
 		return;
 	}
@@ -457,6 +531,7 @@ void updates_execute(conf_t *conf, zone_t *zone)
 
 	/* Process update list - forward if zone has master, or execute.
 	   RCODEs are set. */
+	bool changed = false;
 	if (zone_is_slave(conf, zone)) {
 		log_zone_info(zone->name,
 		              "DDNS, forwarding %zu updates", update_count);
@@ -464,7 +539,12 @@ void updates_execute(conf_t *conf, zone_t *zone)
 	} else {
 		log_zone_info(zone->name,
 		              "DDNS, processing %zu updates", update_count);
-		process_requests(conf, zone, &updates);
+		changed = process_requests(conf, zone, &updates, &t_queued);
+	}
+
+	/* Send responses once the changes are durable, the worker goes on. */
+	if (changed && send_responses_synced(conf, zone, &updates) == KNOT_EOK) {
+		return;
 	}
 
 	/* Send responses. */
@@ -0,0 +1,215 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dnssec/error.h"
+#include "dnssec/random.h"
+#include "knot/server/cookies.h"
+#include "libknot/cookies/alg-fnv64.h"
+#include "libknot/errcode.h"
+#include "contrib/wire.h"
+
+static void rotate_event(event_t *ev)
+{
+	cookie_secret_t *cs = ev->data;
+
+	cookie_secret_rotate(cs);
+	if (cs->lifetime > 0) {
+		evsched_schedule(ev, cs->lifetime * 1000);
+	}
+}
+
+cookie_secret_t *cookie_secret_create(evsched_t *sched, uint32_t lifetime)
+{
+	cookie_secret_t *cs = calloc(1, sizeof(*cs));
+	if (cs == NULL) {
+		return NULL;
+	}
+
+	if (sched != NULL) {
+		cs->rotate = evsched_event_create(sched, rotate_event, cs);
+		if (cs->rotate == NULL) {
+			free(cs);
+			return NULL;
+		}
+	}
+
+	/* Initialize all slots, the previous secret must never be zeroed. */
+	for (unsigned i = 0; i < COOKIE_SECRET_SLOTS; i++) {
+		if (dnssec_random_buffer(cs->data[i], COOKIE_SECRET_LEN) != DNSSEC_EOK) {
+			cookie_secret_destroy(cs);
+			return NULL;
+		}
+	}
+
+	cookie_secret_set_lifetime(cs, lifetime);
+
+	return cs;
+}
+
+void cookie_secret_set_lifetime(cookie_secret_t *cs, uint32_t lifetime)
+{
+	if (cs == NULL || cs->lifetime == lifetime) {
+		return;
+	}
+
+	cs->lifetime = lifetime;
+
+	if (cs->rotate != NULL) {
+		if (lifetime > 0) {
+			evsched_schedule(cs->rotate, lifetime * 1000);
+		} else {
+			evsched_cancel(cs->rotate);
+		}
+	}
+}
+
+int cookie_secret_rotate(cookie_secret_t *cs)
+{
+	if (cs == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* The next slot is neither current nor previous, readers don't use it. */
+	unsigned next = (cs->current + 1) % COOKIE_SECRET_SLOTS;
+	if (dnssec_random_buffer(cs->data[next], COOKIE_SECRET_LEN) != DNSSEC_EOK) {
+		return KNOT_ERROR;
+	}
+
+	/* Publish the new secret after it's completely written. */
+	__sync_synchronize();
+	cs->current = next;
+
+	return KNOT_EOK;
+}
+
+void cookie_secret_destroy(cookie_secret_t *cs)
+{
+	if (cs == NULL) {
+		return;
+	}
+
+	if (cs->rotate != NULL) {
+		evsched_cancel(cs->rotate);
+		evsched_event_free(cs->rotate);
+	}
+
+	memset(cs, 0, sizeof(*cs));
+	free(cs);
+}
+
+static void write_nonce(uint8_t *nonce, uint32_t now)
+{
+	nonce[0] = COOKIE_VERSION;
+	memset(nonce + 1, 0, 3);
+	wire_write_u32(nonce + 4, now);
+}
+
+static bool nonce_valid(const uint8_t *nonce, uint32_t lifetime, uint32_t now)
+{
+	if (nonce[0] != COOKIE_VERSION) {
+		return false;
+	}
+
+	/* Cookies from the future are suspicious. */
+	uint32_t stamp = wire_read_u32(nonce + 4);
+	if ((int32_t)(stamp - now) > COOKIE_MAX_SKEW) {
+		return false;
+	}
+
+	/* Cookies older than two secret lifetimes were issued with a discarded secret. */
+	if (lifetime > 0 && (now - stamp) > 2 * (uint64_t)lifetime + COOKIE_MAX_SKEW) {
+		return false;
+	}
+
+	return true;
+}
+
+int cookie_check(const cookie_secret_t *cs, const struct knot_dns_cookies *cookies,
+                 const struct sockaddr *remote, uint32_t now)
+{
+	if (cs == NULL || cookies == NULL || remote == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (cookies->sc == NULL || cookies->sc_len != COOKIE_SRVR_LEN ||
+	    !nonce_valid(cookies->sc, cs->lifetime, now)) {
+		return KNOT_EINVAL;
+	}
+
+	unsigned current = cs->current;
+	unsigned previous = (current + COOKIE_SECRET_SLOTS - 1) % COOKIE_SECRET_SLOTS;
+
+	struct knot_sc_private srvr_data = {
+		.clnt_sockaddr = remote,
+		.secret_data = cs->data[current],
+		.secret_len = COOKIE_SECRET_LEN
+	};
+
+	int ret = knot_sc_check(COOKIE_NONCE_LEN, cookies, &srvr_data,
+	                        &knot_sc_alg_fnv64);
+	if (ret != KNOT_EOK) {
+		/* Try the previous secret. */
+		srvr_data.secret_data = cs->data[previous];
+		ret = knot_sc_check(COOKIE_NONCE_LEN, cookies, &srvr_data,
+		                    &knot_sc_alg_fnv64);
+	}
+
+	return ret;
+}
+
+uint16_t cookie_generate(const cookie_secret_t *cs,
+                         const struct knot_dns_cookies *cookies,
+                         const struct sockaddr *remote, uint32_t now,
+                         uint8_t *sc, uint16_t sc_len)
+{
+	if (cs == NULL || cookies == NULL || remote == NULL || sc == NULL ||
+	    sc_len < COOKIE_SRVR_LEN) {
+		return 0;
+	}
+
+	assert(COOKIE_SRVR_LEN == COOKIE_NONCE_LEN + knot_sc_alg_fnv64.hash_size);
+
+	uint8_t nonce[COOKIE_NONCE_LEN];
+	write_nonce(nonce, now);
+
+	struct knot_sc_private srvr_data = {
+		.clnt_sockaddr = remote,
+		.secret_data = cs->data[cs->current],
+		.secret_len = COOKIE_SECRET_LEN
+	};
+
+	struct knot_sc_input input = {
+		.cc = cookies->cc,
+		.cc_len = cookies->cc_len,
+		.nonce = nonce,
+		.nonce_len = COOKIE_NONCE_LEN,
+		.srvr_data = &srvr_data
+	};
+
+	uint16_t hash_len = knot_sc_alg_fnv64.hash_func(&input, sc + COOKIE_NONCE_LEN,
+	                                                sc_len - COOKIE_NONCE_LEN);
+	if (hash_len == 0) {
+		return 0;
+	}
+
+	memcpy(sc, nonce, COOKIE_NONCE_LEN);
+
+	return COOKIE_NONCE_LEN + hash_len;
+}
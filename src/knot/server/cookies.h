@@ -0,0 +1,133 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Server-side DNS Cookies (RFC 7873) secret management.
+ *
+ * The server keeps a small ring of secrets. The current secret is used to
+ * generate new server cookies, the previous one is still accepted so that
+ * clients aren't penalized right after a rotation.
+ *
+ * Server cookie layout: version (1B) | reserved (3B) | timestamp (4B) | hash (8B)
+ *
+ * \addtogroup network
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "knot/common/evsched.h"
+#include "libknot/cookies/server.h"
+
+/*! \brief Server secret length. */
+#define COOKIE_SECRET_LEN	16
+/*! \brief Number of secret slots (current, previous, next). */
+#define COOKIE_SECRET_SLOTS	3
+/*! \brief Nonce length (version, reserved and timestamp). */
+#define COOKIE_NONCE_LEN	8
+/*! \brief Generated server cookie length. */
+#define COOKIE_SRVR_LEN		(COOKIE_NONCE_LEN + 8)
+/*! \brief Server cookie format version. */
+#define COOKIE_VERSION		1
+/*! \brief Allowed clock skew for server cookie timestamps (seconds). */
+#define COOKIE_MAX_SKEW		300
+
+/*!
+ * \brief Server cookie secrets.
+ */
+typedef struct cookie_secret {
+	uint8_t data[COOKIE_SECRET_SLOTS][COOKIE_SECRET_LEN]; /*!< Secret ring. */
+	volatile unsigned current; /*!< Index of the current secret. */
+	uint32_t lifetime;         /*!< Secret lifetime in seconds. */
+	event_t *rotate;           /*!< Periodic rotation event. */
+} cookie_secret_t;
+
+/*!
+ * \brief Create server cookie secrets.
+ *
+ * \param sched     Event scheduler for periodic rotation (or NULL).
+ * \param lifetime  Secret lifetime in seconds (0 for no rotation).
+ *
+ * \return Secrets or NULL on error.
+ */
+cookie_secret_t *cookie_secret_create(evsched_t *sched, uint32_t lifetime);
+
+/*!
+ * \brief Change the secret lifetime and reschedule the rotation.
+ *
+ * \param cs        Server cookie secrets.
+ * \param lifetime  New secret lifetime in seconds (0 for no rotation).
+ */
+void cookie_secret_set_lifetime(cookie_secret_t *cs, uint32_t lifetime);
+
+/*!
+ * \brief Replace the current secret with a fresh random one.
+ *
+ * \note The replaced secret remains valid for incoming cookies until the
+ *       next rotation.
+ *
+ * \param cs  Server cookie secrets.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ */
+int cookie_secret_rotate(cookie_secret_t *cs);
+
+/*!
+ * \brief Destroy server cookie secrets.
+ *
+ * \param cs  Server cookie secrets.
+ */
+void cookie_secret_destroy(cookie_secret_t *cs);
+
+/*!
+ * \brief Check the server cookie received from the client.
+ *
+ * \param cs       Server cookie secrets.
+ * \param cookies  Received client and server cookies.
+ * \param remote   Client address.
+ * \param now      Current time (seconds).
+ *
+ * \retval KNOT_EOK if the server cookie is valid.
+ * \retval KNOT_EINVAL if missing or not valid.
+ */
+int cookie_check(const cookie_secret_t *cs, const struct knot_dns_cookies *cookies,
+                 const struct sockaddr *remote, uint32_t now);
+
+/*!
+ * \brief Generate a new server cookie for the client.
+ *
+ * \param cs       Server cookie secrets.
+ * \param cookies  Received client cookie.
+ * \param remote   Client address.
+ * \param now      Current time (seconds).
+ * \param sc       Output buffer for the server cookie.
+ * \param sc_len   Output buffer size.
+ *
+ * \retval non-zero size of written data on successful return
+ * \retval 0 on error
+ */
+uint16_t cookie_generate(const cookie_secret_t *cs,
+                         const struct knot_dns_cookies *cookies,
+                         const struct sockaddr *remote, uint32_t now,
+                         uint8_t *sc, uint16_t sc_len);
+
+/*! @} */
@@ -0,0 +1,230 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <urcu.h>
+
+#include "knot/events/events.h"
+#include "knot/server/ddns-batch.h"
+#include "libknot/errcode.h"
+#include "contrib/hat-trie/hat-trie.h"
+
+struct ddns_batch {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;    /*!< Signalled when the first zone is added. */
+	pthread_t thread;       /*!< Batching thread. */
+	bool stop;              /*!< Thread stop request. */
+	hattrie_t *pending;     /*!< Zone names of the open batch. */
+	knot_zonedb_t **zone_db; /*!< Zone database (RCU protected). */
+	int window;             /*!< Batch collection time in milliseconds. */
+};
+
+/*! \brief Plan UPDATE events of the batched zones. */
+static void plan_batch(knot_zonedb_t **zone_db, hattrie_t *zones)
+{
+	rcu_read_lock();
+
+	knot_zonedb_t *db = rcu_dereference(*zone_db);
+
+	hattrie_iter_t *it = hattrie_iter_begin(zones);
+	for (; db != NULL && !hattrie_iter_finished(it); hattrie_iter_next(it)) {
+		size_t len = 0;
+		const char *key = hattrie_iter_key(it, &len);
+
+		/* The zone could be removed meanwhile. */
+		zone_t *zone = knot_zonedb_find(db, (const knot_dname_t *)key);
+		if (zone != NULL) {
+			zone_events_schedule(zone, ZONE_EVENT_UPDATE, ZONE_EVENT_NOW);
+		}
+	}
+	hattrie_iter_free(it);
+
+	rcu_read_unlock();
+}
+
+/*! \brief Close the open batch and plan its zones, called with the lock held. */
+static void close_batch(ddns_batch_t *db)
+{
+	/* New updates join the next batch. */
+	hattrie_t *zones = db->pending;
+	db->pending = hattrie_create(NULL);
+	if (db->pending != NULL) {
+		pthread_mutex_unlock(&db->lock);
+		plan_batch(db->zone_db, zones);
+		hattrie_free(zones);
+		pthread_mutex_lock(&db->lock);
+	} else {
+		/* Out of memory, plan with new updates blocked. */
+		db->pending = zones;
+		plan_batch(db->zone_db, zones);
+		hattrie_clear(zones);
+	}
+}
+
+static void deadline(struct timespec *ts, int window)
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
+	uint64_t usec = now.tv_usec + window * 1000ULL;
+	ts->tv_sec = now.tv_sec + usec / 1000000;
+	ts->tv_nsec = (usec % 1000000) * 1000;
+}
+
+static void *ddns_batch_run(void *data)
+{
+	ddns_batch_t *db = data;
+
+	rcu_register_thread();
+
+	pthread_mutex_lock(&db->lock);
+	while (!db->stop) {
+		if (hattrie_weight(db->pending) == 0) {
+			pthread_cond_wait(&db->wake, &db->lock);
+			continue;
+		}
+
+		/* Let the batch collect more zones. */
+		struct timespec ts;
+		deadline(&ts, db->window);
+		while (!db->stop &&
+		       pthread_cond_timedwait(&db->wake, &db->lock, &ts) == 0);
+		if (db->stop) {
+			break;
+		}
+
+		close_batch(db);
+	}
+	pthread_mutex_unlock(&db->lock);
+
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+ddns_batch_t *ddns_batch_create(knot_zonedb_t **zone_db, int window)
+{
+	if (zone_db == NULL) {
+		return NULL;
+	}
+
+	ddns_batch_t *db = calloc(1, sizeof(*db));
+	if (db == NULL) {
+		return NULL;
+	}
+
+	db->pending = hattrie_create(NULL);
+	if (db->pending == NULL) {
+		free(db);
+		return NULL;
+	}
+
+	pthread_mutex_init(&db->lock, NULL);
+	pthread_cond_init(&db->wake, NULL);
+	db->zone_db = zone_db;
+	db->window = window;
+
+	if (pthread_create(&db->thread, NULL, ddns_batch_run, db) != 0) {
+		hattrie_free(db->pending);
+		pthread_mutex_destroy(&db->lock);
+		pthread_cond_destroy(&db->wake);
+		free(db);
+		return NULL;
+	}
+
+	return db;
+}
+
+void ddns_batch_set_window(ddns_batch_t *db, int window)
+{
+	if (db == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&db->lock);
+	db->window = window;
+	pthread_mutex_unlock(&db->lock);
+}
+
+int ddns_batch_add(ddns_batch_t *db, const knot_dname_t *zone)
+{
+	if (db == NULL) {
+		return KNOT_ENOTSUP;
+	}
+
+	if (zone == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	pthread_mutex_lock(&db->lock);
+
+	if (db->window == DDNS_BATCH_OFF) {
+		pthread_mutex_unlock(&db->lock);
+		return KNOT_ENOTSUP;
+	}
+
+	/* Join the open batch. */
+	bool first = (hattrie_weight(db->pending) == 0);
+	value_t *val = hattrie_get(db->pending, (const char *)zone,
+	                           knot_dname_size(zone));
+	if (val == NULL) {
+		pthread_mutex_unlock(&db->lock);
+		return KNOT_ENOMEM;
+	}
+	*val = db;
+
+	if (first) {
+		pthread_cond_signal(&db->wake);
+	}
+
+	pthread_mutex_unlock(&db->lock);
+
+	return KNOT_EOK;
+}
+
+void ddns_batch_close(ddns_batch_t *db)
+{
+	if (db == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&db->lock);
+	if (hattrie_weight(db->pending) > 0) {
+		close_batch(db);
+	}
+	pthread_mutex_unlock(&db->lock);
+}
+
+void ddns_batch_destroy(ddns_batch_t *db)
+{
+	if (db == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&db->lock);
+	db->stop = true;
+	pthread_cond_signal(&db->wake);
+	pthread_mutex_unlock(&db->lock);
+	pthread_join(db->thread, NULL);
+
+	hattrie_free(db->pending);
+	pthread_mutex_destroy(&db->lock);
+	pthread_cond_destroy(&db->wake);
+	free(db);
+}
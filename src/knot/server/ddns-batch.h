@@ -0,0 +1,93 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Coalescing of DDNS processing across zones.
+ *
+ * Zones receiving updates are collected during a time window. When the window
+ * closes, the UPDATE events of all the collected zones are planned at once.
+ * Each zone then processes all updates received meanwhile in one batch, and
+ * the commits of the zones share the journal synchronization.
+ *
+ * \addtogroup server
+ * @{
+ */
+
+#pragma once
+
+#include "knot/zone/zonedb.h"
+#include "libknot/dname.h"
+
+/*! \brief Disabled DDNS batching, updates are processed immediately. */
+#define DDNS_BATCH_OFF	0
+
+/*!
+ * \brief DDNS batching context.
+ */
+typedef struct ddns_batch ddns_batch_t;
+
+/*!
+ * \brief Create DDNS batching context and start its thread.
+ *
+ * \param zone_db  Pointer to the RCU protected zone database.
+ * \param window   Batch collection time in milliseconds
+ *                 (\ref DDNS_BATCH_OFF to disable batching).
+ *
+ * \return Context or NULL on error.
+ */
+ddns_batch_t *ddns_batch_create(knot_zonedb_t **zone_db, int window);
+
+/*!
+ * \brief Change the batch collection time.
+ *
+ * \param db      DDNS batching context.
+ * \param window  Batch collection time in milliseconds
+ *                (\ref DDNS_BATCH_OFF to disable batching).
+ */
+void ddns_batch_set_window(ddns_batch_t *db, int window);
+
+/*!
+ * \brief Add the zone with a queued update into the open batch.
+ *
+ * \param db    DDNS batching context (can be NULL).
+ * \param zone  Zone name.
+ *
+ * \retval KNOT_EOK if added.
+ * \retval KNOT_ENOTSUP if the batching is disabled, process immediately.
+ * \return < KNOT_EOK on other errors.
+ */
+int ddns_batch_add(ddns_batch_t *db, const knot_dname_t *zone);
+
+/*!
+ * \brief Close the open batch now, without waiting for its window.
+ *
+ * \note The caller must be a registered RCU thread.
+ *
+ * \param db  DDNS batching context (can be NULL).
+ */
+void ddns_batch_close(ddns_batch_t *db);
+
+/*!
+ * \brief Stop the thread and free the context.
+ *
+ * \note Zones of the open batch aren't planned.
+ *
+ * \param db  DDNS batching context.
+ */
+void ddns_batch_destroy(ddns_batch_t *db);
+
+/*! @} */
@@ -0,0 +1,333 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <urcu.h>
+
+#include "knot/common/log.h"
+#include "knot/server/journal-sync.h"
+#include "libknot/errcode.h"
+#include "contrib/hat-trie/hat-trie.h"
+#include "contrib/ucw/lists.h"
+
+struct journal_sync {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;    /*!< Signalled when the first journal is queued. */
+	pthread_t thread;       /*!< Synchronization thread. */
+	bool stop;              /*!< Thread stop request. */
+	hattrie_t *pending;     /*!< Journals of the open batch by path. */
+	hattrie_t *known;       /*!< Inodes with synchronized directory entry. */
+	int latency;            /*!< Batch collection time in milliseconds. */
+};
+
+/*! \brief Writer waiting for the journal synchronization. */
+typedef struct {
+	node_t n;
+	journal_sync_cb_t cb;
+	void *ctx;
+} waiter_t;
+
+/*! \brief Journal of the open batch. */
+typedef struct {
+	int fd;                 /*!< Duplicated journal descriptor (or -1). */
+	list_t waiters;
+} pending_t;
+
+/*! \brief Synchronize the directory entry of a new file. */
+static int sync_dir(const char *path)
+{
+	char *copy = strdup(path);
+	if (copy == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int fd = open(dirname(copy), O_RDONLY);
+	free(copy);
+	if (fd < 0) {
+		return knot_map_errno();
+	}
+
+	int ret = KNOT_EOK;
+	if (fsync(fd) != 0) {
+		ret = knot_map_errno();
+	}
+
+	close(fd);
+
+	return ret;
+}
+
+static int sync_file(hattrie_t *known, const char *path, int fd)
+{
+	if (fd < 0) {
+		fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			return knot_map_errno();
+		}
+	}
+
+	int ret = KNOT_EOK;
+	struct stat st;
+	if (fdatasync(fd) != 0 || fstat(fd, &st) != 0) {
+		ret = knot_map_errno();
+	}
+
+	close(fd);
+
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Newly created (or replaced) journal needs its directory synced. */
+	value_t ino = (value_t)(uintptr_t)st.st_ino;
+	value_t *val = hattrie_tryget(known, path, strlen(path));
+	if (val != NULL && *val == ino) {
+		return KNOT_EOK;
+	}
+
+	ret = sync_dir(path);
+	if (ret == KNOT_EOK) {
+		val = hattrie_get(known, path, strlen(path));
+		if (val != NULL) {
+			*val = ino;
+		}
+	}
+
+	return ret;
+}
+
+/*! \brief Synchronize all journals of the batch and notify their writers. */
+static void sync_batch(hattrie_t *journals, hattrie_t *known)
+{
+	hattrie_iter_t *it = hattrie_iter_begin(journals);
+	for (; !hattrie_iter_finished(it); hattrie_iter_next(it)) {
+		size_t len = 0;
+		const char *key = hattrie_iter_key(it, &len);
+		pending_t *journal = *hattrie_iter_val(it);
+
+		char path[len + 1];
+		memcpy(path, key, len);
+		path[len] = '\0';
+
+		int ret = sync_file(known, path, journal->fd);
+		if (ret != KNOT_EOK) {
+			log_error("journal, failed to synchronize '%s' (%s)",
+			          path, knot_strerror(ret));
+		}
+
+		waiter_t *w = NULL, *next = NULL;
+		WALK_LIST_DELSAFE(w, next, journal->waiters) {
+			w->cb(ret, w->ctx);
+			free(w);
+		}
+		free(journal);
+	}
+	hattrie_iter_free(it);
+}
+
+static void deadline(struct timespec *ts, int latency)
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
+	uint64_t usec = now.tv_usec + latency * 1000ULL;
+	ts->tv_sec = now.tv_sec + usec / 1000000;
+	ts->tv_nsec = (usec % 1000000) * 1000;
+}
+
+static void *journal_sync_run(void *data)
+{
+	journal_sync_t *js = data;
+
+	rcu_register_thread();
+
+	pthread_mutex_lock(&js->lock);
+	while (true) {
+		bool stop = js->stop;
+		if (hattrie_weight(js->pending) == 0) {
+			if (stop) {
+				break;
+			}
+			pthread_cond_wait(&js->wake, &js->lock);
+			continue;
+		}
+
+		/* Let the batch collect more journals. */
+		if (!stop && js->latency > 0) {
+			struct timespec ts;
+			deadline(&ts, js->latency);
+			while (!js->stop &&
+			       pthread_cond_timedwait(&js->wake, &js->lock, &ts) == 0);
+		}
+
+		/* Close the batch, new writers join the next one. */
+		hattrie_t *journals = js->pending;
+		js->pending = hattrie_create(NULL);
+		if (js->pending != NULL) {
+			pthread_mutex_unlock(&js->lock);
+			sync_batch(journals, js->known);
+			hattrie_free(journals);
+			pthread_mutex_lock(&js->lock);
+		} else {
+			/* Out of memory, synchronize with new writers blocked. */
+			js->pending = journals;
+			sync_batch(journals, js->known);
+			hattrie_clear(journals);
+		}
+	}
+	pthread_mutex_unlock(&js->lock);
+
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+journal_sync_t *journal_sync_create(int latency)
+{
+	journal_sync_t *js = calloc(1, sizeof(*js));
+	if (js == NULL) {
+		return NULL;
+	}
+
+	js->pending = hattrie_create(NULL);
+	js->known = hattrie_create(NULL);
+	if (js->pending == NULL || js->known == NULL) {
+		hattrie_free(js->pending);
+		hattrie_free(js->known);
+		free(js);
+		return NULL;
+	}
+
+	pthread_mutex_init(&js->lock, NULL);
+	pthread_cond_init(&js->wake, NULL);
+	js->latency = latency;
+
+	if (pthread_create(&js->thread, NULL, journal_sync_run, js) != 0) {
+		hattrie_free(js->pending);
+		hattrie_free(js->known);
+		pthread_mutex_destroy(&js->lock);
+		pthread_cond_destroy(&js->wake);
+		free(js);
+		return NULL;
+	}
+
+	return js;
+}
+
+void journal_sync_set_latency(journal_sync_t *js, int latency)
+{
+	if (js == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&js->lock);
+	js->latency = latency;
+	pthread_mutex_unlock(&js->lock);
+}
+
+int journal_sync_submit(journal_sync_t *js, const char *path, int fd,
+                        journal_sync_cb_t cb, void *ctx)
+{
+	if (js == NULL) {
+		return KNOT_ENOTSUP;
+	}
+
+	if (path == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	waiter_t *w = NULL;
+	if (cb != NULL) {
+		w = malloc(sizeof(*w));
+		if (w == NULL) {
+			return KNOT_ENOMEM;
+		}
+		w->cb = cb;
+		w->ctx = ctx;
+	}
+
+	pthread_mutex_lock(&js->lock);
+
+	if (js->latency == JOURNAL_SYNC_OFF) {
+		pthread_mutex_unlock(&js->lock);
+		free(w);
+		return KNOT_ENOTSUP;
+	}
+
+	/* Join the open batch. */
+	bool first = (hattrie_weight(js->pending) == 0);
+	value_t *val = hattrie_get(js->pending, path, strlen(path));
+	if (val == NULL) {
+		pthread_mutex_unlock(&js->lock);
+		free(w);
+		return KNOT_ENOMEM;
+	}
+
+	pending_t *journal = *val;
+	if (journal == NULL) {
+		journal = malloc(sizeof(*journal));
+		if (journal == NULL) {
+			hattrie_del(js->pending, path, strlen(path), NULL);
+			pthread_mutex_unlock(&js->lock);
+			free(w);
+			return KNOT_ENOMEM;
+		}
+		/* Reopened by the path if the descriptor can't be kept. */
+		journal->fd = (fd >= 0) ? dup(fd) : -1;
+		init_list(&journal->waiters);
+		*val = journal;
+	}
+	if (w != NULL) {
+		add_tail(&journal->waiters, &w->n);
+	}
+
+	if (first || js->latency == 0) {
+		pthread_cond_signal(&js->wake);
+	}
+
+	pthread_mutex_unlock(&js->lock);
+
+	return KNOT_EOK;
+}
+
+void journal_sync_destroy(journal_sync_t *js)
+{
+	if (js == NULL) {
+		return;
+	}
+
+	/* Stop the thread, pending journals are still synchronized. */
+	pthread_mutex_lock(&js->lock);
+	js->stop = true;
+	pthread_cond_signal(&js->wake);
+	pthread_mutex_unlock(&js->lock);
+	pthread_join(js->thread, NULL);
+
+	hattrie_free(js->pending);
+	hattrie_free(js->known);
+	pthread_mutex_destroy(&js->lock);
+	pthread_cond_destroy(&js->wake);
+	free(js);
+}
@@ -0,0 +1,97 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Group commit of journal writes to permanent storage.
+ *
+ * Journals written by concurrent updates (of any zones) are collected into
+ * one batch which is synchronized to the disk after a configured latency.
+ * The writers don't wait, each gets a callback from the synchronization
+ * thread when the batch containing its journal is durable.
+ *
+ * \addtogroup utils
+ * @{
+ */
+
+#pragma once
+
+/*! \brief Disabled journal synchronization. */
+#define JOURNAL_SYNC_OFF	-1
+
+/*!
+ * \brief Journal group commit context.
+ */
+typedef struct journal_sync journal_sync_t;
+
+/*!
+ * \brief Callback called from the synchronization thread.
+ *
+ * \note The callback must not submit another journal.
+ *
+ * \param ret  KNOT_EOK if the journal is synchronized, error code otherwise.
+ * \param ctx  Writer context.
+ */
+typedef void (*journal_sync_cb_t)(int ret, void *ctx);
+
+/*!
+ * \brief Create journal group commit context and start its thread.
+ *
+ * \param latency  Maximum batch collection time in milliseconds
+ *                 (\ref JOURNAL_SYNC_OFF to disable synchronization).
+ *
+ * \return Context or NULL on error.
+ */
+journal_sync_t *journal_sync_create(int latency);
+
+/*!
+ * \brief Change the batch collection time.
+ *
+ * \param js       Journal group commit context.
+ * \param latency  Maximum batch collection time in milliseconds
+ *                 (\ref JOURNAL_SYNC_OFF to disable synchronization).
+ */
+void journal_sync_set_latency(journal_sync_t *js, int latency);
+
+/*!
+ * \brief Add the written journal into the open batch.
+ *
+ * The descriptor is duplicated by the first writer of the journal in the
+ * batch, the journal is opened by its path if no descriptor is given.
+ *
+ * \param js    Journal group commit context (can be NULL).
+ * \param path  Path to the written journal file.
+ * \param fd    Descriptor of the open journal file (or -1).
+ * \param cb    Callback when the batch is synchronized (or NULL).
+ * \param ctx   Callback context.
+ *
+ * \retval KNOT_EOK if added, the callback will be called.
+ * \retval KNOT_ENOTSUP if the synchronization is disabled, no callback.
+ * \return < KNOT_EOK on other errors, no callback.
+ */
+int journal_sync_submit(journal_sync_t *js, const char *path, int fd,
+                        journal_sync_cb_t cb, void *ctx);
+
+/*!
+ * \brief Synchronize pending journals, stop the thread and free the context.
+ *
+ * \note The callbacks of the pending journals are called before it returns.
+ *
+ * \param js  Journal group commit context.
+ */
+void journal_sync_destroy(journal_sync_t *js);
+
+/*! @} */
@@ -74,6 +74,16 @@ static inline uint32_t journal_key_from(uint64_t k)
 	return (uint32_t)(k & ((uint64_t)0x00000000ffffffff));
 }
 
+/*! \brief Return 'serial_to' part of the key. */
+static inline uint32_t journal_key_to(uint64_t k)
+{
+	/*      64    32       0
+	 * key = [TO   |   FROM]
+	 * Need: Most significant 32 bits.
+	 */
+	return (uint32_t)(k >> 32);
+}
+
 /*----------------------------------------------------------------------------*/
 
 /*! \brief Compare function to match entries with starting serial. */
@@ -518,6 +528,58 @@ int journal_open(journal_t **journal, const char *path, size_t fslimit)
 	return KNOT_EOK;
 }
 
+/*! \brief Check if the journal file is still at its path. */
+static bool journal_same_file(journal_t *journal, const char *path)
+{
+	struct stat open_st, path_st;
+	if (fstat(journal->fd, &open_st) != 0 || stat(path, &path_st) != 0) {
+		return false;
+	}
+
+	return open_st.st_dev == path_st.st_dev && open_st.st_ino == path_st.st_ino;
+}
+
+int journal_reopen(journal_t **journal, const char *path, size_t fslimit)
+{
+	if (journal == NULL || path == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (fslimit == 0) {
+		fslimit = FSLIMIT_INF;
+	}
+
+	journal_t *j = *journal;
+	if (j != NULL && j->fslimit == fslimit && strcmp(j->path, path) == 0 &&
+	    journal_same_file(j, path)) {
+		struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET,
+		                      .l_start  = 0, .l_len = 0, .l_pid = 0 };
+		if (fcntl(j->fd, F_SETLKW, &lock) == 0) {
+			return KNOT_EOK;
+		}
+	}
+
+	journal_close(j);
+	*journal = NULL;
+
+	return journal_open(journal, path, fslimit);
+}
+
+int journal_unlock(journal_t *journal)
+{
+	if (journal == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	struct flock lock = { .l_type = F_UNLCK, .l_whence = SEEK_SET,
+	                      .l_start  = 0, .l_len = 0, .l_pid = 0 };
+	if (fcntl(journal->fd, F_SETLK, &lock) != 0) {
+		return knot_map_errno();
+	}
+
+	return KNOT_EOK;
+}
+
 /*!
  * \brief Entry identifier compare function.
  *
@@ -976,19 +1038,92 @@ int journal_load_changesets(const char *path, const knot_dname_t *zone, list_t *
 	return KNOT_EOK;
 }
 
-int journal_store_changesets(list_t *src, const char *path, size_t size_limit)
+/*! \brief Map journal entry read-only, the data are used in place. */
+static int journal_map_node(journal_t *journal, journal_node_t *n, uint8_t **dst)
 {
-	if (src == NULL || path == NULL) {
+	const size_t ps = sysconf(_SC_PAGESIZE);
+	off_t ps_delta = (n->pos % ps);
+
+	uint8_t *map = mmap(NULL, n->len + ps_delta, PROT_READ, MAP_SHARED,
+	                    journal->fd, n->pos - ps_delta);
+	if (map == MAP_FAILED) {
+		return KNOT_ERROR;
+	}
+#ifdef HAVE_MADVISE
+	madvise(map, n->len + ps_delta, MADV_SEQUENTIAL);
+#endif
+	*dst = map + ps_delta;
+
+	return KNOT_EOK;
+}
+
+static void journal_unmap_node(journal_node_t *n, uint8_t *ptr)
+{
+	const size_t ps = sysconf(_SC_PAGESIZE);
+	off_t ps_delta = (n->pos % ps);
+	munmap(ptr - ps_delta, n->len + ps_delta);
+}
+
+int journal_read_changesets(const char *path, uint32_t from, uint32_t to,
+                            journal_read_cb_t cb, void *ctx)
+{
+	if (path == NULL || cb == NULL) {
 		return KNOT_EINVAL;
 	}
 
-	/* Open journal for reading. */
 	journal_t *journal = NULL;
-	int ret = journal_open(&journal, path, size_limit);
+	int ret = journal_open(&journal, path, FSLIMIT_INF);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
-	/* Begin writing to journal. */
+
+	journal_node_t *n = NULL;
+	ret = journal_fetch(journal, from, journal_key_from_cmp, &n);
+	if (ret != KNOT_EOK) {
+		goto finish;
+	}
+
+	/* Feed the entries in order until the history end. */
+	uint32_t found_to = from;
+	size_t i = n - journal->nodes;
+	assert(i < journal->max_nodes);
+	for (; i != journal->qtail && found_to != to; i = jnode_next(journal, i)) {
+		n = journal->nodes + i;
+		if (!(n->flags & JOURNAL_VALID)) {
+			continue;
+		}
+
+		uint8_t *data = NULL;
+		ret = journal_map_node(journal, n, &data);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+		ret = cb(data, n->len, ctx);
+		journal_unmap_node(n, data);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+
+		found_to = journal_key_to(n->id);
+	}
+
+	/* Check for complete history. */
+	if (ret == KNOT_EOK && found_to != to) {
+		ret = KNOT_ERANGE;
+	}
+
+finish:
+	journal_close(journal);
+	return ret;
+}
+
+int journal_write_changesets(journal_t *journal, list_t *src)
+{
+	if (journal == NULL || src == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = KNOT_EOK;
 	changeset_t *chs = NULL;
 	WALK_LIST(chs, *src) {
 		ret = changeset_pack(chs, journal);
@@ -997,6 +1132,33 @@ int journal_store_changesets(list_t *src, const char *path, size_t size_limit)
 		}
 	}
 
+	return ret;
+}
+
+int journal_write_changeset(journal_t *journal, changeset_t *change)
+{
+	if (journal == NULL || change == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	return changeset_pack(change, journal);
+}
+
+int journal_store_changesets(list_t *src, const char *path, size_t size_limit)
+{
+	if (src == NULL || path == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* Open journal for reading. */
+	journal_t *journal = NULL;
+	int ret = journal_open(&journal, path, size_limit);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	ret = journal_write_changesets(journal, src);
+
 	journal_close(journal);
 	return ret;
 }
@@ -1014,7 +1176,7 @@ int journal_store_changeset(changeset_t *change, const char *path, size_t size_l
 		return ret;
 	}
 
-	ret = changeset_pack(change, journal);
+	ret = journal_write_changeset(journal, change);
 
 	journal_close(journal);
 	return ret;
@@ -1049,3 +1211,36 @@ int journal_mark_synced(const char *path)
 
 	return KNOT_EOK;
 }
+
+int journal_mark_synced_to(const char *path, uint32_t serial)
+{
+	if (!journal_exists(path)) {
+		return KNOT_EOK;
+	}
+	journal_t *journal = NULL;
+	int ret = journal_open(&journal, path, FSLIMIT_INF);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Find the last change contained in the zone file. */
+	size_t last = journal->qtail;
+	size_t i = journal->qhead;
+	for(; i != journal->qtail; i = jnode_next(journal, i)) {
+		if ((uint32_t)(journal->nodes[i].id >> 32) == serial) {
+			last = i;
+		}
+	}
+
+	/* Keep all changes dirty if the serial is unknown. */
+	if (last != journal->qtail) {
+		i = journal->qhead;
+		for(; i != jnode_next(journal, last); i = jnode_next(journal, i)) {
+			mark_synced(journal, journal->nodes + i);
+		}
+	}
+
+	journal_close(journal);
+
+	return KNOT_EOK;
+}
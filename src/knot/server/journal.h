@@ -118,6 +118,32 @@ typedef struct journal
  */
 int journal_open(journal_t **journal, const char *path, size_t fslimit);
 
+/*!
+ * \brief Reuse the open journal or open it again.
+ *
+ * The open journal is kept and its file locked again if the path, the size
+ * limit, and the file at the path are the same. Otherwise it's closed and
+ * the journal is opened.
+ *
+ * \param journal Open journal (or NULL), replaced if opened again.
+ * \param path Journal file name.
+ * \param fslimit File size limit (0 for no limit).
+ *
+ * \retval KNOT_EOK if successful.
+ * \return < KNOT_EOK on error, the journal is closed.
+ */
+int journal_reopen(journal_t **journal, const char *path, size_t fslimit);
+
+/*!
+ * \brief Unlock the journal file, the journal stays open.
+ *
+ * \param journal Associated journal.
+ *
+ * \retval KNOT_EOK if successful.
+ * \return < KNOT_EOK on error.
+ */
+int journal_unlock(journal_t *journal);
+
 /*!
  * \brief Map journal entry for read/write.
  *
@@ -183,6 +209,36 @@ bool journal_exists(const char *path);
 int journal_load_changesets(const char *path, const knot_dname_t *zone, list_t *dst,
                             uint32_t from, uint32_t to);
 
+/*!
+ * \brief Callback for serialized journal entries.
+ *
+ * \param data  Serialized changeset, valid only during the call.
+ * \param size  Serialized changeset size.
+ * \param ctx   Callback context.
+ *
+ * \return KNOT_E*
+ */
+typedef int (*journal_read_cb_t)(const uint8_t *data, size_t size, void *ctx);
+
+/*!
+ * \brief Read serialized changesets from journal without unpacking them.
+ *
+ * Each journal entry is mapped and passed to the callback in place.
+ *
+ * \param path Path to journal file.
+ * \param from Start serial.
+ * \param to End serial.
+ * \param cb Callback for each entry.
+ * \param ctx Callback context.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_ENOENT if no entry starts with the start serial.
+ * \retval KNOT_ERANGE if the history ends before the end serial.
+ * \return < KNOT_EOK on error or callback error.
+ */
+int journal_read_changesets(const char *path, uint32_t from, uint32_t to,
+                            journal_read_cb_t cb, void *ctx);
+
 // TODO: :-/
 int load_changeset(journal_t *journal, journal_node_t *n, const knot_dname_t *zone, list_t *chgs);
 int changesets_unpack(changeset_t *chs);
@@ -201,6 +257,19 @@ int changesets_unpack(changeset_t *chs);
 int journal_store_changesets(list_t *src, const char *path, size_t size_limit);
 int journal_store_changeset(changeset_t *change, const char *path, size_t size_limit);
 
+/*!
+ * \brief Store changesets in the open journal.
+ *
+ * \param journal Journal locked for writing.
+ * \param src Changesets to store.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_EBUSY when journal is full.
+ * \return < KNOT_EOK on other errors.
+ */
+int journal_write_changesets(journal_t *journal, list_t *src);
+int journal_write_changeset(journal_t *journal, changeset_t *change);
+
 /*! \brief Function for unmarking dirty nodes. */
 /*!
  * \brief Function for unmarking dirty nodes.
@@ -210,4 +279,17 @@ int journal_store_changeset(changeset_t *change, const char *path, size_t size_l
  */
 int journal_mark_synced(const char *path);
 
+/*!
+ * \brief Unmark dirty nodes up to the changeset leading to given serial.
+ *
+ * Used when the zone file was written from an older zone version.
+ *
+ * \param path    Path to journal file.
+ * \param serial  Serial of the zone written into the zone file.
+ *
+ * \retval KNOT_EOK on success.
+ * \return < KNOT_EOK on other errors.
+ */
+int journal_mark_synced_to(const char *path, uint32_t serial);
+
 /*! @} */
@@ -0,0 +1,295 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_CPUSET_LINUX
+#include <sched.h>
+#endif
+
+#include "knot/server/numa.h"
+#include "contrib/macros.h"
+#include "contrib/mempattern.h"
+#include "contrib/ucw/mempool.h"
+#include "libknot/errcode.h"
+
+/*! \brief CPU without a node. */
+#define NO_NODE	-1
+
+/*! \brief Marks the CPUs from the sysfs list format (e.g. "0-3,8,10-11"). */
+static void parse_cpulist(const char *str, int node, int *cpu_node)
+{
+	for (;;) {
+		char *end;
+		unsigned long first = strtoul(str, &end, 10);
+		if (end == str) {
+			return;
+		}
+		unsigned long last = first;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtoul(str, &end, 10);
+			if (end == str) {
+				return;
+			}
+		}
+
+		for (unsigned long cpu = first; cpu <= last && cpu < NUMA_MAX_CPUS; cpu++) {
+			cpu_node[cpu] = node;
+		}
+
+		if (*end != ',') {
+			return;
+		}
+		str = end + 1;
+	}
+}
+
+static void read_node(const char *sysfs, int node, int *cpu_node)
+{
+	char path[512];
+	int ret = snprintf(path, sizeof(path), "%s/node%i/cpulist", sysfs, node);
+	if (ret < 0 || ret >= sizeof(path)) {
+		return;
+	}
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return;
+	}
+
+	char line[4096];
+	if (fgets(line, sizeof(line), file) != NULL) {
+		parse_cpulist(line, node, cpu_node);
+	}
+
+	fclose(file);
+}
+
+/*! \brief Reads the nodes of the CPUs, returns false if no node found. */
+static bool read_nodes(const char *sysfs, int *cpu_node)
+{
+	DIR *dir = opendir(sysfs);
+	if (dir == NULL) {
+		return false;
+	}
+
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		int node, len = 0;
+		if (sscanf(entry->d_name, "node%i%n", &node, &len) == 1 &&
+		    entry->d_name[len] == '\0' && node >= 0 && node < NUMA_MAX_CPUS) {
+			read_node(sysfs, node, cpu_node);
+		}
+	}
+
+	closedir(dir);
+
+	for (unsigned cpu = 0; cpu < NUMA_MAX_CPUS; cpu++) {
+		if (cpu_node[cpu] != NO_NODE) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*! \brief Drops the CPUs the process isn't allowed to run on. */
+static void filter_allowed(int *cpu_node)
+{
+#ifdef HAVE_CPUSET_LINUX
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+		return;
+	}
+
+	int filtered[NUMA_MAX_CPUS];
+	bool any = false;
+	for (unsigned cpu = 0; cpu < NUMA_MAX_CPUS; cpu++) {
+		bool allowed = (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set));
+		filtered[cpu] = allowed ? cpu_node[cpu] : NO_NODE;
+		any = any || (filtered[cpu] != NO_NODE);
+	}
+
+	/* Inconsistent information, keep all the CPUs. */
+	if (any) {
+		memcpy(cpu_node, filtered, sizeof(filtered));
+	}
+#endif
+}
+
+int numa_topology_load(numa_topology_t *topo, const char *sysfs)
+{
+	if (topo == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	memset(topo, 0, sizeof(*topo));
+
+	int cpu_node[NUMA_MAX_CPUS];
+	for (unsigned cpu = 0; cpu < NUMA_MAX_CPUS; cpu++) {
+		cpu_node[cpu] = NO_NODE;
+	}
+
+	if (!read_nodes(sysfs != NULL ? sysfs : NUMA_SYSFS_NODES, cpu_node)) {
+		/* Single node with all the online CPUs. */
+		int online = dt_online_cpus();
+		online = MIN(MAX(online, 1), NUMA_MAX_CPUS);
+		for (unsigned cpu = 0; cpu < online; cpu++) {
+			cpu_node[cpu] = 0;
+		}
+	}
+
+	/* Only when reading the system topology. */
+	if (sysfs == NULL) {
+		filter_allowed(cpu_node);
+	}
+
+	bool node_used[NUMA_MAX_CPUS] = { false };
+	for (unsigned cpu = 0; cpu < NUMA_MAX_CPUS; cpu++) {
+		if (cpu_node[cpu] != NO_NODE) {
+			node_used[cpu_node[cpu]] = true;
+			topo->cpu_count++;
+		}
+	}
+	for (unsigned node = 0; node < NUMA_MAX_CPUS; node++) {
+		topo->node_count += node_used[node];
+	}
+
+	topo->cpus = malloc(topo->cpu_count * sizeof(unsigned));
+	topo->nodes = malloc((topo->node_count + 1) * sizeof(unsigned));
+	if (topo->cpus == NULL || topo->nodes == NULL) {
+		numa_topology_free(topo);
+		return KNOT_ENOMEM;
+	}
+
+	/* CPUs grouped by the node, both in ascending order. */
+	unsigned count = 0, index = 0;
+	for (int node = 0; node < NUMA_MAX_CPUS; node++) {
+		if (!node_used[node]) {
+			continue;
+		}
+		topo->nodes[index++] = count;
+		for (unsigned cpu = 0; cpu < NUMA_MAX_CPUS; cpu++) {
+			if (cpu_node[cpu] == node) {
+				topo->cpus[count++] = cpu;
+			}
+		}
+	}
+	topo->nodes[index] = count;
+
+	return KNOT_EOK;
+}
+
+void numa_topology_free(numa_topology_t *topo)
+{
+	if (topo == NULL) {
+		return;
+	}
+
+	free(topo->cpus);
+	free(topo->nodes);
+	memset(topo, 0, sizeof(*topo));
+}
+
+/*! \brief Returns the n-th lowest CPU, the CPUs are ordered only within nodes. */
+static unsigned nth_cpu(const numa_topology_t *topo, unsigned n)
+{
+	for (unsigned i = 0; i < topo->cpu_count; i++) {
+		unsigned lower = 0;
+		for (unsigned j = 0; j < topo->cpu_count; j++) {
+			lower += (topo->cpus[j] < topo->cpus[i]);
+		}
+		if (lower == n) {
+			return topo->cpus[i];
+		}
+	}
+
+	return topo->cpus[0];
+}
+
+size_t numa_thread_cpus(const numa_topology_t *topo, numa_placement_t placement,
+                        unsigned slot, bool node_wide, unsigned *cpus)
+{
+	if (topo == NULL || topo->cpu_count < 2 || cpus == NULL) {
+		return 0;
+	}
+
+	switch (placement) {
+	case NUMA_PLACEMENT_LINEAR:
+		if (node_wide) {
+			return 0;
+		}
+		cpus[0] = nth_cpu(topo, slot % topo->cpu_count);
+		return 1;
+	case NUMA_PLACEMENT_NUMA:
+		break;
+	default:
+		return 0;
+	}
+
+	/* Consecutive threads on different nodes to balance the nodes. */
+	unsigned node = slot % topo->node_count;
+	unsigned first = topo->nodes[node];
+	unsigned size = topo->nodes[node + 1] - first;
+
+	if (node_wide) {
+		memcpy(cpus, topo->cpus + first, size * sizeof(unsigned));
+		return size;
+	}
+
+	cpus[0] = topo->cpus[first + (slot / topo->node_count) % size];
+	return 1;
+}
+
+int numa_bind_thread(const numa_topology_t *topo, numa_placement_t placement,
+                     bool node_wide, dthread_t *thread)
+{
+	if (topo == NULL || thread == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	unsigned cpus[NUMA_MAX_CPUS];
+	size_t count = numa_thread_cpus(topo, placement, dt_get_id(thread),
+	                                node_wide, cpus);
+	if (count == 0) {
+		return KNOT_EOK;
+	}
+
+	return dt_setaffinity(thread, cpus, count);
+}
+
+void numa_touch_pool(knot_mm_t *mm)
+{
+	if (mm == NULL || mm->ctx == NULL) {
+		return;
+	}
+
+	/* Page-sized allocations fill the current chunk, a byte per page. */
+	uint64_t total = mp_total_size(mm->ctx);
+	for (;;) {
+		uint8_t *page = mp_alloc(mm->ctx, MM_DEFAULT_BLKSIZE);
+		if (page == NULL || mp_total_size(mm->ctx) != total) {
+			break;
+		}
+		*page = 0;
+	}
+
+	mp_flush(mm->ctx);
+}
@@ -0,0 +1,110 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief CPU topology and placement of the query processing threads.
+ *
+ * The NUMA topology is read from sysfs. The UDP threads are pinned to single
+ * CPUs interleaved over the nodes, the TCP threads to whole nodes. The thread
+ * memory is allocated after the placement, so that it is faulted in on the
+ * local node.
+ *
+ * \addtogroup server
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "knot/server/dthreads.h"
+#include "libknot/mm_ctx.h"
+
+/*! \brief Default sysfs directory with the NUMA nodes. */
+#define NUMA_SYSFS_NODES	"/sys/devices/system/node"
+
+/*! \brief Highest supported CPU number plus one. */
+#define NUMA_MAX_CPUS		1024
+
+/*! \brief Thread placement policy. */
+typedef enum {
+	NUMA_PLACEMENT_NONE   = 1, /*!< Threads are not pinned. */
+	NUMA_PLACEMENT_LINEAR = 2, /*!< UDP thread i on CPU i modulo CPU count. */
+	NUMA_PLACEMENT_NUMA   = 3  /*!< Threads interleaved over the nodes. */
+} numa_placement_t;
+
+/*! \brief CPU topology. */
+typedef struct {
+	unsigned cpu_count;   /*!< Number of CPUs. */
+	unsigned node_count;  /*!< Number of nodes with CPUs. */
+	unsigned *cpus;       /*!< CPUs ordered by the node. */
+	unsigned *nodes;      /*!< Node offsets to \a cpus (node_count + 1 items). */
+} numa_topology_t;
+
+/*!
+ * \brief Reads the CPU topology.
+ *
+ * If the topology isn't available, all the online CPUs form a single node.
+ *
+ * \param topo   Topology to initialize.
+ * \param sysfs  Directory with the node subdirectories (NULL for default).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int numa_topology_load(numa_topology_t *topo, const char *sysfs);
+
+/*!
+ * \brief Frees the topology.
+ */
+void numa_topology_free(numa_topology_t *topo);
+
+/*!
+ * \brief Computes the CPUs of the thread.
+ *
+ * \param topo       Topology.
+ * \param placement  Placement policy.
+ * \param slot       Thread index.
+ * \param node_wide  Pin the thread to the whole node (not with the linear
+ *                   placement, which leaves such threads unpinned).
+ * \param cpus       Output CPUs (topology CPU count items).
+ *
+ * \return Number of the CPUs, zero if the thread shouldn't be pinned.
+ */
+size_t numa_thread_cpus(const numa_topology_t *topo, numa_placement_t placement,
+                        unsigned slot, bool node_wide, unsigned *cpus);
+
+/*!
+ * \brief Pins the calling thread according to the placement.
+ *
+ * \note Must be called before the thread allocates its memory.
+ *
+ * \return Error code, KNOT_EOK if pinned or not to be pinned.
+ */
+int numa_bind_thread(const numa_topology_t *topo, numa_placement_t placement,
+                     bool node_wide, dthread_t *thread);
+
+/*!
+ * \brief Faults in the pages of a fresh memory pool on the local node.
+ *
+ * \param mm  Memory pool context.
+ */
+void numa_touch_pool(knot_mm_t *mm);
+
+/*! @} */
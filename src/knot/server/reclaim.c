@@ -0,0 +1,173 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <urcu.h>
+
+#include "knot/server/reclaim.h"
+#include "contrib/ucw/lists.h"
+
+typedef struct {
+	node_t n;
+	reclaim_cb_t cb;
+	void *data;
+} reclaim_item_t;
+
+struct reclaim {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;    /*!< Signalled when a reclamation is deferred. */
+	pthread_cond_t done;    /*!< Signalled when a batch is reclaimed. */
+	pthread_t thread;       /*!< Reclamation thread. */
+	bool stop;              /*!< Thread stop request. */
+	list_t pending;         /*!< Reclamations waiting for a grace period. */
+	uint64_t deferred;      /*!< Number of deferred reclamations. */
+	uint64_t reclaimed;     /*!< Number of finished reclamations. */
+};
+
+static void reclaim_now(reclaim_cb_t cb, void *data)
+{
+	synchronize_rcu();
+	while (!cb(data));
+}
+
+/*! \brief Run the reclamations chunk by chunk, interleaved. */
+static void reclaim_batch(list_t *batch)
+{
+	while (!EMPTY_LIST(*batch)) {
+		reclaim_item_t *item = HEAD(*batch);
+		rem_node(&item->n);
+		if (item->cb(item->data)) {
+			free(item);
+		} else {
+			add_tail(batch, &item->n);
+			sched_yield();
+		}
+	}
+}
+
+static void *reclaim_run(void *data)
+{
+	reclaim_t *rc = data;
+
+	pthread_mutex_lock(&rc->lock);
+	while (true) {
+		if (EMPTY_LIST(rc->pending)) {
+			if (rc->stop) {
+				break;
+			}
+			pthread_cond_wait(&rc->wake, &rc->lock);
+			continue;
+		}
+
+		/* Take the batch, new reclamations wait for the next one. */
+		list_t batch;
+		init_list(&batch);
+		add_tail_list(&batch, &rc->pending);
+		init_list(&rc->pending);
+		uint64_t deferred = rc->deferred;
+		pthread_mutex_unlock(&rc->lock);
+
+		synchronize_rcu();
+		reclaim_batch(&batch);
+
+		pthread_mutex_lock(&rc->lock);
+		rc->reclaimed = deferred;
+		pthread_cond_broadcast(&rc->done);
+	}
+	pthread_mutex_unlock(&rc->lock);
+
+	return NULL;
+}
+
+reclaim_t *reclaim_create(void)
+{
+	reclaim_t *rc = calloc(1, sizeof(*rc));
+	if (rc == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&rc->lock, NULL);
+	pthread_cond_init(&rc->wake, NULL);
+	pthread_cond_init(&rc->done, NULL);
+	init_list(&rc->pending);
+
+	if (pthread_create(&rc->thread, NULL, reclaim_run, rc) != 0) {
+		pthread_mutex_destroy(&rc->lock);
+		pthread_cond_destroy(&rc->wake);
+		pthread_cond_destroy(&rc->done);
+		free(rc);
+		return NULL;
+	}
+
+	return rc;
+}
+
+void reclaim_defer(reclaim_t *rc, reclaim_cb_t cb, void *data)
+{
+	if (cb == NULL) {
+		return;
+	}
+
+	reclaim_item_t *item = (rc != NULL) ? malloc(sizeof(*item)) : NULL;
+	if (item == NULL) {
+		reclaim_now(cb, data);
+		return;
+	}
+	item->cb = cb;
+	item->data = data;
+
+	pthread_mutex_lock(&rc->lock);
+	add_tail(&rc->pending, &item->n);
+	rc->deferred++;
+	pthread_cond_signal(&rc->wake);
+	pthread_mutex_unlock(&rc->lock);
+}
+
+void reclaim_barrier(reclaim_t *rc)
+{
+	if (rc == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&rc->lock);
+	uint64_t deferred = rc->deferred;
+	while (rc->reclaimed < deferred) {
+		pthread_cond_wait(&rc->done, &rc->lock);
+	}
+	pthread_mutex_unlock(&rc->lock);
+}
+
+void reclaim_destroy(reclaim_t *rc)
+{
+	if (rc == NULL) {
+		return;
+	}
+
+	/* Stop the thread, pending reclamations are still finished. */
+	pthread_mutex_lock(&rc->lock);
+	rc->stop = true;
+	pthread_cond_signal(&rc->wake);
+	pthread_mutex_unlock(&rc->lock);
+	pthread_join(rc->thread, NULL);
+
+	pthread_mutex_destroy(&rc->lock);
+	pthread_cond_destroy(&rc->wake);
+	pthread_cond_destroy(&rc->done);
+	free(rc);
+}
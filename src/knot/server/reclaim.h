@@ -0,0 +1,85 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Deferred reclamation of RCU protected data.
+ *
+ * Data replaced by a writer are handed over to a dedicated thread, which
+ * waits for the RCU readers and frees them. Reclamations deferred meanwhile
+ * share one grace period. A reclamation may be split into chunks, other
+ * reclamations and allocations of other threads run in between.
+ *
+ * \addtogroup server
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/*! \brief Maximum number of zone nodes freed in one reclamation chunk. */
+#define RECLAIM_CHUNK	1024
+
+/*!
+ * \brief Reclamation callback.
+ *
+ * \param data  Reclaimed data.
+ *
+ * \retval true if reclaimed completely.
+ * \retval false if the callback has to be called again (next chunk).
+ */
+typedef bool (*reclaim_cb_t)(void *data);
+
+/*!
+ * \brief Deferred reclamation context.
+ */
+typedef struct reclaim reclaim_t;
+
+/*!
+ * \brief Create reclamation context and start its thread.
+ *
+ * \return Context or NULL on error.
+ */
+reclaim_t *reclaim_create(void);
+
+/*!
+ * \brief Reclaim the data after all current RCU readers finish.
+ *
+ * \note Without the context (or on allocation error), the readers are
+ *       synchronized and the data reclaimed immediately.
+ *
+ * \param rc    Reclamation context (can be NULL).
+ * \param cb    Reclamation callback.
+ * \param data  Data to reclaim.
+ */
+void reclaim_defer(reclaim_t *rc, reclaim_cb_t cb, void *data);
+
+/*!
+ * \brief Wait until all reclamations deferred so far are finished.
+ *
+ * \param rc  Reclamation context.
+ */
+void reclaim_barrier(reclaim_t *rc);
+
+/*!
+ * \brief Finish pending reclamations, stop the thread and free the context.
+ *
+ * \param rc  Reclamation context.
+ */
+void reclaim_destroy(reclaim_t *rc);
+
+/*! @} */
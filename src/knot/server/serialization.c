@@ -190,3 +190,91 @@ int rrset_deserialize(const uint8_t *stream, size_t *stream_size,
 
 	return KNOT_EOK;
 }
+
+int rrset_deserialize_view(const uint8_t *stream, size_t *stream_size,
+                           knot_rrset_t *rrset, uint8_t **buf, size_t *buf_size)
+{
+	if (stream == NULL || stream_size == NULL || rrset == NULL ||
+	    buf == NULL || buf_size == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (sizeof(uint64_t) > *stream_size) {
+		return KNOT_ESPACE;
+	}
+	uint64_t rrset_length = 0;
+	memcpy(&rrset_length, stream, sizeof(uint64_t));
+	if (rrset_length > *stream_size) {
+		return KNOT_ESPACE;
+	}
+
+	size_t offset = sizeof(uint64_t);
+	if (offset + sizeof(uint16_t) > rrset_length) {
+		return KNOT_EMALF;
+	}
+	uint16_t rdata_count = 0;
+	memcpy(&rdata_count, stream + offset, sizeof(uint16_t));
+	offset += sizeof(uint16_t);
+
+	/* Owner is used in place. */
+	int owner_size = knot_dname_wire_check(stream + offset,
+	                                       stream + rrset_length, NULL);
+	if (owner_size <= 0) {
+		return KNOT_EMALF;
+	}
+	knot_dname_t *owner = (knot_dname_t *)(stream + offset);
+	offset += owner_size;
+
+	/* Read type and class. */
+	if (offset + 2 * sizeof(uint16_t) > rrset_length) {
+		return KNOT_EMALF;
+	}
+	uint16_t type = 0;
+	memcpy(&type, stream + offset, sizeof(uint16_t));
+	offset += sizeof(uint16_t);
+	uint16_t rclass = 0;
+	memcpy(&rclass, stream + offset, sizeof(uint16_t));
+	offset += sizeof(uint16_t);
+
+	/* Serialized RR size and TTL take the place of the RDATA header. */
+	size_t rrs_size = rrset_length - offset;
+	if (rrs_size > *buf_size) {
+		uint8_t *new_buf = realloc(*buf, rrs_size);
+		if (new_buf == NULL) {
+			return KNOT_ENOMEM;
+		}
+		*buf = new_buf;
+		*buf_size = rrs_size;
+	}
+
+	knot_rrset_init(rrset, owner, type, rclass);
+	rrset->rrs.data = *buf;
+
+	/* Assemble RRs in the scratch buffer, they are stored sorted. */
+	uint8_t *rr = *buf;
+	for (uint16_t i = 0; i < rdata_count; i++) {
+		uint32_t rdata_size = 0;
+		if (offset + sizeof(uint32_t) > rrset_length) {
+			return KNOT_EMALF;
+		}
+		memcpy(&rdata_size, stream + offset, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+		if (rdata_size < sizeof(uint32_t) ||
+		    rdata_size - sizeof(uint32_t) > MAX_RDLENGTH ||
+		    offset + rdata_size > rrset_length) {
+			return KNOT_EMALF;
+		}
+
+		uint32_t ttl = 0;
+		memcpy(&ttl, stream + offset, sizeof(uint32_t));
+		uint16_t rdlen = rdata_size - sizeof(uint32_t);
+		knot_rdata_init(rr, rdlen, stream + offset + sizeof(uint32_t), ttl);
+		rr += knot_rdata_array_size(rdlen);
+		offset += rdata_size;
+	}
+	rrset->rrs.rr_count = rdata_count;
+
+	*stream_size = *stream_size - offset;
+
+	return KNOT_EOK;
+}
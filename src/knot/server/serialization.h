@@ -61,4 +61,25 @@ int rrset_serialize(const knot_rrset_t *rrset, uint8_t *stream, size_t *size);
 int rrset_deserialize(const uint8_t *stream, size_t *stream_size,
                       knot_rrset_t *rrset);
 
+/*!
+ * \brief Reads RRSet from given stream in place.
+ *
+ * Unlike \ref rrset_deserialize, nothing is allocated per RRSet. The owner
+ * points into the stream and the RDATA are assembled in a scratch buffer,
+ * which is reused (and enlarged if needed) by subsequent calls.
+ *
+ * \note The RRSet is valid only until the next call with the same buffer
+ *       and mustn't be cleared.
+ *
+ * \param stream       Stream containing serialized RRSet.
+ * \param stream_size  Output stream size after RRSet has been read.
+ * \param rrset        Output RRSet.
+ * \param buf          Scratch buffer (free with free()).
+ * \param buf_size     Scratch buffer size.
+ *
+ * \return KNOT_E*
+ */
+int rrset_deserialize_view(const uint8_t *stream, size_t *stream_size,
+                           knot_rrset_t *rrset, uint8_t **buf, size_t *buf_size);
+
 /*! @} */
@@ -25,6 +25,7 @@
 #include "knot/conf/confio.h"
 #include "knot/server/server.h"
 #include "knot/server/udp-handler.h"
+#include "knot/server/udp-ring.h"
 #include "knot/server/tcp-handler.h"
 #include "knot/zone/timers.h"
 #include "knot/zone/zonedb-load.h"
@@ -140,7 +141,8 @@ static bool enable_pktinfo(int sock, int family)
  * \retval 0 if successful (EOK).
  * \retval <0 on errors (EACCES, EINVAL, ENOMEM, EADDRINUSE).
  */
-static int server_init_iface(iface_t *new_if, struct sockaddr_storage *addr, int udp_thread_count)
+static int server_init_iface(iface_t *new_if, struct sockaddr_storage *addr,
+                             int udp_thread_count, unsigned udp_offload)
 {
 	/* Initialize interface. */
 	int ret = 0;
@@ -173,6 +175,9 @@ static int server_init_iface(iface_t *new_if, struct sockaddr_storage *addr, int
 	bool warn_bind = false;
 	bool warn_bufsize = false;
 
+	/* Offload features supported by all the sockets. */
+	new_if->fd_udp_offload = udp_offload;
+
 	/* Create bound UDP sockets. */
 	for (int i = 0; i < udp_socket_count; i++ ) {
 		int sock = net_bound_socket(SOCK_DGRAM, (struct sockaddr *)addr, udp_bind_flags);
@@ -202,10 +207,17 @@ static int server_init_iface(iface_t *new_if, struct sockaddr_storage *addr, int
 			log_warning("failed to enable received packet information retrieval");
 		}
 
+		new_if->fd_udp_offload &= udp_offload_setup(sock, new_if->fd_udp_offload);
+
 		new_if->fd_udp[new_if->fd_udp_count] = sock;
 		new_if->fd_udp_count += 1;
 	}
 
+	/* Disable the features missing on a later socket. */
+	for (int i = 0; i < new_if->fd_udp_count; i++) {
+		udp_offload_setup(new_if->fd_udp[i], new_if->fd_udp_offload);
+	}
+
 	/* Create bound TCP socket. */
 	int sock = net_bound_socket(SOCK_STREAM, (struct sockaddr *)addr, 0);
 	if (sock < 0) {
@@ -278,6 +290,11 @@ static int reconfigure_sockets(conf_t *conf, server_t *s)
 	conf_val_t listen_val = conf_get(conf, C_SRV, C_LISTEN);
 	conf_val_t rundir_val = conf_get(conf, C_SRV, C_RUNDIR);
 	char *rundir = conf_abs_path(&rundir_val, NULL);
+	conf_val_t gro_val = conf_get(conf, C_SRV, C_UDP_GRO);
+	unsigned udp_offload = UDP_OFFLOAD_GSO;
+	if (conf_bool(&gro_val)) {
+		udp_offload |= UDP_OFFLOAD_GRO;
+	}
 	while (listen_val.code == KNOT_EOK) {
 		iface_t *m = NULL;
 
@@ -306,7 +323,7 @@ static int reconfigure_sockets(conf_t *conf, server_t *s)
 			/* Create new interface. */
 			m = malloc(sizeof(iface_t));
 			unsigned size = s->handlers[IO_UDP].handler.unit->size;
-			if (server_init_iface(m, &addr, size) < 0) {
+			if (server_init_iface(m, &addr, size, udp_offload) < 0) {
 				free(m);
 				m = 0;
 			}
@@ -377,6 +394,71 @@ int server_init(server_t *server, int bg_workers)
 		return KNOT_ENOMEM;
 	}
 
+	/* Journals are synchronized only if configured. */
+	server->journal_sync = journal_sync_create(JOURNAL_SYNC_OFF);
+	if (server->journal_sync == NULL) {
+		worker_pool_destroy(server->workers);
+		evsched_deinit(&server->sched);
+		return KNOT_ENOMEM;
+	}
+
+	/* Updates are batched only if configured. */
+	server->ddns_batch = ddns_batch_create(&server->zone_db, DDNS_BATCH_OFF);
+	if (server->ddns_batch == NULL) {
+		journal_sync_destroy(server->journal_sync);
+		worker_pool_destroy(server->workers);
+		evsched_deinit(&server->sched);
+		return KNOT_ENOMEM;
+	}
+
+	/* Replaced zone contents are freed in the background. */
+	server->reclaim = reclaim_create();
+	if (server->reclaim == NULL) {
+		ddns_batch_destroy(server->ddns_batch);
+		journal_sync_destroy(server->journal_sync);
+		worker_pool_destroy(server->workers);
+		evsched_deinit(&server->sched);
+		return KNOT_ENOMEM;
+	}
+
+	/* Zone files are flushed in the background by one thread. */
+	server->flusher = worker_pool_create(1);
+	if (server->flusher == NULL) {
+		reclaim_destroy(server->reclaim);
+		ddns_batch_destroy(server->ddns_batch);
+		journal_sync_destroy(server->journal_sync);
+		worker_pool_destroy(server->workers);
+		evsched_deinit(&server->sched);
+		return KNOT_ENOMEM;
+	}
+
+	/* The timers database is opened with the zones. */
+	server->timers = timers_writer_create(NULL, true);
+	if (server->timers == NULL) {
+		worker_pool_destroy(server->flusher);
+		reclaim_destroy(server->reclaim);
+		ddns_batch_destroy(server->ddns_batch);
+		journal_sync_destroy(server->journal_sync);
+		worker_pool_destroy(server->workers);
+		evsched_deinit(&server->sched);
+		return KNOT_ENOMEM;
+	}
+
+	/* CPU topology for the placement of the query threads. */
+	if (numa_topology_load(&server->numa, NULL) != KNOT_EOK) {
+		timers_writer_free(server->timers);
+		worker_pool_destroy(server->flusher);
+		reclaim_destroy(server->reclaim);
+		ddns_batch_destroy(server->ddns_batch);
+		journal_sync_destroy(server->journal_sync);
+		worker_pool_destroy(server->workers);
+		evsched_deinit(&server->sched);
+		return KNOT_ENOMEM;
+	}
+
+	pthread_rwlock_init(&server->ctl_lock, NULL);
+	pthread_mutex_init(&server->ctl_conf_lock, NULL);
+
 	return KNOT_EOK;
 }
 
@@ -400,16 +482,41 @@ void server_deinit(server_t *server)
 
 	/* Free rate limits. */
 	rrl_destroy(server->rrl);
+	addrset_free(server->rrl_whitelist);
+
+	/* Free server cookie secrets. */
+	cookie_secret_destroy(server->cookies);
+
+	/* Stop DDNS batching. */
+	ddns_batch_destroy(server->ddns_batch);
+
+	/* Synchronize pending journals. */
+	journal_sync_destroy(server->journal_sync);
+
+	/* Free zone file flusher. */
+	worker_pool_destroy(server->flusher);
 
 	/* Free zone database. */
 	knot_zonedb_deep_free(&server->zone_db);
 
+	/* Finish pending reclamations. */
+	reclaim_destroy(server->reclaim);
+
+	/* Free zone timers writer. */
+	timers_writer_free(server->timers);
+
 	/* Free remaining events. */
 	evsched_deinit(&server->sched);
 
 	/* Close persistent timers database. */
 	close_timers_db(server->timers_db);
 
+	/* Free CPU topology. */
+	numa_topology_free(&server->numa);
+
+	pthread_rwlock_destroy(&server->ctl_lock);
+	pthread_mutex_destroy(&server->ctl_conf_lock);
+
 	/* Clear the structure. */
 	memset(server, 0, sizeof(server_t));
 }
@@ -467,7 +574,8 @@ int server_start(server_t *server, bool async)
 		return KNOT_EINVAL;
 	}
 
-	/* Start workers. */
+	/* Start zone file flusher and workers. */
+	worker_pool_start(server->flusher);
 	worker_pool_start(server->workers);
 
 	/* Wait for enqueued events if not asynchronous. */
@@ -501,6 +609,11 @@ void server_wait(server_t *server)
 	evsched_join(&server->sched);
 	worker_pool_join(server->workers);
 
+	/* Finish pending zone file flushes. */
+	worker_pool_wait(server->flusher);
+	worker_pool_stop(server->flusher);
+	worker_pool_join(server->flusher);
+
 	for (int proto = IO_UDP; proto <= IO_TCP; ++proto) {
 		if (server->handlers[proto].size > 0) {
 			server_free_handler(&server->handlers[proto].handler);
@@ -586,7 +699,8 @@ int server_reload(server_t *server)
 	if (full || (flags & CONF_IO_FRLD_SRV)) {
 		server_reconfigure(conf(), server);
 	}
-	if (full || (flags & (CONF_IO_FRLD_ZONES | CONF_IO_FRLD_ZONE))) {
+	if (full || (flags & (CONF_IO_FRLD_ZONES | CONF_IO_FRLD_ZONE |
+	                      CONF_IO_FRLD_CACHES | CONF_IO_FRLD_CACHE))) {
 		server_update_zones(conf(), server);
 	}
 
@@ -616,9 +730,10 @@ void server_stop(server_t *server)
 	server->state &= ~ServerRunning;
 }
 
-static int reset_handler(server_t *server, int index, unsigned size, runnable_t run)
+static int reset_handler(server_t *server, int index, unsigned size,
+                         runnable_t run, bool restart)
 {
-	if (server->handlers[index].size != size) {
+	if (server->handlers[index].size != size || restart) {
 		/* Free old handlers */
 		if (server->handlers[index].size > 0) {
 			server_free_handler(&server->handlers[index].handler);
@@ -646,12 +761,25 @@ static int reset_handler(server_t *server, int index, unsigned size, runnable_t
 /*! \brief Reconfigure UDP and TCP query processing threads. */
 static int reconfigure_threads(conf_t *conf, server_t *server)
 {
-	int ret = reset_handler(server, IO_UDP, conf_udp_threads(conf), udp_master);
+	/* The threads are placed on start, restart them if the placement changes. */
+	conf_val_t val = conf_get(conf, C_SRV, C_THREAD_PLACEMENT);
+	numa_placement_t placement = conf_opt(&val);
+	bool restart = (placement != server->placement);
+	server->placement = placement;
+
+	if (restart && placement == NUMA_PLACEMENT_NUMA) {
+		log_info("NUMA thread placement, %u CPUs in %u nodes",
+		         server->numa.cpu_count, server->numa.node_count);
+	}
+
+	int ret = reset_handler(server, IO_UDP, conf_udp_threads(conf), udp_master,
+	                        restart);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
 
-	return reset_handler(server, IO_TCP, conf_tcp_threads(conf), tcp_master);
+	return reset_handler(server, IO_TCP, conf_tcp_threads(conf), tcp_master,
+	                     restart);
 }
 
 static int reconfigure_rate_limits(conf_t *conf, server_t *server)
@@ -684,9 +812,53 @@ static int reconfigure_rate_limits(conf_t *conf, server_t *server)
 		} /* At this point, old buckets will converge to new rate. */
 	}
 
+	/* Compile the whitelist, the old one may still be used by threads. */
+	val = conf_get(conf, C_SRV, C_RATE_LIMIT_WHITELIST);
+	addrset_t *whitelist = conf_addr_set(&val);
+	if (whitelist == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	addrset_t *old = rcu_xchg_pointer(&server->rrl_whitelist, whitelist);
+	if (old != NULL) {
+		synchronize_rcu();
+		addrset_free(old);
+	}
+
+	return KNOT_EOK;
+}
+
+static int reconfigure_cookies(conf_t *conf, server_t *server)
+{
+	conf_val_t val = conf_get(conf, C_SRV, C_COOKIE_LIFETIME);
+	uint32_t lifetime = conf_int(&val);
+
+	/* Secrets are kept once created, threads may use them. */
+	if (!server->cookies && conf->cache.srv_cookies) {
+		server->cookies = cookie_secret_create(&server->sched, lifetime);
+		if (!server->cookies) {
+			return KNOT_ENOMEM;
+		}
+		log_info("DNS cookies, enabled");
+	} else if (server->cookies) {
+		cookie_secret_set_lifetime(server->cookies, lifetime);
+	}
+
 	return KNOT_EOK;
 }
 
+static void reconfigure_journal_sync(conf_t *conf, server_t *server)
+{
+	conf_val_t val = conf_get(conf, C_SRV, C_JOURNAL_SYNC_LATENCY);
+	journal_sync_set_latency(server->journal_sync, conf_int(&val));
+}
+
+static void reconfigure_ddns_batch(conf_t *conf, server_t *server)
+{
+	conf_val_t val = conf_get(conf, C_SRV, C_DDNS_BATCH_WINDOW);
+	ddns_batch_set_window(server->ddns_batch, conf_int(&val));
+}
+
 void server_reconfigure(conf_t *conf, server_t *server)
 {
 	if (conf == NULL || server == NULL) {
@@ -705,6 +877,18 @@ void server_reconfigure(conf_t *conf, server_t *server)
 		          knot_strerror(ret));
 	}
 
+	/* Reconfigure DNS cookies. */
+	if ((ret = reconfigure_cookies(conf, server)) < 0) {
+		log_error("failed to reconfigure DNS cookies (%s)",
+		          knot_strerror(ret));
+	}
+
+	/* Reconfigure journal synchronization. */
+	reconfigure_journal_sync(conf, server);
+
+	/* Reconfigure DDNS batching. */
+	reconfigure_ddns_batch(conf, server);
+
 	/* Reconfigure server threads. */
 	if ((ret = reconfigure_threads(conf, server)) < 0) {
 		log_error("failed to reconfigure server threads (%s)",
@@ -720,6 +904,14 @@ void server_reconfigure(conf_t *conf, server_t *server)
 
 static void reopen_timers_database(conf_t *conf, server_t *server)
 {
+	/* Store pending timers to the current database. */
+	int ret = timers_writer_flush(server->timers);
+	if (ret != KNOT_EOK) {
+		log_warning("failed to update zone timers database (%s)",
+		            knot_strerror(ret));
+	}
+	timers_writer_set_db(server->timers, NULL);
+
 	close_timers_db(server->timers_db);
 	server->timers_db = NULL;
 
@@ -729,11 +921,12 @@ static void reopen_timers_database(conf_t *conf, server_t *server)
 	char *timer_db = conf_abs_path(&val, storage);
 	free(storage);
 
-	int ret = open_timers_db(timer_db, &server->timers_db);
+	ret = open_timers_db(timer_db, &server->timers_db);
 	if (ret != KNOT_EOK) {
 		log_warning("cannot open persistent timers DB '%s' (%s)",
 		            timer_db, knot_strerror(ret));
 	}
+	timers_writer_set_db(server->timers, server->timers_db);
 
 	free(timer_db);
 }
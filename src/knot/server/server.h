@@ -27,15 +27,23 @@
 
 #pragma once
 
+#include <pthread.h>
+
 #include "sys/socket.h"
 
 #include "knot/conf/conf.h"
 #include "knot/common/evsched.h"
 #include "knot/common/fdset.h"
+#include "knot/server/cookies.h"
+#include "knot/server/ddns-batch.h"
+#include "knot/server/journal-sync.h"
 #include "knot/server/dthreads.h"
+#include "knot/server/numa.h"
 #include "knot/common/ref.h"
+#include "knot/server/reclaim.h"
 #include "knot/server/rrl.h"
 #include "knot/worker/pool.h"
+#include "knot/zone/timers.h"
 #include "knot/zone/zonedb.h"
 #include "contrib/ucw/lists.h"
 
@@ -67,6 +75,7 @@ typedef struct iface {
 	struct node n;
 	int *fd_udp;
 	int fd_udp_count;
+	unsigned fd_udp_offload;
 	int fd_tcp;
 	struct sockaddr_storage addr;
 } iface_t;
@@ -103,6 +112,10 @@ typedef struct server {
 		iohandler_t handler;
 	} handlers[2];
 
+	/*! \brief CPU topology and placement of the I/O handler threads. */
+	numa_topology_t numa;
+	numa_placement_t placement;
+
 	/*! \brief Background jobs. */
 	worker_pool_t *workers;
 
@@ -115,6 +128,33 @@ typedef struct server {
 	/*! \brief Rate limiting. */
 	rrl_table_t *rrl;
 
+	/*! \brief Rate limiting exempt clients (RCU protected). */
+	addrset_t *rrl_whitelist;
+
+	/*! \brief Server cookie secrets. */
+	cookie_secret_t *cookies;
+
+	/*! \brief Journal group commit. */
+	journal_sync_t *journal_sync;
+
+	/*! \brief DDNS batching across zones. */
+	ddns_batch_t *ddns_batch;
+
+	/*! \brief Deferred reclamation of replaced zone contents. */
+	reclaim_t *reclaim;
+
+	/*! \brief Background zone file flushes. */
+	worker_pool_t *flusher;
+
+	/*! \brief Incremental zone timers writer. */
+	timers_writer_t *timers;
+
+	/*! \brief Control commands lock (exclusive for server reload). */
+	pthread_rwlock_t ctl_lock;
+
+	/*! \brief Configuration transaction lock for control commands. */
+	pthread_mutex_t ctl_conf_lock;
+
 } server_t;
 
 /*!
@@ -155,6 +195,9 @@ void server_wait(server_t *server);
 /*!
  * \brief Reload server configuration.
  *
+ * \note The caller must hold the control lock exclusively if control
+ *       commands can run concurrently.
+ *
  * \param server  Server instance.
  *
  * \return Error code, KNOT_EOK if success.
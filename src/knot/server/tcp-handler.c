@@ -298,6 +298,10 @@ int tcp_master(dthread_t *thread)
 	iohandler_t *handler = (iohandler_t *)thread->data;
 	unsigned *iostate = &handler->thread_state[dt_get_id(thread)];
 
+	/* Pin the thread to a node before allocating its memory. */
+	server_t *server = handler->server;
+	numa_bind_thread(&server->numa, server->placement, true, thread);
+
 	int ret = KNOT_EOK;
 	ref_t *ref = NULL;
 	tcp_context_t tcp;
@@ -306,6 +310,7 @@ int tcp_master(dthread_t *thread)
 	/* Create big enough memory cushion. */
 	knot_mm_t mm = { 0 };
 	mm_ctx_mempool(&mm, 16 * MM_DEFAULT_BLKSIZE);
+	numa_touch_pool(&mm);
 
 	/* Create TCP answering context. */
 	tcp.server = handler->server;
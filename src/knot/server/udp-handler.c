@@ -40,6 +40,7 @@
 #include "knot/query/layer.h"
 #include "knot/server/server.h"
 #include "knot/server/udp-handler.h"
+#include "knot/server/udp-ring.h"
 
 /* Buffer identifiers. */
 enum {
@@ -107,7 +108,7 @@ static void udp_handle(udp_context_t *udp, int fd, struct sockaddr_storage *ss,
 /*! \brief Pointer to selected UDP master implementation. */
 static void* (*_udp_init)(void) = 0;
 static int (*_udp_deinit)(void *) = 0;
-static int (*_udp_recv)(int, void *) = 0;
+static int (*_udp_recv)(int, unsigned, void *) = 0;
 static int (*_udp_handle)(udp_context_t *, void *) = 0;
 static int (*_udp_send)(void *) = 0;
 
@@ -179,7 +180,7 @@ static int udp_recvfrom_deinit(void *d)
 	return 0;
 }
 
-static int udp_recvfrom_recv(int fd, void *d)
+static int udp_recvfrom_recv(int fd, unsigned offload, void *d)
 {
 	/* Reset max lengths. */
 	struct udp_recvfrom *rq = (struct udp_recvfrom *)d;
@@ -231,89 +232,58 @@ static int udp_recvfrom_send(void *d)
 
 #ifdef ENABLE_RECVMMSG
 
-/* UDP recvmmsg() request struct. */
-struct udp_recvmmsg {
-	int fd;
-	struct sockaddr_storage addrs[RECVMMSG_BATCHLEN];
-	char *iobuf[NBUFS];
-	struct iovec *iov[NBUFS];
-	struct mmsghdr *msgs[NBUFS];
-	unsigned rcvd;
-	knot_mm_t mm;
-	cmsg_pktinfo_t pktinfo[RECVMMSG_BATCHLEN];
-};
+/*! \brief Largest accepted query and sent answer. */
+static size_t udp_recvmmsg_slot_size(void)
+{
+	rcu_read_lock();
+	conf_t *pconf = conf();
+	size_t size = MAX(pconf->cache.srv_max_ipv4_udp_payload,
+	                  pconf->cache.srv_max_ipv6_udp_payload);
+	rcu_read_unlock();
+
+	return size;
+}
 
 static void *udp_recvmmsg_init(void)
 {
-	knot_mm_t mm;
-	mm_ctx_mempool(&mm, sizeof(struct udp_recvmmsg));
-
-	struct udp_recvmmsg *rq = mm.alloc(mm.ctx, sizeof(struct udp_recvmmsg));
-	memset(rq, 0, sizeof(*rq));
-	memcpy(&rq->mm, &mm, sizeof(knot_mm_t));
+	udp_ring_t *ring = malloc(sizeof(udp_ring_t));
+	if (ring == NULL) {
+		return NULL;
+	}
 
-	/* Initialize buffers. */
-	for (unsigned i = 0; i < NBUFS; ++i) {
-		rq->iobuf[i] = mm.alloc(mm.ctx, KNOT_WIRE_MAX_PKTSIZE * RECVMMSG_BATCHLEN);
-		rq->iov[i] = mm.alloc(mm.ctx, sizeof(struct iovec) * RECVMMSG_BATCHLEN);
-		rq->msgs[i] = mm.alloc(mm.ctx, sizeof(struct mmsghdr) * RECVMMSG_BATCHLEN);
-		memset(rq->msgs[i], 0, sizeof(struct mmsghdr) * RECVMMSG_BATCHLEN);
-		for (unsigned k = 0; k < RECVMMSG_BATCHLEN; ++k) {
-			rq->iov[i][k].iov_base = rq->iobuf[i] + k * KNOT_WIRE_MAX_PKTSIZE;
-			rq->iov[i][k].iov_len = KNOT_WIRE_MAX_PKTSIZE;
-			rq->msgs[i][k].msg_hdr.msg_iov = rq->iov[i] + k;
-			rq->msgs[i][k].msg_hdr.msg_iovlen = 1;
-			rq->msgs[i][k].msg_hdr.msg_name = rq->addrs + k;
-			rq->msgs[i][k].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
-			rq->msgs[i][k].msg_hdr.msg_control = &rq->pktinfo[k].cmsg;
-			rq->msgs[i][k].msg_hdr.msg_controllen = sizeof(cmsg_pktinfo_t);
-		}
+	if (udp_ring_init(ring, udp_recvmmsg_slot_size()) != KNOT_EOK) {
+		free(ring);
+		return NULL;
 	}
 
-	return rq;
+	return ring;
 }
 
 static int udp_recvmmsg_deinit(void *d)
 {
-	struct udp_recvmmsg *rq = (struct udp_recvmmsg *)d;
-	if (rq) {
-		mp_delete(rq->mm.ctx);
-	}
-
+	udp_ring_t *ring = (udp_ring_t *)d;
+	udp_ring_deinit(ring);
+	free(ring);
 	return 0;
 }
 
-static int udp_recvmmsg_recv(int fd, void *d)
+static int udp_recvmmsg_recv(int fd, unsigned offload, void *d)
 {
-	struct udp_recvmmsg *rq = (struct udp_recvmmsg *)d;
-
-	int n = recvmmsg(fd, rq->msgs[RX], RECVMMSG_BATCHLEN, MSG_DONTWAIT, NULL);
-	if (n > 0) {
-		rq->fd = fd;
-		rq->rcvd = n;
-	}
-	return n;
+	return udp_ring_recv((udp_ring_t *)d, fd, offload);
 }
 
 static int udp_recvmmsg_handle(udp_context_t *ctx, void *d)
 {
-	struct udp_recvmmsg *rq = (struct udp_recvmmsg *)d;
-
-	/* Handle each received msg. */
-	for (unsigned i = 0; i < rq->rcvd; ++i) {
-		struct iovec *rx = rq->msgs[RX][i].msg_hdr.msg_iov;
-		struct iovec *tx = rq->msgs[TX][i].msg_hdr.msg_iov;
-		rx->iov_len = rq->msgs[RX][i].msg_len; /* Received bytes. */
-
-		udp_pktinfo_handle(&rq->msgs[RX][i].msg_hdr, &rq->msgs[TX][i].msg_hdr);
-
-		udp_handle(ctx, rq->fd, rq->addrs + i, rx, tx);
-		rq->msgs[TX][i].msg_len = tx->iov_len;
-		rq->msgs[TX][i].msg_hdr.msg_namelen = 0;
-		if (tx->iov_len > 0) {
-			/* @note sendmmsg() workaround to prevent sending the packet */
-			rq->msgs[TX][i].msg_hdr.msg_namelen = rq->msgs[RX][i].msg_hdr.msg_namelen;
-		}
+	udp_ring_t *ring = (udp_ring_t *)d;
+
+	/* Handle each received query, a message may carry several. */
+	struct iovec rx, tx;
+	struct sockaddr_storage *ss;
+	while (udp_ring_next(ring, &rx, &ss, &tx)) {
+		udp_handle(ctx, ring->fd, ss, &rx, &tx);
+		udp_ring_answer(ring, tx.iov_len);
+		/* A datagram train may carry many queries. */
+		mp_flush(ctx->layer.mm->ctx);
 	}
 
 	return KNOT_EOK;
@@ -321,21 +291,7 @@ static int udp_recvmmsg_handle(udp_context_t *ctx, void *d)
 
 static int udp_recvmmsg_send(void *d)
 {
-	struct udp_recvmmsg *rq = (struct udp_recvmmsg *)d;
-	int rc = sendmmsg(rq->fd, rq->msgs[TX], rq->rcvd, 0);
-	for (unsigned i = 0; i < rq->rcvd; ++i) {
-		/* Reset buffer size and address len. */
-		struct iovec *rx = rq->msgs[RX][i].msg_hdr.msg_iov;
-		struct iovec *tx = rq->msgs[TX][i].msg_hdr.msg_iov;
-		rx->iov_len = KNOT_WIRE_MAX_PKTSIZE; /* Reset RX buflen */
-		tx->iov_len = KNOT_WIRE_MAX_PKTSIZE;
-
-		memset(rq->addrs + i, 0, sizeof(struct sockaddr_storage));
-		rq->msgs[RX][i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
-		rq->msgs[TX][i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
-		rq->msgs[RX][i].msg_hdr.msg_controllen = sizeof(cmsg_pktinfo_t);
-	}
-	return rc;
+	return udp_ring_flush((udp_ring_t *)d);
 }
 #endif /* ENABLE_RECVMMSG */
 
@@ -369,11 +325,14 @@ static int iface_udp_fd(const iface_t *iface, int thread_id)
 }
 
 /*! \brief Release the interface list reference and free watched descriptor set. */
-static void forget_ifaces(ifacelist_t *ifaces, struct pollfd **fds_ptr)
+static void forget_ifaces(ifacelist_t *ifaces, struct pollfd **fds_ptr,
+                          unsigned **offload_ptr)
 {
 	ref_release((ref_t *)ifaces);
 	free(*fds_ptr);
 	*fds_ptr = NULL;
+	free(*offload_ptr);
+	*offload_ptr = NULL;
 }
 
 /*!
@@ -382,18 +341,23 @@ static void forget_ifaces(ifacelist_t *ifaces, struct pollfd **fds_ptr)
  * \param[in]   ifaces  New interface list.
  * \param[in]   thrid   Thread ID.
  * \param[out]  fds_ptr Allocated set of descriptors.
+ * \param[out]  offload_ptr Offload features of the descriptors.
  *
  * \return Number of watched descriptors, zero on error.
  */
 static nfds_t track_ifaces(const ifacelist_t *ifaces, int thrid,
-                           struct pollfd **fds_ptr)
+                           struct pollfd **fds_ptr, unsigned **offload_ptr)
 {
-	assert(ifaces && fds_ptr);
+	assert(ifaces && fds_ptr && offload_ptr);
 
 	nfds_t nfds = list_size(&ifaces->l);
 	struct pollfd *fds = malloc(nfds * sizeof(*fds));
-	if (!fds) {
+	unsigned *offload = malloc(nfds * sizeof(*offload));
+	if (!fds || !offload) {
+		free(fds);
+		free(offload);
 		*fds_ptr = NULL;
+		*offload_ptr = NULL;
 		return 0;
 	}
 
@@ -403,21 +367,22 @@ static nfds_t track_ifaces(const ifacelist_t *ifaces, int thrid,
 		fds[i].fd = iface_udp_fd(iface, thrid);
 		fds[i].events = POLLIN;
 		fds[i].revents = 0;
+		offload[i] = iface->fd_udp_offload;
 		i += 1;
 	}
 	assert(i == nfds);
 
 	*fds_ptr = fds;
+	*offload_ptr = offload;
 	return nfds;
 }
 
 int udp_master(dthread_t *thread)
 {
-	unsigned cpu = dt_online_cpus();
-	if (cpu > 1) {
-		unsigned cpu_mask = (dt_get_id(thread) % cpu);
-		dt_setaffinity(thread, &cpu_mask, 1);
-	}
+	/* Pin the thread before allocating its memory. */
+	iohandler_t *handler = (iohandler_t *)thread->data;
+	server_t *server = handler->server;
+	numa_bind_thread(&server->numa, server->placement, false, thread);
 
 	/* Drop all capabilities on all workers. */
 #ifdef HAVE_CAP_NG_H
@@ -429,14 +394,14 @@ int udp_master(dthread_t *thread)
 
 	/* Prepare structures for bound sockets. */
 	unsigned thr_id = dt_get_id(thread);
-	iohandler_t *handler = (iohandler_t *)thread->data;
 	unsigned *iostate = &handler->thread_state[thr_id];
-	void *rq = _udp_init();
+	void *rq = NULL;
 	ifacelist_t *ref = NULL;
 
 	/* Create big enough memory cushion. */
 	knot_mm_t mm;
 	mm_ctx_mempool(&mm, 16 * MM_DEFAULT_BLKSIZE);
+	numa_touch_pool(&mm);
 
 	/* Create UDP answering context. */
 	udp_context_t udp;
@@ -447,6 +412,7 @@ int udp_master(dthread_t *thread)
 
 	/* Event source. */
 	struct pollfd *fds = NULL;
+	unsigned *offload = NULL;
 	nfds_t nfds = 0;
 
 	/* Loop until all data is read. */
@@ -458,13 +424,22 @@ int udp_master(dthread_t *thread)
 			udp.thread_id = handler->thread_id[thr_id];
 
 			rcu_read_lock();
-			forget_ifaces(ref, &fds);
+			forget_ifaces(ref, &fds, &offload);
 			ref = handler->server->ifaces;
-			nfds = track_ifaces(ref, udp.thread_id, &fds);
+			nfds = track_ifaces(ref, udp.thread_id, &fds, &offload);
 			rcu_read_unlock();
 			if (nfds == 0) {
 				break;
 			}
+
+			/* Buffers sized by the maximal UDP payload. */
+			if (rq != NULL) {
+				_udp_deinit(rq);
+			}
+			rq = _udp_init();
+			if (rq == NULL) {
+				break;
+			}
 		}
 
 		/* Cancellation point. */
@@ -486,7 +461,7 @@ int udp_master(dthread_t *thread)
 			}
 			events -= 1;
 			int rcvd = 0;
-			if ((rcvd = _udp_recv(fds[i].fd, rq)) > 0) {
+			if ((rcvd = _udp_recv(fds[i].fd, offload[i], rq)) > 0) {
 				_udp_handle(&udp, rq);
 				/* Flush allocated memory. */
 				mp_flush(mm.ctx);
@@ -495,8 +470,10 @@ int udp_master(dthread_t *thread)
 		}
 	}
 
-	_udp_deinit(rq);
-	forget_ifaces(ref, &fds);
+	if (rq != NULL) {
+		_udp_deinit(rq);
+	}
+	forget_ifaces(ref, &fds, &offload);
 	mp_delete(mm.ctx);
 	return KNOT_EOK;
 }
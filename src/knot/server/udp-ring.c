@@ -0,0 +1,415 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/udp.h>
+
+#include "knot/server/udp-ring.h"
+#include "contrib/macros.h"
+#include "contrib/sockaddr.h"
+#include "libknot/errcode.h"
+#include "libknot/packet/wire.h"
+
+unsigned udp_offload_setup(int sock, unsigned offload)
+{
+	unsigned enabled = 0;
+
+	/* Only the batched receive splits the datagram trains. */
+#if defined(ENABLE_RECVMMSG) && defined(UDP_GRO)
+	int on = (offload & UDP_OFFLOAD_GRO) ? 1 : 0;
+	if (setsockopt(sock, SOL_UDP, UDP_GRO, &on, sizeof(on)) == 0 && on) {
+		enabled |= UDP_OFFLOAD_GRO;
+	}
+#endif
+#if defined(ENABLE_RECVMMSG) && defined(UDP_SEGMENT)
+	/* Kernels without the support would send the train as one datagram. */
+	int size = 0;
+	socklen_t len = sizeof(size);
+	if ((offload & UDP_OFFLOAD_GSO) &&
+	    getsockopt(sock, SOL_UDP, UDP_SEGMENT, &size, &len) == 0) {
+		enabled |= UDP_OFFLOAD_GSO;
+	}
+#endif
+
+	return enabled;
+}
+
+#ifdef ENABLE_RECVMMSG
+
+/*! \brief Number of full-size slots received from a UDP_GRO socket. */
+#define UDP_GRO_SLOTS		16
+
+/*! \brief Largest segment sent with UDP_SEGMENT (fits the minimal IPv6 MTU). */
+#define UDP_GSO_MAX_SEGSIZE	1232
+
+int udp_ring_init(udp_ring_t *ring, size_t slot_size)
+{
+	if (ring == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	memset(ring, 0, sizeof(*ring));
+	ring->slot_size = MIN(MAX(slot_size, KNOT_WIRE_MIN_PKTSIZE), KNOT_WIRE_MAX_PKTSIZE);
+	ring->batch = UDP_RING_MINLEN;
+
+	/* The slots are faulted in by the thread when first used. */
+	ring->rx_buf_size = UDP_RING_MAXLEN * ring->slot_size;
+	ring->rx_buf = malloc(ring->rx_buf_size);
+	ring->tx_buf = malloc(UDP_RING_MAXLEN * ring->slot_size);
+	if (ring->rx_buf == NULL || ring->tx_buf == NULL) {
+		udp_ring_deinit(ring);
+		return KNOT_ENOMEM;
+	}
+
+	for (unsigned i = 0; i < UDP_RING_MAXLEN; i++) {
+		struct msghdr *hdr = &ring->rx_msgs[i].msg_hdr;
+		hdr->msg_name = &ring->rx_addrs[i];
+		hdr->msg_iov = &ring->rx_iov[i];
+		hdr->msg_iovlen = 1;
+		hdr->msg_control = ring->rx_cmsgs[i].buf;
+	}
+
+	return KNOT_EOK;
+}
+
+void udp_ring_deinit(udp_ring_t *ring)
+{
+	if (ring == NULL) {
+		return;
+	}
+
+	free(ring->rx_buf);
+	free(ring->gro_buf);
+	free(ring->tx_buf);
+	memset(ring, 0, sizeof(*ring));
+}
+
+size_t udp_ring_memsize(const udp_ring_t *ring)
+{
+	if (ring == NULL) {
+		return 0;
+	}
+
+	size_t size = sizeof(*ring) + ring->rx_buf_size + UDP_RING_MAXLEN * ring->slot_size;
+	if (ring->gro_buf != NULL) {
+		size += UDP_GRO_SLOTS * KNOT_WIRE_MAX_PKTSIZE;
+	}
+
+	return size;
+}
+
+/*! \brief Returns the UDP_GRO segment size of the message, 0 if none. */
+static uint16_t gro_segment(struct msghdr *hdr)
+{
+#ifdef UDP_GRO
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+		if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+			int size = 0;
+			memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+			return size;
+		}
+	}
+#endif
+	return 0;
+}
+
+/*! \brief Doubles the batch length if filled, halves it if mostly unused. */
+static void adapt_batch(udp_ring_t *ring, int received)
+{
+	if (received >= (int)ring->batch) {
+		ring->batch = MIN(2 * ring->batch, UDP_RING_MAXLEN);
+	} else if (received < (int)ring->batch / 4) {
+		ring->batch = MAX(ring->batch / 2, UDP_RING_MINLEN);
+	}
+}
+
+int udp_ring_recv(udp_ring_t *ring, int fd, unsigned offload)
+{
+	if (ring == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* Unsent answers refer to the received messages. */
+	if (ring->tx_count > 0) {
+		udp_ring_flush(ring);
+	}
+
+	/* A train of datagrams needs a full-size slot, the rest is lost. */
+	bool gro = (offload & UDP_OFFLOAD_GRO);
+	if (gro && ring->gro_buf == NULL) {
+		ring->gro_buf = malloc(UDP_GRO_SLOTS * KNOT_WIRE_MAX_PKTSIZE);
+		if (ring->gro_buf == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+	uint8_t *buf = gro ? ring->gro_buf : ring->rx_buf;
+	size_t size = gro ? KNOT_WIRE_MAX_PKTSIZE : ring->slot_size;
+	unsigned count = gro ? UDP_GRO_SLOTS : ring->batch;
+
+	for (unsigned i = 0; i < count; i++) {
+		struct msghdr *hdr = &ring->rx_msgs[i].msg_hdr;
+		ring->rx_iov[i].iov_base = buf + i * size;
+		ring->rx_iov[i].iov_len = size;
+		hdr->msg_namelen = sizeof(struct sockaddr_storage);
+		hdr->msg_controllen = sizeof(udp_cmsg_t);
+		hdr->msg_flags = 0;
+	}
+
+	ring->fd = fd;
+	ring->offload = offload;
+	ring->rx_count = 0;
+	ring->rx_msg = 0;
+	ring->rx_off = 0;
+
+	int n = recvmmsg(fd, ring->rx_msgs, count, MSG_DONTWAIT, NULL);
+	if (!gro) {
+		adapt_batch(ring, n);
+	}
+	if (n <= 0) {
+		return n;
+	}
+
+	for (unsigned i = 0; i < n; i++) {
+		struct msghdr *hdr = &ring->rx_msgs[i].msg_hdr;
+		/* Queries over the accepted payload size are ignored. */
+		if (hdr->msg_flags & MSG_TRUNC) {
+			ring->rx_msgs[i].msg_len = 0;
+		}
+		ring->rx_segs[i] = gro_segment(hdr);
+	}
+	ring->rx_count = n;
+
+	return n;
+}
+
+bool udp_ring_next(udp_ring_t *ring, struct iovec *query,
+                   struct sockaddr_storage **addr, struct iovec *answer)
+{
+	if (ring == NULL || query == NULL || addr == NULL || answer == NULL) {
+		return false;
+	}
+
+	for (; ring->rx_msg < ring->rx_count; ring->rx_msg++, ring->rx_off = 0) {
+		size_t len = ring->rx_msgs[ring->rx_msg].msg_len;
+		if (ring->rx_off < len) {
+			size_t seg = ring->rx_segs[ring->rx_msg];
+			query->iov_base = (uint8_t *)ring->rx_iov[ring->rx_msg].iov_base + ring->rx_off;
+			query->iov_len = MIN(seg > 0 ? seg : len, len - ring->rx_off);
+			ring->rx_off += query->iov_len;
+			break;
+		}
+	}
+	if (ring->rx_msg >= ring->rx_count) {
+		return false;
+	}
+
+	if (ring->tx_count == UDP_RING_MAXLEN) {
+		udp_ring_flush(ring);
+	}
+
+	*addr = &ring->rx_addrs[ring->rx_msg];
+	answer->iov_base = ring->tx_buf + ring->tx_count * ring->slot_size;
+	answer->iov_len = ring->slot_size;
+
+	return true;
+}
+
+void udp_ring_answer(udp_ring_t *ring, size_t len)
+{
+	if (ring == NULL || len == 0 || ring->rx_msg >= ring->rx_count ||
+	    ring->tx_count == UDP_RING_MAXLEN) {
+		return;
+	}
+
+	udp_answer_t *ans = &ring->tx_answers[ring->tx_count++];
+	ans->msg = ring->rx_msg;
+	ans->len = MIN(len, ring->slot_size);
+}
+
+/*! \brief Checks if the answers go to the same client from the same address. */
+static bool same_flow(const udp_ring_t *ring, unsigned msg1, unsigned msg2)
+{
+	if (msg1 == msg2) {
+		return true;
+	}
+
+	const struct msghdr *hdr1 = &ring->rx_msgs[msg1].msg_hdr;
+	const struct msghdr *hdr2 = &ring->rx_msgs[msg2].msg_hdr;
+	return hdr1->msg_controllen == hdr2->msg_controllen &&
+	       memcmp(hdr1->msg_control, hdr2->msg_control, hdr1->msg_controllen) == 0 &&
+	       sockaddr_cmp((struct sockaddr *)&ring->rx_addrs[msg1],
+	                    (struct sockaddr *)&ring->rx_addrs[msg2]) == 0;
+}
+
+/*! \brief Checks if the answer can be appended as a segment of the message. */
+static bool can_append(const udp_ring_t *ring, const struct msghdr *hdr,
+                       const udp_answer_t *first, const udp_answer_t *ans)
+{
+	if (!(ring->offload & UDP_OFFLOAD_GSO) || ring->gso_failed ||
+	    hdr->msg_iovlen >= UDP_GSO_MAX_SEGS || first->len > UDP_GSO_MAX_SEGSIZE) {
+		return false;
+	}
+
+	/* All the segments but the last one have the same size. */
+	const udp_answer_t *last = ans - 1;
+	if (last->len != first->len || ans->len > first->len) {
+		return false;
+	}
+
+	size_t total = hdr->msg_iovlen * first->len + ans->len;
+	return total <= UDP_GSO_MAX_SIZE && same_flow(ring, first->msg, ans->msg);
+}
+
+/*!
+ * \brief Copies the packet info of the query, appends the segment size.
+ *
+ * \return Control message length.
+ */
+static size_t make_cmsg(udp_cmsg_t *tx, struct msghdr *rx, uint16_t segment)
+{
+	size_t len = 0;
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(rx); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(rx, cmsg)) {
+		/* The receive offload options aren't valid when sending. */
+		if (cmsg->cmsg_level == IPPROTO_UDP) {
+			continue;
+		}
+		size_t space = CMSG_SPACE(cmsg->cmsg_len - CMSG_LEN(0));
+		if (len + space > sizeof(tx->buf)) {
+			break;
+		}
+		memcpy(tx->buf + len, cmsg, cmsg->cmsg_len);
+		len += space;
+	}
+
+#ifdef UDP_SEGMENT
+	if (segment > 0 && len + CMSG_SPACE(sizeof(segment)) <= sizeof(tx->buf)) {
+		struct cmsghdr *cmsg = (struct cmsghdr *)(tx->buf + len);
+		cmsg->cmsg_level = SOL_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(segment));
+		memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+		len += CMSG_SPACE(sizeof(segment));
+	}
+#endif
+
+	return len;
+}
+
+/*!
+ * \brief Checks if the send error means the segmentation will never work.
+ *
+ * EIO: no checksum offload on the device, EOPNOTSUPP/ENOPROTOOPT: no support
+ * for UDP_SEGMENT at all. EINVAL only concerns the destination (segment size
+ * over its path MTU), the train is resent but the segmentation stays enabled.
+ */
+static bool gso_unsupported(int error)
+{
+	return error == EIO || error == EOPNOTSUPP || error == ENOPROTOOPT;
+}
+
+/*! \brief Sends the segments of a failed message one by one. */
+static int send_segments(udp_ring_t *ring, struct msghdr *hdr)
+{
+	struct msghdr seg = *hdr;
+	seg.msg_iovlen = 1;
+	seg.msg_controllen -= CMSG_SPACE(sizeof(uint16_t));
+	if (seg.msg_controllen == 0) {
+		seg.msg_control = NULL;
+	}
+
+	int sent = 0;
+	for (size_t i = 0; i < hdr->msg_iovlen; i++) {
+		seg.msg_iov = hdr->msg_iov + i;
+		if (sendmsg(ring->fd, &seg, 0) > 0) {
+			sent += 1;
+		}
+	}
+
+	return sent;
+}
+
+int udp_ring_flush(udp_ring_t *ring)
+{
+	if (ring == NULL || ring->tx_count == 0) {
+		return 0;
+	}
+
+	/* Group the answers into messages. */
+	unsigned first[UDP_RING_MAXLEN];
+	unsigned count = 0;
+	for (unsigned i = 0; i < ring->tx_count; i++) {
+		const udp_answer_t *ans = &ring->tx_answers[i];
+		struct iovec *iov = &ring->tx_iov[i];
+		iov->iov_base = ring->tx_buf + i * ring->slot_size;
+		iov->iov_len = ans->len;
+
+		if (count > 0) {
+			struct msghdr *hdr = &ring->tx_msgs[count - 1].msg_hdr;
+			if (can_append(ring, hdr, &ring->tx_answers[first[count - 1]], ans)) {
+				hdr->msg_iovlen += 1;
+				continue;
+			}
+		}
+
+		struct msghdr *hdr = &ring->tx_msgs[count].msg_hdr;
+		hdr->msg_name = &ring->rx_addrs[ans->msg];
+		hdr->msg_namelen = ring->rx_msgs[ans->msg].msg_hdr.msg_namelen;
+		hdr->msg_iov = iov;
+		hdr->msg_iovlen = 1;
+		first[count++] = i;
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		const udp_answer_t *ans = &ring->tx_answers[first[i]];
+		struct msghdr *hdr = &ring->tx_msgs[i].msg_hdr;
+		uint16_t segment = (hdr->msg_iovlen > 1) ? ans->len : 0;
+		hdr->msg_controllen = make_cmsg(&ring->tx_cmsgs[i],
+		                                &ring->rx_msgs[ans->msg].msg_hdr, segment);
+		/* BSD has problem with zero length and not-null pointer. */
+		hdr->msg_control = (hdr->msg_controllen > 0) ? ring->tx_cmsgs[i].buf : NULL;
+		hdr->msg_flags = 0;
+	}
+
+	int sent = 0;
+	for (unsigned i = 0; i < count; ) {
+		int ret = sendmmsg(ring->fd, ring->tx_msgs + i, count - i, 0);
+		if (ret > 0) {
+			sent += ret;
+			i += ret;
+			continue;
+		}
+
+		/* Skip the failed message, resend a train as single datagrams. */
+		struct msghdr *hdr = &ring->tx_msgs[i].msg_hdr;
+		if (hdr->msg_iovlen > 1) {
+			if (gso_unsupported(errno)) {
+				ring->gso_failed = true;
+			}
+			sent += (send_segments(ring, hdr) > 0);
+		}
+		i += 1;
+	}
+
+	ring->tx_count = 0;
+
+	return sent;
+}
+
+#endif /* ENABLE_RECVMMSG */
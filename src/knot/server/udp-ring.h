@@ -0,0 +1,180 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file
+ *
+ * \brief Batched UDP message buffers.
+ *
+ * The slots are sized by the largest EDNS payload the server accepts instead
+ * of the maximal DNS message size. With UDP_GRO enabled on the socket, a few
+ * full-size slots are received instead, each holding a train of datagrams from
+ * one client. Consecutive answers of equal size to the same client are sent as
+ * one UDP_SEGMENT message. The receive batch length follows the load.
+ *
+ * \addtogroup server
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#ifdef HAVE_SYS_UIO_H /* 'struct iovec' for OpenBSD */
+#include <sys/uio.h>
+#endif /* HAVE_SYS_UIO_H */
+
+/*! \brief Maximal number of messages in a batch. */
+#define UDP_RING_MAXLEN		64
+
+/*! \brief Minimal receive batch length. */
+#define UDP_RING_MINLEN		4
+
+/*! \brief Maximal number of segments of a UDP_SEGMENT message (kernel limit). */
+#define UDP_GSO_MAX_SEGS	64
+
+/*! \brief Maximal UDP payload of a UDP_SEGMENT message. */
+#define UDP_GSO_MAX_SIZE	65507
+
+/*! \brief Offload features of a UDP socket. */
+enum udp_offload {
+	UDP_OFFLOAD_GRO = 1 << 0, /*!< Receive datagram trains (UDP_GRO). */
+	UDP_OFFLOAD_GSO = 1 << 1, /*!< Send datagram trains (UDP_SEGMENT). */
+	UDP_OFFLOAD_ALL = UDP_OFFLOAD_GRO | UDP_OFFLOAD_GSO
+};
+
+/*!
+ * \brief Enables or disables the offload features of a UDP socket.
+ *
+ * \param sock     Socket.
+ * \param offload  Requested features, the other ones are disabled.
+ *
+ * \return Enabled features.
+ */
+unsigned udp_offload_setup(int sock, unsigned offload);
+
+#ifdef ENABLE_RECVMMSG
+
+/*! \brief Control message buffer for the packet info and the offload options. */
+typedef union {
+	struct cmsghdr cmsg;
+	uint8_t buf[CMSG_SPACE(sizeof(struct in6_pktinfo)) + CMSG_SPACE(sizeof(int))];
+} udp_cmsg_t;
+
+/*! \brief Queued answer. */
+typedef struct {
+	unsigned msg;  /*!< Index of the received message. */
+	size_t len;    /*!< Answer length. */
+} udp_answer_t;
+
+/*! \brief Batched UDP message buffers of a thread. */
+typedef struct {
+	int fd;                /*!< Socket of the current batch. */
+	unsigned offload;      /*!< Offload features of the socket. */
+	bool gso_failed;       /*!< Segmentation failed permanently, disabled. */
+	size_t slot_size;      /*!< Compact slot size. */
+	unsigned batch;        /*!< Current receive batch length. */
+
+	/* Received messages. */
+	uint8_t *rx_buf;       /*!< Compact slots. */
+	size_t rx_buf_size;
+	uint8_t *gro_buf;      /*!< Full-size slots, allocated on first use. */
+	unsigned rx_count;
+	unsigned rx_msg;       /*!< Message of the next query. */
+	size_t rx_off;         /*!< Offset of the next query in the message. */
+	struct mmsghdr rx_msgs[UDP_RING_MAXLEN];
+	struct iovec rx_iov[UDP_RING_MAXLEN];
+	struct sockaddr_storage rx_addrs[UDP_RING_MAXLEN];
+	udp_cmsg_t rx_cmsgs[UDP_RING_MAXLEN];
+	uint16_t rx_segs[UDP_RING_MAXLEN]; /*!< GRO segment sizes, 0 if none. */
+
+	/* Queued answers and the messages to send. */
+	uint8_t *tx_buf;
+	unsigned tx_count;
+	udp_answer_t tx_answers[UDP_RING_MAXLEN];
+	struct iovec tx_iov[UDP_RING_MAXLEN];
+	struct mmsghdr tx_msgs[UDP_RING_MAXLEN];
+	udp_cmsg_t tx_cmsgs[UDP_RING_MAXLEN];
+} udp_ring_t;
+
+/*!
+ * \brief Allocates the ring buffers.
+ *
+ * \param ring       Ring to initialize.
+ * \param slot_size  Largest accepted query or sent answer.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int udp_ring_init(udp_ring_t *ring, size_t slot_size);
+
+/*!
+ * \brief Frees the ring buffers.
+ */
+void udp_ring_deinit(udp_ring_t *ring);
+
+/*!
+ * \brief Returns the size of the allocated buffers.
+ */
+size_t udp_ring_memsize(const udp_ring_t *ring);
+
+/*!
+ * \brief Receives a batch of messages.
+ *
+ * \param ring     Ring.
+ * \param fd       Socket.
+ * \param offload  Offload features enabled on the socket.
+ *
+ * \return Number of received messages, 0 or negative if none.
+ */
+int udp_ring_recv(udp_ring_t *ring, int fd, unsigned offload);
+
+/*!
+ * \brief Gets the next query and the buffer for its answer.
+ *
+ * The queued answers are sent if no answer slot is left.
+ *
+ * \param ring   Ring.
+ * \param query  Received query.
+ * \param addr   Query source address.
+ * \param answer Answer buffer, its length to be set by the caller (0 for none).
+ *
+ * \return False if no query left.
+ */
+bool udp_ring_next(udp_ring_t *ring, struct iovec *query,
+                   struct sockaddr_storage **addr, struct iovec *answer);
+
+/*!
+ * \brief Queues the answer to the last query.
+ *
+ * \param ring  Ring.
+ * \param len   Answer length, 0 for no answer.
+ */
+void udp_ring_answer(udp_ring_t *ring, size_t len);
+
+/*!
+ * \brief Sends the queued answers.
+ *
+ * \return Number of sent messages.
+ */
+int udp_ring_flush(udp_ring_t *ring);
+
+#endif /* ENABLE_RECVMMSG */
+
+/*! @} */
@@ -14,7 +14,11 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "knot/updates/acl.h"
+#include "contrib/addrset.h"
 
 bool acl_allowed(conf_t *conf, conf_val_t *acl, acl_action_t action,
                  const struct sockaddr_storage *addr, knot_tsig_key_t *tsig)
@@ -102,3 +106,203 @@ next_acl:
 
 	return false;
 }
+
+static bool addr_match(const acl_rule_t *rule, const struct sockaddr_storage *addr)
+{
+	if (rule->addrs == NULL) {
+		return true;
+	}
+
+	return addrset_match(rule->addrs, (struct sockaddr *)addr);
+}
+
+static const acl_key_t *key_match(const acl_rule_t *rule, const knot_tsig_key_t *tsig)
+{
+	if (tsig->name == NULL) {
+		return NULL;
+	}
+
+	for (size_t i = 0; i < rule->key_count; i++) {
+		const acl_key_t *key = &rule->keys[i];
+		if (key->algorithm == tsig->algorithm &&
+		    knot_dname_cmp(key->name, tsig->name) == 0) {
+			return key;
+		}
+	}
+
+	return NULL;
+}
+
+bool acl_match(const acl_t *acl, acl_action_t action,
+               const struct sockaddr_storage *addr, knot_tsig_key_t *tsig)
+{
+	if (acl == NULL || addr == NULL || tsig == NULL) {
+		return false;
+	}
+
+	for (size_t i = 0; i < acl->count; i++) {
+		const acl_rule_t *rule = &acl->rules[i];
+
+		/* Check if the address matches the current acl address list. */
+		if (!addr_match(rule, addr)) {
+			continue;
+		}
+
+		/* Check for key match or empty list without key provided. */
+		const acl_key_t *key = key_match(rule, tsig);
+		if (key == NULL && !(rule->key_count == 0 && tsig->name == NULL)) {
+			continue;
+		}
+
+		/* Check if the action is allowed. */
+		if (action != ACL_ACTION_NONE) {
+			if (rule->actions == 0) {
+				/* Empty action list allowed with deny only. */
+				return false;
+			} else if (!(rule->actions & (1 << action))) {
+				continue;
+			}
+		}
+
+		/* Check if denied. */
+		if (rule->deny) {
+			return false;
+		}
+
+		/* Fill the output with tsig secret if provided. */
+		if (key != NULL) {
+			tsig->secret = key->secret;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+static int compile_addrs(conf_t *conf, conf_val_t *id, acl_rule_t *rule)
+{
+	conf_val_t val = conf_id_get(conf, C_ACL, C_ADDR, id);
+	if (val.code == KNOT_ENOENT) {
+		return KNOT_EOK;
+	}
+
+	rule->addrs = conf_addr_set(&val);
+	if (rule->addrs == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	return KNOT_EOK;
+}
+
+static int compile_keys(conf_t *conf, conf_val_t *id, acl_rule_t *rule)
+{
+	conf_val_t val = conf_id_get(conf, C_ACL, C_KEY, id);
+	if (val.code != KNOT_EOK) {
+		return KNOT_EOK;
+	}
+
+	rule->keys = calloc(conf_val_count(&val), sizeof(acl_key_t));
+	if (rule->keys == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	while (val.code == KNOT_EOK) {
+		acl_key_t *key = &rule->keys[rule->key_count++];
+
+		key->name = knot_dname_copy(conf_dname(&val), NULL);
+
+		conf_val_t alg_val = conf_id_get(conf, C_KEY, C_ALG, &val);
+		key->algorithm = conf_opt(&alg_val);
+
+		conf_val_t secret_val = conf_id_get(conf, C_KEY, C_SECRET, &val);
+		size_t secret_len = 0;
+		const uint8_t *secret = conf_bin(&secret_val, &secret_len);
+		key->secret.data = malloc(secret_len > 0 ? secret_len : 1);
+		if (key->name == NULL || key->secret.data == NULL) {
+			return KNOT_ENOMEM;
+		}
+		memcpy(key->secret.data, secret, secret_len);
+		key->secret.size = secret_len;
+
+		conf_val_next(&val);
+	}
+
+	return KNOT_EOK;
+}
+
+static int compile_rule(conf_t *conf, conf_val_t *id, acl_rule_t *rule)
+{
+	int ret = compile_addrs(conf, id, rule);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	ret = compile_keys(conf, id, rule);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	conf_val_t val = conf_id_get(conf, C_ACL, C_ACTION, id);
+	while (val.code == KNOT_EOK) {
+		rule->actions |= 1 << conf_opt(&val);
+		conf_val_next(&val);
+	}
+
+	val = conf_id_get(conf, C_ACL, C_DENY, id);
+	rule->deny = conf_bool(&val);
+
+	return KNOT_EOK;
+}
+
+acl_t *acl_compile(conf_t *conf, conf_val_t *acl)
+{
+	if (conf == NULL || acl == NULL) {
+		return NULL;
+	}
+
+	acl_t *out = calloc(1, sizeof(*out));
+	if (out == NULL) {
+		return NULL;
+	}
+
+	if (acl->code != KNOT_EOK) {
+		return out;
+	}
+
+	out->rules = calloc(conf_val_count(acl), sizeof(acl_rule_t));
+	if (out->rules == NULL) {
+		free(out);
+		return NULL;
+	}
+
+	while (acl->code == KNOT_EOK) {
+		int ret = compile_rule(conf, acl, &out->rules[out->count++]);
+		if (ret != KNOT_EOK) {
+			acl_free(out);
+			return NULL;
+		}
+		conf_val_next(acl);
+	}
+
+	return out;
+}
+
+void acl_free(acl_t *acl)
+{
+	if (acl == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < acl->count; i++) {
+		acl_rule_t *rule = &acl->rules[i];
+		for (size_t j = 0; j < rule->key_count; j++) {
+			knot_dname_free(&rule->keys[j].name, NULL);
+			free(rule->keys[j].secret.data);
+		}
+		free(rule->keys);
+		addrset_free(rule->addrs);
+	}
+	free(acl->rules);
+	free(acl);
+}
@@ -54,4 +54,60 @@ typedef enum {
 bool acl_allowed(conf_t *conf, conf_val_t *acl, acl_action_t action,
                  const struct sockaddr_storage *addr, knot_tsig_key_t *tsig);
 
+/*! \brief Compiled TSIG key. */
+typedef struct {
+	knot_dname_t *name;
+	dnssec_tsig_algorithm_t algorithm;
+	dnssec_binary_t secret;
+} acl_key_t;
+
+/*! \brief Compiled ACL rule. */
+typedef struct {
+	addrset_t *addrs;     /*!< Matching addresses (NULL matches any). */
+	acl_key_t *keys;      /*!< Matching keys (NULL matches no key). */
+	size_t key_count;
+	unsigned actions;     /*!< Bitmap of allowed actions. */
+	bool deny;            /*!< Deny rule. */
+} acl_rule_t;
+
+/*!
+ * \brief Compiled ACL list independent of the configuration database.
+ */
+typedef struct {
+	acl_rule_t *rules;
+	size_t count;
+} acl_t;
+
+/*!
+ * \brief Compiles ACL list from the configuration.
+ *
+ * \param conf  Configuration.
+ * \param acl   Pointer to ACL config multivalued identifier.
+ *
+ * \return Compiled ACL or NULL on error.
+ */
+acl_t *acl_compile(conf_t *conf, conf_val_t *acl);
+
+/*!
+ * \brief Checks if the address and/or tsig key matches compiled ACL list.
+ *
+ * Same semantics as \ref acl_allowed, tsig.secret points to the compiled ACL.
+ *
+ * \param acl     Compiled ACL.
+ * \param action  ACL action.
+ * \param addr    IP address.
+ * \param tsig    TSIG parameters.
+ *
+ * \retval True if authenticated.
+ */
+bool acl_match(const acl_t *acl, acl_action_t action,
+               const struct sockaddr_storage *addr, knot_tsig_key_t *tsig);
+
+/*!
+ * \brief Frees compiled ACL.
+ *
+ * \param acl  Compiled ACL.
+ */
+void acl_free(acl_t *acl);
+
 /*! @} */
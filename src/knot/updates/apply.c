@@ -18,6 +18,7 @@
 
 #include "knot/common/log.h"
 #include "knot/updates/apply.h"
+#include "knot/server/serialization.h"
 #include "libknot/libknot.h"
 #include "contrib/macros.h"
 #include "contrib/mempattern.h"
@@ -58,6 +59,18 @@ static int free_additional(zone_node_t **node, void *data)
 	return KNOT_EOK;
 }
 
+/*! \brief Frees single node of a shallow copy, normal nodes with additionals. */
+static int free_node_shallow(zone_node_t **node, void *data)
+{
+	bool *normal = data;
+	if (*normal) {
+		free_additional(node, NULL);
+	}
+	node_free(node, NULL);
+
+	return KNOT_EOK;
+}
+
 /* -------------------- Changeset application helpers ----------------------- */
 
 /*! \brief Replaces rdataset of given type with a copy. */
@@ -185,6 +198,28 @@ static int apply_add(apply_ctx_t *ctx, changeset_t *chset)
 }
 
 /*! \brief Apply single change to zone contents structure. */
+static int replace_soa(apply_ctx_t *ctx, const knot_rrset_t *soa_from,
+                       const knot_rrset_t *soa_to)
+{
+	zone_contents_t *contents = ctx->contents;
+
+	if (!knot_dname_is_equal(soa_to->owner, contents->apex->owner)) {
+		return KNOT_EDENIED;
+	}
+
+	int ret = apply_remove_rr(ctx, soa_from);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// Check for SOA with proper serial but different rdata.
+	if (node_rrtype_exists(contents->apex, KNOT_RRTYPE_SOA)) {
+		return KNOT_ESOAINVAL;
+	}
+
+	return apply_add_rr(ctx, soa_to);
+}
+
 static int apply_single(apply_ctx_t *ctx, changeset_t *chset)
 {
 	/*
@@ -364,24 +399,8 @@ int apply_remove_rr(apply_ctx_t *ctx, const knot_rrset_t *rr)
 
 int apply_replace_soa(apply_ctx_t *ctx, changeset_t *chset)
 {
-	zone_contents_t *contents = ctx->contents;
-
-	if (!knot_dname_is_equal(chset->soa_to->owner, contents->apex->owner)) {
-		return KNOT_EDENIED;
-	}
-
 	assert(chset->soa_from && chset->soa_to);
-	int ret = apply_remove_rr(ctx, chset->soa_from);
-	if (ret != KNOT_EOK) {
-		return ret;
-	}
-
-	// Check for SOA with proper serial but different rdata.
-	if (node_rrtype_exists(contents->apex, KNOT_RRTYPE_SOA)) {
-		return KNOT_ESOAINVAL;
-	}
-
-	return apply_add_rr(ctx, chset->soa_to);
+	return replace_soa(ctx, chset->soa_from, chset->soa_to);
 }
 
 int apply_prepare_to_sign(apply_ctx_t *ctx)
@@ -511,6 +530,100 @@ int apply_changeset_directly(apply_ctx_t *ctx, changeset_t *ch)
 	return KNOT_EOK;
 }
 
+/*! \brief Reads one serialized RRSet, the stream position is advanced. */
+static int read_rrset(const uint8_t **pos, size_t *remaining, knot_rrset_t *rrset,
+                      uint8_t **buf, size_t *buf_size)
+{
+	size_t before = *remaining;
+	int ret = rrset_deserialize_view(*pos, remaining, rrset, buf, buf_size);
+	if (ret != KNOT_EOK) {
+		return KNOT_EMALF;
+	}
+	*pos += before - *remaining;
+
+	return KNOT_EOK;
+}
+
+static int apply_serialized(apply_ctx_t *ctx, const uint8_t *data, size_t size,
+                            uint8_t **buf, size_t *buf_size)
+{
+	const uint8_t *pos = data;
+	size_t remaining = size;
+
+	// check if serial matches
+	knot_rrset_t rrset;
+	const uint8_t *soa_from_pos = pos;
+	int ret = read_rrset(&pos, &remaining, &rrset, buf, buf_size);
+	if (ret != KNOT_EOK || rrset.type != KNOT_RRTYPE_SOA) {
+		return KNOT_EMALF;
+	}
+	const knot_rdataset_t *soa = node_rdataset(ctx->contents->apex, KNOT_RRTYPE_SOA);
+	if (soa == NULL || knot_soa_serial(soa) != knot_soa_serial(&rrset.rrs)) {
+		return KNOT_EINVAL;
+	}
+
+	// Removals until the second SOA, additions after it.
+	const uint8_t *soa_to_pos = NULL;
+	while (remaining > 0) {
+		const uint8_t *rrset_pos = pos;
+		ret = read_rrset(&pos, &remaining, &rrset, buf, buf_size);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		if (rrset.type == KNOT_RRTYPE_SOA) {
+			if (soa_to_pos == NULL) {
+				soa_to_pos = rrset_pos;
+			}
+			continue;
+		}
+
+		if (soa_to_pos == NULL) {
+			ret = apply_remove_rr(ctx, &rrset);
+		} else {
+			ret = apply_add_rr(ctx, &rrset);
+		}
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	if (soa_to_pos == NULL) {
+		return KNOT_EMALF;
+	}
+
+	// Both SOAs are needed at once, the second one is read to a separate buffer.
+	uint8_t *soa_buf = NULL;
+	size_t soa_buf_size = 0;
+	knot_rrset_t soa_from, soa_to;
+	remaining = size - (soa_from_pos - data);
+	ret = read_rrset(&soa_from_pos, &remaining, &soa_from, buf, buf_size);
+	if (ret == KNOT_EOK) {
+		remaining = size - (soa_to_pos - data);
+		ret = read_rrset(&soa_to_pos, &remaining, &soa_to, &soa_buf, &soa_buf_size);
+	}
+	if (ret == KNOT_EOK) {
+		ret = replace_soa(ctx, &soa_from, &soa_to);
+	}
+	free(soa_buf);
+
+	return ret;
+}
+
+int apply_serialized_directly(apply_ctx_t *ctx, const uint8_t *data, size_t size)
+{
+	if (ctx == NULL || ctx->contents == NULL || data == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	uint8_t *buf = NULL;
+	size_t buf_size = 0;
+	int ret = apply_serialized(ctx, data, size, &buf, &buf_size);
+	free(buf);
+
+	return ret;
+}
+
 int apply_finalize(apply_ctx_t *ctx)
 {
 	return zone_contents_adjust_full(ctx->contents);
@@ -559,3 +672,34 @@ void update_free_zone(zone_contents_t **contents)
 	free(*contents);
 	*contents = NULL;
 }
+
+int update_free_zone_part(zone_contents_t **contents, hattrie_iter_t **it,
+                          size_t max)
+{
+	if (contents == NULL || it == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	zone_contents_t *zone = *contents;
+	if (zone == NULL) {
+		return KNOT_EOK;
+	}
+
+	/* Normal tree first, dropped once its nodes are freed. */
+	zone_tree_t **tree = (zone->nodes != NULL) ? &zone->nodes :
+	                                             &zone->nsec3_nodes;
+	bool normal = (tree == &zone->nodes);
+	int ret = zone_tree_apply_part(*tree, it, free_node_shallow, &normal, max);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	if (normal) {
+		zone_tree_free(tree);
+		return KNOT_EAGAIN;
+	}
+
+	zone_contents_free(contents);
+
+	return KNOT_EOK;
+}
@@ -138,6 +138,22 @@ int apply_changeset(apply_ctx_t *ctx, zone_t *zone, changeset_t *ch,
  */
 int apply_changesets_directly(apply_ctx_t *ctx, list_t *chsets);
 
+/*!
+ * \brief Applies changeset in the serialized (journal) form directly to the zone.
+ *
+ * The RRSets are read in place, the changeset structure isn't created.
+ *
+ * \note The zone isn't adjusted, call \ref apply_finalize after the last one.
+ * \warning Modified zone is in inconsitent state after error and should be freed.
+ *
+ * \param ctx   Apply context.
+ * \param data  Serialized changeset.
+ * \param size  Serialized changeset size.
+ *
+ * \return KNOT_E*
+ */
+int apply_serialized_directly(apply_ctx_t *ctx, const uint8_t *data, size_t size);
+
 /*!
  * \brief Applies changeset directly to the zone, without copying it.
  *
@@ -181,4 +197,18 @@ void update_rollback(apply_ctx_t *ctx);
  */
 void update_free_zone(zone_contents_t **contents);
 
+/*!
+ * \brief Shallow frees zone contents in chunks, see update_free_zone.
+ *
+ * \param contents  Contents to free, reset when completely freed.
+ * \param it        Iteration state, NULL before the first call.
+ * \param max       Maximum number of nodes freed in this call.
+ *
+ * \retval KNOT_EOK if completely freed.
+ * \retval KNOT_EAGAIN if some nodes remain.
+ * \return < KNOT_EOK on other errors (no node freed in this call).
+ */
+int update_free_zone_part(zone_contents_t **contents, hattrie_iter_t **it,
+                          size_t max);
+
 /*! @} */
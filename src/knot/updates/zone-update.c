@@ -22,8 +22,6 @@
 #include "contrib/ucw/lists.h"
 #include "contrib/ucw/mempool.h"
 
-#include <urcu.h>
-
 static int init_incremental(zone_update_t *update, zone_t *zone)
 {
 	if (zone->contents == NULL) {
@@ -410,13 +408,16 @@ static int sign_update(zone_update_t *update,
 	const bool full_sign = changeset_empty(&update->change) ||
 	                       apex_dnssec_changed(update);
 	if (full_sign) {
-		ret = knot_dnssec_zone_sign(new_contents, &sec_ch,
+		ret = knot_dnssec_zone_sign(new_contents,
+		                            update->zone->dnssec_cache, &sec_ch,
 		                            ZONE_SIGN_KEEP_SOA_SERIAL,
 		                            &refresh_at);
 	} else {
 		/* Sign the created changeset */
-		ret = knot_dnssec_sign_changeset(new_contents, &update->change,
-		                                 &sec_ch, &refresh_at);
+		ret = knot_dnssec_sign_changeset(new_contents,
+		                                 update->zone->dnssec_cache,
+		                                 &update->change, &sec_ch,
+		                                 &refresh_at);
 	}
 	if (ret != KNOT_EOK) {
 		changeset_clear(&sec_ch);
@@ -612,12 +613,11 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 	zone_contents_t *old_contents = zone_switch_contents(update->zone,
 	                                                     new_contents);
 
-	/* Sync RCU. */
-	synchronize_rcu();
+	/* Readers are synchronized by the deferred reclamation. */
 	if (update->flags & UPDATE_FULL) {
-		zone_contents_deep_free(&old_contents);
+		zone_contents_retire(update->zone, &old_contents, NULL);
 	} else if (update->flags & UPDATE_INCREMENTAL) {
-		update_free_zone(&old_contents);
+		zone_contents_retire(update->zone, &old_contents, &update->a_ctx);
 		changeset_clear(&update->change);
 	}
 	update_cleanup(&update->a_ctx);
@@ -1138,6 +1138,37 @@ void zone_contents_deep_free(zone_contents_t **contents)
 	zone_contents_free(contents);
 }
 
+int zone_contents_deep_free_part(zone_contents_t **contents, hattrie_iter_t **it,
+                                 size_t max)
+{
+	if (contents == NULL || it == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	zone_contents_t *zone = *contents;
+	if (zone == NULL) {
+		return KNOT_EOK;
+	}
+
+	/* NSEC3 tree first, dropped once its nodes are freed. */
+	zone_tree_t **tree = (zone->nsec3_nodes != NULL) ? &zone->nsec3_nodes :
+	                                                   &zone->nodes;
+	int ret = zone_tree_apply_part(*tree, it, destroy_node_rrsets_from_tree,
+	                               NULL, max);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	if (tree == &zone->nsec3_nodes) {
+		zone_tree_free(tree);
+		return KNOT_EAGAIN;
+	}
+
+	zone_contents_free(contents);
+
+	return KNOT_EOK;
+}
+
 uint32_t zone_contents_serial(const zone_contents_t *zone)
 {
 	if (zone == NULL) {
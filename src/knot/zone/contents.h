@@ -243,6 +243,20 @@ void zone_contents_free(zone_contents_t **contents);
  */
 void zone_contents_deep_free(zone_contents_t **contents);
 
+/*!
+ * \brief Deep free of zone contents in chunks, see zone_contents_deep_free.
+ *
+ * \param contents  Zone contents to free, reset when completely freed.
+ * \param it        Iteration state, NULL before the first call.
+ * \param max       Maximum number of nodes freed in this call.
+ *
+ * \retval KNOT_EOK if completely freed.
+ * \retval KNOT_EAGAIN if some nodes remain.
+ * \return < KNOT_EOK on other errors (no node freed in this call).
+ */
+int zone_contents_deep_free_part(zone_contents_t **contents, hattrie_iter_t **it,
+                                 size_t max);
+
 /*!
  * \brief Fetch zone serial.
  *
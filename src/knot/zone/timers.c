@@ -14,8 +14,14 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
+#include <sys/time.h>
+#include <urcu.h>
+
 #include "libknot/libknot.h"
+#include "knot/common/log.h"
 #include "knot/zone/timers.h"
+#include "contrib/mempattern.h"
 #include "contrib/wire.h"
 #include "contrib/wire_ctx.h"
 
@@ -55,22 +61,24 @@ static bool event_persistent(size_t event)
 	return event_id_to_key[event] != 0;
 }
 
+bool timer_db_persistent(zone_event_type_t event)
+{
+	return event > ZONE_EVENT_INVALID && event < ZONE_EVENT_COUNT &&
+	       event_persistent(event);
+}
+
 /*! \brief Clear array of timers. */
 static void clear_timers(time_t *timers)
 {
 	memset(timers, 0, ZONE_EVENT_COUNT * sizeof(time_t));
 }
 
-/*! \brief Stores timers for persistent events. */
-static int store_timers(zone_t *zone, knot_db_txn_t *txn)
-{
-	// Create key
-	knot_db_val_t key = { .len = knot_dname_size(zone->name), .data = zone->name };
-
-	// Create value
-	uint8_t packed_timer[EVENT_KEY_PAIR_SIZE * PERSISTENT_EVENT_COUNT];
+#define PACKED_TIMERS_SIZE (EVENT_KEY_PAIR_SIZE * PERSISTENT_EVENT_COUNT)
 
-	wire_ctx_t w = wire_ctx_init(packed_timer, sizeof(packed_timer));
+/*! \brief Serializes timers for persistent events. */
+static int pack_timers(const time_t *timers, bool expired, uint8_t *packed)
+{
+	wire_ctx_t w = wire_ctx_init(packed, PACKED_TIMERS_SIZE);
 
 	for (zone_event_type_t event = 0; event < ZONE_EVENT_COUNT; ++event) {
 		if (!event_persistent(event)) {
@@ -81,8 +89,8 @@ static int store_timers(zone_t *zone, knot_db_txn_t *txn)
 		wire_ctx_write_u8(&w, event_id_to_key[event]);
 
 		// Value
-		time_t value = zone_events_get_time(zone, event);
-		if (event == ZONE_EVENT_EXPIRE && zone->flags & ZONE_EXPIRED) {
+		time_t value = timers[event];
+		if (event == ZONE_EVENT_EXPIRE && expired) {
 			/*
 			 * WORKAROUND. The current timer database contains
 			 * time stamps for running timers. The expiration
@@ -94,8 +102,44 @@ static int store_timers(zone_t *zone, knot_db_txn_t *txn)
 		wire_ctx_write_u64(&w, value);
 	}
 
-	if (w.error != KNOT_EOK) {
-		return w.error;
+	return w.error;
+}
+
+/*! \brief Deserializes timers for persistent events. */
+static void unpack_timers(const knot_db_val_t *val, time_t *timers)
+{
+	clear_timers(timers);
+
+	const size_t stored_event_count = val->len / EVENT_KEY_PAIR_SIZE;
+	size_t offset = 0;
+	for (size_t i = 0; i < stored_event_count; ++i) {
+		const uint8_t db_key = ((uint8_t *)val->data)[offset];
+		offset += 1;
+		if (known_event_key(db_key)) {
+			const zone_event_type_t event = key_to_event_id[db_key];
+			timers[event] =
+				(time_t)wire_read_u64((uint8_t *)val->data + offset);
+		}
+		offset += sizeof(uint64_t);
+	}
+}
+
+/*! \brief Stores timers for persistent events. */
+static int store_timers(zone_t *zone, knot_db_txn_t *txn)
+{
+	// Create key
+	knot_db_val_t key = { .len = knot_dname_size(zone->name), .data = zone->name };
+
+	// Create value
+	time_t timers[ZONE_EVENT_COUNT];
+	for (zone_event_type_t event = 0; event < ZONE_EVENT_COUNT; ++event) {
+		timers[event] = zone_events_get_time(zone, event);
+	}
+
+	uint8_t packed_timer[PACKED_TIMERS_SIZE];
+	int ret = pack_timers(timers, zone->flags & ZONE_EXPIRED, packed_timer);
+	if (ret != KNOT_EOK) {
+		return ret;
 	}
 
 	knot_db_val_t val = { .len = sizeof(packed_timer), .data = packed_timer };
@@ -123,18 +167,7 @@ static int read_timers(knot_db_txn_t *txn, const zone_t *zone, time_t *timers)
 		return KNOT_EOK;
 	}
 
-	const size_t stored_event_count = val.len / EVENT_KEY_PAIR_SIZE;
-	size_t offset = 0;
-	for (size_t i = 0; i < stored_event_count; ++i) {
-		const uint8_t db_key = ((uint8_t *)val.data)[offset];
-		offset += 1;
-		if (known_event_key(db_key)) {
-			const zone_event_type_t event = key_to_event_id[db_key];
-			timers[event] =
-				(time_t)wire_read_u64((uint8_t *)val.data + offset);
-		}
-		offset += sizeof(uint64_t);
-	}
+	unpack_timers(&val, timers);
 
 	return KNOT_EOK;
 }
@@ -302,3 +335,424 @@ int sweep_timer_db(knot_db_t *timer_db, knot_zonedb_t *zone_db)
 
 	return db_api->txn_commit(&txn);
 }
+
+int read_timer_db(knot_db_t *timer_db, knot_mm_t *mm, hattrie_t **timers)
+{
+	if (mm == NULL || timers == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	*timers = hattrie_create(mm);
+	if (*timers == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	if (timer_db == NULL) {
+		return KNOT_EOK;
+	}
+
+	const knot_db_api_t *db_api = knot_db_lmdb_api();
+	assert(db_api);
+
+	knot_db_txn_t txn;
+	int ret = db_api->txn_begin(timer_db, &txn, KNOT_DB_RDONLY);
+	if (ret != KNOT_EOK) {
+		hattrie_free(*timers);
+		*timers = NULL;
+		return ret;
+	}
+
+	if (db_api->count(&txn) <= 0) {
+		db_api->txn_abort(&txn);
+		return KNOT_EOK;
+	}
+
+	// One cursor scan over all records.
+	knot_db_iter_t *it = db_api->iter_begin(&txn, 0);
+	while (it != NULL) {
+		knot_db_val_t key, val;
+		ret = db_api->iter_key(it, &key);
+		if (ret == KNOT_EOK) {
+			ret = db_api->iter_val(it, &val);
+		}
+		if (ret != KNOT_EOK) {
+			break;
+		}
+
+		time_t *zone_timers = mm_alloc(mm, ZONE_EVENT_COUNT * sizeof(time_t));
+		value_t *slot = hattrie_get(*timers, key.data, key.len);
+		if (zone_timers == NULL || slot == NULL) {
+			ret = KNOT_ENOMEM;
+			break;
+		}
+		unpack_timers(&val, zone_timers);
+		*slot = zone_timers;
+
+		it = db_api->iter_next(it);
+	}
+	db_api->iter_finish(it);
+	db_api->txn_abort(&txn);
+
+	if (ret != KNOT_EOK) {
+		hattrie_free(*timers);
+		*timers = NULL;
+	}
+
+	return ret;
+}
+
+const time_t *timer_db_find(hattrie_t *timers, const knot_dname_t *zone_name)
+{
+	if (timers == NULL || zone_name == NULL) {
+		return NULL;
+	}
+
+	value_t *slot = hattrie_tryget(timers, (const char *)zone_name,
+	                               knot_dname_size(zone_name));
+
+	return (slot != NULL) ? *slot : NULL;
+}
+
+/*! \brief Pending timers of a subset of zones. */
+typedef struct {
+	pthread_mutex_t lock;
+	hattrie_t *pending;  /*!< Zone name -> packed timers. */
+} writer_shard_t;
+
+struct timers_writer {
+	pthread_mutex_t db_lock;  /*!< Serializes database commits. */
+	knot_db_t *timer_db;
+	pthread_mutex_t lock;     /*!< Commit thread state lock. */
+	pthread_cond_t wake;      /*!< Signalled on the thread stop request. */
+	pthread_t thread;         /*!< Periodic commit thread. */
+	bool running;
+	bool stop;
+	writer_shard_t shards[TIMERS_WRITER_SHARDS];
+};
+
+static writer_shard_t *get_shard(timers_writer_t *writer, const knot_dname_t *name)
+{
+	// FNV-1a, zone names are spread evenly across the shards.
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0, len = knot_dname_size(name); i < len; i++) {
+		hash = (hash ^ name[i]) * 16777619u;
+	}
+
+	return &writer->shards[hash % TIMERS_WRITER_SHARDS];
+}
+
+static void free_pending(hattrie_t *pending)
+{
+	hattrie_iter_t *it = hattrie_iter_begin(pending);
+	for (; !hattrie_iter_finished(it); hattrie_iter_next(it)) {
+		free(*hattrie_iter_val(it));
+	}
+	hattrie_iter_free(it);
+	hattrie_free(pending);
+}
+
+/*!
+ * \brief Periodic commits of the pending timers.
+ *
+ * The database commit and its disk synchronization don't delay the events
+ * of the shared scheduler.
+ */
+static void *writer_run(void *data)
+{
+	timers_writer_t *writer = data;
+
+	rcu_register_thread();
+
+	pthread_mutex_lock(&writer->lock);
+	while (!writer->stop) {
+		struct timeval now;
+		gettimeofday(&now, NULL);
+		uint64_t usec = now.tv_usec + TIMERS_WRITER_INTERVAL * 1000ULL;
+		struct timespec ts = {
+			.tv_sec = now.tv_sec + usec / 1000000,
+			.tv_nsec = (usec % 1000000) * 1000
+		};
+		while (!writer->stop &&
+		       pthread_cond_timedwait(&writer->wake, &writer->lock, &ts) == 0);
+		if (writer->stop) {
+			break;
+		}
+		pthread_mutex_unlock(&writer->lock);
+
+		int ret = timers_writer_flush(writer);
+		if (ret != KNOT_EOK) {
+			log_error("failed to update zone timers database (%s)",
+			          knot_strerror(ret));
+		}
+
+		pthread_mutex_lock(&writer->lock);
+	}
+	pthread_mutex_unlock(&writer->lock);
+
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+timers_writer_t *timers_writer_create(knot_db_t *timer_db, bool periodic)
+{
+	timers_writer_t *writer = calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&writer->db_lock, NULL);
+	pthread_mutex_init(&writer->lock, NULL);
+	pthread_cond_init(&writer->wake, NULL);
+	writer->timer_db = timer_db;
+
+	// All locks initialized before any cleanup on failure.
+	for (unsigned i = 0; i < TIMERS_WRITER_SHARDS; i++) {
+		pthread_mutex_init(&writer->shards[i].lock, NULL);
+	}
+
+	for (unsigned i = 0; i < TIMERS_WRITER_SHARDS; i++) {
+		writer->shards[i].pending = hattrie_create(NULL);
+		if (writer->shards[i].pending == NULL) {
+			timers_writer_free(writer);
+			return NULL;
+		}
+	}
+
+	if (periodic) {
+		if (pthread_create(&writer->thread, NULL, writer_run, writer) != 0) {
+			timers_writer_free(writer);
+			return NULL;
+		}
+		writer->running = true;
+	}
+
+	return writer;
+}
+
+void timers_writer_set_db(timers_writer_t *writer, knot_db_t *timer_db)
+{
+	if (writer == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&writer->db_lock);
+	writer->timer_db = timer_db;
+	pthread_mutex_unlock(&writer->db_lock);
+}
+
+int timers_writer_stage(timers_writer_t *writer, const knot_dname_t *zone_name,
+                        const time_t *timers, bool expired)
+{
+	if (writer == NULL) {
+		return KNOT_EOK;
+	}
+
+	if (zone_name == NULL || timers == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	uint8_t packed[PACKED_TIMERS_SIZE];
+	int ret = pack_timers(timers, expired, packed);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	writer_shard_t *shard = get_shard(writer, zone_name);
+
+	pthread_mutex_lock(&shard->lock);
+	value_t *slot = hattrie_get(shard->pending, (const char *)zone_name,
+	                            knot_dname_size(zone_name));
+	if (slot != NULL && *slot == NULL) {
+		*slot = malloc(PACKED_TIMERS_SIZE);
+	}
+	if (slot == NULL || *slot == NULL) {
+		pthread_mutex_unlock(&shard->lock);
+		return KNOT_ENOMEM;
+	}
+	memcpy(*slot, packed, PACKED_TIMERS_SIZE);
+	pthread_mutex_unlock(&shard->lock);
+
+	return KNOT_EOK;
+}
+
+void timers_writer_sweep(timers_writer_t *writer, knot_zonedb_t *zone_db)
+{
+	if (writer == NULL || zone_db == NULL) {
+		return;
+	}
+
+	for (unsigned i = 0; i < TIMERS_WRITER_SHARDS; i++) {
+		writer_shard_t *shard = &writer->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		hattrie_t *kept = hattrie_create(NULL);
+		if (kept == NULL) {
+			pthread_mutex_unlock(&shard->lock);
+			continue;
+		}
+
+		// Move timers of existing zones, the trie can't shrink while iterated.
+		hattrie_iter_t *it = hattrie_iter_begin(shard->pending);
+		for (; !hattrie_iter_finished(it); hattrie_iter_next(it)) {
+			size_t len = 0;
+			const char *key = hattrie_iter_key(it, &len);
+			value_t *val = hattrie_iter_val(it);
+			if (!knot_zonedb_find(zone_db, (const knot_dname_t *)key)) {
+				continue;
+			}
+			value_t *slot = hattrie_get(kept, key, len);
+			if (slot != NULL) {
+				*slot = *val;
+				*val = NULL;
+			}
+		}
+		hattrie_iter_free(it);
+
+		free_pending(shard->pending);
+		shard->pending = kept;
+		pthread_mutex_unlock(&shard->lock);
+	}
+}
+
+/*! \brief Return not written timers unless newer ones were staged meanwhile. */
+static void requeue_pending(writer_shard_t *shard, hattrie_t *pending)
+{
+	pthread_mutex_lock(&shard->lock);
+	hattrie_iter_t *it = hattrie_iter_begin(pending);
+	for (; !hattrie_iter_finished(it); hattrie_iter_next(it)) {
+		size_t len = 0;
+		const char *key = hattrie_iter_key(it, &len);
+		value_t *val = hattrie_iter_val(it);
+		value_t *slot = hattrie_get(shard->pending, key, len);
+		if (slot != NULL && *slot == NULL) {
+			*slot = *val;
+			*val = NULL;
+		}
+	}
+	hattrie_iter_free(it);
+	pthread_mutex_unlock(&shard->lock);
+
+	free_pending(pending);
+}
+
+int timers_writer_flush(timers_writer_t *writer)
+{
+	if (writer == NULL) {
+		return KNOT_EOK;
+	}
+
+	const knot_db_api_t *db_api = knot_db_lmdb_api();
+	assert(db_api);
+
+	pthread_mutex_lock(&writer->db_lock);
+
+	// Keep pending timers until a database is available.
+	if (writer->timer_db == NULL) {
+		pthread_mutex_unlock(&writer->db_lock);
+		return KNOT_EOK;
+	}
+
+	knot_db_txn_t txn;
+	bool open = false;
+	int ret = KNOT_EOK;
+	hattrie_t *detached[TIMERS_WRITER_SHARDS] = { NULL };
+
+	// Detach pending timers shard by shard, writers are blocked briefly.
+	for (unsigned i = 0; i < TIMERS_WRITER_SHARDS; i++) {
+		writer_shard_t *shard = &writer->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		if (hattrie_weight(shard->pending) == 0) {
+			pthread_mutex_unlock(&shard->lock);
+			continue;
+		}
+		hattrie_t *empty = hattrie_create(NULL);
+		if (empty == NULL) {
+			pthread_mutex_unlock(&shard->lock);
+			ret = KNOT_ENOMEM;
+			break;
+		}
+		detached[i] = shard->pending;
+		shard->pending = empty;
+		pthread_mutex_unlock(&shard->lock);
+
+		if (!open) {
+			ret = db_api->txn_begin(writer->timer_db, &txn, KNOT_DB_SORTED);
+			if (ret != KNOT_EOK) {
+				break;
+			}
+			open = true;
+		}
+
+		hattrie_iter_t *it = hattrie_iter_begin(detached[i]);
+		for (; !hattrie_iter_finished(it); hattrie_iter_next(it)) {
+			size_t len = 0;
+			knot_db_val_t key = { .data = (void *)hattrie_iter_key(it, &len) };
+			key.len = len;
+			knot_db_val_t val = { .len = PACKED_TIMERS_SIZE,
+			                      .data = *hattrie_iter_val(it) };
+			ret = db_api->insert(&txn, &key, &val, 0);
+			if (ret != KNOT_EOK) {
+				break;
+			}
+		}
+		hattrie_iter_free(it);
+
+		if (ret != KNOT_EOK) {
+			break;
+		}
+	}
+
+	// One commit for all zones changed within the interval.
+	if (open) {
+		if (ret == KNOT_EOK) {
+			ret = db_api->txn_commit(&txn);
+		} else {
+			db_api->txn_abort(&txn);
+		}
+	}
+
+	// Retry the failed timers with the next commit.
+	for (unsigned i = 0; i < TIMERS_WRITER_SHARDS; i++) {
+		if (detached[i] == NULL) {
+			continue;
+		}
+		if (ret == KNOT_EOK) {
+			free_pending(detached[i]);
+		} else {
+			requeue_pending(&writer->shards[i], detached[i]);
+		}
+	}
+
+	pthread_mutex_unlock(&writer->db_lock);
+
+	return ret;
+}
+
+void timers_writer_free(timers_writer_t *writer)
+{
+	if (writer == NULL) {
+		return;
+	}
+
+	if (writer->running) {
+		pthread_mutex_lock(&writer->lock);
+		writer->stop = true;
+		pthread_cond_signal(&writer->wake);
+		pthread_mutex_unlock(&writer->lock);
+		pthread_join(writer->thread, NULL);
+	}
+
+	for (unsigned i = 0; i < TIMERS_WRITER_SHARDS; i++) {
+		if (writer->shards[i].pending != NULL) {
+			free_pending(writer->shards[i].pending);
+		}
+		pthread_mutex_destroy(&writer->shards[i].lock);
+	}
+	pthread_mutex_destroy(&writer->db_lock);
+	pthread_cond_destroy(&writer->wake);
+	pthread_mutex_destroy(&writer->lock);
+
+	free(writer);
+}
@@ -16,9 +16,28 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <time.h>
+
 #include "libknot/db/db.h"
+#include "libknot/mm_ctx.h"
 #include "knot/zone/zone.h"
 #include "knot/zone/zonedb.h"
+#include "contrib/hat-trie/hat-trie.h"
+
+/*! \brief Number of independently locked sets of pending timers. */
+#define TIMERS_WRITER_SHARDS	16
+/*! \brief Interval of pending timers commits (milliseconds). */
+#define TIMERS_WRITER_INTERVAL	1000
+
+/*!
+ * \brief Checks if the zone event timer is stored in timers db.
+ *
+ * \param event  Zone event type.
+ *
+ * \return True if the event timer is persistent.
+ */
+bool timer_db_persistent(zone_event_type_t event);
 
 /*!
  * \brief Opens zone timers db.
@@ -82,3 +101,91 @@ int remove_timer_db(knot_db_t *timer_db, knot_zonedb_t *zone_db,
  * \return KNOT_EOK or an error
  */
 int sweep_timer_db(knot_db_t *timer_db, knot_zonedb_t *zone_db);
+
+/*!
+ * \brief Reads timers of all zones from timers db with one cursor scan.
+ *
+ * \param[in]  timer_db  Timer database (can be NULL).
+ * \param[in]  mm        Memory context for the output.
+ * \param[out] timers    Zone name to timers array (size ZONE_EVENT_COUNT).
+ *
+ * \return KNOT_E*
+ */
+int read_timer_db(knot_db_t *timer_db, knot_mm_t *mm, hattrie_t **timers);
+
+/*!
+ * \brief Finds zone timers read by \ref read_timer_db.
+ *
+ * \param timers     Timers of all zones.
+ * \param zone_name  Zone name.
+ *
+ * \return Timers array or NULL if not stored.
+ */
+const time_t *timer_db_find(hattrie_t *timers, const knot_dname_t *zone_name);
+
+/*!
+ * \brief Incremental timers db writer.
+ *
+ * Changed zone timers are collected in sharded pending sets and written
+ * periodically in a single transaction.
+ */
+typedef struct timers_writer timers_writer_t;
+
+/*!
+ * \brief Creates incremental timers db writer.
+ *
+ * \param timer_db  Timer database (can be NULL).
+ * \param periodic  Commit periodically in a separate thread.
+ *
+ * \return Writer or NULL on error.
+ */
+timers_writer_t *timers_writer_create(knot_db_t *timer_db, bool periodic);
+
+/*!
+ * \brief Changes the timer database of the writer.
+ *
+ * \note Pending timers should be flushed before.
+ *
+ * \param writer    Timers writer.
+ * \param timer_db  New timer database (can be NULL).
+ */
+void timers_writer_set_db(timers_writer_t *writer, knot_db_t *timer_db);
+
+/*!
+ * \brief Stages changed zone timers for the next commit.
+ *
+ * \param writer     Timers writer (can be NULL).
+ * \param zone_name  Zone name.
+ * \param timers     Zone timers (size ZONE_EVENT_COUNT).
+ * \param expired    Zone is expired.
+ *
+ * \return KNOT_E*
+ */
+int timers_writer_stage(timers_writer_t *writer, const knot_dname_t *zone_name,
+                        const time_t *timers, bool expired);
+
+/*!
+ * \brief Drops pending timers of zones removed from the zone database.
+ *
+ * \note The removed zones must not stage timers anymore.
+ *
+ * \param writer   Timers writer (can be NULL).
+ * \param zone_db  Current zone database.
+ */
+void timers_writer_sweep(timers_writer_t *writer, knot_zonedb_t *zone_db);
+
+/*!
+ * \brief Writes all pending timers in one transaction.
+ *
+ * \param writer  Timers writer.
+ *
+ * \return KNOT_E*
+ */
+int timers_writer_flush(timers_writer_t *writer);
+
+/*!
+ * \brief Frees the writer, pending timers are dropped.
+ *
+ * \param writer  Timers writer.
+ */
+void timers_writer_free(timers_writer_t *writer);
@@ -15,17 +15,16 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include "libknot/libknot.h"
+#include "knot/server/dthreads.h"
 #include "knot/zone/zone-diff.h"
 #include "knot/zone/serial.h"
-
-struct zone_diff_param {
-	zone_tree_t *nodes;
-	changeset_t *changeset;
-};
+#include "contrib/macros.h"
 
 static int load_soas(const zone_contents_t *zone1, const zone_contents_t *zone2,
                      changeset_t *changeset)
@@ -192,87 +191,63 @@ static int diff_rrsets(const knot_rrset_t *rrset1, const knot_rrset_t *rrset2,
 	return KNOT_EOK;
 }
 
-/*!< \todo this could be generic function for adding / removing. */
-static int knot_zone_diff_node(zone_node_t **node_ptr, void *data)
-{
-	if (node_ptr == NULL || *node_ptr == NULL || data == NULL) {
-		return KNOT_EINVAL;
-	}
-
-	zone_node_t *node = *node_ptr;
-
-	struct zone_diff_param *param = (struct zone_diff_param *)data;
-	if (param->changeset == NULL) {
-		return KNOT_EINVAL;
-	}
+/*! \brief Minimal number of nodes diffed by one thread. */
+#define DIFF_SHARD_MIN	65536
 
-	/*
-	 * First, we have to search the second tree to see if there's according
-	 * node, if not, the whole node has been removed.
-	 */
-	zone_node_t *node_in_second_tree = NULL;
-	const knot_dname_t *node_owner = node->owner;
-	assert(node_owner);
-
-	zone_tree_get(param->nodes, node_owner, &node_in_second_tree);
-
-	if (node_in_second_tree == NULL) {
-		return remove_node(node, param->changeset);
-	}
-
-	assert(node_in_second_tree != node);
+/*! \brief Diff of nodes with the same owner in both trees. */
+static int diff_nodes(const zone_node_t *node1, const zone_node_t *node2,
+                      changeset_t *changeset)
+{
+	assert(node1 != node2);
 
 	/* The nodes are in both trees, we have to diff each RRSet. */
-	if (node->rrset_count == 0) {
+	if (node1->rrset_count == 0) {
 		/*
 		 * If there are no RRs in the first tree, all of the RRs
 		 * in the second tree will have to be inserted to ADD section.
 		 */
-		return add_node(node_in_second_tree, param->changeset);
+		return add_node(node2, changeset);
 	}
 
-	for (unsigned i = 0; i < node->rrset_count; i++) {
+	for (unsigned i = 0; i < node1->rrset_count; i++) {
 		/* Search for the RRSet in the node from the second tree. */
-		knot_rrset_t rrset = node_rrset_at(node, i);
+		knot_rrset_t rrset = node_rrset_at(node1, i);
 
 		/* SOAs are handled explicitly. */
 		if (rrset.type == KNOT_RRTYPE_SOA) {
 			continue;
 		}
 
-		knot_rrset_t rrset_from_second_node =
-			node_rrset(node_in_second_tree, rrset.type);
+		knot_rrset_t rrset_from_second_node = node_rrset(node2, rrset.type);
 		if (knot_rrset_empty(&rrset_from_second_node)) {
 			/* RRSet has been removed. Make a copy and remove. */
-			int ret = changeset_add_removal(
-				param->changeset, &rrset, 0);
+			int ret = changeset_add_removal(changeset, &rrset, 0);
 			if (ret != KNOT_EOK) {
 				return ret;
 			}
 		} else {
 			/* Diff RRSets. */
 			int ret = diff_rrsets(&rrset, &rrset_from_second_node,
-			                      param->changeset);
+			                      changeset);
 			if (ret != KNOT_EOK) {
 				return ret;
 			}
 		}
 	}
 
-	for (unsigned i = 0; i < node_in_second_tree->rrset_count; i++) {
-		/* Search for the RRSet in the node from the second tree. */
-		knot_rrset_t rrset = node_rrset_at(node_in_second_tree, i);
+	for (unsigned i = 0; i < node2->rrset_count; i++) {
+		/* Search for the RRSet in the node from the first tree. */
+		knot_rrset_t rrset = node_rrset_at(node2, i);
 
 		/* SOAs are handled explicitly. */
 		if (rrset.type == KNOT_RRTYPE_SOA) {
 			continue;
 		}
 
-		knot_rrset_t rrset_from_first_node = node_rrset(node, rrset.type);
+		knot_rrset_t rrset_from_first_node = node_rrset(node1, rrset.type);
 		if (knot_rrset_empty(&rrset_from_first_node)) {
 			/* RRSet has been added. Make a copy and add. */
-			int ret = changeset_add_addition(
-				param->changeset, &rrset, 0);
+			int ret = changeset_add_addition(changeset, &rrset, 0);
 			if (ret != KNOT_EOK) {
 				return ret;
 			}
@@ -282,43 +257,297 @@ static int knot_zone_diff_node(zone_node_t **node_ptr, void *data)
 	return KNOT_EOK;
 }
 
-/*!< \todo possibly not needed! */
-static int add_new_nodes(zone_node_t **node_ptr, void *data)
+/*! \brief Check if the nodes have the same RRSets including TTLs. */
+static bool nodes_equal(const zone_node_t *node1, const zone_node_t *node2)
 {
-	if (node_ptr == NULL || *node_ptr == NULL || data == NULL) {
-		return KNOT_EINVAL;
+	if (node1->rrset_count != node2->rrset_count) {
+		return false;
 	}
 
-	zone_node_t *node = *node_ptr;
+	for (unsigned i = 0; i < node1->rrset_count; i++) {
+		const struct rr_data *data = &node1->rrs[i];
+		const knot_rdataset_t *rrs2 = node_rdataset(node2, data->type);
+		if (rrs2 == NULL || !knot_rdataset_eq(&data->rrs, rrs2)) {
+			return false;
+		}
 
-	struct zone_diff_param *param = (struct zone_diff_param *)data;
-	if (param->changeset == NULL) {
-		return KNOT_EINVAL;
+		for (uint16_t j = 0; j < rrs2->rr_count; j++) {
+			if (knot_rdata_ttl(knot_rdataset_at(&data->rrs, j)) !=
+			    knot_rdata_ttl(knot_rdataset_at(rrs2, j))) {
+				return false;
+			}
+		}
 	}
 
-	/*
-	* If a node is not present in the second zone, it is a new node
-	* and has to be added to changeset. Differencies on the RRSet level are
-	* already handled.
-	*/
+	return true;
+}
 
-	const knot_dname_t *node_owner = node->owner;
-	/*
-	 * Node should definitely have an owner, otherwise it would not be in
-	 * the tree.
-	 */
-	assert(node_owner);
+/*! \brief Add differences of the nodes (one of them can be NULL). */
+static int diff_pair(const zone_node_t *node1, const zone_node_t *node2,
+                     changeset_t *changeset)
+{
+	if (node2 == NULL) {
+		return remove_node(node1, changeset);
+	} else if (node1 == NULL) {
+		return add_node(node2, changeset);
+	} else {
+		return diff_nodes(node1, node2, changeset);
+	}
+}
+
+/*! \brief Zone tree node with its lookup key. */
+typedef struct {
+	const char *key;
+	size_t len;
+	const zone_node_t *node;
+} diff_item_t;
+
+/*! \brief Ordered sequence of zone tree nodes, either a tree or an array. */
+typedef struct {
+	hattrie_iter_t *it;
+	const diff_item_t *items;
+	size_t pos;
+	size_t end;
+} diff_cursor_t;
+
+static bool cursor_get(diff_cursor_t *c, diff_item_t *item)
+{
+	if (c->it != NULL) {
+		if (hattrie_iter_finished(c->it)) {
+			return false;
+		}
+		item->key = hattrie_iter_key(c->it, &item->len);
+		item->node = *hattrie_iter_val(c->it);
+		return true;
+	}
 
-	zone_node_t *new_node = NULL;
-	zone_tree_get(param->nodes, node_owner, &new_node);
+	if (c->pos >= c->end) {
+		return false;
+	}
+	*item = c->items[c->pos];
+	return true;
+}
+
+static void cursor_next(diff_cursor_t *c)
+{
+	if (c->it != NULL) {
+		hattrie_iter_next(c->it);
+	} else {
+		c->pos++;
+	}
+}
+
+/*! \brief Compare lookup keys in the zone tree order. */
+static int key_cmp(const diff_item_t *item1, const diff_item_t *item2)
+{
+	int cmp = memcmp(item1->key, item2->key, MIN(item1->len, item2->len));
+	if (cmp == 0 && item1->len != item2->len) {
+		cmp = (item1->len < item2->len) ? -1 : 1;
+	}
+	return cmp;
+}
+
+typedef int (*diff_pair_cb_t)(const zone_node_t *node1, const zone_node_t *node2,
+                              void *ctx);
+
+/*!
+ * \brief Merge-join of two ordered node sequences.
+ *
+ * The callback is called for each owner with differing nodes.
+ */
+static int merge_join(diff_cursor_t *c1, diff_cursor_t *c2, diff_pair_cb_t cb,
+                      void *ctx)
+{
+	diff_item_t item1, item2;
+	bool have1 = cursor_get(c1, &item1);
+	bool have2 = cursor_get(c2, &item2);
+
+	while (have1 || have2) {
+		int cmp = !have1 ? 1 : (!have2 ? -1 : key_cmp(&item1, &item2));
+
+		int ret = KNOT_EOK;
+		if (cmp < 0) {
+			ret = cb(item1.node, NULL, ctx);
+		} else if (cmp > 0) {
+			ret = cb(NULL, item2.node, ctx);
+		} else if (!nodes_equal(item1.node, item2.node)) {
+			ret = cb(item1.node, item2.node, ctx);
+		}
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		if (cmp <= 0) {
+			cursor_next(c1);
+			have1 = cursor_get(c1, &item1);
+		}
+		if (cmp >= 0) {
+			cursor_next(c2);
+			have2 = cursor_get(c2, &item2);
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static int changeset_pair(const zone_node_t *node1, const zone_node_t *node2,
+                          void *ctx)
+{
+	return diff_pair(node1, node2, ctx);
+}
+
+/*! \brief Differing nodes found by one shard. */
+typedef struct {
+	pthread_t thread;
+	diff_cursor_t c1;
+	diff_cursor_t c2;
+	const zone_node_t **pairs;
+	size_t count;
+	size_t size;
+	int ret;
+} diff_shard_t;
+
+static int shard_pair(const zone_node_t *node1, const zone_node_t *node2,
+                      void *ctx)
+{
+	diff_shard_t *shard = ctx;
+
+	if (shard->count + 2 > shard->size) {
+		size_t size = MAX(2 * shard->size, 64);
+		const zone_node_t **pairs = realloc(shard->pairs, size * sizeof(*pairs));
+		if (pairs == NULL) {
+			return KNOT_ENOMEM;
+		}
+		shard->pairs = pairs;
+		shard->size = size;
+	}
+
+	shard->pairs[shard->count++] = node1;
+	shard->pairs[shard->count++] = node2;
+
+	return KNOT_EOK;
+}
+
+static void *shard_run(void *data)
+{
+	diff_shard_t *shard = data;
+	shard->ret = merge_join(&shard->c1, &shard->c2, shard_pair, shard);
+	return NULL;
+}
+
+static diff_item_t *tree_items(zone_tree_t *tree, size_t *count)
+{
+	*count = zone_tree_count(tree);
+	diff_item_t *items = malloc(MAX(*count, 1) * sizeof(*items));
+	if (items == NULL || *count == 0) {
+		return items;
+	}
+
+	diff_cursor_t c = { .it = hattrie_iter_begin(tree) };
+	if (c.it == NULL) {
+		free(items);
+		return NULL;
+	}
+
+	size_t i = 0;
+	while (i < *count && cursor_get(&c, &items[i])) {
+		cursor_next(&c);
+		i++;
+	}
+	hattrie_iter_free(c.it);
+	*count = i;
+
+	return items;
+}
+
+/*! \brief Position of the first item not less than the given one. */
+static size_t lower_bound(const diff_item_t *items, size_t count,
+                          const diff_item_t *item)
+{
+	size_t from = 0, to = count;
+	while (from < to) {
+		size_t mid = from + (to - from) / 2;
+		if (key_cmp(&items[mid], item) < 0) {
+			from = mid + 1;
+		} else {
+			to = mid;
+		}
+	}
+
+	return from;
+}
+
+/*!
+ * \brief Diff the trees by parallel merge-joins over disjoint key ranges.
+ *
+ * Shards only search for differing nodes, the changeset is built from
+ * their results in the tree order.
+ */
+static int diff_sharded(zone_tree_t *nodes1, zone_tree_t *nodes2,
+                        changeset_t *changeset, size_t shards)
+{
+	size_t count1, count2;
+	diff_item_t *items1 = tree_items(nodes1, &count1);
+	diff_item_t *items2 = tree_items(nodes2, &count2);
+	diff_shard_t *shard = calloc(shards, sizeof(*shard));
+	if (items1 == NULL || items2 == NULL || shard == NULL) {
+		free(items1);
+		free(items2);
+		free(shard);
+		return KNOT_ENOMEM;
+	}
+
+	/* Split the larger sequence evenly, the other at the same keys. */
+	bool first = (count1 >= count2);
+	const diff_item_t *split = first ? items1 : items2;
+	size_t split_count = first ? count1 : count2;
+
+	size_t from1 = 0, from2 = 0;
+	for (size_t i = 0; i < shards; i++) {
+		size_t to1 = count1, to2 = count2;
+		if (i < shards - 1) {
+			const diff_item_t *bound = &split[split_count * (i + 1) / shards];
+			to1 = lower_bound(items1, count1, bound);
+			to2 = lower_bound(items2, count2, bound);
+		}
+		shard[i].c1 = (diff_cursor_t) { .items = items1, .pos = from1, .end = to1 };
+		shard[i].c2 = (diff_cursor_t) { .items = items2, .pos = from2, .end = to2 };
+		from1 = to1;
+		from2 = to2;
+	}
+
+	bool started[shards];
+	for (size_t i = 0; i < shards; i++) {
+		started[i] = (pthread_create(&shard[i].thread, NULL, shard_run,
+		                             &shard[i]) == 0);
+		if (!started[i]) {
+			shard_run(&shard[i]);
+		}
+	}
 
 	int ret = KNOT_EOK;
+	for (size_t i = 0; i < shards; i++) {
+		if (started[i]) {
+			pthread_join(shard[i].thread, NULL);
+		}
+		if (ret == KNOT_EOK) {
+			ret = shard[i].ret;
+		}
+	}
 
-	if (!new_node) {
-		assert(node);
-		ret = add_node(node, param->changeset);
+	/* Build the changeset in the tree order. */
+	for (size_t i = 0; i < shards; i++) {
+		for (size_t j = 0; ret == KNOT_EOK && j < shard[i].count; j += 2) {
+			ret = diff_pair(shard[i].pairs[j], shard[i].pairs[j + 1],
+			                changeset);
+		}
+		free(shard[i].pairs);
 	}
 
+	free(shard);
+	free(items1);
+	free(items2);
+
 	return ret;
 }
 
@@ -327,20 +556,33 @@ static int load_trees(zone_tree_t *nodes1, zone_tree_t *nodes2,
 {
 	assert(changeset);
 
-	struct zone_diff_param param = {
-		.changeset = changeset
-	};
+	if (zone_tree_is_empty(nodes1) && zone_tree_is_empty(nodes2)) {
+		return KNOT_EOK;
+	}
+
+	size_t count = MAX(zone_tree_count(nodes1), zone_tree_count(nodes2));
+	size_t shards = MIN(dt_optimal_size(), count / DIFF_SHARD_MIN);
+	if (shards > 1) {
+		return diff_sharded(nodes1, nodes2, changeset, shards);
+	}
 
-	// Traverse one tree, compare every node, each RRSet with its rdata.
-	param.nodes = nodes2;
-	int ret = zone_tree_apply(nodes1, knot_zone_diff_node, &param);
-	if (ret != KNOT_EOK) {
-		return ret;
+	/* Stream both trees in order. */
+	diff_cursor_t c1 = { 0 }, c2 = { 0 };
+	if (!zone_tree_is_empty(nodes1)) {
+		c1.it = hattrie_iter_begin(nodes1);
+	}
+	if (!zone_tree_is_empty(nodes2)) {
+		c2.it = hattrie_iter_begin(nodes2);
+	}
+
+	int ret = KNOT_ENOMEM;
+	if ((c1.it != NULL || zone_tree_is_empty(nodes1)) &&
+	    (c2.it != NULL || zone_tree_is_empty(nodes2))) {
+		ret = merge_join(&c1, &c2, changeset_pair, changeset);
 	}
 
-	// Some nodes may have been added. Add missing nodes to changeset.
-	param.nodes = nodes1;
-	ret = zone_tree_apply(nodes2, add_new_nodes, &param);
+	hattrie_iter_free(c1.it);
+	hattrie_iter_free(c2.it);
 
 	return ret;
 }
@@ -15,19 +15,23 @@
  */
 
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "knot/dnssec/zone-nsec.h"
 #include "knot/zone/zone-dump.h"
 #include "libknot/libknot.h"
 
-/*! \brief Size of auxiliary buffer. */
-#define DUMP_BUF_LEN (70 * 1024)
+/*! \brief Size of the output buffer, text is written to the file in chunks of it. */
+#define DUMP_BUF_LEN (1024 * 1024)
 
 /*! \brief Dump parameters. */
 typedef struct {
 	FILE     *file;
 	char     *buf;
 	size_t   buflen;
+	size_t   used;
 	uint64_t rr_count;
 	bool     dump_rrsig;
 	bool     dump_nsec;
@@ -36,21 +40,73 @@ typedef struct {
 	const char *first_comment;
 } dump_params_t;
 
+static int buf_flush(dump_params_t *params)
+{
+	if (params->used > 0 &&
+	    fwrite(params->buf, params->used, 1, params->file) != 1) {
+		return KNOT_EFEWDATA;
+	}
+
+	params->used = 0;
+
+	return KNOT_EOK;
+}
+
+static int buf_puts(dump_params_t *params, const char *str)
+{
+	size_t len = strlen(str);
+	if (params->used + len >= params->buflen) {
+		int ret = buf_flush(params);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		if (len >= params->buflen) {
+			return KNOT_ESPACE;
+		}
+	}
+
+	memcpy(params->buf + params->used, str, len);
+	params->used += len;
+
+	return KNOT_EOK;
+}
+
+static int rrset_dump_text(const knot_rrset_t *rrset, dump_params_t *params)
+{
+	for (uint16_t i = 0; i < rrset->rrs.rr_count; i++) {
+		int ret = knot_rrset_txt_dump_rr(rrset, i, params->buf + params->used,
+		                                 params->buflen - params->used,
+		                                 params->style);
+		if (ret == KNOT_ESPACE && params->used > 0) {
+			// Write out the buffer and retry with the whole space.
+			ret = buf_flush(params);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
+			ret = knot_rrset_txt_dump_rr(rrset, i, params->buf,
+			                             params->buflen, params->style);
+		}
+		if (ret < 0) {
+			return ret;
+		}
+		params->used += ret;
+	}
+
+	params->rr_count += rrset->rrs.rr_count;
+
+	return KNOT_EOK;
+}
+
 static int apex_node_dump_text(zone_node_t *node, dump_params_t *params)
 {
 	knot_rrset_t soa = node_rrset(node, KNOT_RRTYPE_SOA);
-	knot_dump_style_t soa_style = *params->style;
 
 	// Dump SOA record as a first.
 	if (!params->dump_nsec) {
-		int ret = knot_rrset_txt_dump(&soa, &params->buf, &params->buflen,
-		                              &soa_style);
-		if (ret < 0) {
+		int ret = rrset_dump_text(&soa, params);
+		if (ret != KNOT_EOK) {
 			return ret;
 		}
-		params->rr_count += soa.rrs.rr_count;
-		fprintf(params->file, "%s", params->buf);
-		params->buf[0] = '\0';
 	}
 
 	// Dump other records.
@@ -67,14 +123,10 @@ static int apex_node_dump_text(zone_node_t *node, dump_params_t *params)
 			break;
 		}
 
-		int ret = knot_rrset_txt_dump(&rrset, &params->buf, &params->buflen,
-		                              params->style);
-		if (ret < 0) {
+		int ret = rrset_dump_text(&rrset, params);
+		if (ret != KNOT_EOK) {
 			return ret;
 		}
-		params->rr_count +=  rrset.rrs.rr_count;
-		fprintf(params->file, "%s", params->buf);
-		params->buf[0] = '\0';
 	}
 
 	return KNOT_EOK;
@@ -87,8 +139,7 @@ static int node_dump_text(zone_node_t *node, void *data)
 	// Zone apex rrsets.
 	if (node->owner == params->origin && !params->dump_rrsig &&
 	    !params->dump_nsec) {
-		apex_node_dump_text(node, params);
-		return KNOT_EOK;
+		return apex_node_dump_text(node, params);
 	}
 
 	// Dump non-apex rrsets.
@@ -119,45 +170,83 @@ static int node_dump_text(zone_node_t *node, void *data)
 
 		// Dump block comment if available.
 		if (params->first_comment != NULL) {
-			fprintf(params->file, "%s", params->first_comment);
+			int ret = buf_puts(params, params->first_comment);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
 			params->first_comment = NULL;
 		}
 
-		int ret = knot_rrset_txt_dump(&rrset, &params->buf, &params->buflen,
-		                              params->style);
-		if (ret < 0) {
+		int ret = rrset_dump_text(&rrset, params);
+		if (ret != KNOT_EOK) {
 			return ret;
 		}
-		params->rr_count += rrset.rrs.rr_count;
-		fprintf(params->file, "%s", params->buf);
-		params->buf[0] = '\0';
 	}
 
 	return KNOT_EOK;
 }
 
+static int dump_sections(zone_contents_t *zone, dump_params_t *params,
+                         bool comments)
+{
+	// Dump standard zone records without RRSIGS.
+	int ret = zone_contents_apply(zone, node_dump_text, params);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// Dump RRSIG records if available.
+	params->dump_rrsig = true;
+	params->dump_nsec = false;
+	params->first_comment = comments ? ";; DNSSEC signatures\n" : NULL;
+	ret = zone_contents_apply(zone, node_dump_text, params);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// Dump NSEC chain if available.
+	params->dump_rrsig = false;
+	params->dump_nsec = true;
+	params->first_comment = comments ? ";; DNSSEC NSEC chain\n" : NULL;
+	ret = zone_contents_apply(zone, node_dump_text, params);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// Dump NSEC3 chain if available.
+	params->dump_rrsig = false;
+	params->dump_nsec = true;
+	params->first_comment = comments ? ";; DNSSEC NSEC3 chain\n" : NULL;
+	ret = zone_contents_nsec3_apply(zone, node_dump_text, params);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	params->dump_rrsig = true;
+	params->dump_nsec = false;
+	params->first_comment = comments ? ";; DNSSEC NSEC3 signatures\n" : NULL;
+	return zone_contents_nsec3_apply(zone, node_dump_text, params);
+}
+
 int zone_dump_text(zone_contents_t *zone, FILE *file, bool comments)
 {
 	if (zone == NULL || file == NULL) {
 		return KNOT_EINVAL;
 	}
 
-	// Allocate auxiliary buffer for dumping operations.
+	// Allocate the output buffer, records are formatted directly into it.
 	char *buf = malloc(DUMP_BUF_LEN);
 	if (buf == NULL) {
 		return KNOT_ENOMEM;
 	}
 
-	if (comments) {
-		fprintf(file, ";; Zone dump (Knot DNS %s)\n", PACKAGE_VERSION);
-	}
-
 	// Set structure with parameters.
 	zone_node_t *apex = zone->apex;
 	dump_params_t params = {
 		.file = file,
 		.buf = buf,
 		.buflen = DUMP_BUF_LEN,
+		.used = 0,
 		.rr_count = 0,
 		.origin = apex->owner,
 		.style = &KNOT_DUMP_STYLE_DEFAULT,
@@ -165,48 +254,19 @@ int zone_dump_text(zone_contents_t *zone, FILE *file, bool comments)
 		.dump_nsec = false
 	};
 
-	// Dump standard zone records without RRSIGS.
-	int ret = zone_contents_apply(zone, node_dump_text, &params);
-	if (ret != KNOT_EOK) {
-		return ret;
-	}
-
-	// Dump RRSIG records if available.
-	params.dump_rrsig = true;
-	params.dump_nsec = false;
-	params.first_comment = comments ? ";; DNSSEC signatures\n" : NULL;
-	ret = zone_contents_apply(zone, node_dump_text, &params);
-	if (ret != KNOT_EOK) {
-		return ret;
-	}
-
-	// Dump NSEC chain if available.
-	params.dump_rrsig = false;
-	params.dump_nsec = true;
-	params.first_comment = comments ? ";; DNSSEC NSEC chain\n" : NULL;
-	ret = zone_contents_apply(zone, node_dump_text, &params);
-	if (ret != KNOT_EOK) {
-		return ret;
-	}
-
-	// Dump NSEC3 chain if available.
-	params.dump_rrsig = false;
-	params.dump_nsec = true;
-	params.first_comment = comments ? ";; DNSSEC NSEC3 chain\n" : NULL;
-	ret = zone_contents_nsec3_apply(zone, node_dump_text, &params);
-	if (ret != KNOT_EOK) {
-		return ret;
+	int ret = KNOT_EOK;
+	if (comments) {
+		char header[64];
+		(void)snprintf(header, sizeof(header), ";; Zone dump (Knot DNS %s)\n",
+		               PACKAGE_VERSION);
+		ret = buf_puts(&params, header);
 	}
 
-	params.dump_rrsig = true;
-	params.dump_nsec = false;
-	params.first_comment = comments ? ";; DNSSEC NSEC3 signatures\n" : NULL;
-	ret = zone_contents_nsec3_apply(zone, node_dump_text, &params);
-	if (ret != KNOT_EOK) {
-		return ret;
+	if (ret == KNOT_EOK) {
+		ret = dump_sections(zone, &params, comments);
 	}
 
-	if (comments) {
+	if (ret == KNOT_EOK && comments) {
 		// Create formatted date-time string.
 		time_t now = time(NULL);
 		struct tm tm;
@@ -215,12 +275,19 @@ int zone_dump_text(zone_contents_t *zone, FILE *file, bool comments)
 		strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S %Z", &tm);
 
 		// Dump trailing statistics.
-		fprintf(file, ";; Written %"PRIu64" records\n"
-		              ";; Time %s\n",
-	        	params.rr_count, date);
+		char trailer[160];
+		(void)snprintf(trailer, sizeof(trailer),
+		               ";; Written %"PRIu64" records\n"
+		               ";; Time %s\n",
+		               params.rr_count, date);
+		ret = buf_puts(&params, trailer);
 	}
 
-	free(params.buf); // params.buf may be != buf because of knot_rrset_txt_dump_dynamic()
+	if (ret == KNOT_EOK) {
+		ret = buf_flush(&params);
+	}
 
-	return KNOT_EOK;
+	free(buf);
+
+	return ret;
 }
@@ -90,6 +90,11 @@ int zone_load_check(conf_t *conf, zone_contents_t *contents)
 	return KNOT_EOK;
 }
 
+static int apply_journal_entry(const uint8_t *data, size_t size, void *ctx)
+{
+	return apply_serialized_directly(ctx, data, size);
+}
+
 int zone_load_journal(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 {
 	if (conf == NULL || zone == NULL || contents == NULL) {
@@ -107,31 +112,26 @@ int zone_load_journal(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 	/* Fetch SOA serial. */
 	uint32_t serial = zone_contents_serial(contents);
 
-	/*! \todo Check what should be the upper bound. */
-	list_t chgs;
-	init_list(&chgs);
+	/* Apply changesets in place from the journal. */
+	apply_ctx_t a_ctx = { 0 };
+	apply_init_ctx(&a_ctx, contents, 0);
 
+	/*! \todo Check what should be the upper bound. */
 	pthread_mutex_lock(&zone->journal_lock);
-	int ret = journal_load_changesets(journal_name, zone->name, &chgs, serial,
-	                                  serial - 1);
+	int ret = journal_read_changesets(journal_name, serial, serial - 1,
+	                                  apply_journal_entry, &a_ctx);
 	pthread_mutex_unlock(&zone->journal_lock);
 	free(journal_name);
 
-	if ((ret != KNOT_EOK && ret != KNOT_ERANGE) || EMPTY_LIST(chgs)) {
-		changesets_free(&chgs);
-		/* Absence of records is not an error. */
-		if (ret == KNOT_ENOENT) {
-			return KNOT_EOK;
-		} else {
-			return ret;
-		}
+	/* Absence of records is not an error. */
+	if (ret == KNOT_ENOENT) {
+		update_cleanup(&a_ctx);
+		return KNOT_EOK;
 	}
 
-	/* Apply changesets. */
-	apply_ctx_t a_ctx = { 0 };
-	apply_init_ctx(&a_ctx, contents, 0);
-
-	ret = apply_changesets_directly(&a_ctx, &chgs);
+	if (ret == KNOT_EOK || ret == KNOT_ERANGE) {
+		ret = apply_finalize(&a_ctx);
+	}
 	if (ret == KNOT_EOK) {
 		log_zone_info(zone->name, "changes from journal applied %u -> %u",
 		              serial, zone_contents_serial(contents));
@@ -142,7 +142,6 @@ int zone_load_journal(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 	}
 
 	update_cleanup(&a_ctx);
-	changesets_free(&chgs);
 
 	return ret;
 }
@@ -166,7 +165,8 @@ int zone_load_post(conf_t *conf, zone_t *zone, zone_contents_t *contents,
 	val = conf_zone_get(conf, C_IXFR_DIFF, zone->name);
 	bool build_diffs = conf_bool(&val);
 	if (dnssec_enable) {
-		ret = knot_dnssec_zone_sign(contents, &change, 0, dnssec_refresh);
+		ret = knot_dnssec_zone_sign(contents, zone->dnssec_cache, &change,
+		                            0, dnssec_refresh);
 		if (ret != KNOT_EOK) {
 			changeset_clear(&change);
 			return ret;
@@ -204,6 +204,47 @@ int zone_tree_apply(zone_tree_t *tree, zone_tree_apply_cb_t function, void *data
 	return hattrie_apply_rev(tree, (int (*)(value_t *, void *))function, data);
 }
 
+int zone_tree_apply_part(zone_tree_t *tree, hattrie_iter_t **it,
+                         zone_tree_apply_cb_t function, void *data, size_t max)
+{
+	if (it == NULL || function == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (zone_tree_is_empty(tree)) {
+		return KNOT_EOK;
+	}
+
+	if (*it == NULL) {
+		*it = hattrie_iter_begin(tree);
+		if (*it == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	for (size_t i = 0; i < max; i++) {
+		if (hattrie_iter_finished(*it)) {
+			hattrie_iter_free(*it);
+			*it = NULL;
+			return KNOT_EOK;
+		}
+
+		int ret = function((zone_node_t **)hattrie_iter_val(*it), data);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		hattrie_iter_next(*it);
+	}
+
+	if (hattrie_iter_finished(*it)) {
+		hattrie_iter_free(*it);
+		*it = NULL;
+		return KNOT_EOK;
+	}
+
+	return KNOT_EAGAIN;
+}
+
 void zone_tree_free(zone_tree_t **tree)
 {
 	if (tree == NULL || *tree == NULL) {
@@ -141,6 +141,26 @@ int zone_tree_delete_empty_node(zone_tree_t *tree, zone_node_t *node);
  */
 int zone_tree_apply(zone_tree_t *tree, zone_tree_apply_cb_t function, void *data);
 
+/*!
+ * \brief Applies the given function to a limited number of nodes.
+ *
+ * Each call continues where the previous one stopped. The tree mustn't be
+ * modified in between, the function may free the nodes though.
+ *
+ * \param tree      Zone tree to apply the function to.
+ * \param it        Iteration state, NULL before the first call. It's freed
+ *                  and reset when all nodes have been processed.
+ * \param function  Function to be applied to the nodes.
+ * \param data      Arbitrary data to be passed to the function.
+ * \param max       Maximum number of nodes processed in this call.
+ *
+ * \retval KNOT_EOK if all nodes have been processed.
+ * \retval KNOT_EAGAIN if some nodes remain.
+ * \return < KNOT_EOK on other errors.
+ */
+int zone_tree_apply_part(zone_tree_t *tree, hattrie_iter_t **it,
+                         zone_tree_apply_cb_t function, void *data, size_t max);
+
 /*!
  * \brief Destroys the zone tree, not touching the saved data.
  *
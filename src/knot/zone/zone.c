@@ -14,14 +14,21 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <urcu.h>
 
 #include "knot/common/log.h"
+#include "knot/dnssec/key-cache.h"
 #include "knot/nameserver/process_query.h"
 #include "knot/query/requestor.h"
+#include "knot/server/ddns-batch.h"
+#include "knot/server/journal-sync.h"
+#include "knot/server/reclaim.h"
 #include "knot/updates/zone-update.h"
 #include "knot/zone/contents.h"
 #include "knot/zone/serial.h"
@@ -35,6 +42,127 @@
 
 #define JOURNAL_SUFFIX	".diff.db"
 
+/*! \brief Deferred zone contents reclamation. */
+typedef struct {
+	node_t n;
+	zone_contents_t *contents;
+	apply_ctx_t ctx;
+	bool incremental;
+	hattrie_iter_t *it;     /*!< Progress of the chunked reclamation. */
+} retired_t;
+
+/*! \brief Background flush job. */
+typedef struct {
+	task_t task;
+	zone_t *zone;
+	zone_contents_t *contents;
+	char *zonefile;
+	char *journal_file;
+	unsigned generation;
+	unsigned epoch;
+} flush_job_t;
+
+static void retired_free(zone_contents_t *contents, apply_ctx_t *ctx)
+{
+	if (ctx == NULL) {
+		zone_contents_deep_free(&contents);
+	} else {
+		update_free_zone(&contents);
+		update_cleanup(ctx);
+	}
+}
+
+static retired_t *retired_create(zone_contents_t *contents, apply_ctx_t *ctx)
+{
+	retired_t *item = malloc(sizeof(*item));
+	if (item == NULL) {
+		return NULL;
+	}
+
+	item->contents = contents;
+	item->incremental = (ctx != NULL);
+	item->it = NULL;
+	apply_init_ctx(&item->ctx, NULL, 0);
+	if (ctx != NULL && !EMPTY_LIST(ctx->old_data)) {
+		add_tail_list(&item->ctx.old_data, &ctx->old_data);
+		init_list(&ctx->old_data);
+	}
+
+	return item;
+}
+
+/*! \brief Reclamation callback, frees at most RECLAIM_CHUNK nodes a call. */
+static bool retired_reclaim(void *data)
+{
+	retired_t *item = data;
+
+	int ret = item->incremental ?
+	          update_free_zone_part(&item->contents, &item->it, RECLAIM_CHUNK) :
+	          zone_contents_deep_free_part(&item->contents, &item->it, RECLAIM_CHUNK);
+	if (ret == KNOT_EAGAIN) {
+		return false;
+	}
+
+	/* Chunking failed, free the rest at once. */
+	if (ret != KNOT_EOK) {
+		hattrie_iter_free(item->it);
+		retired_free(item->contents, item->incremental ? &item->ctx : NULL);
+	} else {
+		update_cleanup(&item->ctx);
+	}
+	free(item);
+
+	return true;
+}
+
+/*! \brief Check if some contents are read outside RCU (flush lock). */
+static bool contents_pinned(const zone_t *zone)
+{
+	return zone->flush.snapshot != NULL || zone->flush.pins > 0;
+}
+
+/*!
+ * \brief Drop a pin and run the deferred reclamations if no pin is left.
+ *
+ * \param zone   Zone.
+ * \param flush  Drop the flush snapshot instead of a reader pin.
+ */
+static void contents_unpin(zone_t *zone, bool flush)
+{
+	list_t retired;
+	init_list(&retired);
+
+	pthread_mutex_lock(&zone->flush.lock);
+	if (flush) {
+		zone->flush.snapshot = NULL;
+	} else {
+		assert(zone->flush.pins > 0);
+		zone->flush.pins--;
+	}
+
+	if (!contents_pinned(zone) && !EMPTY_LIST(zone->flush.retired)) {
+		add_tail_list(&retired, &zone->flush.retired);
+		init_list(&zone->flush.retired);
+	}
+
+	/* Hand over to the reclamation thread while the zone exists. */
+	retired_t *item = NULL, *next = NULL;
+	if (zone->reclaim != NULL) {
+		WALK_LIST_DELSAFE(item, next, retired) {
+			reclaim_defer(zone->reclaim, retired_reclaim, item);
+		}
+		init_list(&retired);
+	}
+
+	pthread_cond_broadcast(&zone->flush.done);
+	pthread_mutex_unlock(&zone->flush.lock);
+
+	/* The zone may be already freed here. */
+	WALK_LIST_DELSAFE(item, next, retired) {
+		reclaim_defer(NULL, retired_reclaim, item);
+	}
+}
+
 static void free_ddns_queue(zone_t *z)
 {
 	ptrnode_t *node = NULL, *nxt = NULL;
@@ -66,15 +194,23 @@ zone_t* zone_new(const knot_dname_t *name)
 	// Journal lock
 	pthread_mutex_init(&zone->journal_lock, NULL);
 
+	// Control update lock
+	pthread_mutex_init(&zone->control_lock, NULL);
+
+	// Background flush
+	pthread_mutex_init(&zone->flush.lock, NULL);
+	pthread_cond_init(&zone->flush.done, NULL);
+	init_list(&zone->flush.retired);
+
 	// Preferred master lock
 	pthread_mutex_init(&zone->preferred_lock, NULL);
 
+	// DNSSEC cache (signing works without it)
+	zone->dnssec_cache = kdnssec_cache_new();
+
 	// Initialize events
 	zone_events_init(zone);
 
-	// Initialize query modules list.
-	init_list(&zone->query_modules);
-
 	return zone;
 }
 
@@ -97,13 +233,24 @@ void zone_free(zone_t **zone_ptr)
 
 	zone_t *zone = *zone_ptr;
 
+	/* Wait for the background flush and the pinned readers. */
+	pthread_mutex_lock(&zone->flush.lock);
+	while (contents_pinned(zone)) {
+		pthread_cond_wait(&zone->flush.done, &zone->flush.lock);
+	}
+	pthread_mutex_unlock(&zone->flush.lock);
+	pthread_cond_destroy(&zone->flush.done);
+	pthread_mutex_destroy(&zone->flush.lock);
+
 	zone_events_deinit(zone);
 
 	knot_dname_free(&zone->name, NULL);
 
 	free_ddns_queue(zone);
 	pthread_mutex_destroy(&zone->ddns_lock);
+	journal_close(zone->journal);
 	pthread_mutex_destroy(&zone->journal_lock);
+	pthread_mutex_destroy(&zone->control_lock);
 
 	/* Control update. */
 	zone_control_clear(zone);
@@ -112,36 +259,84 @@ void zone_free(zone_t **zone_ptr)
 	pthread_mutex_destroy(&zone->preferred_lock);
 	free(zone->preferred_master);
 
-	/* Free zone contents. */
-	zone_contents_deep_free(&zone->contents);
+	kdnssec_cache_free(zone->dnssec_cache);
 
-	conf_deactivate_modules(&zone->query_modules, &zone->query_plan);
+	/* Free zone contents, in the background if possible. */
+	retired_t *item = NULL;
+	if (zone->reclaim != NULL && zone->contents != NULL) {
+		item = retired_create(zone->contents, NULL);
+	}
+	if (item != NULL) {
+		reclaim_defer(zone->reclaim, retired_reclaim, item);
+		zone->contents = NULL;
+	} else {
+		zone_contents_deep_free(&zone->contents);
+	}
+
+	if (zone->query_modules != NULL) {
+		ref_release(&zone->query_modules->ref);
+	}
+
+	zone_conf_cache_free(zone->conf_cache);
 
 	free(zone);
 	*zone_ptr = NULL;
 }
 
-int zone_change_store(conf_t *conf, zone_t *zone, changeset_t *change)
+/*! \brief Close the kept journal, it's reopened by the next store (journal lock). */
+static void journal_drop(zone_t *zone)
 {
-	if (conf == NULL || zone == NULL || change == NULL) {
-		return KNOT_EINVAL;
+	journal_close(zone->journal);
+	zone->journal = NULL;
+}
+
+static int journal_write(journal_t *journal, changeset_t *change, list_t *chgs)
+{
+	if (change != NULL) {
+		return journal_write_changeset(journal, change);
+	} else {
+		return journal_write_changesets(journal, chgs);
 	}
+}
 
+/*! \brief Store a changeset or a list of changesets in the zone journal. */
+static int journal_store(conf_t *conf, zone_t *zone, changeset_t *change,
+                         list_t *chgs)
+{
 	conf_val_t val = conf_zone_get(conf, C_MAX_JOURNAL_SIZE, zone->name);
 	int64_t ixfr_fslimit = conf_int(&val);
 	char *journal_file = conf_journalfile(conf, zone->name);
+	if (journal_file == NULL) {
+		return KNOT_ENOMEM;
+	}
 
 	pthread_mutex_lock(&zone->journal_lock);
-	int ret = journal_store_changeset(change, journal_file, ixfr_fslimit);
+	int ret = journal_reopen(&zone->journal, journal_file, ixfr_fslimit);
+	if (ret == KNOT_EOK) {
+		ret = journal_write(zone->journal, change, chgs);
+	}
 	if (ret == KNOT_EBUSY) {
 		log_zone_notice(zone->name, "journal is full, flushing");
 
 		/* Transaction rolled back, journal released, we may flush. */
+		journal_drop(zone);
 		ret = zone_flush_journal(conf, zone);
 		if (ret == KNOT_EOK) {
-			ret = journal_store_changeset(change, journal_file, ixfr_fslimit);
+			ret = journal_reopen(&zone->journal, journal_file, ixfr_fslimit);
+		}
+		if (ret == KNOT_EOK) {
+			ret = journal_write(zone->journal, change, chgs);
 		}
 	}
+
+	/* Keep the journal open for the next store, reread it after a failure. */
+	if (ret == KNOT_EOK) {
+		journal_unlock(zone->journal);
+		(void)journal_sync_submit(zone->journal_sync, journal_file,
+		                          zone->journal->fd, NULL, NULL);
+	} else {
+		journal_drop(zone);
+	}
 	pthread_mutex_unlock(&zone->journal_lock);
 
 	free(journal_file);
@@ -149,28 +344,39 @@ int zone_change_store(conf_t *conf, zone_t *zone, changeset_t *change)
 	return ret;
 }
 
+int zone_change_store(conf_t *conf, zone_t *zone, changeset_t *change)
+{
+	if (conf == NULL || zone == NULL || change == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	return journal_store(conf, zone, change, NULL);
+}
+
 int zone_changes_store(conf_t *conf, zone_t *zone, list_t *chgs)
 {
 	if (conf == NULL || zone == NULL || chgs == NULL) {
 		return KNOT_EINVAL;
 	}
 
-	conf_val_t val = conf_zone_get(conf, C_MAX_JOURNAL_SIZE, zone->name);
-	int64_t ixfr_fslimit = conf_int(&val);
-	char *journal_file = conf_journalfile(conf, zone->name);
-
-	pthread_mutex_lock(&zone->journal_lock);
-	int ret = journal_store_changesets(chgs, journal_file, ixfr_fslimit);
-	if (ret == KNOT_EBUSY) {
-		log_zone_notice(zone->name, "journal is full, flushing");
+	return journal_store(conf, zone, NULL, chgs);
+}
 
-		/* Transaction rolled back, journal released, we may flush. */
-		ret = zone_flush_journal(conf, zone);
-		if (ret == KNOT_EOK) {
-			ret = journal_store_changesets(chgs, journal_file, ixfr_fslimit);
-		}
+int zone_journal_sync(conf_t *conf, zone_t *zone, journal_sync_cb_t cb, void *ctx)
+{
+	if (conf == NULL || zone == NULL || cb == NULL) {
+		return KNOT_EINVAL;
+	}
 
+	char *journal_file = conf_journalfile(conf, zone->name);
+	if (journal_file == NULL) {
+		return KNOT_ENOMEM;
 	}
+
+	/* The journal is reopened by the path if it was dropped meanwhile. */
+	pthread_mutex_lock(&zone->journal_lock);
+	int fd = (zone->journal != NULL) ? zone->journal->fd : -1;
+	int ret = journal_sync_submit(zone->journal_sync, journal_file, fd, cb, ctx);
 	pthread_mutex_unlock(&zone->journal_lock);
 
 	free(journal_file);
@@ -191,6 +397,198 @@ zone_contents_t *zone_switch_contents(zone_t *zone, zone_contents_t *new_content
 	return old_contents;
 }
 
+void zone_contents_retire(zone_t *zone, zone_contents_t **contents,
+                          apply_ctx_t *ctx)
+{
+	if (zone == NULL || contents == NULL) {
+		return;
+	}
+
+	if (*contents == NULL) {
+		update_cleanup(ctx);
+		return;
+	}
+
+	retired_t *item = retired_create(*contents, ctx);
+	if (item == NULL) {
+		synchronize_rcu();
+	}
+
+	pthread_mutex_lock(&zone->flush.lock);
+
+	/*
+	 * Defer behind the flush and the pinned readers, the retired contents
+	 * may share data with the read ones. Only if out of memory, wait for
+	 * them to finish.
+	 */
+	if (item != NULL && contents_pinned(zone)) {
+		add_tail(&zone->flush.retired, &item->n);
+		item = NULL;
+		*contents = NULL;
+	}
+	while (*contents != NULL && item == NULL && contents_pinned(zone)) {
+		pthread_cond_wait(&zone->flush.done, &zone->flush.lock);
+	}
+
+	pthread_mutex_unlock(&zone->flush.lock);
+
+	if (item != NULL) {
+		reclaim_defer(zone->reclaim, retired_reclaim, item);
+	} else if (*contents != NULL) {
+		retired_free(*contents, ctx);
+	}
+	update_cleanup(ctx);
+	*contents = NULL;
+}
+
+zone_contents_t *zone_contents_pin(zone_t *zone)
+{
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	/* Retirement of the read contents is deferred under the same lock. */
+	rcu_read_lock();
+	pthread_mutex_lock(&zone->flush.lock);
+	zone_contents_t *contents = rcu_dereference(zone->contents);
+	if (contents != NULL) {
+		zone->flush.pins++;
+	}
+	pthread_mutex_unlock(&zone->flush.lock);
+	rcu_read_unlock();
+
+	return contents;
+}
+
+void zone_contents_unpin(zone_t *zone)
+{
+	if (zone == NULL) {
+		return;
+	}
+
+	contents_unpin(zone, false);
+}
+
+static void zone_modules_free(ref_t *ref)
+{
+	zone_modules_t *modules = (zone_modules_t *)ref;
+
+	conf_deactivate_modules(&modules->list, &modules->plan);
+	free(modules);
+}
+
+zone_modules_t *zone_modules_create(conf_t *conf, const knot_dname_t *name)
+{
+	if (conf == NULL || name == NULL) {
+		return NULL;
+	}
+
+	zone_modules_t *modules = calloc(1, sizeof(*modules));
+	if (modules == NULL) {
+		return NULL;
+	}
+
+	ref_init(&modules->ref, zone_modules_free);
+	init_list(&modules->list);
+
+	conf_activate_modules(conf, name, &modules->list, &modules->plan);
+	if (modules->plan == NULL) {
+		free(modules);
+		return NULL;
+	}
+
+	return modules;
+}
+
+void zone_modules_set(zone_t *zone, zone_modules_t *modules)
+{
+	if (zone == NULL || modules == NULL) {
+		return;
+	}
+
+	assert(zone->query_modules == NULL);
+
+	ref_retain(&modules->ref);
+	zone->query_modules = modules;
+	zone->query_plan = modules->plan;
+}
+
+zone_conf_cache_t *zone_conf_cache_create(conf_t *conf, const knot_dname_t *name)
+{
+	if (conf == NULL || name == NULL) {
+		return NULL;
+	}
+
+	zone_conf_cache_t *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	conf_val_t val = conf_zone_get(conf, C_ACL, name);
+	cache->acl = acl_compile(conf, &val);
+	if (cache->acl == NULL) {
+		free(cache);
+		return NULL;
+	}
+
+	val = conf_zone_get(conf, C_DISABLE_ANY, name);
+	cache->disable_any = conf_bool(&val);
+
+	val = conf_zone_get(conf, C_MAX_ZONE_SIZE, name);
+	cache->max_zone_size = conf_int(&val);
+
+	return cache;
+}
+
+void zone_conf_cache_free(zone_conf_cache_t *cache)
+{
+	while (cache != NULL) {
+		zone_conf_cache_t *next = cache->next;
+		acl_free(cache->acl);
+		free(cache);
+		cache = next;
+	}
+}
+
+zone_conf_cache_t *zone_conf_cache_set(zone_t *zone, zone_conf_cache_t *cache)
+{
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	return rcu_xchg_pointer(&zone->conf_cache, cache);
+}
+
+bool zone_conf_disable_any(conf_t *conf, const zone_t *zone)
+{
+	rcu_read_lock();
+	const zone_conf_cache_t *cache = rcu_dereference(zone->conf_cache);
+	if (cache != NULL) {
+		bool disable_any = cache->disable_any;
+		rcu_read_unlock();
+		return disable_any;
+	}
+	rcu_read_unlock();
+
+	conf_val_t val = conf_zone_get(conf, C_DISABLE_ANY, zone->name);
+	return conf_bool(&val);
+}
+
+int64_t zone_conf_max_zone_size(conf_t *conf, const zone_t *zone)
+{
+	rcu_read_lock();
+	const zone_conf_cache_t *cache = rcu_dereference(zone->conf_cache);
+	if (cache != NULL) {
+		int64_t max_zone_size = cache->max_zone_size;
+		rcu_read_unlock();
+		return max_zone_size;
+	}
+	rcu_read_unlock();
+
+	conf_val_t val = conf_zone_get(conf, C_MAX_ZONE_SIZE, zone->name);
+	return conf_int(&val);
+}
+
 bool zone_is_slave(conf_t *conf, const zone_t *zone)
 {
 	if (conf == NULL || zone == NULL) {
@@ -315,39 +713,30 @@ int zone_master_try(conf_t *conf, zone_t *zone, zone_master_cb callback,
 	return success ? KNOT_EOK : KNOT_ENOMASTER;
 }
 
-int zone_flush_journal(conf_t *conf, zone_t *zone)
+/*! \brief Check if the zone file differs from given contents. */
+static bool flush_needed(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 {
-	if (conf == NULL || zone == NULL || zone_contents_is_empty(zone->contents)) {
-		return KNOT_EINVAL;
-	}
-
 	bool force = zone->flags & ZONE_FORCE_FLUSH;
 	zone->flags &= ~ZONE_FORCE_FLUSH;
 
 	/* Check for disabled zonefile synchronization. */
 	conf_val_t val = conf_zone_get(conf, C_ZONEFILE_SYNC, zone->name);
 	if (conf_int(&val) < 0 && !force) {
-		return KNOT_EOK;
+		return false;
 	}
 
 	/* Check for difference against zonefile serial. */
-	zone_contents_t *contents = zone->contents;
 	uint32_t serial_to = zone_contents_serial(contents);
 	if (!force && zone->zonefile.exists && zone->zonefile.serial == serial_to) {
-		return KNOT_EOK; /* No differences. */
+		return false; /* No differences. */
 	}
 
-	char *zonefile = conf_zonefile(conf, zone->name);
-
-	/* Synchronize journal. */
-	int ret = zonefile_write(zonefile, contents);
-	if (ret != KNOT_EOK) {
-		log_zone_warning(zone->name, "failed to update zone file (%s)",
-		                 knot_strerror(ret));
-		free(zonefile);
-		return ret;
-	}
+	return true;
+}
 
+/*! \brief Update zone file parameters after the zone file was written. */
+static void flush_apply(zone_t *zone, time_t mtime, uint32_t serial_to)
+{
 	if (zone->zonefile.exists) {
 		log_zone_info(zone->name, "zone file updated, serial %u -> %u",
 		              zone->zonefile.serial, serial_to);
@@ -356,29 +745,295 @@ int zone_flush_journal(conf_t *conf, zone_t *zone)
 		              serial_to);
 	}
 
+	/* Update zone file serial. */
+	zone->zonefile.exists = true;
+	zone->zonefile.mtime = mtime;
+	zone->zonefile.serial = serial_to;
+}
+
+/*! \brief Take the version of the written zone file. */
+static int flush_finish(zone_t *zone, const char *zonefile, time_t *mtime)
+{
 	/* Update zone version. */
 	struct stat st;
 	if (stat(zonefile, &st) < 0) {
 		log_zone_warning(zone->name, "failed to update zone file (%s)",
 		                 knot_strerror(knot_map_errno()));
-		free(zonefile);
 		return KNOT_EACCES;
 	}
+	*mtime = st.st_mtime;
 
-	free(zonefile);
+	return KNOT_EOK;
+}
+
+/*! \brief Publish the background flush result, flush lock held. */
+static void flush_publish(zone_t *zone)
+{
+	if (zone->flush.result.ready) {
+		flush_apply(zone, zone->flush.result.mtime, zone->flush.result.serial);
+		zone->flush.result.ready = false;
+	}
+}
+
+void zone_flush_publish(zone_t *zone)
+{
+	if (zone == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&zone->flush.lock);
+	flush_publish(zone);
+	pthread_mutex_unlock(&zone->flush.lock);
+}
+
+void zone_flush_wait(zone_t *zone)
+{
+	if (zone == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&zone->flush.lock);
+	while (zone->flush.snapshot != NULL) {
+		pthread_cond_wait(&zone->flush.done, &zone->flush.lock);
+	}
+	flush_publish(zone);
+	pthread_mutex_unlock(&zone->flush.lock);
+}
+
+void zone_flush_invalidate(zone_t *zone)
+{
+	if (zone == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&zone->flush.lock);
+	flush_publish(zone);
+	zone->flush.epoch++;
+	pthread_mutex_unlock(&zone->flush.lock);
+}
+
+int zone_flush_journal(conf_t *conf, zone_t *zone)
+{
+	if (conf == NULL || zone == NULL || zone_contents_is_empty(zone->contents)) {
+		return KNOT_EINVAL;
+	}
+
+	zone_flush_publish(zone);
+
+	zone_contents_t *contents = zone->contents;
+	if (!flush_needed(conf, zone, contents)) {
+		return KNOT_EOK;
+	}
+
+	/* Any running background flush writes older contents. */
+	pthread_mutex_lock(&zone->flush.lock);
+	unsigned generation = ++zone->flush.generation;
+	pthread_mutex_unlock(&zone->flush.lock);
 
+	uint32_t serial_to = zone_contents_serial(contents);
+	char *zonefile = conf_zonefile(conf, zone->name);
 	char *journal_file = conf_journalfile(conf, zone->name);
 
-	/* Update zone file serial and journal. */
-	zone->zonefile.exists = true;
-	zone->zonefile.mtime = st.st_mtime;
-	zone->zonefile.serial = serial_to;
-	journal_mark_synced(journal_file);
+	/* Synchronize journal. */
+	char *tmp_name = NULL;
+	int ret = zonefile_write_tmp(zonefile, contents, &tmp_name);
+	if (ret == KNOT_EOK && rename(tmp_name, zonefile) != 0) {
+		ret = knot_map_errno();
+		unlink(tmp_name);
+	}
+	free(tmp_name);
+	if (ret != KNOT_EOK) {
+		log_zone_warning(zone->name, "failed to update zone file (%s)",
+		                 knot_strerror(ret));
+		goto finish;
+	}
 
-	free(journal_file);
+	time_t mtime = 0;
+	ret = flush_finish(zone, zonefile, &mtime);
+	if (ret != KNOT_EOK) {
+		goto finish;
+	}
+	zone->flush.committed = generation;
+
+	/* Result of a running background flush is older. */
+	pthread_mutex_lock(&zone->flush.lock);
+	zone->flush.result.ready = false;
+	pthread_mutex_unlock(&zone->flush.lock);
+	flush_apply(zone, mtime, serial_to);
+
+	/* Update journal. */
+	journal_drop(zone);
+	journal_mark_synced(journal_file);
 
 	/* Trim extra heap. */
 	mem_trim();
+finish:
+	free(zonefile);
+	free(journal_file);
+
+	return ret;
+}
+
+/*!
+ * \brief Move the zone file written by the background flush in place.
+ *
+ * The zonefile parameters are left to the zone event processing, see
+ * zone_flush_publish().
+ */
+static int flush_commit(flush_job_t *job, const char *tmp_name)
+{
+	zone_t *zone = job->zone;
+	uint32_t serial_to = zone_contents_serial(job->contents);
+
+	pthread_mutex_lock(&zone->journal_lock);
+	pthread_mutex_lock(&zone->flush.lock);
+
+	/* Drop the file if a newer flush has already finished or the zone
+	 * file was reloaded meanwhile. */
+	if ((int)(job->generation - zone->flush.committed) <= 0 ||
+	    job->epoch != zone->flush.epoch) {
+		if (job->epoch != zone->flush.epoch) {
+			zone->flush.again = true;
+		}
+		pthread_mutex_unlock(&zone->flush.lock);
+		pthread_mutex_unlock(&zone->journal_lock);
+		unlink(tmp_name);
+		return KNOT_EOK;
+	}
+
+	/* Swap temporary zonefile and new zonefile. */
+	if (rename(tmp_name, job->zonefile) != 0) {
+		int ret = knot_map_errno();
+		pthread_mutex_unlock(&zone->flush.lock);
+		pthread_mutex_unlock(&zone->journal_lock);
+		unlink(tmp_name);
+		return ret;
+	}
+
+	time_t mtime = 0;
+	int ret = flush_finish(zone, job->zonefile, &mtime);
+	if (ret == KNOT_EOK) {
+		zone->flush.result.ready = true;
+		zone->flush.result.mtime = mtime;
+		zone->flush.result.serial = serial_to;
+		zone->flush.committed = job->generation;
+		/* Changes applied after the snapshot must remain dirty. */
+		journal_drop(zone);
+		journal_mark_synced_to(job->journal_file, serial_to);
+	}
+
+	pthread_mutex_unlock(&zone->flush.lock);
+	pthread_mutex_unlock(&zone->journal_lock);
+
+	return ret;
+}
+
+/*! \brief Unpin the flushed contents and run the deferred reclamations. */
+static void flush_release(zone_t *zone)
+{
+	contents_unpin(zone, true);
+}
+
+static void flush_job_free(flush_job_t *job)
+{
+	free(job->zonefile);
+	free(job->journal_file);
+	free(job);
+}
+
+static void flush_run(task_t *task)
+{
+	flush_job_t *job = task->ctx;
+	zone_t *zone = job->zone;
+
+	char *tmp_name = NULL;
+	int ret = zonefile_write_tmp(job->zonefile, job->contents, &tmp_name);
+	if (ret == KNOT_EOK) {
+		ret = flush_commit(job, tmp_name);
+		free(tmp_name);
+	}
+	if (ret != KNOT_EOK) {
+		log_zone_warning(zone->name, "failed to update zone file (%s)",
+		                 knot_strerror(ret));
+	}
+
+	/* Publish the result and run the flush requested in the meantime. */
+	pthread_mutex_lock(&zone->flush.lock);
+	bool again = zone->flush.again || zone->flush.result.ready;
+	zone->flush.again = false;
+	pthread_mutex_unlock(&zone->flush.lock);
+	if (again) {
+		zone_events_schedule(zone, ZONE_EVENT_FLUSH, ZONE_EVENT_NOW);
+	}
+
+	flush_release(zone);
+	flush_job_free(job);
+}
+
+int zone_flush_journal_async(conf_t *conf, zone_t *zone)
+{
+	if (conf == NULL || zone == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* Pin the contents before they can be replaced and reclaimed. */
+	rcu_read_lock();
+	pthread_mutex_lock(&zone->flush.lock);
+
+	int ret = KNOT_EOK;
+	zone_contents_t *contents = zone->contents;
+	if (zone_contents_is_empty(contents)) {
+		ret = KNOT_EINVAL;
+		goto unlock;
+	}
+
+	/* Postpone the flush after the running one. */
+	if (zone->flush.snapshot != NULL) {
+		zone->flush.again = true;
+		goto unlock;
+	}
+
+	flush_publish(zone);
+
+	if (!flush_needed(conf, zone, contents)) {
+		goto unlock;
+	}
+
+	flush_job_t *job = calloc(1, sizeof(*job));
+	if (job == NULL) {
+		ret = KNOT_ENOMEM;
+		goto unlock;
+	}
+	job->zone = zone;
+	job->contents = contents;
+	job->zonefile = conf_zonefile(conf, zone->name);
+	job->journal_file = conf_journalfile(conf, zone->name);
+	if (job->zonefile == NULL || job->journal_file == NULL) {
+		flush_job_free(job);
+		ret = KNOT_ENOMEM;
+		goto unlock;
+	}
+	job->task.ctx = job;
+	job->task.run = flush_run;
+	job->generation = ++zone->flush.generation;
+	job->epoch = zone->flush.epoch;
+	zone->flush.snapshot = contents;
+
+	pthread_mutex_unlock(&zone->flush.lock);
+	rcu_read_unlock();
+
+	/* The flushes are queued to one thread, their number is bounded
+	 * by the zones as each zone has at most one running. */
+	if (zone->flusher != NULL) {
+		worker_pool_assign(zone->flusher, &job->task);
+	} else {
+		flush_run(&job->task);
+	}
+
+	return KNOT_EOK;
+unlock:
+	pthread_mutex_unlock(&zone->flush.lock);
+	rcu_read_unlock();
 
 	return ret;
 }
@@ -411,18 +1066,23 @@ int zone_update_enqueue(zone_t *zone, knot_pkt_t *pkt, struct process_query_para
 	pthread_mutex_lock(&zone->ddns_lock);
 
 	/* Enqueue created request. */
+	if (zone->ddns_queue_size == 0) {
+		gettimeofday(&zone->ddns_queue_time, NULL);
+	}
 	ptrlist_add(&zone->ddns_queue, req, NULL);
 	++zone->ddns_queue_size;
 
 	pthread_mutex_unlock(&zone->ddns_lock);
 
-	/* Schedule UPDATE event. */
-	zone_events_schedule(zone, ZONE_EVENT_UPDATE, ZONE_EVENT_NOW);
+	/* Schedule UPDATE event, possibly batched with other zones. */
+	if (ddns_batch_add(zone->ddns_batch, zone->name) != KNOT_EOK) {
+		zone_events_schedule(zone, ZONE_EVENT_UPDATE, ZONE_EVENT_NOW);
+	}
 
 	return KNOT_EOK;
 }
 
-size_t zone_update_dequeue(zone_t *zone, list_t *updates)
+size_t zone_update_dequeue(zone_t *zone, list_t *updates, struct timeval *queued)
 {
 	if (zone == NULL || updates == NULL) {
 		return 0;
@@ -437,6 +1097,9 @@ size_t zone_update_dequeue(zone_t *zone, list_t *updates)
 
 	*updates = zone->ddns_queue;
 	size_t update_count = zone->ddns_queue_size;
+	if (queued != NULL) {
+		*queued = zone->ddns_queue_time;
+	}
 	init_list(&zone->ddns_queue);
 	zone->ddns_queue_size = 0;
 
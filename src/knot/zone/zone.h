@@ -24,19 +24,28 @@
 
 #pragma once
 
+#include <sys/time.h>
 #include <time.h>
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "knot/common/ref.h"
 #include "knot/conf/conf.h"
 #include "knot/conf/confio.h"
 #include "knot/server/journal.h"
+#include "knot/server/journal-sync.h"
+#include "knot/updates/acl.h"
 #include "knot/events/events.h"
 #include "knot/zone/contents.h"
 #include "libknot/dname.h"
 #include "libknot/packet/pkt.h"
 
+struct apply_ctx;
+struct journal_sync;
+struct kdnssec_cache;
+struct ddns_batch;
 struct process_query_param;
+struct reclaim;
 struct zone_update;
 
 /*!
@@ -49,6 +58,31 @@ typedef enum zone_flag_t {
 	ZONE_EXPIRED      = 1 << 3, /* Zone is expired. */
 } zone_flag_t;
 
+/*!
+ * \brief Zone configuration compiled for the query path.
+ *
+ * Built at zone database reload so that queries don't look up the
+ * configuration database. Owns all its data, independent of the
+ * configuration it was compiled from.
+ */
+typedef struct zone_conf_cache {
+	acl_t *acl;             /*!< Zone ACL. */
+	bool disable_any;       /*!< Answer ANY queries with TC over UDP. */
+	int64_t max_zone_size;  /*!< Maximum zone size for incoming transfers. */
+	struct zone_conf_cache *next; /*!< Next cache waiting for reclamation. */
+} zone_conf_cache_t;
+
+/*!
+ * \brief Loaded query modules of a zone.
+ *
+ * Zones with the same list of zone independent modules share the instance.
+ */
+typedef struct zone_modules {
+	ref_t ref;                /*!< Number of zones using the modules. */
+	list_t list;              /*!< Loaded query modules. */
+	struct query_plan *plan;  /*!< Query plan of the modules. */
+} zone_modules_t;
+
 /*!
  * \brief Structure for holding DNS zone.
  */
@@ -76,21 +110,62 @@ typedef struct zone
 	pthread_mutex_t ddns_lock;
 	size_t ddns_queue_size;
 	list_t ddns_queue;
+	struct timeval ddns_queue_time; /*!< Arrival of the oldest queued update. */
+
+	/*! \brief DDNS batching across zones (or NULL). */
+	struct ddns_batch *ddns_batch;
 
-	/*! \brief Control update context. */
+	/*! \brief Control update context and its lock. */
+	pthread_mutex_t control_lock;
 	struct zone_update *control_update;
 
 	/*! \brief Journal access lock. */
 	pthread_mutex_t journal_lock;
 
+	/*! \brief Journal kept open between the stores (journal lock). */
+	journal_t *journal;
+
+	/*! \brief Journal group commit (or NULL). */
+	struct journal_sync *journal_sync;
+
+	/*! \brief DNSSEC signing context and keys cache (or NULL). */
+	struct kdnssec_cache *dnssec_cache;
+
+	/*! \brief Deferred reclamation of replaced contents (or NULL). */
+	struct reclaim *reclaim;
+
+	/*! \brief Background zone file flushes (or NULL). */
+	worker_pool_t *flusher;
+
+	/*! \brief Background zone file flush. */
+	struct {
+		pthread_mutex_t lock;       /*!< Flush state lock. */
+		pthread_cond_t done;        /*!< Signalled when a pin is dropped. */
+		zone_contents_t *snapshot;  /*!< Contents being written (or NULL). */
+		unsigned pins;              /*!< Readers of contents outside RCU. */
+		list_t retired;             /*!< Reclamation deferred by the pins. */
+		bool again;                 /*!< Flush requested during the flush. */
+		unsigned generation;        /*!< Last started flush. */
+		unsigned committed;         /*!< Last flush in the zone file (journal lock). */
+		unsigned epoch;             /*!< Zone file invalidations counter. */
+		struct {
+			bool ready;         /*!< Not yet published in zonefile. */
+			time_t mtime;
+			uint32_t serial;
+		} result;                   /*!< Zone file written by the flush. */
+	} flush;
+
 	/*! \brief Preferred master lock. */
 	pthread_mutex_t preferred_lock;
 	/*! \brief Preferred master for remote operation. */
 	struct sockaddr_storage *preferred_master;
 
-	/*! \brief Query modules. */
-	list_t query_modules;
+	/*! \brief Query modules (can be shared, or NULL) and their plan. */
+	zone_modules_t *query_modules;
 	struct query_plan *query_plan;
+
+	/*! \brief Compiled configuration (RCU protected, can be NULL). */
+	zone_conf_cache_t *conf_cache;
 } zone_t;
 
 /*!
@@ -130,6 +205,101 @@ int zone_change_store(conf_t *conf, zone_t *zone, changeset_t *change);
  */
 zone_contents_t *zone_switch_contents(zone_t *zone, zone_contents_t *new_contents);
 
+/*!
+ * \brief Free zone contents replaced by zone_switch_contents().
+ *
+ * The contents are freed by the reclamation thread once the RCU readers
+ * finish, and not before the end of a running background flush or a pinned
+ * reader which may still read the old contents or their shared data. Without
+ * the reclamation thread, the readers are synchronized and the contents freed
+ * immediately.
+ *
+ * \param zone      Zone.
+ * \param contents  Replaced contents (deep freed if \a ctx is NULL).
+ * \param ctx       Apply context of an incremental update (or NULL), its old
+ *                  data are taken over and the context is cleaned up.
+ */
+void zone_contents_retire(zone_t *zone, zone_contents_t **contents,
+                          struct apply_ctx *ctx);
+
+/*!
+ * \brief Pins the current zone contents for a long read outside RCU.
+ *
+ * The pinned contents and any replaced since are not reclaimed until
+ * zone_contents_unpin(), so the reader can block (e.g. on a socket).
+ *
+ * \param zone  Zone.
+ *
+ * \return Pinned contents, NULL if the zone has no contents (nothing pinned).
+ */
+zone_contents_t *zone_contents_pin(zone_t *zone);
+
+/*!
+ * \brief Unpins the contents pinned by zone_contents_pin().
+ *
+ * \param zone  Zone.
+ */
+void zone_contents_unpin(zone_t *zone);
+
+/*!
+ * \brief Compiles the zone configuration for the query path.
+ *
+ * \param conf  Configuration.
+ * \param name  Zone name.
+ *
+ * \return Compiled configuration or NULL on error.
+ */
+zone_conf_cache_t *zone_conf_cache_create(conf_t *conf, const knot_dname_t *name);
+
+/*!
+ * \brief Frees the compiled zone configuration (and the following ones).
+ *
+ * \param cache  Compiled configuration.
+ */
+void zone_conf_cache_free(zone_conf_cache_t *cache);
+
+/*!
+ * \brief Loads the query modules configured for the zone.
+ *
+ * \param conf  Configuration.
+ * \param name  Zone name.
+ *
+ * \return Unused modules or NULL if no module is loaded.
+ */
+zone_modules_t *zone_modules_create(conf_t *conf, const knot_dname_t *name);
+
+/*!
+ * \brief Sets the zone query modules, which can be shared with other zones.
+ *
+ * \param zone     Zone without query modules.
+ * \param modules  Query modules (can be NULL).
+ */
+void zone_modules_set(zone_t *zone, zone_modules_t *modules);
+
+/*!
+ * \brief Publishes new compiled zone configuration.
+ *
+ * \param zone   Zone.
+ * \param cache  New compiled configuration.
+ *
+ * \return Replaced compiled configuration, to be freed after synchronize_rcu().
+ */
+zone_conf_cache_t *zone_conf_cache_set(zone_t *zone, zone_conf_cache_t *cache);
+
+/*!
+ * \brief Checks if ANY queries are disabled for the zone.
+ *
+ * \note Uses the compiled configuration, the configuration otherwise.
+ */
+bool zone_conf_disable_any(conf_t *conf, const zone_t *zone);
+
+/*!
+ * \brief Returns maximum zone size for incoming transfers.
+ *
+ * \note Uses the compiled configuration, the configuration otherwise.
+ */
+int64_t zone_conf_max_zone_size(conf_t *conf, const zone_t *zone);
+
 /*! \brief Checks if the zone is slave. */
 bool zone_is_slave(conf_t *conf, const zone_t *zone);
 
@@ -154,14 +324,71 @@ typedef int (*zone_master_cb)(conf_t *conf, zone_t *zone, const conf_remote_t *r
 int zone_master_try(conf_t *conf, zone_t *zone, zone_master_cb callback,
                     void *callback_data, const char *err_str);
 
+/*!
+ * \brief Call the callback when the stored changes are durable.
+ *
+ * The journal is synchronized with the journals of other updates, the
+ * callback is called from the journal synchronization thread.
+ *
+ * \param conf  Configuration.
+ * \param zone  Zone with stored changes.
+ * \param cb    Callback with the synchronization result.
+ * \param ctx   Callback context.
+ *
+ * \retval KNOT_EOK if the callback will be called.
+ * \retval KNOT_ENOTSUP if the journal synchronization is disabled.
+ * \return < KNOT_EOK on other errors.
+ */
+int zone_journal_sync(conf_t *conf, zone_t *zone, journal_sync_cb_t cb, void *ctx);
+
 /*! \brief Synchronize zone file with journal. */
 int zone_flush_journal(conf_t *conf, zone_t *zone);
 
+/*!
+ * \brief Synchronize zone file with journal in the background.
+ *
+ * The current zone contents are written into the zone file by the flusher
+ * while queries, updates and other zone events go on. Only one flush of the
+ * zone runs at a time, a flush requested meanwhile is scheduled after the
+ * running one. Without the flusher, the zone file is written synchronously.
+ */
+int zone_flush_journal_async(conf_t *conf, zone_t *zone);
+
+/*!
+ * \brief Publish the zone file written by a finished background flush.
+ *
+ * The zonefile parameters are only updated by the zone event processing,
+ * the background flush leaves its result to be published here.
+ */
+void zone_flush_publish(zone_t *zone);
+
+/*!
+ * \brief Wait for the background flush and publish its result.
+ *
+ * To be called before the zonefile parameters are taken over by a reloaded
+ * zone, the running flush would publish them to the replaced zone.
+ */
+void zone_flush_wait(zone_t *zone);
+
+/*!
+ * \brief Publish the finished background flush and discard the running one.
+ *
+ * To be called before the zone file is reloaded, the running flush would
+ * overwrite it with the replaced contents.
+ */
+void zone_flush_invalidate(zone_t *zone);
+
 /*! \brief Enqueue UPDATE request for processing. */
 int zone_update_enqueue(zone_t *zone, knot_pkt_t *pkt, struct process_query_param *param);
 
-/*! \brief Dequeue UPDATE request. Returns number of queued updates. */
-size_t zone_update_dequeue(zone_t *zone, list_t *updates);
+/*!
+ * \brief Dequeue UPDATE requests. Returns number of queued updates.
+ *
+ * \param zone     Zone.
+ * \param updates  Output list of the requests.
+ * \param queued   Output arrival time of the oldest request (can be NULL).
+ */
+size_t zone_update_dequeue(zone_t *zone, list_t *updates, struct timeval *queued);
 
 /*! \brief Returns true if final SOA in transfer has newer serial than zone */
 bool zone_transfer_needed(const zone_t *zone, const knot_pkt_t *pkt);
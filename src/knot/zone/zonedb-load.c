@@ -15,9 +15,11 @@
 */
 
 #include <assert.h>
+#include <pthread.h>
 #include <urcu.h>
 
 #include "knot/conf/confio.h"
+#include "knot/nameserver/query_module.h"
 #include "knot/zone/zonedb-load.h"
 #include "knot/zone/zone-load.h"
 #include "knot/zone/zone.h"
@@ -26,6 +28,12 @@
 #include "knot/zone/timers.h"
 #include "knot/common/log.h"
 #include "libknot/libknot.h"
+#include "contrib/macros.h"
+#include "contrib/mempattern.h"
+#include "contrib/ucw/mempool.h"
+
+/*! \brief Minimal number of zones processed by one reload thread. */
+#define RELOAD_SHARD_MIN	1024
 
 /*!
  * \brief Zone file status.
@@ -116,12 +124,17 @@ static zone_t *create_zone_from(const knot_dname_t *name, server_t *server)
 	}
 
 	int result = zone_events_setup(zone, server->workers, &server->sched,
-	                               server->timers_db);
+	                               server->timers);
 	if (result != KNOT_EOK) {
 		zone_free(&zone);
 		return NULL;
 	}
 
+	zone->journal_sync = server->journal_sync;
+	zone->ddns_batch = server->ddns_batch;
+	zone->reclaim = server->reclaim;
+	zone->flusher = server->flusher;
+
 	return zone;
 }
 
@@ -135,6 +148,10 @@ static zone_t *create_zone_reload(conf_t *conf, const knot_dname_t *name,
 	zone->contents = old_zone->contents;
 	zone->bootstrap_retry = old_zone->bootstrap_retry;
 
+	/* Take over the zone file written by the background flush, a flush
+	 * still running would publish it to the replaced zone. */
+	zone_flush_wait(old_zone);
+
 	zone_status_t zstatus;
 	if (zone_is_slave(conf, zone) && old_zone->flags & ZONE_EXPIRED) {
 		zone->flags |= ZONE_EXPIRED;
@@ -172,14 +189,12 @@ static bool slave_event(zone_event_type_t event)
 	return event == ZONE_EVENT_EXPIRE || event == ZONE_EVENT_REFRESH;
 }
 
-static int reuse_events(conf_t *conf, knot_db_t *timer_db, zone_t *zone)
+static void reuse_events(conf_t *conf, const time_t *timers, zone_t *zone)
 {
 	// Get persistent timers
 
-	time_t timers[ZONE_EVENT_COUNT] = { 0 };
-	int ret = read_zone_timers(timer_db, zone, timers);
-	if (ret != KNOT_EOK) {
-		return ret;
+	if (timers == NULL) {
+		return;
 	}
 
 	for (zone_event_type_t event = 0; event < ZONE_EVENT_COUNT; ++event) {
@@ -199,25 +214,20 @@ static int reuse_events(conf_t *conf, knot_db_t *timer_db, zone_t *zone)
 
 		zone_events_schedule_at(zone, event, timers[event]);
 	}
-
-	return KNOT_EOK;
 }
 
 static zone_t *create_zone_new(conf_t *conf, const knot_dname_t *name,
-                               server_t *server)
+                               server_t *server, hattrie_t *timers)
 {
 	zone_t *zone = create_zone_from(name, server);
 	if (!zone) {
 		return NULL;
 	}
 
-	int ret = reuse_events(conf, server->timers_db, zone);
-	if (ret != KNOT_EOK) {
-		log_zone_error(zone->name, "cannot read zone timers (%s)",
-		               knot_strerror(ret));
-		zone_free(&zone);
-		return NULL;
-	}
+	/* Restored timers are already stored. */
+	zone->events.timers = NULL;
+	reuse_events(conf, timer_db_find(timers, zone->name), zone);
+	zone->events.timers = server->timers;
 
 	zone_status_t zstatus = zone_file_status(conf, NULL, name);
 	if (zone->flags & ZONE_EXPIRED) {
@@ -252,11 +262,12 @@ static zone_t *create_zone_new(conf_t *conf, const knot_dname_t *name,
  * \param conf       Configuration.
  * \param server     Server.
  * \param old_zone   Already loaded zone (can be NULL).
+ * \param timers     Persistent timers of all zones (for a new zone).
  *
  * \return Error code, KNOT_EOK if successful.
  */
 static zone_t *create_zone(conf_t *conf, const knot_dname_t *name, server_t *server,
-                           zone_t *old_zone)
+                           zone_t *old_zone, hattrie_t *timers)
 {
 	assert(conf);
 	assert(name);
@@ -265,7 +276,155 @@ static zone_t *create_zone(conf_t *conf, const knot_dname_t *name, server_t *ser
 	if (old_zone) {
 		return create_zone_reload(conf, name, server, old_zone);
 	} else {
-		return create_zone_new(conf, name, server);
+		return create_zone_new(conf, name, server, timers);
+	}
+}
+
+/*! \brief Callback processing zones from \a from to \a to (exclusive). */
+typedef void (*shard_fcn_t)(void *ctx, size_t from, size_t to);
+
+typedef struct {
+	pthread_t thread;
+	shard_fcn_t fcn;
+	void *ctx;
+	size_t from;
+	size_t to;
+} shard_t;
+
+static void *shard_run(void *data)
+{
+	shard_t *shard = data;
+
+	rcu_register_thread();
+	shard->fcn(shard->ctx, shard->from, shard->to);
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+/*!
+ * \brief Process zones in parallel shards.
+ *
+ * \note The last shard is processed by the calling thread.
+ *
+ * \param conf   Configuration (number of background workers).
+ * \param count  Number of zones.
+ * \param fcn    Shard callback.
+ * \param ctx    Callback context.
+ */
+static void run_sharded(conf_t *conf, size_t count, shard_fcn_t fcn, void *ctx)
+{
+	size_t shards = MIN(conf_bg_threads(conf), count / RELOAD_SHARD_MIN);
+	if (shards <= 1) {
+		fcn(ctx, 0, count);
+		return;
+	}
+
+	shard_t shard[shards];
+	size_t from = 0;
+	for (size_t i = 0; i < shards; i++) {
+		size_t to = from + count / shards + (i < count % shards ? 1 : 0);
+		shard[i] = (shard_t) { .fcn = fcn, .ctx = ctx, .from = from, .to = to };
+		from = to;
+	}
+	assert(from == count);
+
+	// Start the threads, process a shard directly if not possible.
+	bool started[shards];
+	for (size_t i = 0; i < shards - 1; i++) {
+		started[i] = (pthread_create(&shard[i].thread, NULL, shard_run,
+		                             &shard[i]) == 0);
+		if (!started[i]) {
+			fcn(ctx, shard[i].from, shard[i].to);
+		}
+	}
+
+	fcn(ctx, shard[shards - 1].from, shard[shards - 1].to);
+
+	for (size_t i = 0; i < shards - 1; i++) {
+		if (started[i]) {
+			pthread_join(shard[i].thread, NULL);
+		}
+	}
+}
+
+/*! \brief Zone to be created during the reload. */
+typedef struct {
+	knot_dname_t *name;
+	zone_t *old_zone;
+	zone_t *zone;
+} zone_entry_t;
+
+typedef struct {
+	conf_t *conf;
+	server_t *server;
+	hattrie_t *timers;
+	zone_entry_t *entries;
+} create_ctx_t;
+
+static void create_zones(void *data, size_t from, size_t to)
+{
+	create_ctx_t *ctx = data;
+
+	for (size_t i = from; i < to; i++) {
+		zone_entry_t *entry = &ctx->entries[i];
+		entry->zone = create_zone(ctx->conf, entry->name, ctx->server,
+		                          entry->old_zone, ctx->timers);
+	}
+}
+
+/*!
+ * \brief Check if the listed modules don't depend on the zone they are loaded for.
+ */
+static bool modules_shareable(conf_val_t *val)
+{
+	for (; val->code == KNOT_EOK; conf_val_next(val)) {
+		conf_val(val);
+		const static_module_t *module = find_module((const yp_name_t *)val->data);
+		if (module == NULL || module->scope != MOD_SCOPE_ANY) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * \brief Load the zone query modules, reuse the ones with the same module list.
+ *
+ * \param conf    Configuration.
+ * \param zone    Zone without query modules.
+ * \param shared  Loaded modules indexed by the module list (can be NULL).
+ */
+static void activate_modules(conf_t *conf, zone_t *zone, hattrie_t *shared)
+{
+	conf_val_t val = conf_zone_get(conf, C_MODULE, zone->name);
+	if (val.code != KNOT_EOK) {
+		return;
+	}
+
+	const char *key = (const char *)val.blob;
+	size_t key_len = val.blob_len;
+
+	if (shared == NULL || !modules_shareable(&val)) {
+		zone_modules_t *modules = zone_modules_create(conf, zone->name);
+		zone_modules_set(zone, modules);
+		return;
+	}
+
+	value_t *found = hattrie_tryget(shared, key, key_len);
+	if (found != NULL) {
+		zone_modules_set(zone, *found);
+		return;
+	}
+
+	zone_modules_t *modules = zone_modules_create(conf, zone->name);
+	zone_modules_set(zone, modules);
+	if (modules != NULL) {
+		value_t *slot = hattrie_get(shared, key, key_len);
+		if (slot != NULL) {
+			*slot = modules;
+		}
 	}
 }
 
@@ -320,6 +479,21 @@ static knot_zonedb_t *create_zonedb(conf_t *conf, server_t *server)
 		mark_changed_zones(server->zone_db, conf->io.zones);
 	}
 
+	/* Persistent timers of new zones, read with one scan when needed. */
+	knot_mm_t mm;
+	mm_ctx_mempool(&mm, MM_DEFAULT_BLKSIZE);
+	hattrie_t *timers = NULL;
+	int timers_ret = KNOT_EOK;
+
+	zone_entry_t *entries = malloc(conf_id_count(conf, C_ZONE) * sizeof(*entries));
+	if (entries == NULL) {
+		mp_delete(mm.ctx);
+		knot_zonedb_free(&db_new);
+		return NULL;
+	}
+	size_t count = 0;
+
+	/* Reuse unchanged zones, collect the zones to be created. */
 	for (conf_iter_t iter = conf_iter(conf, C_ZONE); iter.code == KNOT_EOK;
 	     conf_iter_next(conf, &iter)) {
 		conf_val_t id = conf_iter_id(conf, &iter);
@@ -334,17 +508,54 @@ static knot_zonedb_t *create_zonedb(conf_t *conf, server_t *server)
 			}
 		}
 
-		zone_t *zone = create_zone(conf, name, server, old_zone);
-		if (zone == NULL) {
+		if (old_zone == NULL && timers == NULL && timers_ret == KNOT_EOK) {
+			timers_ret = read_timer_db(server->timers_db, &mm, &timers);
+			if (timers_ret != KNOT_EOK) {
+				log_error("cannot read zone timers, using defaults (%s)",
+				          knot_strerror(timers_ret));
+			}
+		}
+
+		knot_dname_t *name_copy = knot_dname_copy(name, &mm);
+		if (name_copy == NULL) {
 			log_zone_error(name, "zone cannot be created");
 			continue;
 		}
 
-		conf_activate_modules(conf, zone->name, &zone->query_modules,
-		                      &zone->query_plan);
+		assert(count < conf_id_count(conf, C_ZONE));
+		entries[count++] = (zone_entry_t) {
+			.name = name_copy,
+			.old_zone = old_zone
+		};
+	}
+
+	/* Create the zones in parallel. */
+	create_ctx_t ctx = {
+		.conf = conf,
+		.server = server,
+		.timers = timers,
+		.entries = entries
+	};
+	run_sharded(conf, count, create_zones, &ctx);
+
+	/* Modules share the configuration memory context, activate them serially. */
+	hattrie_t *modules = hattrie_create(&mm);
+	for (size_t i = 0; i < count; i++) {
+		zone_t *zone = entries[i].zone;
+		if (zone == NULL) {
+			log_zone_error(entries[i].name, "zone cannot be created");
+			continue;
+		}
+
+		activate_modules(conf, zone, modules);
 
 		knot_zonedb_insert(db_new, zone);
 	}
+	hattrie_free(modules);
+
+	free(entries);
+	hattrie_free(timers);
+	mp_delete(mm.ctx);
 
 	return db_new;
 }
@@ -403,6 +614,108 @@ static void remove_old_zonedb(conf_t *conf, knot_zonedb_t *db_old,
 	}
 }
 
+typedef struct {
+	conf_t *conf;
+	zone_t **zones;
+	zone_conf_cache_t **caches;
+} cache_ctx_t;
+
+static void compile_conf_caches(void *data, size_t from, size_t to)
+{
+	cache_ctx_t *ctx = data;
+
+	for (size_t i = from; i < to; i++) {
+		const zone_t *zone = ctx->zones[i];
+		ctx->caches[i] = zone_conf_cache_create(ctx->conf, zone->name);
+		if (ctx->caches[i] == NULL) {
+			log_zone_warning(zone->name, "failed to compile configuration");
+		}
+	}
+}
+
+/*!
+ * \brief Check if the compiled zone configuration must be rebuilt.
+ */
+static bool conf_cache_outdated(conf_t *conf, const zone_t *zone)
+{
+	return zone->conf_cache == NULL ||
+	       (zone->change_type & CONF_IO_TCHANGE) ||
+	       (conf->io.flags & CONF_IO_FRLD_CACHES);
+}
+
+static void retire_conf_cache(zone_t *zone, zone_conf_cache_t *cache,
+                              zone_conf_cache_t **retired)
+{
+	zone_conf_cache_t *old = zone_conf_cache_set(zone, cache);
+	if (old != NULL) {
+		old->next = *retired;
+		*retired = old;
+	}
+	zone->change_type &= ~CONF_IO_TCHANGE;
+}
+
+/*!
+ * \brief Compile the configuration of the created and changed zones.
+ *
+ * Reused zones keep their compiled configuration unless their section or
+ * a referenced ACL, key or remote has changed.
+ *
+ * \return Replaced caches to be freed after the RCU grace period.
+ */
+static zone_conf_cache_t *update_conf_caches(conf_t *conf, knot_zonedb_t *db)
+{
+	size_t count = 0;
+	knot_zonedb_iter_t it;
+	knot_zonedb_iter_begin(db, &it);
+	for (; !knot_zonedb_iter_finished(&it); knot_zonedb_iter_next(&it)) {
+		const zone_t *zone = knot_zonedb_iter_val(&it);
+		if (conf_cache_outdated(conf, zone)) {
+			count++;
+		}
+	}
+	if (count == 0) {
+		return NULL;
+	}
+
+	cache_ctx_t ctx = {
+		.conf = conf,
+		.zones = malloc(count * sizeof(zone_t *)),
+		.caches = calloc(count, sizeof(zone_conf_cache_t *))
+	};
+
+	zone_conf_cache_t *retired = NULL;
+	bool compile = (ctx.zones != NULL && ctx.caches != NULL);
+
+	size_t i = 0;
+	knot_zonedb_iter_begin(db, &it);
+	for (; !knot_zonedb_iter_finished(&it); knot_zonedb_iter_next(&it)) {
+		zone_t *zone = knot_zonedb_iter_val(&it);
+		if (!conf_cache_outdated(conf, zone)) {
+			continue;
+		}
+		if (compile) {
+			assert(i < count);
+			ctx.zones[i++] = zone;
+		} else {
+			/* The outdated configuration mustn't be used, use the slow path. */
+			retire_conf_cache(zone, NULL, &retired);
+		}
+	}
+
+	if (compile) {
+		run_sharded(conf, count, compile_conf_caches, &ctx);
+
+		for (i = 0; i < count; i++) {
+			retire_conf_cache(ctx.zones[i], ctx.caches[i], &retired);
+		}
+	}
+
+	free(ctx.zones);
+	free(ctx.caches);
+
+	return retired;
+}
+
 void zonedb_reload(conf_t *conf, server_t *server)
 {
 	if (conf == NULL || server == NULL) {
@@ -419,6 +732,9 @@ void zonedb_reload(conf_t *conf, server_t *server)
 	/* Rebuild zone database search stack. */
 	knot_zonedb_build_index(db_new);
 
+	/* Compile the zone configuration for the query path. */
+	zone_conf_cache_t *retired = update_conf_caches(conf, db_new);
+
 	/* Switch the databases. */
 	knot_zonedb_t **db_current = &server->zone_db;
 	knot_zonedb_t *db_old = rcu_xchg_pointer(db_current, db_new);
@@ -426,9 +742,16 @@ void zonedb_reload(conf_t *conf, server_t *server)
 	/* Wait for readers to finish reading old zone database. */
 	synchronize_rcu();
 
-	/* Sweep the timer database. */
+	/* Free the replaced compiled configuration. */
+	zone_conf_cache_free(retired);
+
+	/* Store pending timers and sweep the timer database. */
+	timers_writer_flush(server->timers);
 	sweep_timer_db(server->timers_db, db_new);
 
 	/* Remove old zone DB. */
 	remove_old_zonedb(conf, db_old, db_new);
+
+	/* Drop timers staged by the removed zones meanwhile. */
+	timers_writer_sweep(server->timers, db_new);
 }
@@ -30,6 +30,8 @@ static void discard_zone(zone_t *zone)
 	if (conf_rawid_exists(conf(), C_ZONE, zone->name, knot_dname_size(zone->name))) {
 		char *journal_file = conf_journalfile(conf(), zone->name);
 
+		zone_flush_wait(zone);
+
 		/* Flush if bootstrapped or if the journal doesn't exist. */
 		if (!zone->zonefile.exists || !journal_exists(journal_file)) {
 			pthread_mutex_lock(&zone->journal_lock);
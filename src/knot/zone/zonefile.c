@@ -50,12 +50,6 @@ static void process_error(zs_scanner_t *s)
 	      zs_strerror(s->error.code));
 }
 
-static int add_rdata_to_rr(knot_rrset_t *rrset, const zs_scanner_t *scanner)
-{
-	return knot_rrset_add_rdata(rrset, scanner->r_data, scanner->r_data_length,
-	                            scanner->r_ttl, NULL);
-}
-
 static void log_ttl_error(const zcreator_t *zc, const zone_node_t *node,
                           const knot_rrset_t *rr, const knot_dname_t *zone_name)
 {
@@ -96,22 +90,25 @@ static bool handle_err(zcreator_t *zc, const zone_node_t *node,
 	}
 }
 
-int zcreator_step(zcreator_t *zc, const knot_rrset_t *rr)
+/*!
+ * \brief Adds a record into the zone.
+ *
+ * \param zc    Zone creator.
+ * \param rr    Record to add.
+ * \param node  Node of the record owner if known, set to the node used.
+ */
+static int zcreator_add(zcreator_t *zc, const knot_rrset_t *rr,
+                        zone_node_t **node)
 {
-	if (zc == NULL || rr == NULL || rr->rrs.rr_count != 1) {
-		return KNOT_EINVAL;
-	}
-
 	if (rr->type == KNOT_RRTYPE_SOA &&
 	    node_rrtype_exists(zc->z->apex, KNOT_RRTYPE_SOA)) {
 		// Ignore extra SOA
 		return KNOT_EOK;
 	}
 
-	zone_node_t *node = NULL;
-	int ret = zone_contents_add_rr(zc->z, rr, &node);
+	int ret = zone_contents_add_rr(zc->z, rr, node);
 	if (ret != KNOT_EOK) {
-		if (!handle_err(zc, node, rr, ret, zc->master)) {
+		if (!handle_err(zc, *node, rr, ret, zc->master)) {
 			// Fatal error
 			return ret;
 		}
@@ -123,7 +120,17 @@ int zcreator_step(zcreator_t *zc, const knot_rrset_t *rr)
 	return KNOT_EOK;
 }
 
-/*! \brief Creates RR from parser input, passes it to handling function. */
+int zcreator_step(zcreator_t *zc, const knot_rrset_t *rr)
+{
+	if (zc == NULL || rr == NULL || rr->rrs.rr_count != 1) {
+		return KNOT_EINVAL;
+	}
+
+	zone_node_t *node = NULL;
+	return zcreator_add(zc, rr, &node);
+}
+
+/*! \brief Creates RRs from a batch of parser records, adds them to the zone. */
 static void process_data(zs_scanner_t *scanner)
 {
 	zcreator_t *zc = scanner->process.data;
@@ -132,37 +139,50 @@ static void process_data(zs_scanner_t *scanner)
 		return;
 	}
 
-	knot_dname_t *owner = knot_dname_copy(scanner->r_owner, NULL);
-	if (owner == NULL) {
-		zc->ret = KNOT_ENOMEM;
-		return;
-	}
+	// Node of the previous record, shared owner means the same node.
+	const uint8_t *node_owner = NULL;
+	bool node_nsec3 = false;
+	zone_node_t *node = NULL;
 
-	knot_rrset_t rr;
-	knot_rrset_init(&rr, owner, scanner->r_type, scanner->r_class);
-	int ret = add_rdata_to_rr(&rr, scanner);
-	if (ret != KNOT_EOK) {
-		char *rr_name = knot_dname_to_str_alloc(rr.owner);
-		const knot_dname_t *zname = zc->z->apex->owner;
-		ERROR(zname, "failed to add RDATA, file '%s', line %"PRIu64", owner '%s'",
-		      scanner->file.name, scanner->line_counter, rr_name);
-		free(rr_name);
-		knot_dname_free(&owner, NULL);
-		zc->ret = ret;
-		return;
-	}
+	for (size_t i = 0; i < scanner->batch.count; i++) {
+		const zs_record_t *record = &scanner->batch.records[i];
+
+		// The owner is used directly from the scanner.
+		knot_rrset_t rr;
+		knot_rrset_init(&rr, (knot_dname_t *)record->owner, record->type,
+		                record->rclass);
+
+		knot_rdata_t rdata[knot_rdata_array_size(record->data_length)];
+		knot_rdata_init(rdata, record->data_length, record->data,
+		                record->ttl);
+		rr.rrs.rr_count = 1;
+		rr.rrs.data = rdata;
+
+		/* Convert RDATA dnames to lowercase before adding to zone. */
+		int ret = knot_rrset_rr_to_canonical(&rr);
+		if (ret != KNOT_EOK) {
+			zc->ret = ret;
+			break;
+		}
 
-	/* Convert RDATA dnames to lowercase before adding to zone. */
-	ret = knot_rrset_rr_to_canonical(&rr);
-	if (ret != KNOT_EOK) {
-		knot_dname_free(&owner, NULL);
-		zc->ret = ret;
-		return;
+		bool nsec3 = knot_rrset_is_nsec3rel(&rr);
+		if (record->owner != node_owner || nsec3 != node_nsec3) {
+			node = NULL;
+		}
+
+		ret = zcreator_add(zc, &rr, &node);
+		if (ret != KNOT_EOK) {
+			zc->ret = ret;
+			break;
+		}
+
+		node_owner = record->owner;
+		node_nsec3 = nsec3;
 	}
 
-	zc->ret = zcreator_step(zc, &rr);
-	knot_dname_free(&owner, NULL);
-	knot_rdataset_clear(&rr.rrs, NULL);
+	if (zc->ret != KNOT_EOK) {
+		scanner->state = ZS_STATE_STOP;
+	}
 }
 
 int zonefile_open(zloader_t *loader, const char *source,
@@ -201,7 +221,8 @@ int zonefile_open(zloader_t *loader, const char *source,
 
 	if (zs_init(&loader->scanner, origin_str, KNOT_CLASS_IN, 3600) != 0 ||
 	    zs_set_input_file(&loader->scanner, source) != 0 ||
-	    zs_set_processing(&loader->scanner, process_data, process_error, zc) != 0) {
+	    zs_set_batch_processing(&loader->scanner, process_data, process_error,
+	                            0, zc) != 0) {
 		zs_deinit(&loader->scanner);
 		free(origin_str);
 		free(zc);
@@ -298,9 +319,9 @@ int zonefile_exists(const char *path, time_t *mtime)
 	return KNOT_EOK;
 }
 
-int zonefile_write(const char *path, zone_contents_t *zone)
+int zonefile_write_tmp(const char *path, zone_contents_t *zone, char **tmp_name)
 {
-	if (!zone || !path) {
+	if (!zone || !path || !tmp_name) {
 		return KNOT_EINVAL;
 	}
 
@@ -310,17 +331,33 @@ int zonefile_write(const char *path, zone_contents_t *zone)
 	}
 
 	FILE *file = NULL;
-	char *tmp_name = NULL;
-	ret = open_tmp_file(path, &tmp_name, &file, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP);
+	ret = open_tmp_file(path, tmp_name, &file, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
 
+	/* The dump is already buffered in large chunks. */
+	setvbuf(file, NULL, _IONBF, 0);
+
 	ret = zone_dump_text(zone, file, true);
-	fclose(file);
+	if (fclose(file) != 0 && ret == KNOT_EOK) {
+		ret = knot_map_errno();
+	}
+	if (ret != KNOT_EOK) {
+		unlink(*tmp_name);
+		free(*tmp_name);
+		*tmp_name = NULL;
+		return ret;
+	}
+
+	return KNOT_EOK;
+}
+
+int zonefile_write(const char *path, zone_contents_t *zone)
+{
+	char *tmp_name = NULL;
+	int ret = zonefile_write_tmp(path, zone, &tmp_name);
 	if (ret != KNOT_EOK) {
-		unlink(tmp_name);
-		free(tmp_name);
 		return ret;
 	}
 
@@ -96,6 +96,18 @@ int zonefile_exists(const char *path, time_t *mtime);
  */
 int zonefile_write(const char *path, zone_contents_t *zone);
 
+/*!
+ * \brief Write zone contents to a temporary file next to the zone file.
+ *
+ * \param path      Zonefile path.
+ * \param zone      Zone contents to write.
+ * \param tmp_name  Output name of the written file (to be renamed and freed
+ *                  by the caller).
+ *
+ * \return KNOT_E*
+ */
+int zonefile_write_tmp(const char *path, zone_contents_t *zone, char **tmp_name);
+
 /*!
  * \brief Close zone file loader.
  *
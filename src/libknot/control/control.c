@@ -37,6 +37,7 @@
 
 /*! Default socket operations timeout in milliseconds. */
 #define DEFAULT_TIMEOUT		(5 * 1000)
+#define LISTEN_BACKLOG		8
 
 /*! The first data item code. */
 #define DATA_CODE_OFFSET	16
@@ -55,6 +56,15 @@ struct knot_ctl {
 	/*! The latter read data. */
 	knot_ctl_data_t data;
 
+	/*! The latter read bulk data (NULL if not bulk). */
+	uint8_t *bulk;
+	/*! The latter read bulk data length. */
+	size_t bulk_len;
+	/*! Bulk data buffer size. */
+	size_t bulk_size;
+	/*! Indication of the latter read bulk unit. */
+	bool bulk_ready;
+
 	/*! Write wire context. */
 	wire_ctx_t wire_out;
 	/*! Read wire context. */
@@ -73,6 +83,7 @@ static int type_to_code(knot_ctl_type_t type)
 	case KNOT_CTL_TYPE_DATA:  return  1;
 	case KNOT_CTL_TYPE_EXTRA: return  2;
 	case KNOT_CTL_TYPE_BLOCK: return  3;
+	case KNOT_CTL_TYPE_BULK:  return  4;
 	default:                  return -1;
 	}
 }
@@ -84,6 +95,7 @@ static int code_to_type(uint8_t code)
 	case 1:  return KNOT_CTL_TYPE_DATA;
 	case 2:  return KNOT_CTL_TYPE_EXTRA;
 	case 3:  return KNOT_CTL_TYPE_BLOCK;
+	case 4:  return KNOT_CTL_TYPE_BULK;
 	default: return -1;
 	}
 }
@@ -174,6 +186,7 @@ void knot_ctl_free(knot_ctl_t *ctx)
 	close_sock(&ctx->sock);
 
 	clean_data(ctx);
+	free(ctx->bulk);
 
 	mp_delete(ctx->mm.ctx);
 
@@ -212,7 +225,7 @@ int knot_ctl_bind(knot_ctl_t *ctx, const char *path)
 	}
 
 	// Start listening.
-	if (listen(ctx->listen_sock, 1) != 0) {
+	if (listen(ctx->listen_sock, LISTEN_BACKLOG) != 0) {
 		close_sock(&ctx->listen_sock);
 		return knot_map_errno();
 	}
@@ -244,11 +257,17 @@ void knot_ctl_unbind(knot_ctl_t *ctx)
 _public_
 int knot_ctl_accept(knot_ctl_t *ctx)
 {
-	if (ctx == NULL) {
+	return knot_ctl_accept_client(ctx, ctx);
+}
+
+_public_
+int knot_ctl_accept_client(knot_ctl_t *ctx, knot_ctl_t *client)
+{
+	if (ctx == NULL || client == NULL) {
 		return KNOT_EINVAL;
 	}
 
-	knot_ctl_close(ctx);
+	knot_ctl_close(client);
 
 	// Control interface.
 	struct pollfd pfd = { .fd = ctx->listen_sock, .events = POLLIN };
@@ -257,14 +276,15 @@ int knot_ctl_accept(knot_ctl_t *ctx)
 		return knot_map_errno();
 	}
 
-	int client = net_accept(ctx->listen_sock, NULL);
-	if (client < 0) {
-		return client;
+	int sock = net_accept(ctx->listen_sock, NULL);
+	if (sock < 0) {
+		return sock;
 	}
 
-	ctx->sock = client;
+	client->sock = sock;
+	client->timeout = ctx->timeout;
 
-	reset_buffers(ctx);
+	reset_buffers(client);
 
 	return KNOT_EOK;
 }
@@ -390,9 +410,9 @@ int knot_ctl_send(knot_ctl_t *ctx, knot_ctl_type_t type, knot_ctl_data_t *data)
 		return KNOT_EINVAL;
 	}
 
-	// Get the type code.
+	// Get the type code (bulk units are sent separately).
 	int code = type_to_code(type);
-	if (code == -1) {
+	if (code == -1 || type == KNOT_CTL_TYPE_BULK) {
 		return KNOT_EINVAL;
 	}
 
@@ -500,6 +520,61 @@ static int receive_item_value(knot_ctl_t *ctx, char **value)
 	return KNOT_EOK;
 }
 
+static int receive_bulk(knot_ctl_t *ctx)
+{
+	wire_ctx_t *w = &ctx->wire_in;
+
+	// Read data length.
+	int ret = ensure_input(ctx, sizeof(uint32_t));
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	uint32_t data_len = wire_ctx_read_u32(w);
+	if (w->error != KNOT_EOK) {
+		return w->error;
+	}
+	if (data_len > KNOT_CTL_BULK_MAXLEN) {
+		return KNOT_EMALF;
+	}
+
+	// Reuse the data buffer.
+	if (ctx->bulk == NULL || data_len > ctx->bulk_size) {
+		size_t size = (data_len > 0) ? data_len : 1;
+		uint8_t *bulk = realloc(ctx->bulk, size);
+		if (bulk == NULL) {
+			return KNOT_ENOMEM;
+		}
+		ctx->bulk = bulk;
+		ctx->bulk_size = size;
+	}
+
+	// Take the already buffered part.
+	size_t have = wire_ctx_available(w);
+	if (have > data_len) {
+		have = data_len;
+	}
+	wire_ctx_read(w, ctx->bulk, have);
+	if (w->error != KNOT_EOK) {
+		return w->error;
+	}
+
+	// Receive the rest directly.
+	while (have < data_len) {
+		ret = net_stream_recv(ctx->sock, ctx->bulk + have, data_len - have,
+		                      ctx->timeout);
+		if (ret < 0) {
+			return ret;
+		}
+		assert(ret > 0);
+		have += ret;
+	}
+
+	ctx->bulk_len = data_len;
+	ctx->bulk_ready = true;
+
+	return KNOT_EOK;
+}
+
 _public_
 int knot_ctl_receive(knot_ctl_t *ctx, knot_ctl_type_t *type, knot_ctl_data_t *data)
 {
@@ -511,7 +586,7 @@ int knot_ctl_receive(knot_ctl_t *ctx, knot_ctl_type_t *type, knot_ctl_data_t *da
 
 	// Reset output variables.
 	*type = KNOT_CTL_TYPE_END;
-	clean_data(ctx);
+	ctx->bulk_ready = false;
 
 	// Read data units until end of message.
 	bool have_type = false;
@@ -532,12 +607,21 @@ int knot_ctl_receive(knot_ctl_t *ctx, knot_ctl_type_t *type, knot_ctl_data_t *da
 				break;
 			}
 
-			// Set the unit type.
+			// Set the unit type, bulk unit keeps the previous data.
 			*type = current_type;
+			if (current_type != KNOT_CTL_TYPE_BULK) {
+				clean_data(ctx);
+			}
 
 			if (is_data_type(current_type)) {
 				have_type = true;
 				continue;
+			} else if (current_type == KNOT_CTL_TYPE_BULK) {
+				ret = receive_bulk(ctx);
+				if (ret != KNOT_EOK) {
+					return ret;
+				}
+				break;
 			} else {
 				break;
 			}
@@ -563,3 +647,60 @@ int knot_ctl_receive(knot_ctl_t *ctx, knot_ctl_type_t *type, knot_ctl_data_t *da
 
 	return KNOT_EOK;
 }
+
+_public_
+int knot_ctl_send_bulk(knot_ctl_t *ctx, const uint8_t *data, size_t len)
+{
+	if (ctx == NULL || (data == NULL && len > 0)) {
+		return KNOT_EINVAL;
+	}
+
+	if (len > KNOT_CTL_BULK_MAXLEN) {
+		return KNOT_ERANGE;
+	}
+
+	wire_ctx_t *w = &ctx->wire_out;
+
+	// Write the unit type and the data length.
+	int ret = ensure_output(ctx, sizeof(uint8_t) + sizeof(uint32_t));
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	wire_ctx_write_u8(w, type_to_code(KNOT_CTL_TYPE_BULK));
+	wire_ctx_write_u32(w, len);
+	if (w->error != KNOT_EOK) {
+		return w->error;
+	}
+
+	// Buffer the data if they fit.
+	if (wire_ctx_available(w) >= len) {
+		wire_ctx_write(w, data, len);
+		return w->error;
+	}
+
+	// Flush the buffer and send the data directly.
+	ret = net_stream_send(ctx->sock, w->wire, wire_ctx_offset(w), ctx->timeout);
+	if (ret < 0) {
+		return ret;
+	}
+	*w = wire_ctx_init(w->wire, CTL_BUFF_SIZE);
+
+	ret = net_stream_send(ctx->sock, data, len, ctx->timeout);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return KNOT_EOK;
+}
+
+_public_
+const uint8_t *knot_ctl_bulk(knot_ctl_t *ctx, size_t *len)
+{
+	if (ctx == NULL || len == NULL || !ctx->bulk_ready) {
+		return NULL;
+	}
+
+	*len = ctx->bulk_len;
+
+	return ctx->bulk;
+}
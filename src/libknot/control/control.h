@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 /*! Control data item indexes. */
 typedef enum {
 	KNOT_CTL_IDX_CMD = 0, /*!< Control command name. */
@@ -46,8 +49,12 @@ typedef enum {
 	KNOT_CTL_TYPE_DATA,  /*!< Data unit, cached. */
 	KNOT_CTL_TYPE_EXTRA, /*!< Extra value data unit, cached. */
 	KNOT_CTL_TYPE_BLOCK, /*!< End of data block, cache flushed. */
+	KNOT_CTL_TYPE_BULK,  /*!< Binary data unit, cached. */
 } knot_ctl_type_t;
 
+/*! Maximum binary data length of a bulk unit. */
+#define KNOT_CTL_BULK_MAXLEN	(16 * 1024 * 1024)
+
 /*! Control input/output string data. */
 typedef const char* knot_ctl_data_t[KNOT_CTL_IDX__COUNT];
 
@@ -123,6 +130,21 @@ int knot_ctl_connect(knot_ctl_t *ctx, const char *path);
  */
 int knot_ctl_accept(knot_ctl_t *ctx);
 
+/*!
+ * Waits for an incoming connection and assigns it to another context.
+ *
+ * The client context inherits the timeout of the listening context. This
+ * allows more connections to be processed concurrently.
+ *
+ * \note Server operation.
+ *
+ * \param[in] ctx     Listening control context.
+ * \param[in] client  Control context for the accepted connection.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_ctl_accept_client(knot_ctl_t *ctx, knot_ctl_t *client);
+
 /*!
  * Closes the remote connections.
  *
@@ -146,6 +168,8 @@ int knot_ctl_send(knot_ctl_t *ctx, knot_ctl_type_t type, knot_ctl_data_t *data);
 /*!
  * Receives one control unit.
  *
+ * \note A bulk unit keeps the data items of the previous data unit.
+ *
  * \param[in] ctx    Control context.
  * \param[out] type  Received unit type.
  * \param[out] data  Received data unit (optional).
@@ -154,4 +178,27 @@ int knot_ctl_send(knot_ctl_t *ctx, knot_ctl_type_t type, knot_ctl_data_t *data);
  */
 int knot_ctl_receive(knot_ctl_t *ctx, knot_ctl_type_t *type, knot_ctl_data_t *data);
 
+/*!
+ * Sends one bulk unit with binary data.
+ *
+ * Large data are sent directly, bypassing the output buffer.
+ *
+ * \param[in] ctx   Control context.
+ * \param[in] data  Binary data.
+ * \param[in] len   Data length (at most KNOT_CTL_BULK_MAXLEN).
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_ctl_send_bulk(knot_ctl_t *ctx, const uint8_t *data, size_t len);
+
+/*!
+ * Returns binary data of the bulk unit received by the latter knot_ctl_receive.
+ *
+ * \param[in] ctx   Control context.
+ * \param[out] len  Data length.
+ *
+ * \return Data valid until the next receive, NULL if the unit isn't bulk.
+ */
+const uint8_t *knot_ctl_bulk(knot_ctl_t *ctx, size_t *len);
+
 /*! @} */
@@ -209,6 +209,16 @@ int knot_dname_unpack(uint8_t *dst, const knot_dname_t *src,
 }
 
 /*----------------------------------------------------------------------------*/
+/*!
+ * \brief Bitmap of characters written to the textual name as they are.
+ *
+ * Locale independent alphanumeric characters and '-', '_', '*', '/'.
+ */
+static const uint8_t plain_chars[32] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xA4, 0xFF, 0x03,
+	0xFE, 0xFF, 0xFF, 0x87, 0xFE, 0xFF, 0xFF, 0x07,
+};
+
 _public_
 char *knot_dname_to_str(char *dst, const knot_dname_t *name, size_t maxlen)
 {
@@ -232,81 +242,75 @@ char *knot_dname_to_str(char *dst, const knot_dname_t *name, size_t maxlen)
 		return NULL;
 	}
 
-	uint8_t label_len = 0;
-	size_t  str_len = 0;
-
-	for (unsigned i = 0; i < dname_size; i++) {
-		uint8_t c = name[i];
-
-		/* Read next label size. */
-		if (label_len == 0) {
-			label_len = c;
-
-			/* Write label separation. */
-			if (str_len > 0 || dname_size == 1) {
-				res[str_len++] = '.';
-			}
+	size_t str_len = 0;
 
-			continue;
-		}
+	/* Root name. */
+	if (*name == 0) {
+		res[str_len++] = '.';
+	}
 
-		if (isalnum(c) != 0 || c == '-' || c == '_' || c == '*' ||
-		    c == '/') {
-			res[str_len++] = c;
-		} else if (ispunct(c) != 0 && c != '#') {
-			/* Exclusion of '#' character is to avoid possible
-			 * collision with rdata hex notation '\#'. So it is
-			 * encoded in \ddd notation.
-			 */
+	for (const uint8_t *label = name; *label != 0; label += 1 + *label) {
+		for (uint8_t i = 1; i <= *label; i++) {
+			uint8_t c = label[i];
 
-			if (dst != NULL) {
-				if (maxlen <= str_len + 2) {
+			if (plain_chars[c / 8] & (1 << (c % 8))) {
+				if (dst != NULL && maxlen <= str_len + 1) {
 					return NULL;
 				}
-			} else {
-				/* Extend output buffer for \x format. */
-				alloc_size += 1;
-				char *extended = realloc(res, alloc_size);
-				if (extended == NULL) {
-					free(res);
-					return NULL;
+				res[str_len++] = c;
+			} else if (c > ' ' && c < 0x7F && c != '#') {
+				/* Exclusion of '#' character is to avoid possible
+				 * collision with rdata hex notation '\#'. So it is
+				 * encoded in \ddd notation.
+				 */
+
+				if (dst != NULL) {
+					if (maxlen <= str_len + 2) {
+						return NULL;
+					}
+				} else {
+					/* Extend output buffer for \x format. */
+					alloc_size += 1;
+					char *extended = realloc(res, alloc_size);
+					if (extended == NULL) {
+						free(res);
+						return NULL;
+					}
+					res = extended;
 				}
-				res = extended;
-			}
 
-			/* Write encoded character. */
-			res[str_len++] = '\\';
-			res[str_len++] = c;
-		} else {
-			if (dst != NULL) {
-				if (maxlen <= str_len + 4) {
-					return NULL;
-				}
+				/* Write encoded character. */
+				res[str_len++] = '\\';
+				res[str_len++] = c;
 			} else {
-				/* Extend output buffer for \DDD format. */
-				alloc_size += 3;
-				char *extended = realloc(res, alloc_size);
-				if (extended == NULL) {
-					free(res);
-					return NULL;
+				if (dst != NULL) {
+					if (maxlen <= str_len + 4) {
+						return NULL;
+					}
+				} else {
+					/* Extend output buffer for \DDD format. */
+					alloc_size += 3;
+					char *extended = realloc(res, alloc_size);
+					if (extended == NULL) {
+						free(res);
+						return NULL;
+					}
+					res = extended;
 				}
-				res = extended;
-			}
 
-			/* Write encoded character. */
-			int ret = snprintf(res + str_len, alloc_size - str_len,
-			                   "\\%03u", c);
-			if (ret <= 0 || ret >= alloc_size - str_len) {
-				if (dst == NULL) {
-					free(res);
-				}
-				return NULL;
+				/* Write encoded character. */
+				res[str_len++] = '\\';
+				res[str_len++] = '0' + c / 100;
+				res[str_len++] = '0' + c / 10 % 10;
+				res[str_len++] = '0' + c % 10;
 			}
-
-			str_len += ret;
 		}
 
-		label_len--;
+		/* Write label separation. */
+		if (dst != NULL && maxlen <= str_len + 1) {
+			return NULL;
+		}
+		res[str_len++] = '.';
 	}
 
 	/* String_termination. */
@@ -17,7 +17,6 @@
 #include <arpa/inet.h>
 #include <ctype.h>
 #include <inttypes.h>
-#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +33,7 @@
 #include "libknot/descriptor.h"
 #include "libknot/errcode.h"
 #include "libknot/lookup.h"
+#include "contrib/base16.h"
 #include "contrib/base32hex.h"
 #include "contrib/base64.h"
 #include "contrib/wire.h"
@@ -69,278 +69,353 @@ const knot_dump_style_t KNOT_DUMP_STYLE_DEFAULT = {
 	.ascii_to_idn = NULL
 };
 
-static void dump_string(rrset_dump_params_t *p, const char *str)
+/*! \brief Decimal representation of numbers 00 to 99. */
+static const char digit_pairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/*!
+ * \brief Writes a decimal number without termination.
+ *
+ * \note The output must have space for 20 characters.
+ *
+ * \return Length of the number.
+ */
+static size_t num_to_str(char *out, uint64_t num)
 {
-	size_t in_len = strlen(str);
+	char buf[20];
+	char *pos = buf + sizeof(buf);
 
-	// Check input size (+ 1 termination).
-	if (in_len >= p->out_max) {
-		return;
+	while (num >= 100) {
+		pos -= 2;
+		memcpy(pos, digit_pairs + 2 * (num % 100), 2);
+		num /= 100;
 	}
-
-	// Copy string including termination '\0'!
-	if (memcpy(p->out, str, in_len + 1) == NULL) {
-		return;
+	if (num >= 10) {
+		pos -= 2;
+		memcpy(pos, digit_pairs + 2 * num, 2);
+	} else {
+		*--pos = '0' + num;
 	}
 
-	// Fill in output.
-	p->out += in_len;
-	p->out_max -= in_len;
-	p->total += in_len;
-	p->ret = 0;
+	size_t len = buf + sizeof(buf) - pos;
+	memcpy(out, pos, len);
+
+	return len;
 }
 
-static void wire_num8_to_str(rrset_dump_params_t *p)
+/*!
+ * \brief Writes a fixed-point decimal number without termination.
+ *
+ * The fractional part is written only if not zero.
+ *
+ * \note The output must have space for 22 characters.
+ *
+ * \param out       Output.
+ * \param num       Number in units of 10^-decimals.
+ * \param decimals  Number of decimal places (1 to 3).
+ *
+ * \return Length of the number.
+ */
+static size_t decimal_to_str(char *out, uint64_t num, unsigned decimals)
 {
-	uint8_t data = *(p->in);
-	size_t  in_len = sizeof(data);
-	size_t  out_len = 0;
+	uint32_t scale = 1;
+	for (unsigned i = 0; i < decimals; i++) {
+		scale *= 10;
+	}
 
-	// Check input size.
-	if (in_len > p->in_max) {
-		return;
+	size_t len = num_to_str(out, num / scale);
+
+	uint32_t frac = num % scale;
+	if (frac != 0) {
+		out[len++] = '.';
+		for (unsigned i = decimals; i > 0; i--) {
+			out[len + i - 1] = '0' + frac % 10;
+			frac /= 10;
+		}
+		len += decimals;
 	}
 
-	// Write number.
-	int ret = snprintf(p->out, p->out_max, "%u", data);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
-		return;
+	return len;
+}
+
+/*!
+ * \brief Writes a 16-bit number in lower case hexadecimal without leading
+ *        zeros and termination.
+ *
+ * \return Length of the number.
+ */
+static size_t hex16_to_str(char *out, uint16_t num)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	size_t len = 0;
+	for (int shift = 12; shift >= 0; shift -= 4) {
+		if ((num >> shift) != 0 || shift == 0) {
+			out[len++] = hex[(num >> shift) & 0x0F];
+		}
 	}
-	out_len = ret;
 
-	// Fill in output.
-	p->in += in_len;
-	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
+	return len;
 }
 
-static void wire_num16_to_str(rrset_dump_params_t *p)
+/*!
+ * \brief Writes an IPv4 address in dotted-decimal notation without termination.
+ *
+ * \note The output must have space for INET_ADDRSTRLEN characters.
+ *
+ * \return Length of the address.
+ */
+static size_t ipv4_to_str(char *out, const uint8_t *addr)
 {
-	uint16_t data;
-	size_t   in_len = sizeof(data);
-	size_t   out_len = 0;
+	size_t len = num_to_str(out, addr[0]);
+	for (int i = 1; i < 4; i++) {
+		out[len++] = '.';
+		len += num_to_str(out + len, addr[i]);
+	}
 
-	// Check input size.
-	if (in_len > p->in_max) {
-		return;
+	return len;
+}
+
+/*!
+ * \brief Writes an IPv6 address without termination.
+ *
+ * The format is the same as of inet_ntop(): the first longest run of at least
+ * two zero words is compressed and IPv4-mapped and IPv4-compatible addresses
+ * end with the IPv4 address.
+ *
+ * \note The output must have space for INET6_ADDRSTRLEN characters.
+ *
+ * \return Length of the address.
+ */
+static size_t ipv6_to_str(char *out, const uint8_t *addr)
+{
+	uint16_t words[8];
+	for (int i = 0; i < 8; i++) {
+		words[i] = wire_read_u16(addr + 2 * i);
 	}
 
-	// Fill in input data.
-	data = wire_read_u16(p->in);
+	// Find the first longest run of zero words.
+	int best = -1, best_len = 0;
+	for (int i = 0; i < 8;) {
+		int j = i;
+		while (j < 8 && words[j] == 0) {
+			j++;
+		}
+		if (j - i > best_len) {
+			best = i;
+			best_len = j - i;
+		}
+		i = (j > i) ? j : i + 1;
+	}
+	if (best_len < 2) {
+		best = -1;
+	}
 
-	// Write number.
-	int ret = snprintf(p->out, p->out_max, "%u", data);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
-		return;
+	size_t len = 0;
+	for (int i = 0; i < 8; i++) {
+		// Compressed zeros.
+		if (best != -1 && i >= best && i < best + best_len) {
+			if (i == best) {
+				out[len++] = ':';
+			}
+			continue;
+		}
+		if (i != 0) {
+			out[len++] = ':';
+		}
+		// Embedded IPv4 address.
+		if (i == 6 && best == 0 &&
+		    (best_len == 6 || (best_len == 5 && words[5] == 0xFFFF))) {
+			len += ipv4_to_str(out + len, addr + 12);
+			return len;
+		}
+		len += hex16_to_str(out + len, words[i]);
+	}
+	if (best != -1 && best + best_len == 8) {
+		out[len++] = ':';
 	}
-	out_len = ret;
 
-	// Fill in output.
-	p->in += in_len;
-	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
+	return len;
 }
 
-static void wire_num32_to_str(rrset_dump_params_t *p)
+/*!
+ * \brief Writes a timestamp in YYYYMMDDhhmmss format (UTC) without termination.
+ *
+ * \note The output must have space for 14 characters.
+ *
+ * \return Length of the timestamp.
+ */
+static size_t timestamp_to_str(char *out, uint32_t timestamp)
 {
-	uint32_t data;
-	size_t   in_len = sizeof(data);
-	size_t   out_len = 0;
+	uint32_t days = timestamp / 86400;
+	uint32_t secs = timestamp % 86400;
+
+	// Civil date from the day number, years start on March 1st.
+	uint32_t z = days + 719468;
+	uint32_t era = z / 146097;
+	uint32_t doe = z - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+	uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+	uint32_t year = yoe + era * 400 + (month <= 2);
+
+	const uint32_t parts[] = { year / 100, year % 100, month, day,
+	                           secs / 3600, secs / 60 % 60, secs % 60 };
+	for (int i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+		memcpy(out + 2 * i, digit_pairs + 2 * parts[i], 2);
+	}
+
+	return 14;
+}
 
-	// Check input size.
-	if (in_len > p->in_max) {
-		return;
+/*!
+ * \brief Writes a record type mnemonic (or TYPEXXX) without termination.
+ *
+ * \note The output must have space for 16 characters.
+ *
+ * \return Length of the type.
+ */
+static size_t type_to_str(char *out, uint16_t type)
+{
+	const char *name = knot_get_rdata_descriptor(type)->type_name;
+	if (name != NULL) {
+		size_t len = strlen(name);
+		memcpy(out, name, len);
+		return len;
 	}
 
-	// Fill in input data.
-	data = wire_read_u32(p->in);
+	memcpy(out, "TYPE", 4);
+	return 4 + num_to_str(out + 4, type);
+}
 
-	// Write number.
-	int ret = snprintf(p->out, p->out_max, "%u", data);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
+/*! \brief Appends a string of the given length to the output. */
+static void dump_raw(rrset_dump_params_t *p, const char *str, size_t len)
+{
+	// Check output size (+ 1 termination).
+	if (len >= p->out_max) {
+		p->ret = -1;
 		return;
 	}
-	out_len = ret;
+
+	memcpy(p->out, str, len);
+	p->out[len] = '\0';
 
 	// Fill in output.
-	p->in += in_len;
-	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
+	p->out += len;
+	p->out_max -= len;
+	p->total += len;
 	p->ret = 0;
 }
 
-static void wire_num48_to_str(rrset_dump_params_t *p)
+static void dump_string(rrset_dump_params_t *p, const char *str)
+{
+	dump_raw(p, str, strlen(str));
+}
+
+static void wire_num_to_str(rrset_dump_params_t *p, size_t in_len)
 {
 	uint64_t data;
-	size_t   in_len = 6;
-	size_t   out_len = 0;
 
 	// Check input size.
 	if (in_len > p->in_max) {
+		p->ret = -1;
 		return;
 	}
 
 	// Fill in input data.
-	data = wire_read_u48(p->in);
+	switch (in_len) {
+	case 1:
+		data = *(p->in);
+		break;
+	case 2:
+		data = wire_read_u16(p->in);
+		break;
+	case 4:
+		data = wire_read_u32(p->in);
+		break;
+	default:
+		data = wire_read_u48(p->in);
+		break;
+	}
 
 	// Write number.
-	int ret = snprintf(p->out, p->out_max, "%"PRIu64"", data);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
+	char buf[20];
+	dump_raw(p, buf, num_to_str(buf, data));
+	if (p->ret != 0) {
 		return;
 	}
-	out_len = ret;
 
-	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
 }
 
 static void wire_ipv4_to_str(rrset_dump_params_t *p)
 {
-	struct in_addr addr4;
-	size_t in_len = sizeof(addr4.s_addr);
-	size_t out_len = 0;
+	size_t in_len = 4;
 
 	// Check input size.
 	if (in_len > p->in_max) {
-		return;
-	}
-
-	// Fill in input data.
-	if (memcpy(&(addr4.s_addr), p->in, in_len) == NULL) {
+		p->ret = -1;
 		return;
 	}
 
 	// Write address.
-	if (inet_ntop(AF_INET, &addr4, p->out, p->out_max) == NULL) {
+	char buf[INET_ADDRSTRLEN];
+	dump_raw(p, buf, ipv4_to_str(buf, p->in));
+	if (p->ret != 0) {
 		return;
 	}
-	out_len = strlen(p->out);
 
-	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
 }
 
 static void wire_ipv6_to_str(rrset_dump_params_t *p)
 {
-	struct in6_addr addr6;
-	size_t in_len = sizeof(addr6.s6_addr);
-	size_t out_len = 0;
+	size_t in_len = 16;
 
 	// Check input size.
 	if (in_len > p->in_max) {
-		return;
-	}
-
-	// Fill in input data.
-	if (memcpy(&(addr6.s6_addr), p->in, in_len) == NULL) {
+		p->ret = -1;
 		return;
 	}
 
 	// Write address.
-	if (inet_ntop(AF_INET6, &addr6, p->out, p->out_max) == NULL) {
+	char buf[INET6_ADDRSTRLEN];
+	dump_raw(p, buf, ipv6_to_str(buf, p->in));
+	if (p->ret != 0) {
 		return;
 	}
-	out_len = strlen(p->out);
 
-	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
 }
 
 static void wire_type_to_str(rrset_dump_params_t *p)
 {
-	char     type[32];
-	uint16_t data;
-	size_t   in_len = sizeof(data);
-	size_t   out_len = 0;
+	size_t in_len = sizeof(uint16_t);
 
 	// Check input size.
 	if (in_len > p->in_max) {
+		p->ret = -1;
 		return;
 	}
 
-	// Fill in input data.
-	if (memcpy(&data, p->in, in_len) == NULL) {
-		return;
-	}
-
-	// Get record type name string.
-	if (knot_rrtype_to_string(ntohs(data), type, sizeof(type)) <= 0) {
-		return;
-	}
-
-	// Write string.
-	int ret = snprintf(p->out, p->out_max, "%s", type);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
+	// Write record type name string.
+	char type[16];
+	dump_raw(p, type, type_to_str(type, wire_read_u16(p->in)));
+	if (p->ret != 0) {
 		return;
 	}
-	out_len = ret;
 
-	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
-}
-
-static int hex_encode(const uint8_t  *in,
-                      const uint32_t in_len,
-                      uint8_t        *out,
-                      const uint32_t out_len)
-{
-	static const char hex[] = "0123456789ABCDEF";
-
-	if (out_len < 2 * in_len) {
-		return -1;
-	}
-
-	for (uint32_t i = 0; i < in_len; i++) {
-		out[2 * i]     = hex[in[i] / 16];
-		out[2 * i + 1] = hex[in[i] % 16];
-	}
-
-	return 2 * in_len;
-}
-
-static int hex_encode_alloc(const uint8_t  *in,
-                            const uint32_t in_len,
-                            uint8_t        **out)
-{
-	uint32_t out_len = 2 * in_len;
-
-	// Allocating output buffer.
-	*out = malloc(out_len);
-
-	if (*out == NULL) {
-		return -1;
-	}
-
-	// Encoding data.
-	return hex_encode(in, in_len, *out, out_len);
 }
 
 typedef int (*encode_t)(const uint8_t *in, const uint32_t in_len,
@@ -454,13 +529,13 @@ static void wire_len_data_encode_to_str(rrset_dump_params_t *p,
 	if (print_len == true) {
 		switch (len_len) {
 		case 1:
-			wire_num8_to_str(p);
+			wire_num_to_str(p, 1);
 			break;
 		case 2:
-			wire_num16_to_str(p);
+			wire_num_to_str(p, 2);
 			break;
 		case 4:
-			wire_num32_to_str(p);
+			wire_num_to_str(p, 4);
 			break;
 		}
 
@@ -512,25 +587,18 @@ static void wire_len_data_encode_to_str(rrset_dump_params_t *p,
 
 static void wire_unknown_to_str(rrset_dump_params_t *p)
 {
-	int    ret;
 	size_t in_len = p->in_max;
-	size_t out_len = 0;
 
 	// Write unknown length header.
+	char header[32] = "\\# ";
+	size_t header_len = 3 + num_to_str(header + 3, in_len);
 	if (in_len > 0) {
-		ret = snprintf(p->out, p->out_max, "\\# %zu ", in_len);
-	} else {
-		ret = snprintf(p->out, p->out_max, "\\# 0");
+		header[header_len++] = ' ';
 	}
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
+	dump_raw(p, header, header_len);
+	if (p->ret != 0) {
 		return;
 	}
-	out_len = ret;
-
-	// Fill in output.
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
 
 	// Write hex data if any.
 	if (in_len > 0) {
@@ -542,7 +610,7 @@ static void wire_unknown_to_str(rrset_dump_params_t *p)
 			}
 		}
 
-		wire_data_encode_to_str(p, &hex_encode, &hex_encode_alloc);
+		wire_data_encode_to_str(p, &base16_encode, &base16_encode_alloc);
 		if (p->ret != 0) {
 			return;
 		}
@@ -590,41 +658,51 @@ static void wire_text_to_str(rrset_dump_params_t *p, bool quote, bool with_heade
 		}
 	}
 
+	// Check output size if the longest representation (\ddd) might not fit.
+	if (4 * in_len >= p->out_max) {
+		size_t out_len = 0;
+		for (size_t i = 0; i < in_len; i++) {
+			uint8_t ch = p->in[i];
+			if (ch >= ' ' && ch < 0x7F) {
+				out_len += (ch == '\\' || ch == '"') ? 2 : 1;
+			} else {
+				out_len += 4;
+			}
+		}
+		// Including termination.
+		if (out_len >= p->out_max) {
+			p->ret = -1;
+			return;
+		}
+	}
+
 	// Loop over all characters.
+	char *out = p->out;
 	for (size_t i = 0; i < in_len; i++) {
 		uint8_t ch = p->in[i];
 
-		if (isprint(ch) != 0) {
+		if (ch >= ' ' && ch < 0x7F) {
 			// For special character print leading slash.
 			if (ch == '\\' || ch == '"') {
-				dump_string(p, "\\");
-				if (p->ret != 0) {
-					return;
-				}
+				*out++ = '\\';
 			}
 
 			// Print text character.
-			if (p->out_max == 0) {
-				return;
-			}
-
-			*p->out = ch;
-			p->out++;
-			p->out_max--;
-			p->total++;
+			*out++ = ch;
 		} else {
 			// Unprintable character encode via \ddd notation.
-			int ret = snprintf(p->out, p->out_max,"\\%03u", ch);
-			if (ret <= 0 || (size_t)ret >= p->out_max) {
-				return;
-			}
-
-			p->out += ret;
-			p->out_max -= ret;
-			p->total += ret;
+			*out++ = '\\';
+			*out++ = '0' + ch / 100;
+			*out++ = '0' + ch / 10 % 10;
+			*out++ = '0' + ch % 10;
 		}
 	}
 
+	size_t out_len = out - p->out;
+	p->out += out_len;
+	p->out_max -= out_len;
+	p->total += out_len;
+
 	// Closing quotation.
 	if (quote) {
 		dump_string(p, "\"");
@@ -648,106 +726,58 @@ static void wire_text_to_str(rrset_dump_params_t *p, bool quote, bool with_heade
 
 static void wire_timestamp_to_str(rrset_dump_params_t *p)
 {
-	uint32_t data;
-	size_t   in_len = sizeof(data);
-	size_t   out_len = 0;
-	int      ret;
+	size_t in_len = sizeof(uint32_t);
 
 	// Check input size.
 	if (in_len > p->in_max) {
+		p->ret = -1;
 		return;
 	}
 
-	// Fill in input data.
-	if (memcpy(&data, p->in, in_len) == NULL) {
-		return;
-	}
-
-	time_t timestamp = ntohl(data);
+	uint32_t timestamp = wire_read_u32(p->in);
 
+	char buf[20];
+	size_t out_len;
 	if (p->style->human_tmstamp) {
-		struct tm result;
 		// Write timestamp in YYYYMMDDhhmmss format.
-		ret = strftime(p->out, p->out_max, "%Y%m%d%H%M%S",
-		               gmtime_r(&timestamp, &result));
-		if (ret == 0) {
-			return;
-		}
+		out_len = timestamp_to_str(buf, timestamp);
 	} else {
 		// Write timestamp only.
-		ret = snprintf(p->out, p->out_max, "%u", ntohl(data));
-		if (ret <= 0 || (size_t)ret >= p->out_max) {
-			return;
-		}
+		out_len = num_to_str(buf, timestamp);
+	}
+	dump_raw(p, buf, out_len);
+	if (p->ret != 0) {
+		return;
 	}
-	out_len = ret;
 
-	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
 }
 
-static int time_to_human_str(char         *out,
-                             const size_t out_len,
-                             uint32_t     data)
+/*!
+ * \brief Writes time in the human readable format (e.g. 1d2h30m) without
+ *        termination.
+ *
+ * \note The output must have space for 32 characters.
+ *
+ * \return Length of the time.
+ */
+static size_t time_to_human_str(char *out, uint32_t data)
 {
-	size_t   total_len = 0;
-	uint32_t num;
-	int      ret;
-
-	// Process days.
-	num = data / 86400;
-	if (num > 0) {
-		ret = snprintf(out + total_len, out_len - total_len,
-		               "%ud", num);
-		if (ret <= 0 || (size_t)ret >= out_len - total_len) {
-			return -1;
-		}
-
-		total_len += ret;
-		data -= num * 86400;
-	}
-
-	// Process hours.
-	num = data / 3600;
-	if (num > 0) {
-		ret = snprintf(out + total_len, out_len - total_len,
-		               "%uh", num);
-		if (ret <= 0 || (size_t)ret >= out_len - total_len) {
-			return -1;
+	static const struct {
+		uint32_t secs;
+		char unit;
+	} units[] = { { 86400, 'd' }, { 3600, 'h' }, { 60, 'm' }, { 1, 's' } };
+
+	size_t total_len = 0;
+	for (int i = 0; i < sizeof(units) / sizeof(units[0]); i++) {
+		uint32_t num = data / units[i].secs;
+		// Seconds are written if nothing else was.
+		if (num > 0 || (units[i].secs == 1 && total_len == 0)) {
+			total_len += num_to_str(out + total_len, num);
+			out[total_len++] = units[i].unit;
+			data -= num * units[i].secs;
 		}
-
-		total_len += ret;
-		data -= num * 3600;
-	}
-
-	// Process minutes.
-	num = data / 60;
-	if (num > 0) {
-		ret = snprintf(out + total_len, out_len - total_len,
-		               "%um", num);
-		if (ret <= 0 || (size_t)ret >= out_len - total_len) {
-			return -1;
-		}
-
-		total_len += ret;
-		data -= num * 60;
-	}
-
-	// Process seconds.
-	num = data;
-	if (num > 0 || total_len == 0) {
-		ret = snprintf(out + total_len, out_len - total_len,
-		               "%us", num);
-		if (ret <= 0 || (size_t)ret >= out_len - total_len) {
-			return -1;
-		}
-
-		total_len += ret;
 	}
 
 	return total_len;
@@ -755,49 +785,36 @@ static int time_to_human_str(char         *out,
 
 static void wire_ttl_to_str(rrset_dump_params_t *p)
 {
-	uint32_t data;
-	size_t   in_len = sizeof(data);
-	size_t   out_len = 0;
-	int      ret;
+	size_t in_len = sizeof(uint32_t);
 
 	// Check input size.
 	if (in_len > p->in_max) {
+		p->ret = -1;
 		return;
 	}
 
-	// Fill in input data.
-	if (memcpy(&data, p->in, in_len) == NULL) {
-		return;
-	}
+	uint32_t ttl = wire_read_u32(p->in);
 
+	char buf[32];
+	size_t out_len;
 	if (p->style->human_ttl) {
 		// Write time in human readable format.
-		ret = time_to_human_str(p->out, p->out_max, ntohl(data));
-		if (ret <= 0) {
-			return;
-		}
+		out_len = time_to_human_str(buf, ttl);
 	} else {
-		// Write timestamp only.
-		ret = snprintf(p->out, p->out_max, "%u", ntohl(data));
-		if (ret <= 0 || (size_t)ret >= p->out_max) {
-			return;
-		}
+		// Write time only.
+		out_len = num_to_str(buf, ttl);
+	}
+	dump_raw(p, buf, out_len);
+	if (p->ret != 0) {
+		return;
 	}
-	out_len = ret;
 
-	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
-	p->out += out_len;
-	p->out_max -= out_len;
-	p->total += out_len;
-	p->ret = 0;
 }
 
 static void wire_bitmap_to_str(rrset_dump_params_t *p)
 {
-	int    ret;
-	char   type[32];
 	size_t i = 0;
 	size_t in_len = p->in_max;
 	size_t out_len = 0;
@@ -820,36 +837,43 @@ static void wire_bitmap_to_str(rrset_dump_params_t *p)
 			return;
 		}
 
-		// Bitmap processing.
+		// Bitmap processing, empty bytes are skipped at once.
 		for (size_t j = 0; j < (bitmap_len * 8); j++) {
+			if (j % 8 == 0 && p->in[i + j / 8] == 0) {
+				j += 7;
+				continue;
+			}
 			if ((p->in[i + j / 8] & (128 >> (j % 8))) != 0) {
 				uint16_t type_num = win * 256 + j;
 
-				if (knot_rrtype_to_string(type_num, type,
-				                          sizeof(type)) <= 0) {
-					return;
-				}
-
 				// Print type name to type list.
+				char type[1 + 16];
+				size_t type_len = 0;
 				if (out_len > 0) {
-					ret = snprintf(p->out, p->out_max,
-					               " %s", type);
-				} else {
-					ret = snprintf(p->out, p->out_max,
-					               "%s", type);
+					type[type_len++] = ' ';
 				}
-				if (ret <= 0 || (size_t)ret >= p->out_max) {
+				type_len += type_to_str(type + type_len, type_num);
+				if (type_len >= p->out_max) {
+					p->ret = -1;
 					return;
 				}
-				out_len += ret;
-				p->out += ret;
-				p->out_max -= ret;
+				memcpy(p->out, type, type_len);
+				out_len += type_len;
+				p->out += type_len;
+				p->out_max -= type_len;
 			}
 		}
 
 		i += bitmap_len;
 	}
 
+	// String termination.
+	if (p->out_max == 0) {
+		p->ret = -1;
+		return;
+	}
+	*p->out = '\0';
+
 	// Fill in output.
 	p->in += in_len;
 	p->in_max -= in_len;
@@ -996,8 +1020,6 @@ static void wire_apl_to_str(rrset_dump_params_t *p)
 
 static void wire_loc_to_str(rrset_dump_params_t *p)
 {
-	int    ret;
-
 	// Read values.
 	wire_ctx_t wire = wire_ctx_init_const(p->in, p->in_max);
 	uint8_t version = wire_ctx_read_u8(&wire);
@@ -1021,86 +1043,70 @@ static void wire_loc_to_str(rrset_dump_params_t *p)
 		return;
 	}
 
-	p->in += wire_ctx_offset(&wire);
-	p->in_max = wire_ctx_available(&wire);
-
-	// Latitude calculation.
-	char lat_mark;
-	uint32_t lat;
-	if (lat_w >= LOC_ZERO) {
-		lat_mark = 'N';
-		lat = lat_w - LOC_ZERO;
-	} else {
-		lat_mark = 'S';
-		lat = LOC_ZERO - lat_w;
-	}
-
-	uint32_t d1 = lat / 3600000;
-	uint32_t m1 = (lat - 3600000 * d1) / 60000;
-	double s1 = 0.001 * (lat - 3600000 * d1 - 60000 * m1);
-
-	// Longitude calculation.
-	char lon_mark;
-	uint32_t lon;
-	if (lon_w >= LOC_ZERO) {
-		lon_mark = 'E';
-		lon = lon_w - LOC_ZERO;
-	} else {
-		lon_mark = 'W';
-		lon = LOC_ZERO - lon_w;
-	}
-
-	uint32_t d2 = lon / 3600000;
-	uint32_t m2 = (lon - 3600000 * d2) / 60000;
-	double s2 = 0.001 * (lon - 3600000 * d2 - 60000 * m2);
-
-	// Write latitude and longitude.
-	ret = snprintf(p->out, p->out_max, "%u %u %.*f %c  %u %u %.*f %c",
-	               d1, m1, (uint32_t)s1 != s1 ? 3 : 0, s1, lat_mark,
-	               d2, m2, (uint32_t)s2 != s2 ? 3 : 0, s2, lon_mark);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
-		return;
+	// Sizes check.
+	uint8_t sizes[] = { size_w, hpre_w, vpre_w };
+	for (int i = 0; i < sizeof(sizes); i++) {
+		if ((sizes[i] >> 4) > 9 || (sizes[i] & 0xF) > 9) {
+			return;
+		}
 	}
-	p->out += ret;
-	p->out_max -= ret;
-	p->total += ret;
-
-	// Altitude calculation.
-	double alt = 0.01 * alt_w - 100000.0;
 
-	// Compute mantisa and exponent for each size.
-	uint8_t size_m = size_w >> 4;
-	uint8_t size_e = size_w & 0xF;
-	uint8_t hpre_m = hpre_w >> 4;
-	uint8_t hpre_e = hpre_w & 0xF;
-	uint8_t vpre_m = vpre_w >> 4;
-	uint8_t vpre_e = vpre_w & 0xF;
+	p->in += wire_ctx_offset(&wire);
+	p->in_max = wire_ctx_available(&wire);
 
-	// Sizes check.
-	if (size_m > 9 || size_e > 9 || hpre_m > 9 || hpre_e > 9 ||
-	    vpre_m > 9 || vpre_e > 9) {
-		return;
-	}
+	char buf[128];
+	size_t len = 0;
 
-	// Size and precisions calculation.
-	double size = 0.01 * size_m * pow(10, size_e);
-	double hpre = 0.01 * hpre_m * pow(10, hpre_e);
-	double vpre = 0.01 * vpre_m * pow(10, vpre_e);
+	// Latitude and longitude calculation.
+	const uint32_t angles_w[] = { lat_w, lon_w };
+	const char marks[][2] = { { 'N', 'S' }, { 'E', 'W' } };
+	for (int i = 0; i < 2; i++) {
+		char mark;
+		uint32_t angle;
+		if (angles_w[i] >= LOC_ZERO) {
+			mark = marks[i][0];
+			angle = angles_w[i] - LOC_ZERO;
+		} else {
+			mark = marks[i][1];
+			angle = LOC_ZERO - angles_w[i];
+		}
 
-	// Write altitude and precisions.
-	ret = snprintf(p->out, p->out_max, "  %.*fm  %.*fm %.*fm %.*fm",
-	               (int32_t)alt != alt ? 2 : 0, alt,
-	               (uint32_t)size != size ? 2 : 0, size,
-	               (uint32_t)hpre != hpre ? 2 : 0, hpre,
-	               (uint32_t)vpre != vpre ? 2 : 0, vpre);
-	if (ret <= 0 || (size_t)ret >= p->out_max) {
-		return;
+		// Degrees, minutes and seconds with up to 3 decimal places.
+		len += num_to_str(buf + len, angle / 3600000);
+		buf[len++] = ' ';
+		len += num_to_str(buf + len, angle / 60000 % 60);
+		buf[len++] = ' ';
+		len += decimal_to_str(buf + len, angle % 60000, 3);
+		buf[len++] = ' ';
+		buf[len++] = mark;
+		buf[len++] = ' ';
+		buf[len++] = ' ';
+	}
+
+	// Altitude in centimeters with the offset.
+	int64_t alt = (int64_t)alt_w - 10000000;
+	if (alt < 0) {
+		buf[len++] = '-';
+		alt = -alt;
+	}
+	len += decimal_to_str(buf + len, alt, 2);
+	buf[len++] = 'm';
+
+	// Size and precisions in centimeters (mantissa and exponent).
+	for (int i = 0; i < sizeof(sizes); i++) {
+		uint64_t size = sizes[i] >> 4;
+		for (int e = sizes[i] & 0xF; e > 0; e--) {
+			size *= 10;
+		}
+		if (i == 0) {
+			buf[len++] = ' ';
+		}
+		buf[len++] = ' ';
+		len += decimal_to_str(buf + len, size, 2);
+		buf[len++] = 'm';
 	}
-	p->out += ret;
-	p->out_max -= ret;
-	p->total += ret;
 
-	p->ret = 0;
+	dump_raw(p, buf, len);
 }
 
 static void wire_gateway_to_str(rrset_dump_params_t *p)
@@ -1114,7 +1120,7 @@ static void wire_gateway_to_str(rrset_dump_params_t *p)
 	uint8_t alg = *(p->in + 1);
 
 	// Write gateway type.
-	wire_num8_to_str(p);
+	wire_num_to_str(p, 1);
 	if (p->ret != 0) {
 		return;
 	}
@@ -1126,7 +1132,7 @@ static void wire_gateway_to_str(rrset_dump_params_t *p)
 	}
 
 	// Write algorithm number.
-	wire_num8_to_str(p);
+	wire_num_to_str(p, 1);
 	if (p->ret != 0) {
 		return;
 	}
@@ -1188,7 +1194,7 @@ static void wire_l64_to_str(rrset_dump_params_t *p)
 
 	// Write identifier (2-byte) labels separated with a colon.
 	while (p->in_max > 0) {
-		int ret = hex_encode(p->in, 2, (uint8_t *)(p->out), p->out_max);
+		int ret = base16_encode(p->in, 2, (uint8_t *)(p->out), p->out_max);
 		if (ret <= 0) {
 			return;
 		}
@@ -1219,7 +1225,7 @@ static void wire_eui_to_str(rrset_dump_params_t *p)
 
 	// Write EUI hexadecimal pairs.
 	while (p->in_max > 0) {
-		int ret = hex_encode(p->in, 1, (uint8_t *)(p->out), p->out_max);
+		int ret = base16_encode(p->in, 1, (uint8_t *)(p->out), p->out_max);
 		if (ret <= 0) {
 			return;
 		}
@@ -1355,7 +1361,8 @@ static void dnskey_info(const uint8_t *rdata,
 #define DUMP_PARAMS	rrset_dump_params_t *const p
 #define	DUMP_END	return (p->in_max == 0 ? (int)p->total : KNOT_EPARSEFAIL);
 
-#define CHECK_RET(p)	if (p->ret != 0) return -1;
+/*! \brief Check the last step and require the next one to succeed explicitly. */
+#define CHECK_RET(p)	if (p->ret != 0) return -1; p->ret = -1;
 
 #define WRAP_INIT	dump_string(p, "(" BLOCK_INDENT); CHECK_RET(p);
 #define WRAP_END	dump_string(p, BLOCK_INDENT ")"); CHECK_RET(p);
@@ -1367,27 +1374,27 @@ static void dnskey_info(const uint8_t *rdata,
 			}
 
 #define DUMP_SPACE	dump_string(p, " "); CHECK_RET(p);
-#define DUMP_NUM8	wire_num8_to_str(p); CHECK_RET(p);
-#define DUMP_NUM16	wire_num16_to_str(p); CHECK_RET(p);
-#define DUMP_NUM32	wire_num32_to_str(p); CHECK_RET(p);
-#define DUMP_NUM48	wire_num48_to_str(p); CHECK_RET(p);
+#define DUMP_NUM8	wire_num_to_str(p, 1); CHECK_RET(p);
+#define DUMP_NUM16	wire_num_to_str(p, 2); CHECK_RET(p);
+#define DUMP_NUM32	wire_num_to_str(p, 4); CHECK_RET(p);
+#define DUMP_NUM48	wire_num_to_str(p, 6); CHECK_RET(p);
 #define DUMP_DNAME	wire_dname_to_str(p); CHECK_RET(p);
 #define DUMP_TIME	wire_ttl_to_str(p); CHECK_RET(p);
 #define DUMP_TIMESTAMP	wire_timestamp_to_str(p); CHECK_RET(p);
 #define DUMP_IPV4	wire_ipv4_to_str(p); CHECK_RET(p);
 #define DUMP_IPV6	wire_ipv6_to_str(p); CHECK_RET(p);
 #define DUMP_TYPE	wire_type_to_str(p); CHECK_RET(p);
-#define DUMP_HEX	wire_data_encode_to_str(p, &hex_encode, \
-				&hex_encode_alloc); CHECK_RET(p);
+#define DUMP_HEX	wire_data_encode_to_str(p, &base16_encode, \
+				&base16_encode_alloc); CHECK_RET(p);
 #define DUMP_BASE64	wire_data_encode_to_str(p, &base64_encode, \
 				&base64_encode_alloc); CHECK_RET(p);
 #define DUMP_HASH	wire_len_data_encode_to_str(p, &base32hex_encode, \
 				1, false, ""); CHECK_RET(p);
-#define DUMP_SALT	wire_len_data_encode_to_str(p, &hex_encode, \
+#define DUMP_SALT	wire_len_data_encode_to_str(p, &base16_encode, \
 				1, false, "-"); CHECK_RET(p);
 #define DUMP_TSIG_DGST	wire_len_data_encode_to_str(p, &base64_encode, \
 				2, true, ""); CHECK_RET(p);
-#define DUMP_TSIG_DATA	wire_len_data_encode_to_str(p, &hex_encode, \
+#define DUMP_TSIG_DATA	wire_len_data_encode_to_str(p, &base16_encode, \
 				2, true, ""); CHECK_RET(p);
 #define DUMP_TEXT	wire_text_to_str(p, true, true); CHECK_RET(p);
 #define DUMP_LONG_TEXT	wire_text_to_str(p, true, false); CHECK_RET(p);
@@ -1913,11 +1920,6 @@ int knot_rrset_txt_dump_data(const knot_rrset_t      *rrset,
 	return ret;
 }
 
-#define SNPRINTF_CHECK(ret, max_len)			\
-	if ((ret) < 0 || (size_t)(ret) >= (max_len)) {	\
-		return KNOT_ESPACE;			\
-	}
-
 _public_
 int knot_rrset_txt_dump_header(const knot_rrset_t      *rrset,
                                const uint32_t          ttl,
@@ -1929,111 +1931,136 @@ int knot_rrset_txt_dump_header(const knot_rrset_t      *rrset,
 		return KNOT_EINVAL;
 	}
 
-	size_t len = 0;
-	char   buf[32];
-	int    ret;
+	rrset_dump_params_t p = {
+		.style = style,
+		.out = dst,
+		.out_max = maxlen,
+		.total = 0,
+		.ret = -1
+	};
 
 	// Dump rrset owner.
-	char *name = knot_dname_to_str_alloc(rrset->owner);
-	if (style->ascii_to_idn != NULL) {
+	size_t name_len;
+	if (style->ascii_to_idn == NULL) {
+		if (knot_dname_to_str(p.out, rrset->owner, p.out_max) == NULL) {
+			return KNOT_ESPACE;
+		}
+		name_len = strlen(p.out);
+		p.out += name_len;
+		p.out_max -= name_len;
+		p.total += name_len;
+	} else {
+		char *name = knot_dname_to_str_alloc(rrset->owner);
+		if (name == NULL) {
+			return KNOT_ESPACE;
+		}
 		style->ascii_to_idn(&name);
+		name_len = strlen(name);
+		dump_raw(&p, name, name_len);
+		free(name);
+		if (p.ret != 0) {
+			return KNOT_ESPACE;
+		}
+	}
+
+	// Align the owner to 20 characters.
+	char buf[32] = "                    ";
+	size_t len = name_len < 20 ? 20 - name_len : 0;
+	buf[len++] = name_len < 4 * TAB_WIDTH ? '\t' : ' ';
+	dump_raw(&p, buf, len);
+	if (p.ret != 0) {
+		return KNOT_ESPACE;
 	}
-	char sep = strlen(name) < 4 * TAB_WIDTH ? '\t' : ' ';
-	ret = snprintf(dst + len, maxlen - len, "%-20s%c", name, sep);
-	free(name);
-	SNPRINTF_CHECK(ret, maxlen - len);
-	len += ret;
 
 	// Set white space separation character.
-	sep = style->wrap ? ' ' : '\t';
+	char sep = style->wrap ? ' ' : '\t';
 
 	// Dump rrset ttl.
 	if (style->show_ttl) {
 		if (style->empty_ttl) {
-			ret = snprintf(dst + len, maxlen - len, "%c", sep);
+			len = 0;
 		} else if (style->human_ttl) {
 			// Create human readable ttl string.
-			if (time_to_human_str(buf, sizeof(buf), ttl) < 0) {
-				return KNOT_ESPACE;
-			}
-			ret = snprintf(dst + len, maxlen - len, "%s%c",
-			               buf, sep);
+			len = time_to_human_str(buf, ttl);
 		} else {
-			ret = snprintf(dst + len, maxlen - len, "%u%c", ttl, sep);
+			len = num_to_str(buf, ttl);
+		}
+		buf[len++] = sep;
+		dump_raw(&p, buf, len);
+		if (p.ret != 0) {
+			return KNOT_ESPACE;
 		}
-		SNPRINTF_CHECK(ret, maxlen - len);
-		len += ret;
 	}
 
 	// Dump rrset class.
 	if (style->show_class) {
-		if (knot_rrclass_to_string(rrset->rclass, buf, sizeof(buf)) < 0) {
+		int ret = knot_rrclass_to_string(rrset->rclass, buf, sizeof(buf));
+		if (ret < 0) {
+			return KNOT_ESPACE;
+		}
+		len = ret;
+		while (len < 2) {
+			buf[len++] = ' ';
+		}
+		buf[len++] = sep;
+		dump_raw(&p, buf, len);
+		if (p.ret != 0) {
 			return KNOT_ESPACE;
 		}
-		ret = snprintf(dst + len, maxlen - len, "%-2s%c", buf, sep);
-		SNPRINTF_CHECK(ret, maxlen - len);
-		len += ret;
 	}
 
 	// Dump rrset type.
 	if (style->generic) {
-		if (snprintf(buf, sizeof(buf), "TYPE%u", rrset->type) < 0) {
-			return KNOT_ESPACE;
-		}
-	} else if (knot_rrtype_to_string(rrset->type, buf, sizeof(buf)) < 0) {
-		return KNOT_ESPACE;
+		memcpy(buf, "TYPE", 4);
+		len = 4 + num_to_str(buf + 4, rrset->type);
+	} else {
+		len = type_to_str(buf, rrset->type);
 	}
 	if (rrset->rrs.rr_count > 0) {
-		ret = snprintf(dst + len, maxlen - len, "%s%c", buf, sep);
-	} else {
-		ret = snprintf(dst + len, maxlen - len, "%s", buf);
+		buf[len++] = sep;
+	}
+	dump_raw(&p, buf, len);
+	if (p.ret != 0) {
+		return KNOT_ESPACE;
 	}
-	SNPRINTF_CHECK(ret, maxlen - len);
-	len += ret;
 
-	return len;
+	return p.total;
 }
 
-static int rrset_txt_dump(const knot_rrset_t      *rrset,
-                          char                    *dst,
-                          const size_t            maxlen,
-                          const knot_dump_style_t *style)
+_public_
+int knot_rrset_txt_dump_rr(const knot_rrset_t      *rrset,
+                           const size_t            pos,
+                           char                    *dst,
+                           const size_t            maxlen,
+                           const knot_dump_style_t *style)
 {
-	if (rrset == NULL || dst == NULL || style == NULL) {
+	if (rrset == NULL || dst == NULL || style == NULL ||
+	    pos >= rrset->rrs.rr_count) {
 		return KNOT_EINVAL;
 	}
 
-	size_t len = 0;
-
-	dst[0] = '\0';
-
-	// Loop over rdata in rrset.
-	uint16_t rr_count = rrset->rrs.rr_count;
-	for (uint16_t i = 0; i < rr_count; i++) {
-		// Dump rdata owner, class, ttl and type.
-		const knot_rdata_t *rr_data = knot_rdataset_at(&rrset->rrs, i);
-		int ret = knot_rrset_txt_dump_header(rrset, knot_rdata_ttl(rr_data),
-		                                     dst + len, maxlen - len, style);
-		if (ret < 0) {
-			return KNOT_ESPACE;
-		}
-		len += ret;
+	// Dump rdata owner, class, ttl and type.
+	const knot_rdata_t *rr_data = knot_rdataset_at(&rrset->rrs, pos);
+	int ret = knot_rrset_txt_dump_header(rrset, knot_rdata_ttl(rr_data),
+	                                     dst, maxlen, style);
+	if (ret < 0) {
+		return KNOT_ESPACE;
+	}
+	size_t len = ret;
 
-		// Dump rdata as such.
-		ret = knot_rrset_txt_dump_data(rrset, i, dst + len,
-		                               maxlen - len, style);
-		if (ret < 0) {
-			return KNOT_ESPACE;
-		}
-		len += ret;
+	// Dump rdata as such.
+	ret = knot_rrset_txt_dump_data(rrset, pos, dst + len, maxlen - len, style);
+	if (ret < 0) {
+		return KNOT_ESPACE;
+	}
+	len += ret;
 
-		// Terminate line.
-		if (len >= maxlen) {
-			return KNOT_ESPACE;
-		}
-		dst[len++] = '\n';
-		dst[len] = '\0';
+	// Terminate line.
+	if (len + 1 >= maxlen) {
+		return KNOT_ESPACE;
 	}
+	dst[len++] = '\n';
+	dst[len] = '\0';
 
 	return len;
 }
@@ -2044,13 +2071,25 @@ int knot_rrset_txt_dump(const knot_rrset_t      *rrset,
                         size_t                  *dst_size,
                         const knot_dump_style_t *style)
 {
-	if (dst == NULL || dst_size == NULL) {
+	if (rrset == NULL || dst == NULL || dst_size == NULL || *dst == NULL ||
+	    style == NULL) {
 		return KNOT_EINVAL;
 	}
 
-	while (1) {
-		int ret = rrset_txt_dump(rrset, *dst, *dst_size, style);
-		if (ret != KNOT_ESPACE) {
+	size_t len = 0;
+
+	(*dst)[0] = '\0';
+
+	// Append rdata in rrset, enlarge the output if needed.
+	uint16_t rr_count = rrset->rrs.rr_count;
+	for (uint16_t i = 0; i < rr_count;) {
+		int ret = knot_rrset_txt_dump_rr(rrset, i, *dst + len,
+		                                 *dst_size - len, style);
+		if (ret >= 0) {
+			len += ret;
+			i++;
+			continue;
+		} else if (ret != KNOT_ESPACE) {
 			return ret;
 		}
 
@@ -2059,13 +2098,14 @@ int knot_rrset_txt_dump(const knot_rrset_t      *rrset,
 			return KNOT_ESPACE;
 		}
 
-		char * new_dst = malloc(new_dst_size);
+		char *new_dst = realloc(*dst, new_dst_size);
 		if (new_dst == NULL) {
 			return KNOT_ENOMEM;
 		}
 
-		free(*dst);
 		*dst = new_dst;
 		*dst_size = new_dst_size;
 	}
+
+	return len;
 }
@@ -89,9 +89,34 @@ int knot_rrset_txt_dump_data(const knot_rrset_t      *rrset,
                              const size_t            maxlen,
                              const knot_dump_style_t *style);
 
+/*!
+ * \brief Dumps one record of the rrset as a complete text line.
+ *
+ * The output is appended to the buffer without any reallocation, so many
+ * records can be formatted into one shared buffer.
+ *
+ * \param rrset		RRset to dump.
+ * \param pos		Position of the record to dump.
+ * \param dst		Output buffer.
+ * \param maxlen	Output buffer size.
+ * \param style		Output style.
+ *
+ * \retval output length	if success.
+ * \retval KNOT_ESPACE		if the buffer is too small.
+ * \retval < 0			if other error.
+ */
+int knot_rrset_txt_dump_rr(const knot_rrset_t      *rrset,
+                           const size_t            pos,
+                           char                    *dst,
+                           const size_t            maxlen,
+                           const knot_dump_style_t *style);
+
 /*!
  * \brief Dumps rrset, re-allocates dst to double (4x, 8x, ...) if too small.
  *
+ * Records are appended to the output, the already dumped ones are kept
+ * when the buffer is re-allocated.
+ *
  * \param rrset		RRset to dump.
  * \param dst		Output buffer.
  * \param dst_size	Output buffer size (changed if *dst re-allocated).
@@ -0,0 +1,667 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libknot/libknot.h"
+#include "utils/common/msg.h"
+#include "utils/common/netio.h"
+#include "utils/common/params.h"
+#include "contrib/strtonum.h"
+
+#if USE_DNSTAP
+# include "contrib/dnstap/convert.h"
+# include "contrib/dnstap/reader.h"
+#endif // USE_DNSTAP
+
+#define PROGRAM_NAME	"kbench"
+
+#define DEFAULT_INFLIGHT	100
+#define DEFAULT_WAIT		2
+#define MAX_INFLIGHT		65535
+#define ID_SLOTS		65536
+#define BURST			64
+#define NSEC_PER_SEC		1000000000ULL
+
+/*! \brief Query message to replay. */
+typedef struct {
+	uint8_t *wire;
+	uint16_t len;
+} query_msg_t;
+
+/*! \brief Set of queries to replay. */
+typedef struct {
+	query_msg_t *msgs;
+	size_t count;
+	size_t max;
+} query_set_t;
+
+/*! \brief Benchmark parameters. */
+typedef struct {
+	const char *server;
+	const char *port;
+	int socktype;
+	uint32_t rate;          /*!< Target rate in queries per second (0 = max). */
+	uint32_t inflight;      /*!< Maximum number of outstanding queries. */
+	uint32_t duration;      /*!< Sending time limit in seconds (0 = none). */
+	uint32_t limit;         /*!< Number of queries to send (0 = query set). */
+	uint32_t wait;          /*!< Response timeout in seconds. */
+	bool edns;              /*!< Add EDNS to queries from a text list. */
+	bool dnstap;            /*!< Input is a dnstap file. */
+} bench_params_t;
+
+/*! \brief Outstanding query slot, indexed by the message ID. */
+typedef struct {
+	uint64_t sent_at;
+	bool pending;
+} slot_t;
+
+/*! \brief Benchmark results. */
+typedef struct {
+	uint64_t sent;
+	uint64_t send_failed;
+	uint64_t received;
+	uint64_t lost;
+	uint64_t unexpected;
+	uint64_t truncated;
+	uint64_t rcodes[16];
+	uint32_t *latency;      /*!< Response latencies in microseconds. */
+	size_t latency_max;
+	uint64_t start;
+	uint64_t end;
+} bench_stats_t;
+
+static volatile bool interrupted = false;
+
+static void interrupt_handler(int signum)
+{
+	interrupted = true;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void print_help(void)
+{
+	printf("Usage: %s [parameters] <input>\n"
+	       "\n"
+	       "Parameters:\n"
+	       " -s, --server <address>   Server address. (default %s)\n"
+	       " -p, --port <port>        Server port. (default %s)\n"
+	       " -T, --tcp                Use TCP (one pipelined connection).\n"
+	       " -r, --rate <qps>         Target query rate. (default maximum)\n"
+	       " -q, --inflight <count>   Maximum outstanding queries. (default %u)\n"
+	       " -l, --duration <sec>     Sending time limit.\n"
+	       " -n, --count <count>      Number of queries to send. (default input size)\n"
+	       " -t, --timeout <sec>      Response timeout. (default %u)\n"
+	       " -e, --edns               Add EDNS to queries from a text list.\n"
+	       " -D, --dnstap             Replay queries from a dnstap file.\n"
+	       " -h, --help               Print the program help.\n"
+	       " -V, --version            Print the program version.\n"
+	       "\n"
+	       "Text input contains one query per line: <name> [<type>]\n",
+	       PROGRAM_NAME, DEFAULT_IPV4_NAME, DEFAULT_DNS_PORT,
+	       DEFAULT_INFLIGHT, DEFAULT_WAIT);
+}
+
+static int query_set_add(query_set_t *set, const uint8_t *wire, size_t len)
+{
+	if (len < KNOT_WIRE_HEADER_SIZE || len > MAX_PACKET_SIZE) {
+		return KNOT_EMALF;
+	}
+
+	if (set->count == set->max) {
+		size_t max = (set->max == 0) ? 1024 : 2 * set->max;
+		query_msg_t *msgs = realloc(set->msgs, max * sizeof(*msgs));
+		if (msgs == NULL) {
+			return KNOT_ENOMEM;
+		}
+		set->msgs = msgs;
+		set->max = max;
+	}
+
+	query_msg_t *msg = &set->msgs[set->count];
+	msg->wire = malloc(len);
+	if (msg->wire == NULL) {
+		return KNOT_ENOMEM;
+	}
+	memcpy(msg->wire, wire, len);
+	msg->len = len;
+	set->count++;
+
+	return KNOT_EOK;
+}
+
+static void query_set_clear(query_set_t *set)
+{
+	for (size_t i = 0; i < set->count; i++) {
+		free(set->msgs[i].wire);
+	}
+	free(set->msgs);
+	memset(set, 0, sizeof(*set));
+}
+
+static int put_query(query_set_t *set, knot_pkt_t *pkt, const char *name,
+                     const char *type, bool edns)
+{
+	uint16_t qtype = KNOT_RRTYPE_A;
+	if (type != NULL && knot_rrtype_from_string(type, &qtype) != 0) {
+		return KNOT_EINVAL;
+	}
+
+	knot_dname_t *qname = knot_dname_from_str_alloc(name);
+	if (qname == NULL) {
+		return KNOT_EINVAL;
+	}
+	knot_dname_to_lower(qname);
+
+	knot_pkt_clear(pkt);
+	int ret = knot_pkt_put_question(pkt, qname, KNOT_CLASS_IN, qtype);
+	knot_dname_free(&qname, NULL);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	if (edns) {
+		knot_rrset_t opt_rr;
+		ret = knot_edns_init(&opt_rr, DEFAULT_EDNS_SIZE, 0, 0, &pkt->mm);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		knot_pkt_begin(pkt, KNOT_ADDITIONAL);
+		ret = knot_pkt_put(pkt, KNOT_COMPR_HINT_NONE, &opt_rr, KNOT_PF_FREE);
+		if (ret != KNOT_EOK) {
+			knot_rrset_clear(&opt_rr, &pkt->mm);
+			return ret;
+		}
+	}
+
+	return query_set_add(set, pkt->wire, pkt->size);
+}
+
+static int load_text(query_set_t *set, const char *path, bool edns)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		ERR("can't open input file '%s'\n", path);
+		return KNOT_EFILE;
+	}
+
+	knot_pkt_t *pkt = knot_pkt_new(NULL, MAX_PACKET_SIZE, NULL);
+	if (pkt == NULL) {
+		fclose(file);
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	char *line = NULL;
+	size_t line_size = 0;
+	size_t line_num = 0;
+	while (getline(&line, &line_size, file) != -1) {
+		line_num++;
+
+		char *save = NULL;
+		char *name = strtok_r(line, SEP_CHARS, &save);
+		if (name == NULL || name[0] == '#') {
+			continue;
+		}
+		char *type = strtok_r(NULL, SEP_CHARS, &save);
+
+		ret = put_query(set, pkt, name, type, edns);
+		if (ret != KNOT_EOK) {
+			ERR("invalid query on line %zu (%s)\n", line_num,
+			    knot_strerror(ret));
+			break;
+		}
+	}
+
+	free(line);
+	knot_pkt_free(&pkt);
+	fclose(file);
+
+	return ret;
+}
+
+static int load_dnstap(query_set_t *set, const char *path)
+{
+#if USE_DNSTAP
+	dt_reader_t *reader = dt_reader_create(path);
+	if (reader == NULL) {
+		ERR("can't open input file '%s'\n", path);
+		return KNOT_EFILE;
+	}
+
+	int ret = KNOT_EOK;
+	while (ret == KNOT_EOK) {
+		Dnstap__Dnstap *frame = NULL;
+		ret = dt_reader_read(reader, &frame);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+
+		/* Replay only queries received by the server. */
+		Dnstap__Message *message = frame->message;
+		if (frame->type == DNSTAP__DNSTAP__TYPE__MESSAGE &&
+		    message->has_query_message &&
+		    !dt_message_role_is_initiator(message->type)) {
+			ret = query_set_add(set, message->query_message.data,
+			                    message->query_message.len);
+			if (ret == KNOT_EMALF) {
+				WARN("ignoring malformed dnstap query\n");
+				ret = KNOT_EOK;
+			}
+		}
+
+		dt_reader_free_frame(reader, &frame);
+	}
+
+	dt_reader_free(reader);
+
+	return (ret == KNOT_EOF) ? KNOT_EOK : ret;
+#else
+	ERR("no dnstap support but -D was specified\n");
+	return KNOT_ENOTSUP;
+#endif // USE_DNSTAP
+}
+
+/*! \brief Drop outstanding queries without response in time. */
+static void expire_slots(slot_t *slots, uint64_t *oldest, uint64_t sent,
+                         uint64_t now, uint64_t timeout, uint32_t *inflight,
+                         bench_stats_t *stats)
+{
+	while (*oldest < sent) {
+		slot_t *slot = &slots[*oldest % ID_SLOTS];
+		if (slot->pending) {
+			if (now - slot->sent_at < timeout) {
+				break;
+			}
+			slot->pending = false;
+			(*inflight)--;
+			stats->lost++;
+		}
+		(*oldest)++;
+	}
+}
+
+static void process_response(const uint8_t *wire, int len, slot_t *slots,
+                             uint32_t *inflight, bench_stats_t *stats)
+{
+	if (len < KNOT_WIRE_HEADER_SIZE || !knot_wire_get_qr(wire)) {
+		stats->unexpected++;
+		return;
+	}
+
+	slot_t *slot = &slots[knot_wire_get_id(wire)];
+	if (!slot->pending) {
+		stats->unexpected++;
+		return;
+	}
+	slot->pending = false;
+	(*inflight)--;
+
+	uint64_t latency = (now_ns() - slot->sent_at) / 1000;
+	if (stats->received < stats->latency_max) {
+		stats->latency[stats->received] = (latency > UINT32_MAX) ?
+		                                  UINT32_MAX : latency;
+	}
+	stats->received++;
+	stats->rcodes[knot_wire_get_rcode(wire)]++;
+	if (knot_wire_get_tc(wire)) {
+		stats->truncated++;
+	}
+}
+
+static int run(const bench_params_t *params, const query_set_t *set,
+               net_t *net, bench_stats_t *stats)
+{
+	uint64_t limit = params->limit;
+	if (limit == 0) {
+		limit = (params->duration > 0) ? UINT64_MAX : set->count;
+	}
+
+	/* Latency samples are kept for the first responses only if unlimited. */
+	stats->latency_max = (limit < (1 << 24)) ? limit : (1 << 24);
+	stats->latency = malloc(stats->latency_max * sizeof(uint32_t));
+	slot_t *slots = calloc(ID_SLOTS, sizeof(slot_t));
+	uint8_t *buf = malloc(MAX_PACKET_SIZE);
+	if (stats->latency == NULL || slots == NULL || buf == NULL) {
+		free(slots);
+		free(buf);
+		return KNOT_ENOMEM;
+	}
+
+	const uint64_t timeout = params->wait * NSEC_PER_SEC;
+	const uint64_t interval = (params->rate > 0) ? NSEC_PER_SEC / params->rate : 0;
+	uint64_t oldest = 0;
+	uint32_t inflight = 0;
+	int ret = KNOT_EOK;
+
+	stats->start = now_ns();
+	uint64_t stop_at = (params->duration > 0) ?
+	                   stats->start + params->duration * NSEC_PER_SEC : UINT64_MAX;
+	uint64_t next_send = stats->start;
+	bool sending = (limit > 0);
+
+	while (!interrupted && (sending || inflight > 0)) {
+		uint64_t now = now_ns();
+		if (now >= stop_at) {
+			sending = false;
+		}
+
+		/* Send a burst of queries allowed by the rate and window. */
+		for (int i = 0; sending && i < BURST; i++) {
+			if (inflight >= params->inflight || now < next_send) {
+				break;
+			}
+
+			const query_msg_t *msg = &set->msgs[stats->sent % set->count];
+			slot_t *slot = &slots[stats->sent % ID_SLOTS];
+			if (slot->pending) {
+				slot->pending = false;
+				inflight--;
+				stats->lost++;
+			}
+
+			memcpy(buf, msg->wire, msg->len);
+			knot_wire_set_id(buf, stats->sent % ID_SLOTS);
+			slot->sent_at = now_ns();
+			if (net_send(net, buf, msg->len) == KNOT_EOK) {
+				slot->pending = true;
+				inflight++;
+			} else {
+				stats->send_failed++;
+			}
+			stats->sent++;
+			next_send += interval;
+			if (stats->sent == limit) {
+				sending = false;
+			}
+		}
+
+		expire_slots(slots, &oldest, stats->sent, now_ns(), timeout,
+		             &inflight, stats);
+
+		/* Wait for responses until the next query is due. */
+		int wait_ms = 100;
+		if (sending && inflight < params->inflight) {
+			uint64_t ts = now_ns();
+			wait_ms = (next_send > ts) ? (next_send - ts) / 1000000 : 0;
+		}
+
+		struct pollfd pfd = { .fd = net->sockfd, .events = POLLIN };
+		for (int i = 0; i < BURST && poll(&pfd, 1, wait_ms) == 1; i++) {
+			int len = net_receive(net, buf, MAX_PACKET_SIZE);
+			if (len < 0) {
+				/* Stream broken, outstanding queries are lost. */
+				if (net->socktype == SOCK_STREAM) {
+					ret = len;
+					stats->lost += inflight;
+					inflight = 0;
+					sending = false;
+					break;
+				}
+				continue;
+			}
+			process_response(buf, len, slots, &inflight, stats);
+			wait_ms = 0;
+		}
+	}
+
+	stats->end = now_ns();
+	stats->lost += inflight;
+
+	free(slots);
+	free(buf);
+
+	return ret;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void print_stats(bench_stats_t *stats, const char *remote)
+{
+	double elapsed = (stats->end - stats->start) / (double)NSEC_PER_SEC;
+	if (elapsed <= 0) {
+		elapsed = 1e-9;
+	}
+	double sent = (stats->sent > 0) ? stats->sent : 1;
+	double received = (stats->received > 0) ? stats->received : 1;
+
+	printf("Benchmark of %s, %.02f seconds\n", remote, elapsed);
+	printf("  queries sent:     %"PRIu64" (%.0f QPS)\n",
+	       stats->sent, stats->sent / elapsed);
+	printf("  responses:        %"PRIu64" (%.0f QPS, %.02f%%)\n",
+	       stats->received, stats->received / elapsed,
+	       100.0 * stats->received / sent);
+	printf("  lost:             %"PRIu64" (%.02f%%)\n",
+	       stats->lost, 100.0 * stats->lost / sent);
+	if (stats->send_failed > 0) {
+		printf("  send failures:    %"PRIu64"\n", stats->send_failed);
+	}
+	if (stats->unexpected > 0) {
+		printf("  unexpected:       %"PRIu64"\n", stats->unexpected);
+	}
+	printf("  truncated:        %"PRIu64" (%.02f%%)\n",
+	       stats->truncated, 100.0 * stats->truncated / received);
+
+	if (stats->received == 0) {
+		return;
+	}
+
+	printf("Response codes:\n");
+	for (int i = 0; i < 16; i++) {
+		if (stats->rcodes[i] == 0) {
+			continue;
+		}
+		const knot_lookup_t *rcode = knot_lookup_by_id(knot_rcode_names, i);
+		if (rcode != NULL) {
+			printf("  %-16s  %"PRIu64" (%.02f%%)\n", rcode->name,
+			       stats->rcodes[i], 100.0 * stats->rcodes[i] / received);
+		} else {
+			printf("  RCODE%-11i  %"PRIu64" (%.02f%%)\n", i,
+			       stats->rcodes[i], 100.0 * stats->rcodes[i] / received);
+		}
+	}
+
+	size_t samples = (stats->received < stats->latency_max) ?
+	                 stats->received : stats->latency_max;
+	if (samples == 0) {
+		return;
+	}
+
+	qsort(stats->latency, samples, sizeof(uint32_t), cmp_u32);
+
+	uint64_t sum = 0;
+	for (size_t i = 0; i < samples; i++) {
+		sum += stats->latency[i];
+	}
+
+	const double pcts[] = { 50, 90, 99, 99.9 };
+	printf("Latency (microseconds):\n");
+	printf("  min %u, avg %.0f", stats->latency[0], (double)sum / samples);
+	for (int i = 0; i < sizeof(pcts) / sizeof(*pcts); i++) {
+		size_t idx = (pcts[i] * samples) / 100;
+		if (idx >= samples) {
+			idx = samples - 1;
+		}
+		printf(", p%g %u", pcts[i], stats->latency[idx]);
+	}
+	printf(", max %u\n", stats->latency[samples - 1]);
+}
+
+int main(int argc, char *argv[])
+{
+	bench_params_t params = {
+		.server = DEFAULT_IPV4_NAME,
+		.port = DEFAULT_DNS_PORT,
+		.socktype = SOCK_DGRAM,
+		.inflight = DEFAULT_INFLIGHT,
+		.wait = DEFAULT_WAIT
+	};
+
+	/* Long options. */
+	struct option opts[] = {
+		{ "server",   required_argument, NULL, 's' },
+		{ "port",     required_argument, NULL, 'p' },
+		{ "tcp",      no_argument,       NULL, 'T' },
+		{ "rate",     required_argument, NULL, 'r' },
+		{ "inflight", required_argument, NULL, 'q' },
+		{ "duration", required_argument, NULL, 'l' },
+		{ "count",    required_argument, NULL, 'n' },
+		{ "timeout",  required_argument, NULL, 't' },
+		{ "edns",     no_argument,       NULL, 'e' },
+		{ "dnstap",   no_argument,       NULL, 'D' },
+		{ "help",     no_argument,       NULL, 'h' },
+		{ "version",  no_argument,       NULL, 'V' },
+		{ NULL }
+	};
+
+	int opt = 0;
+	while ((opt = getopt_long(argc, argv, "s:p:Tr:q:l:n:t:eDhV", opts, NULL)) != -1) {
+		int ret = KNOT_EOK;
+		switch (opt) {
+		case 's':
+			params.server = optarg;
+			break;
+		case 'p':
+			params.port = optarg;
+			break;
+		case 'T':
+			params.socktype = SOCK_STREAM;
+			break;
+		case 'r':
+			ret = str_to_u32(optarg, &params.rate);
+			break;
+		case 'q':
+			ret = str_to_u32(optarg, &params.inflight);
+			if (params.inflight == 0 || params.inflight > MAX_INFLIGHT) {
+				ret = KNOT_ERANGE;
+			}
+			break;
+		case 'l':
+			ret = str_to_u32(optarg, &params.duration);
+			break;
+		case 'n':
+			ret = str_to_u32(optarg, &params.limit);
+			break;
+		case 't':
+			ret = str_to_u32(optarg, &params.wait);
+			if (params.wait == 0 || params.wait > INT_MAX / 1000) {
+				ret = KNOT_ERANGE;
+			}
+			break;
+		case 'e':
+			params.edns = true;
+			break;
+		case 'D':
+			params.dnstap = true;
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		case 'V':
+			print_version(PROGRAM_NAME);
+			return EXIT_SUCCESS;
+		default:
+			print_help();
+			return EXIT_FAILURE;
+		}
+
+		if (ret != KNOT_EOK) {
+			ERR("invalid value '%s' of parameter -%c\n", optarg, opt);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		print_help();
+		return EXIT_FAILURE;
+	}
+
+	query_set_t set = { NULL };
+	int ret = params.dnstap ? load_dnstap(&set, argv[optind]) :
+	                          load_text(&set, argv[optind], params.edns);
+	if (ret != KNOT_EOK) {
+		query_set_clear(&set);
+		return EXIT_FAILURE;
+	}
+	if (set.count == 0) {
+		ERR("no queries in '%s'\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	srv_info_t *remote = srv_info_create(params.server, params.port);
+	if (remote == NULL) {
+		query_set_clear(&set);
+		return EXIT_FAILURE;
+	}
+
+	net_t net;
+	ret = net_init(NULL, remote, AF_UNSPEC, params.socktype, params.wait,
+	               NULL, &net);
+	if (ret == KNOT_EOK) {
+		ret = net_connect(&net);
+	}
+	if (ret != KNOT_EOK) {
+		ERR("can't connect to %s@%s (%s)\n", params.server, params.port,
+		    knot_strerror(ret));
+		net_clean(&net);
+		srv_info_free(remote);
+		query_set_clear(&set);
+		return EXIT_FAILURE;
+	}
+
+	struct sigaction sa = { .sa_handler = interrupt_handler };
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	bench_stats_t stats = { 0 };
+	ret = run(&params, &set, &net, &stats);
+	if (ret == KNOT_ENOMEM) {
+		ERR("not enough memory\n");
+	} else {
+		if (ret != KNOT_EOK) {
+			WARN("connection to %s failed (%s)\n", net.remote_str,
+			     knot_strerror(ret));
+		}
+		print_stats(&stats, net.remote_str);
+	}
+
+	free(stats.latency);
+	net_close(&net);
+	net_clean(&net);
+	srv_info_free(remote);
+	query_set_clear(&set);
+
+	return (ret == KNOT_EOK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,6 +14,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +28,7 @@
 #include "knot/zone/zone-load.h"
 #include "contrib/macros.h"
 #include "contrib/string.h"
+#include "contrib/wire_ctx.h"
 #include "contrib/openbsd/strlcat.h"
 #include "utils/knotc/commands.h"
 #include "utils/knotc/estimator.h"
@@ -45,6 +47,7 @@
 #define CMD_ZONE_RETRANSFER	"zone-retransfer"
 #define CMD_ZONE_FLUSH		"zone-flush"
 #define CMD_ZONE_SIGN		"zone-sign"
+#define CMD_ZONE_KEYS_LOAD	"zone-keys-load"
 
 #define CMD_ZONE_READ		"zone-read"
 #define CMD_ZONE_BEGIN		"zone-begin"
@@ -55,6 +58,8 @@
 #define CMD_ZONE_SET		"zone-set"
 #define CMD_ZONE_UNSET		"zone-unset"
 #define CMD_ZONE_PURGE		"zone-purge"
+#define CMD_ZONE_IMPORT		"zone-import"
+#define CMD_ZONE_EXPORT		"zone-export"
 
 #define CMD_CONF_INIT		"conf-init"
 #define CMD_CONF_CHECK		"conf-check"
@@ -216,6 +221,7 @@ static void format_data(ctl_cmd_t cmd, knot_ctl_type_t data_type,
 	case CTL_ZONE_RETRANSFER:
 	case CTL_ZONE_FLUSH:
 	case CTL_ZONE_SIGN:
+	case CTL_ZONE_KEYS_LOAD:
 	case CTL_ZONE_BEGIN:
 	case CTL_ZONE_COMMIT:
 	case CTL_ZONE_ABORT:
@@ -318,6 +324,7 @@ static void format_block(ctl_cmd_t cmd, bool failed, bool empty)
 	case CTL_ZONE_RETRANSFER:
 	case CTL_ZONE_FLUSH:
 	case CTL_ZONE_SIGN:
+	case CTL_ZONE_KEYS_LOAD:
 	case CTL_ZONE_BEGIN:
 	case CTL_ZONE_COMMIT:
 	case CTL_ZONE_ABORT:
@@ -367,6 +374,9 @@ static int ctl_receive(cmd_args_t *args)
 		case KNOT_CTL_TYPE_EXTRA:
 			format_data(args->desc->cmd, type, &data, &empty);
 			break;
+		case KNOT_CTL_TYPE_BULK:
+			// Binary data are processed by the specific command.
+			continue;
 		default:
 			assert(0);
 			return KNOT_EINVAL;
@@ -711,6 +721,255 @@ static int cmd_zone_node_ctl(cmd_args_t *args)
 	return ctl_receive(args);
 }
 
+typedef struct {
+	knot_ctl_t *ctl;
+	int ret;
+	size_t len;
+	uint8_t wire[CTL_BULK_SIZE];
+} import_ctx_t;
+
+static int import_flush(import_ctx_t *ctx)
+{
+	if (ctx->len == 0) {
+		return KNOT_EOK;
+	}
+
+	int ret = knot_ctl_send_bulk(ctx->ctl, ctx->wire, ctx->len);
+	ctx->len = 0;
+
+	return ret;
+}
+
+static void import_record(zs_scanner_t *s)
+{
+	import_ctx_t *ctx = s->process.data;
+
+	size_t rr_size = s->r_owner_length + 3 * sizeof(uint16_t) +
+	                 sizeof(uint32_t) + s->r_data_length;
+	if (sizeof(ctx->wire) - ctx->len < rr_size) {
+		ctx->ret = import_flush(ctx);
+	}
+
+	// Write the record in the wire format.
+	wire_ctx_t w = wire_ctx_init(ctx->wire + ctx->len, sizeof(ctx->wire) - ctx->len);
+	wire_ctx_write(&w, s->r_owner, s->r_owner_length);
+	wire_ctx_write_u16(&w, s->r_type);
+	wire_ctx_write_u16(&w, s->r_class);
+	wire_ctx_write_u32(&w, s->r_ttl);
+	wire_ctx_write_u16(&w, s->r_data_length);
+	wire_ctx_write(&w, s->r_data, s->r_data_length);
+	if (ctx->ret == KNOT_EOK) {
+		ctx->ret = w.error;
+	}
+
+	if (ctx->ret != KNOT_EOK) {
+		s->state = ZS_STATE_STOP;
+		return;
+	}
+
+	ctx->len += wire_ctx_offset(&w);
+}
+
+static void import_error(zs_scanner_t *s)
+{
+	log_error("failed to parse zone file, line %"PRIu64" (%s)",
+	          s->line_counter, zs_errorname(s->error.code));
+
+	s->state = ZS_STATE_STOP;
+}
+
+static int cmd_zone_import(cmd_args_t *args)
+{
+	int ret = check_args(args, 2, 2);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_ctl_data_t data = {
+		[KNOT_CTL_IDX_CMD] = ctl_cmd_to_str(args->desc->cmd),
+		[KNOT_CTL_IDX_FLAGS] = CTL_FLAG_BULK,
+		[KNOT_CTL_IDX_ZONE] = args->argv[0]
+	};
+
+	import_ctx_t *ctx = malloc(sizeof(*ctx));
+	zs_scanner_t *zs = malloc(sizeof(*zs));
+	if (ctx == NULL || zs == NULL) {
+		free(ctx);
+		free(zs);
+		return KNOT_ENOMEM;
+	}
+	ctx->ctl = args->ctl;
+	ctx->ret = KNOT_EOK;
+	ctx->len = 0;
+
+	if (zs_init(zs, args->argv[0], KNOT_CLASS_IN, 3600) != 0 ||
+	    zs_set_processing(zs, import_record, import_error, ctx) != 0 ||
+	    zs_set_input_file(zs, args->argv[1]) != 0) {
+		log_error("failed to open zone file '%s' (%s)", args->argv[1],
+		          zs_errorname(zs->error.code));
+		zs_deinit(zs);
+		free(zs);
+		free(ctx);
+		return KNOT_EPARSEFAIL;
+	}
+
+	ret = knot_ctl_send(args->ctl, KNOT_CTL_TYPE_DATA, &data);
+	if (ret != KNOT_EOK) {
+		log_error(CTL_LOG_STR" (%s)", knot_strerror(ret));
+		goto import_failed;
+	}
+
+	// Stream the records, the server stores them in the open transaction.
+	bool parsed = (zs_parse_all(zs) == 0);
+	ret = ctx->ret;
+	if (ret == KNOT_EOK) {
+		ret = import_flush(ctx);
+	}
+	if (ret != KNOT_EOK) {
+		log_error(CTL_LOG_STR" (%s)", knot_strerror(ret));
+		goto import_failed;
+	}
+
+	// Finish the stream with an empty bulk unit and the input block.
+	ret = knot_ctl_send_bulk(args->ctl, NULL, 0);
+	if (ret == KNOT_EOK) {
+		ret = knot_ctl_send(args->ctl, KNOT_CTL_TYPE_BLOCK, NULL);
+	}
+	if (ret != KNOT_EOK) {
+		log_error(CTL_LOG_STR" (%s)", knot_strerror(ret));
+		goto import_failed;
+	}
+
+	ret = ctl_receive(args);
+	if (ret == KNOT_EOK && !parsed) {
+		ret = KNOT_EPARSEFAIL;
+	}
+
+import_failed:
+	zs_deinit(zs);
+	free(zs);
+	free(ctx);
+
+	return ret;
+}
+
+static int export_bulk(FILE *file, const uint8_t *wire, size_t len,
+                       char **buf, size_t *buf_size)
+{
+	size_t pos = 0;
+	while (pos < len) {
+		knot_rrset_t rr;
+		int ret = knot_rrset_rr_from_wire(wire, &pos, len, NULL, &rr, false);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		ret = knot_rrset_txt_dump(&rr, buf, buf_size, &KNOT_DUMP_STYLE_DEFAULT);
+		knot_rrset_clear(&rr, NULL);
+		if (ret < 0) {
+			return ret;
+		}
+
+		if (fputs(*buf, file) == EOF) {
+			return knot_map_errno();
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static int cmd_zone_export(cmd_args_t *args)
+{
+	int ret = check_args(args, 2, 2);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_ctl_data_t data = {
+		[KNOT_CTL_IDX_CMD] = ctl_cmd_to_str(args->desc->cmd),
+		[KNOT_CTL_IDX_FLAGS] = CTL_FLAG_BULK,
+		[KNOT_CTL_IDX_ZONE] = args->argv[0]
+	};
+
+	size_t buf_size = 512;
+	char *buf = malloc(buf_size);
+	if (buf == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	FILE *file = fopen(args->argv[1], "w");
+	if (file == NULL) {
+		ret = knot_map_errno();
+		log_error("failed to open file '%s' (%s)", args->argv[1],
+		          knot_strerror(ret));
+		free(buf);
+		return ret;
+	}
+
+	ret = knot_ctl_send(args->ctl, KNOT_CTL_TYPE_DATA, &data);
+	if (ret == KNOT_EOK) {
+		ret = knot_ctl_send(args->ctl, KNOT_CTL_TYPE_BLOCK, NULL);
+	}
+	if (ret != KNOT_EOK) {
+		log_error(CTL_LOG_STR" (%s)", knot_strerror(ret));
+		fclose(file);
+		free(buf);
+		return ret;
+	}
+
+	int dump_ret = KNOT_EOK;
+	bool failed = false;
+
+	// Write the received records until the end of the answer block.
+	while (true) {
+		knot_ctl_type_t type;
+		ret = knot_ctl_receive(args->ctl, &type, &data);
+		if (ret != KNOT_EOK) {
+			log_error(CTL_LOG_STR" (%s)", knot_strerror(ret));
+			break;
+		}
+
+		if (type == KNOT_CTL_TYPE_BULK) {
+			size_t len = 0;
+			const uint8_t *wire = knot_ctl_bulk(args->ctl, &len);
+			if (dump_ret == KNOT_EOK) {
+				dump_ret = export_bulk(file, wire, len, &buf, &buf_size);
+			}
+		} else if (type == KNOT_CTL_TYPE_DATA || type == KNOT_CTL_TYPE_EXTRA) {
+			if (data[KNOT_CTL_IDX_ERROR] != NULL) {
+				log_zone_str_error(args->argv[0], "export (%s)",
+				                   data[KNOT_CTL_IDX_ERROR]);
+				failed = true;
+			}
+		} else if (type == KNOT_CTL_TYPE_BLOCK) {
+			break;
+		} else {
+			log_error(CTL_LOG_STR" (%s)", knot_strerror(KNOT_EMALF));
+			ret = KNOT_EMALF;
+			break;
+		}
+	}
+
+	free(buf);
+	if (fclose(file) != 0 && dump_ret == KNOT_EOK) {
+		dump_ret = knot_map_errno();
+	}
+
+	if (ret != KNOT_EOK) {
+		return ret;
+	} else if (dump_ret != KNOT_EOK) {
+		log_error("failed to write file '%s' (%s)", args->argv[1],
+		          knot_strerror(dump_ret));
+		return dump_ret;
+	} else if (failed) {
+		return KNOT_ERROR;
+	}
+
+	log_info("OK");
+
+	return KNOT_EOK;
+}
+
 static int cmd_conf_init(cmd_args_t *args)
 {
 	int ret = check_args(args, 0, 0);
@@ -879,6 +1138,7 @@ const cmd_desc_t cmd_table[] = {
 	{ CMD_ZONE_RETRANSFER, cmd_zone_ctl,      CTL_ZONE_RETRANSFER, CMD_FOPT_ZONE },
 	{ CMD_ZONE_FLUSH,      cmd_zone_ctl,      CTL_ZONE_FLUSH,      CMD_FOPT_ZONE },
 	{ CMD_ZONE_SIGN,       cmd_zone_ctl,      CTL_ZONE_SIGN,       CMD_FOPT_ZONE },
+	{ CMD_ZONE_KEYS_LOAD,  cmd_zone_ctl,      CTL_ZONE_KEYS_LOAD,  CMD_FOPT_ZONE },
 
 	{ CMD_ZONE_READ,       cmd_zone_node_ctl, CTL_ZONE_READ,       CMD_FREQ_ZONE },
 	{ CMD_ZONE_BEGIN,      cmd_zone_ctl,      CTL_ZONE_BEGIN,      CMD_FREQ_ZONE | CMD_FOPT_ZONE },
@@ -889,6 +1149,8 @@ const cmd_desc_t cmd_table[] = {
 	{ CMD_ZONE_SET,        cmd_zone_node_ctl, CTL_ZONE_SET,        CMD_FREQ_ZONE },
 	{ CMD_ZONE_UNSET,      cmd_zone_node_ctl, CTL_ZONE_UNSET,      CMD_FREQ_ZONE },
 	{ CMD_ZONE_PURGE,      cmd_zone_ctl,      CTL_ZONE_PURGE,      CMD_FREQ_ZONE },
+	{ CMD_ZONE_IMPORT,     cmd_zone_import,   CTL_ZONE_SET,        CMD_FREQ_ZONE },
+	{ CMD_ZONE_EXPORT,     cmd_zone_export,   CTL_ZONE_READ,       CMD_FREQ_ZONE },
 
 	{ CMD_CONF_INIT,       cmd_conf_init,     CTL_NONE,            CMD_FWRITE },
 	{ CMD_CONF_CHECK,      cmd_conf_check,    CTL_NONE,            CMD_FREAD },
@@ -921,6 +1183,7 @@ static const cmd_help_t cmd_help_table[] = {
 	{ CMD_ZONE_RETRANSFER, "[<zone>...]",                            "Force slave zone retransfer (no serial check)." },
 	{ CMD_ZONE_FLUSH,      "[<zone>...]",                            "Flush zone journal into the zone file." },
 	{ CMD_ZONE_SIGN,       "[<zone>...]",                            "Re-sign the automatically signed zone." },
+	{ CMD_ZONE_KEYS_LOAD,  "[<zone>...]",                            "Re-load keys from KASP database, sign the zone." },
 	{ "",                  "",                                       "" },
 	{ CMD_ZONE_READ,       "<zone> [<owner> [<type>]]",              "Get zone data that are currently being presented." },
 	{ CMD_ZONE_BEGIN,      "<zone>...",                              "Begin a zone transaction." },
@@ -931,6 +1194,8 @@ static const cmd_help_t cmd_help_table[] = {
 	{ CMD_ZONE_SET,        "<zone>  <owner> [<ttl>] <type> <rdata>", "Add zone record within the transaction." },
 	{ CMD_ZONE_UNSET,      "<zone>  <owner> [<type> [<rdata>]]",     "Remove zone data within the transaction." },
 	{ CMD_ZONE_PURGE,      "<zone>...",                              "Purge zone data, file, journal, and timers." },
+	{ CMD_ZONE_IMPORT,     "<zone>  <filename>",                     "Add zone file records within the transaction." },
+	{ CMD_ZONE_EXPORT,     "<zone>  <filename>",                     "Write zone data being presented into a file." },
 	{ "",                  "",                                       "" },
 	{ CMD_CONF_INIT,       "",                                       "Initialize the confdb. (*)" },
 	{ CMD_CONF_CHECK,      "",                                       "Check the server configuration. (*)" },
@@ -40,7 +40,10 @@
 #include "knot/common/process.h"
 #include "knot/server/server.h"
 #include "knot/server/tcp-handler.h"
+#include "knot/worker/pool.h"
 #include "knot/zone/timers.h"
+#include "contrib/net.h"
+#include "contrib/sockaddr.h"
 
 #define PROGRAM_NAME "knotd"
 
@@ -213,6 +216,66 @@ static void setup_capabilities(void)
 #endif /* HAVE_CAP_NG_H */
 }
 
+/*! \brief Control connections processing context. */
+typedef struct {
+	server_t *server;
+	worker_pool_t *workers;
+	const char *listen;
+} ctl_loop_t;
+
+/*! \brief Accepted control connection. */
+typedef struct {
+	task_t task;
+	knot_ctl_t *ctl;
+	ctl_loop_t *loop;
+} ctl_client_t;
+
+/*! \brief Wake up the event loop waiting for a connection. */
+static void ctl_wake(const char *listen)
+{
+	struct sockaddr_storage addr;
+	if (sockaddr_set(&addr, AF_UNIX, listen, 0) != KNOT_EOK) {
+		return;
+	}
+
+	int sock = net_connected_socket(SOCK_STREAM, (struct sockaddr *)&addr, NULL);
+	if (sock >= 0) {
+		close(sock);
+	}
+}
+
+static void ctl_client_run(task_t *task)
+{
+	ctl_client_t *client = task->ctx;
+
+	int ret = ctl_process(client->ctl, client->loop->server);
+	knot_ctl_free(client->ctl);
+
+	if (ret == KNOT_CTL_ESTOP) {
+		sig_req_stop = true;
+		ctl_wake(client->loop->listen);
+	}
+
+	free(client);
+}
+
+static int ctl_dispatch(ctl_loop_t *loop, knot_ctl_t *ctl)
+{
+	ctl_client_t *client = malloc(sizeof(*client));
+	if (client == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	client->task.ctx = client;
+	client->task.run = ctl_client_run;
+	client->ctl = ctl;
+	client->loop = loop;
+
+	worker_pool_assign(loop->workers, &client->task);
+
+	return KNOT_EOK;
+}
+
 /*! \brief Event loop listening for signals and remote commands. */
 static void event_loop(server_t *server, char *socket)
 {
@@ -230,7 +293,21 @@ static void event_loop(server_t *server, char *socket)
 	if (ctl == NULL) {
 		log_fatal("control, failed to initialize (%s)",
 		          knot_strerror(KNOT_ENOMEM));
-		return;
+		goto finish;
+	}
+
+	/* Control connections are processed concurrently. */
+	conf_val_t workers_val = conf_get(conf(), C_CTL, C_WORKERS);
+	ctl_loop_t loop = {
+		.server = server,
+		.workers = worker_pool_create(conf_int(&workers_val)),
+		.listen = listen
+	};
+	if (loop.workers == NULL) {
+		log_fatal("control, failed to initialize (%s)",
+		          knot_strerror(KNOT_ENOMEM));
+		knot_ctl_free(ctl);
+		goto finish;
 	}
 
 	// Set control timeout.
@@ -241,19 +318,19 @@ static void event_loop(server_t *server, char *socket)
 	/* Bind the control socket. */
 	int ret = knot_ctl_bind(ctl, listen);
 	if (ret != KNOT_EOK) {
-		knot_ctl_free(ctl);
 		log_fatal("control, failed to bind socket '%s' (%s)",
 		          listen, knot_strerror(ret));
-		return;
+		worker_pool_destroy(loop.workers);
+		knot_ctl_free(ctl);
+		goto finish;
 	}
 
-	if (socket == NULL) {
-		free(listen);
-	}
+	worker_pool_start(loop.workers);
 
 	enable_signals();
 
 	/* Run event loop. */
+	knot_ctl_t *client = NULL;
 	for (;;) {
 		/* Interrupts. */
 		if (sig_req_stop) {
@@ -261,27 +338,53 @@ static void event_loop(server_t *server, char *socket)
 		}
 		if (sig_req_reload) {
 			sig_req_reload = false;
+			pthread_rwlock_wrlock(&server->ctl_lock);
 			server_reload(server);
+			pthread_rwlock_unlock(&server->ctl_lock);
 		}
 
 		// Update control timeout.
 		knot_ctl_set_timeout(ctl, conf()->cache.ctl_timeout);
 
-		ret = knot_ctl_accept(ctl);
-		if (ret != KNOT_EOK) {
+		if (client == NULL) {
+			client = knot_ctl_alloc();
+			if (client == NULL) {
+				log_error("control, failed to accept (%s)",
+				          knot_strerror(KNOT_ENOMEM));
+				break;
+			}
+		}
+
+		ret = knot_ctl_accept_client(ctl, client);
+		if (ret != KNOT_EOK || sig_req_stop) {
 			continue;
 		}
 
-		ret = ctl_process(ctl, server);
-		knot_ctl_close(ctl);
-		if (ret == KNOT_CTL_ESTOP) {
-			break;
+		ret = ctl_dispatch(&loop, client);
+		if (ret != KNOT_EOK) {
+			log_error("control, failed to process (%s)",
+			          knot_strerror(ret));
+			knot_ctl_close(client);
+			continue;
 		}
+		client = NULL;
 	}
+	knot_ctl_free(client);
+
+	/* Let the pending commands finish. */
+	worker_pool_wait(loop.workers);
+	worker_pool_stop(loop.workers);
+	worker_pool_join(loop.workers);
+	worker_pool_destroy(loop.workers);
 
 	/* Unbind the control socket. */
 	knot_ctl_unbind(ctl);
 	knot_ctl_free(ctl);
+
+finish:
+	if (socket == NULL) {
+		free(listen);
+	}
 }
 
 static void print_help(void)
@@ -555,7 +658,11 @@ int main(int argc, char **argv)
 	server_wait(&server);
 
 	log_info("updating zone timers database");
-	write_timer_db(server.timers_db, server.zone_db);
+	ret = timers_writer_flush(server.timers);
+	if (ret != KNOT_EOK) {
+		log_error("failed to update zone timers database (%s)",
+		          knot_strerror(ret));
+	}
 
 	/* Cleanup PID file. */
 	pid_cleanup();
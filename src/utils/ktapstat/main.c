@@ -0,0 +1,670 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libknot/libknot.h"
+#include "utils/common/msg.h"
+#include "utils/common/params.h"
+#include "contrib/dnstap/fields.h"
+#include "contrib/dnstap/mmap_reader.h"
+#include "contrib/macros.h"
+#include "contrib/qp-trie/qp.h"
+#include "contrib/sockaddr.h"
+#include "contrib/strtonum.h"
+#include "contrib/wire.h"
+
+#define PROGRAM_NAME	"ktapstat"
+
+#define DEFAULT_TOP		10
+#define MAX_THREADS		256
+#define LATENCY_BUCKETS		32
+#define TYPE_COUNT		65536
+#define RCODE_COUNT		16
+
+/*! \brief Dnstap.Type of the message frames. */
+#define DNSTAP_TYPE_MESSAGE	1
+
+/*! \brief Analysis parameters. */
+typedef struct {
+	uint32_t threads;
+	uint32_t top;
+	bool responses;       /*!< Analyze responses instead of queries. */
+} stat_params_t;
+
+/*! \brief Statistics of a part of the capture. */
+typedef struct {
+	uint64_t frames;
+	uint64_t queries;
+	uint64_t responses;
+	uint64_t other;
+	uint64_t malformed;
+	uint64_t analyzed;
+	trie_t *names;        /*!< Counters by the lower-case wire QNAME. */
+	trie_t *clients;      /*!< Counters by the raw client address. */
+	uint64_t *types;      /*!< Counters by the QTYPE. */
+	uint64_t rcodes[RCODE_COUNT];
+	uint64_t latency[LATENCY_BUCKETS]; /*!< Powers of two microseconds. */
+	uint64_t latency_count;
+} stats_t;
+
+/*! \brief Analysis thread context. */
+typedef struct {
+	pthread_t thread;
+	const dt_mmap_reader_t *reader;
+	const stat_params_t *params;
+	size_t begin;
+	size_t end;
+	int ret;
+	stats_t stats;
+} worker_t;
+
+/*! \brief Counter item for the sorting. */
+typedef struct {
+	const char *key;
+	size_t len;
+	uint64_t count;
+} item_t;
+
+static void print_help(void)
+{
+	printf("Usage: %s [parameters] <capture>\n"
+	       "\n"
+	       "Parameters:\n"
+	       " -t, --threads <count>    Number of analysis threads. (default CPU count)\n"
+	       " -n, --top <count>        Number of the most frequent items. (default %u)\n"
+	       " -R, --responses          Analyze responses instead of queries.\n"
+	       " -h, --help               Print the program help.\n"
+	       " -V, --version            Print the program version.\n",
+	       PROGRAM_NAME, DEFAULT_TOP);
+}
+
+static int stats_init(stats_t *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	stats->names = trie_create(NULL);
+	stats->clients = trie_create(NULL);
+	stats->types = calloc(TYPE_COUNT, sizeof(uint64_t));
+	if (stats->names == NULL || stats->clients == NULL || stats->types == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	return KNOT_EOK;
+}
+
+static void stats_deinit(stats_t *stats)
+{
+	if (stats->names != NULL) {
+		trie_free(stats->names);
+	}
+	if (stats->clients != NULL) {
+		trie_free(stats->clients);
+	}
+	free(stats->types);
+}
+
+static int count_key(trie_t *trie, const void *key, size_t len, uint64_t count)
+{
+	trie_val_t *val = trie_get_ins(trie, key, len);
+	if (val == NULL) {
+		return KNOT_ENOMEM;
+	}
+	*val = (void *)((uintptr_t)*val + count);
+
+	return KNOT_EOK;
+}
+
+static unsigned latency_bucket(uint64_t usec)
+{
+	unsigned bucket = 0;
+	while (usec > 0 && bucket < LATENCY_BUCKETS - 1) {
+		usec >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static uint64_t time_usec(const dt_field_t *sec, const dt_field_t *nsec)
+{
+	uint64_t usec = sec->num * 1000000;
+	if (nsec->present) {
+		usec += nsec->num / 1000;
+	}
+	return usec;
+}
+
+/*! \brief Counts the question of the DNS message. */
+static int count_question(stats_t *stats, const dt_field_t *wire)
+{
+	if (wire->len < KNOT_WIRE_HEADER_SIZE ||
+	    knot_wire_get_qdcount(wire->data) == 0) {
+		return KNOT_EMALF;
+	}
+
+	const uint8_t *qname = wire->data + KNOT_WIRE_HEADER_SIZE;
+	const uint8_t *end = wire->data + wire->len;
+	int qname_len = knot_dname_wire_check(qname, end, NULL);
+	if (qname_len <= 0 || end - qname < qname_len + 2 * sizeof(uint16_t)) {
+		return KNOT_EMALF;
+	}
+
+	uint8_t name[KNOT_DNAME_MAXLEN];
+	memcpy(name, qname, qname_len);
+	knot_dname_to_lower(name);
+
+	stats->types[wire_read_u16(qname + qname_len)]++;
+
+	return count_key(stats->names, name, qname_len, 1);
+}
+
+static int process_frame(stats_t *stats, const stat_params_t *params,
+                         const uint8_t *frame, size_t frame_len)
+{
+	dt_field_t dnstap[DT_FIELD_MAX + 1];
+	int ret = dt_fields_get(frame, frame_len,
+	                        DT_FIELD(DT_DNSTAP_TYPE) | DT_FIELD(DT_DNSTAP_MESSAGE),
+	                        dnstap);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	if (!dnstap[DT_DNSTAP_TYPE].present ||
+	    dnstap[DT_DNSTAP_TYPE].num != DNSTAP_TYPE_MESSAGE ||
+	    !dnstap[DT_DNSTAP_MESSAGE].present) {
+		stats->other++;
+		return KNOT_EOK;
+	}
+
+	dt_field_t msg[DT_FIELD_MAX + 1];
+	ret = dt_fields_get(dnstap[DT_DNSTAP_MESSAGE].data,
+	                    dnstap[DT_DNSTAP_MESSAGE].len,
+	                    DT_FIELD(DT_MSG_TYPE) |
+	                    DT_FIELD(DT_MSG_QUERY_ADDRESS) |
+	                    DT_FIELD(DT_MSG_QUERY_TIME_SEC) |
+	                    DT_FIELD(DT_MSG_QUERY_TIME_NSEC) |
+	                    DT_FIELD(DT_MSG_QUERY_MESSAGE) |
+	                    DT_FIELD(DT_MSG_RESPONSE_TIME_SEC) |
+	                    DT_FIELD(DT_MSG_RESPONSE_TIME_NSEC) |
+	                    DT_FIELD(DT_MSG_RESPONSE_MESSAGE),
+	                    msg);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	if (!msg[DT_MSG_TYPE].present) {
+		return KNOT_EMALF;
+	}
+
+	/* The query message types are odd, the response ones even. */
+	const dt_field_t *wire = NULL;
+	bool is_query = (msg[DT_MSG_TYPE].num % 2 == 1);
+	if (is_query) {
+		stats->queries++;
+		if (!params->responses && msg[DT_MSG_QUERY_MESSAGE].present) {
+			wire = &msg[DT_MSG_QUERY_MESSAGE];
+		}
+	} else {
+		stats->responses++;
+		if (!msg[DT_MSG_RESPONSE_MESSAGE].present) {
+			return KNOT_EOK;
+		}
+		const dt_field_t *resp = &msg[DT_MSG_RESPONSE_MESSAGE];
+		if (resp->len >= KNOT_WIRE_HEADER_SIZE) {
+			stats->rcodes[knot_wire_get_rcode(resp->data)]++;
+		}
+		if (params->responses) {
+			wire = resp;
+		}
+
+		/* Latency of the responses with both times. */
+		if (msg[DT_MSG_QUERY_TIME_SEC].present &&
+		    msg[DT_MSG_RESPONSE_TIME_SEC].present) {
+			uint64_t qtime = time_usec(&msg[DT_MSG_QUERY_TIME_SEC],
+			                           &msg[DT_MSG_QUERY_TIME_NSEC]);
+			uint64_t rtime = time_usec(&msg[DT_MSG_RESPONSE_TIME_SEC],
+			                           &msg[DT_MSG_RESPONSE_TIME_NSEC]);
+			if (rtime >= qtime) {
+				stats->latency[latency_bucket(rtime - qtime)]++;
+				stats->latency_count++;
+			}
+		}
+	}
+
+	if (wire == NULL) {
+		return KNOT_EOK;
+	}
+
+	ret = count_question(stats, wire);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	const dt_field_t *addr = &msg[DT_MSG_QUERY_ADDRESS];
+	if (addr->present && (addr->len == 4 || addr->len == 16)) {
+		ret = count_key(stats->clients, addr->data, addr->len, 1);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	stats->analyzed++;
+
+	return KNOT_EOK;
+}
+
+static void *worker_run(void *arg)
+{
+	worker_t *w = arg;
+
+	size_t offset = w->begin;
+	while (offset < w->end) {
+		const uint8_t *frame;
+		size_t len;
+		w->ret = dt_mmap_reader_next(w->reader, &offset, &frame, &len);
+		if (w->ret != KNOT_EOK) {
+			break;
+		}
+
+		w->stats.frames++;
+		int ret = process_frame(&w->stats, w->params, frame, len);
+		if (ret == KNOT_EMALF) {
+			w->stats.malformed++;
+		} else if (ret != KNOT_EOK) {
+			w->ret = ret;
+			break;
+		}
+	}
+
+	if (w->ret == KNOT_EOF) {
+		w->ret = KNOT_EOK;
+	}
+
+	return NULL;
+}
+
+static int merge_trie(trie_t *dst, trie_t *src)
+{
+	trie_it_t *it = trie_it_begin(src);
+	if (it == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	for (; !trie_it_finished(it) && ret == KNOT_EOK; trie_it_next(it)) {
+		size_t len;
+		const char *key = trie_it_key(it, &len);
+		ret = count_key(dst, key, len, (uintptr_t)*trie_it_val(it));
+	}
+	trie_it_free(it);
+
+	return ret;
+}
+
+static int merge_stats(stats_t *dst, stats_t *src)
+{
+	dst->frames += src->frames;
+	dst->queries += src->queries;
+	dst->responses += src->responses;
+	dst->other += src->other;
+	dst->malformed += src->malformed;
+	dst->analyzed += src->analyzed;
+	dst->latency_count += src->latency_count;
+	for (size_t i = 0; i < TYPE_COUNT; i++) {
+		dst->types[i] += src->types[i];
+	}
+	for (size_t i = 0; i < RCODE_COUNT; i++) {
+		dst->rcodes[i] += src->rcodes[i];
+	}
+	for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		dst->latency[i] += src->latency[i];
+	}
+
+	int ret = merge_trie(dst->names, src->names);
+	if (ret == KNOT_EOK) {
+		ret = merge_trie(dst->clients, src->clients);
+	}
+
+	return ret;
+}
+
+static int item_cmp(const void *a, const void *b)
+{
+	const item_t *x = a, *y = b;
+	if (x->count != y->count) {
+		return (x->count < y->count) ? 1 : -1;
+	}
+	/* Keep the trie order for equal counts. */
+	return (x->key < y->key) ? -1 : (x->key > y->key);
+}
+
+static double share(uint64_t count, uint64_t total)
+{
+	return (total > 0) ? 100.0 * count / total : 0.0;
+}
+
+static void print_item(const item_t *item, uint64_t total, bool name)
+{
+	char buf[KNOT_DNAME_TXT_MAXLEN + 1] = "";
+	if (name) {
+		knot_dname_to_str(buf, (const knot_dname_t *)item->key, sizeof(buf));
+	} else {
+		struct sockaddr_storage ss;
+		int family = (item->len == 4) ? AF_INET : AF_INET6;
+		sockaddr_set_raw(&ss, family, (const uint8_t *)item->key, item->len);
+		sockaddr_tostr(buf, sizeof(buf), (struct sockaddr *)&ss);
+	}
+
+	printf("%12"PRIu64" %7.2f%%  %s\n", item->count, share(item->count, total), buf);
+}
+
+static int print_top_trie(trie_t *trie, const char *title, uint32_t top,
+                          uint64_t total, bool name)
+{
+	size_t count = trie_weight(trie);
+	item_t *items = malloc(count * sizeof(item_t) + 1);
+	trie_it_t *it = trie_it_begin(trie);
+	if (items == NULL || it == NULL) {
+		free(items);
+		if (it != NULL) {
+			trie_it_free(it);
+		}
+		return KNOT_ENOMEM;
+	}
+
+	size_t i = 0;
+	for (; !trie_it_finished(it); trie_it_next(it), i++) {
+		items[i].key = trie_it_key(it, &items[i].len);
+		items[i].count = (uintptr_t)*trie_it_val(it);
+	}
+	trie_it_free(it);
+
+	qsort(items, count, sizeof(item_t), item_cmp);
+
+	printf("\nTop %s (%zu unique):\n", title, count);
+	for (i = 0; i < count && i < top; i++) {
+		print_item(&items[i], total, name);
+	}
+
+	free(items);
+
+	return KNOT_EOK;
+}
+
+static void print_top_types(const stats_t *stats, uint32_t top)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < TYPE_COUNT; i++) {
+		count += (stats->types[i] > 0);
+	}
+
+	printf("\nTop query types (%zu unique):\n", count);
+
+	/* Few types, repeated selection of the maximum is enough. */
+	bool *used = calloc(TYPE_COUNT, sizeof(bool));
+	if (used == NULL) {
+		return;
+	}
+	for (uint32_t n = 0; n < top && n < count; n++) {
+		size_t max = 0;
+		for (size_t i = 0; i < TYPE_COUNT; i++) {
+			if (!used[i] && stats->types[i] > stats->types[max]) {
+				max = i;
+			}
+		}
+		used[max] = true;
+
+		char type[32];
+		knot_rrtype_to_string(max, type, sizeof(type));
+		printf("%12"PRIu64" %7.2f%%  %s\n", stats->types[max],
+		       share(stats->types[max], stats->analyzed), type);
+	}
+	free(used);
+}
+
+static void print_rcodes(const stats_t *stats)
+{
+	if (stats->responses == 0) {
+		return;
+	}
+
+	printf("\nResponse codes:\n");
+	for (size_t i = 0; i < RCODE_COUNT; i++) {
+		if (stats->rcodes[i] == 0) {
+			continue;
+		}
+		const knot_lookup_t *rcode = knot_lookup_by_id(knot_rcode_names, i);
+		char num[8];
+		snprintf(num, sizeof(num), "%zu", i);
+		printf("%12"PRIu64" %7.2f%%  %s\n", stats->rcodes[i],
+		       share(stats->rcodes[i], stats->responses),
+		       (rcode != NULL) ? rcode->name : num);
+	}
+}
+
+static uint64_t bucket_limit(unsigned bucket)
+{
+	return (uint64_t)1 << bucket;
+}
+
+static void print_latency(const stats_t *stats)
+{
+	if (stats->latency_count == 0) {
+		return;
+	}
+
+	printf("\nResponse latency (%"PRIu64" responses):\n", stats->latency_count);
+
+	unsigned first = 0, last = LATENCY_BUCKETS - 1;
+	while (stats->latency[first] == 0) {
+		first++;
+	}
+	while (stats->latency[last] == 0) {
+		last--;
+	}
+	for (unsigned i = first; i <= last; i++) {
+		uint64_t low = (i == 0) ? 0 : bucket_limit(i - 1);
+		printf("%12"PRIu64" %7.2f%%  %"PRIu64" - %"PRIu64" us\n",
+		       stats->latency[i], share(stats->latency[i], stats->latency_count),
+		       low, bucket_limit(i));
+	}
+
+	const double percentiles[] = { 50, 90, 99, 99.9 };
+	printf("\n");
+	for (size_t p = 0; p < sizeof(percentiles) / sizeof(*percentiles); p++) {
+		uint64_t limit = stats->latency_count * percentiles[p] / 100;
+		uint64_t sum = 0;
+		unsigned i = 0;
+		for (; i < LATENCY_BUCKETS - 1; i++) {
+			sum += stats->latency[i];
+			if (sum > limit) {
+				break;
+			}
+		}
+		printf("%11g%% < %"PRIu64" us\n", percentiles[p], bucket_limit(i));
+	}
+}
+
+static int print_stats(stats_t *stats, const stat_params_t *params)
+{
+	printf("Frames:     %"PRIu64" (malformed %"PRIu64", other %"PRIu64")\n"
+	       "Queries:    %"PRIu64"\n"
+	       "Responses:  %"PRIu64"\n"
+	       "Analyzed:   %"PRIu64" %s\n",
+	       stats->frames, stats->malformed, stats->other,
+	       stats->queries, stats->responses, stats->analyzed,
+	       params->responses ? "responses" : "queries");
+
+	int ret = print_top_trie(stats->names, "query names", params->top,
+	                         stats->analyzed, true);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	print_top_types(stats, params->top);
+	ret = print_top_trie(stats->clients, "clients", params->top,
+	                     stats->analyzed, false);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	print_rcodes(stats);
+	print_latency(stats);
+
+	return KNOT_EOK;
+}
+
+static int analyze(const char *path, const stat_params_t *params)
+{
+	dt_mmap_reader_t reader;
+	int ret = dt_mmap_reader_open(&reader, path);
+	if (ret != KNOT_EOK) {
+		ERR("can't open dnstap file '%s' (%s)\n", path, knot_strerror(ret));
+		return ret;
+	}
+
+	worker_t *workers = calloc(params->threads, sizeof(worker_t));
+	size_t *bounds = calloc(params->threads + 1, sizeof(size_t));
+	if (workers == NULL || bounds == NULL) {
+		free(workers);
+		free(bounds);
+		dt_mmap_reader_close(&reader);
+		return KNOT_ENOMEM;
+	}
+
+	dt_mmap_reader_split(&reader, params->threads, bounds);
+
+	/* Start the workers. */
+	uint32_t started = 0;
+	for (; started < params->threads; started++) {
+		worker_t *w = &workers[started];
+		w->reader = &reader;
+		w->params = params;
+		w->begin = bounds[started];
+		w->end = bounds[started + 1];
+		ret = stats_init(&w->stats);
+		if (ret != KNOT_EOK) {
+			stats_deinit(&w->stats);
+			break;
+		}
+		if (pthread_create(&w->thread, NULL, worker_run, w) != 0) {
+			stats_deinit(&w->stats);
+			ret = KNOT_ERROR;
+			break;
+		}
+	}
+
+	/* Collect the results, a malformed frame ends only its range. */
+	bool truncated = false;
+	for (uint32_t i = 0; i < started; i++) {
+		worker_t *w = &workers[i];
+		pthread_join(w->thread, NULL);
+		if (w->ret == KNOT_EMALF) {
+			truncated = true;
+		} else if (ret == KNOT_EOK) {
+			ret = w->ret;
+		}
+		if (i > 0 && ret == KNOT_EOK) {
+			ret = merge_stats(&workers[0].stats, &w->stats);
+		}
+		if (i > 0) {
+			stats_deinit(&w->stats);
+		}
+	}
+
+	if (truncated && ret == KNOT_EOK) {
+		WARN("truncated or malformed file, partial results\n");
+	}
+
+	if (ret == KNOT_EOK) {
+		ret = print_stats(&workers[0].stats, params);
+	}
+	if (ret != KNOT_EOK) {
+		ERR("failed to analyze '%s' (%s)\n", path, knot_strerror(ret));
+	}
+
+	if (started > 0) {
+		stats_deinit(&workers[0].stats);
+	}
+	free(workers);
+	free(bounds);
+	dt_mmap_reader_close(&reader);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	stat_params_t params = {
+		.threads = (cpus > 0) ? MIN(cpus, MAX_THREADS) : 1,
+		.top = DEFAULT_TOP
+	};
+
+	/* Long options. */
+	struct option opts[] = {
+		{ "threads",   required_argument, NULL, 't' },
+		{ "top",       required_argument, NULL, 'n' },
+		{ "responses", no_argument,       NULL, 'R' },
+		{ "help",      no_argument,       NULL, 'h' },
+		{ "version",   no_argument,       NULL, 'V' },
+		{ NULL }
+	};
+
+	int opt = 0;
+	while ((opt = getopt_long(argc, argv, "t:n:RhV", opts, NULL)) != -1) {
+		int ret = KNOT_EOK;
+		switch (opt) {
+		case 't':
+			ret = str_to_u32(optarg, &params.threads);
+			if (params.threads == 0 || params.threads > MAX_THREADS) {
+				ret = KNOT_ERANGE;
+			}
+			break;
+		case 'n':
+			ret = str_to_u32(optarg, &params.top);
+			break;
+		case 'R':
+			params.responses = true;
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		case 'V':
+			print_version(PROGRAM_NAME);
+			return EXIT_SUCCESS;
+		default:
+			print_help();
+			return EXIT_FAILURE;
+		}
+
+		if (ret != KNOT_EOK) {
+			ERR("invalid value '%s' of parameter -%c\n", optarg, opt);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		print_help();
+		return EXIT_FAILURE;
+	}
+
+	int ret = analyze(argv[optind], &params);
+
+	return (ret == KNOT_EOK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
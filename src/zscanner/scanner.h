@@ -94,6 +94,32 @@ typedef enum {
 	ZS_STATE_STOP      /*!< Finished parsing. */
 } zs_state_t;
 
+/*!
+ * \brief Parsed record passed to the batch processing callback.
+ *
+ * The owner and rdata point to the scanner batch storage and are valid until
+ * the callback returns. Consecutive records with the same owner share the
+ * owner storage, so they can be detected by the owner pointer comparison.
+ */
+typedef struct {
+	/*! Record owner. */
+	const uint8_t *owner;
+	/*! Length of the record owner. */
+	uint32_t owner_length;
+	/*! Class of the record. */
+	uint16_t rclass;
+	/*! TTL of the record. */
+	uint32_t ttl;
+	/*! Type of the record data. */
+	uint16_t type;
+	/*! Length of the record data. */
+	uint32_t data_length;
+	/*! Record data. */
+	const uint8_t *data;
+	/*! Zone data line of the record. */
+	uint64_t line;
+} zs_record_t;
+
 /*!
  * \brief Context structure for zone scanner.
  *
@@ -194,6 +220,24 @@ struct scanner {
 		void *data;
 	} process;
 
+	/*! Batch processing of records (see zs_set_batch_processing). */
+	struct {
+		/*! Callback function for a batch of correct zone records. */
+		void (*callback)(zs_scanner_t *);
+		/*! Callback function for wrong situations. */
+		void (*error)(zs_scanner_t *);
+		/*! Parsed records in the current batch. */
+		zs_record_t *records;
+		/*! Number of parsed records in the current batch. */
+		size_t count;
+		/*! Maximal number of records in a batch. */
+		size_t max_count;
+		/*! Storage for owners and rdata of the records. */
+		uint8_t *storage;
+		/*! Size of the used storage. */
+		size_t storage_used;
+	} batch;
+
 	/*! Input parameters. */
 	struct {
 		/*! Start of the block. */
@@ -341,6 +385,35 @@ int zs_set_processing(
 	void *data
 );
 
+/*!
+ * \brief Sets the scanner batch processing callbacks for automatic processing.
+ *
+ * Instead of the record callback for each record, the batch callback is
+ * executed for up to \a max_count records at once (scanner->batch.records and
+ * scanner->batch.count). A pending batch is also passed before an error
+ * callback and at the end of the automatic parsing, so the order of records
+ * and errors is kept. Setting the ZS_STATE_STOP state in the batch callback
+ * stops the processing.
+ *
+ * \note Error code is stored in the scanner context.
+ *
+ * \param scanner        Scanner context.
+ * \param process_batch  Batch processing callback function.
+ * \param process_error  Error callback function (may be NULL).
+ * \param max_count      Maximal number of records in a batch (0 for default).
+ * \param data           Arbitrary data useful in callback functions.
+ *
+ * \retval  0  if success.
+ * \retval -1  if error.
+ */
+int zs_set_batch_processing(
+	zs_scanner_t *scanner,
+	void (*process_batch)(zs_scanner_t *),
+	void (*process_error)(zs_scanner_t *),
+	size_t max_count,
+	void *data
+);
+
 /*!
  * \brief Parses one record from the input.
  *
@@ -41,6 +41,11 @@
 /*! \brief Shorthand for error reset. */
 #define NOERR { WARN(ZS_OK); s->error.fatal = false; }
 
+/*! \brief Default maximal number of records in a batch. */
+#define BATCH_COUNT	256
+/*! \brief Size of the batch storage for owners and rdata. */
+#define BATCH_STORAGE_SIZE	(4 * (MAX_DNAME_LENGTH + MAX_RDATA_LENGTH))
+
 /*!
  * \brief Writes record type number to r_data.
  *
@@ -181,6 +186,8 @@ void zs_deinit(
 
 	input_deinit(s);
 	free(s->path);
+	free(s->batch.records);
+	free(s->batch.storage);
 }
 
 __attribute__((visibility("default")))
@@ -303,10 +310,150 @@ int zs_set_processing(
 	s->process.record = process_record;
 	s->process.error = process_error;
 	s->process.data = data;
+	s->batch.callback = NULL;
+
+	return 0;
+}
+
+static void batch_flush(
+	zs_scanner_t *s)
+{
+	if (s->batch.count == 0) {
+		return;
+	}
+
+	s->batch.callback(s);
+
+	s->batch.count = 0;
+	s->batch.storage_used = 0;
+}
+
+static void batch_record(
+	zs_scanner_t *s)
+{
+	// Pass the current batch if the record doesn't fit.
+	if (s->batch.count == s->batch.max_count ||
+	    s->batch.storage_used + s->r_owner_length + s->r_data_length >
+	    BATCH_STORAGE_SIZE) {
+		batch_flush(s);
+		if (s->state == ZS_STATE_STOP) {
+			return;
+		}
+	}
+
+	zs_record_t *rr = s->batch.records + s->batch.count;
+
+	// Share the owner with the previous record if equal.
+	const zs_record_t *prev = (s->batch.count > 0) ? rr - 1 : NULL;
+	if (prev != NULL && prev->owner_length == s->r_owner_length &&
+	    memcmp(prev->owner, s->r_owner, s->r_owner_length) == 0) {
+		rr->owner = prev->owner;
+	} else {
+		uint8_t *owner = s->batch.storage + s->batch.storage_used;
+		memcpy(owner, s->r_owner, s->r_owner_length);
+		s->batch.storage_used += s->r_owner_length;
+		rr->owner = owner;
+	}
+	rr->owner_length = s->r_owner_length;
+
+	uint8_t *data = s->batch.storage + s->batch.storage_used;
+	memcpy(data, s->r_data, s->r_data_length);
+	s->batch.storage_used += s->r_data_length;
+	rr->data = data;
+	rr->data_length = s->r_data_length;
+
+	rr->rclass = s->r_class;
+	rr->ttl = s->r_ttl;
+	rr->type = s->r_type;
+	rr->line = s->line_counter;
+
+	s->batch.count++;
+}
+
+static void batch_error(
+	zs_scanner_t *s)
+{
+	// Keep the order of records and errors.
+	zs_state_t state = s->state;
+	batch_flush(s);
+	if (s->state == ZS_STATE_STOP) {
+		return;
+	}
+	s->state = state;
+
+	if (s->batch.error != NULL) {
+		s->batch.error(s);
+	}
+}
+
+__attribute__((visibility("default")))
+int zs_set_batch_processing(
+	zs_scanner_t *s,
+	void (*process_batch)(zs_scanner_t *),
+	void (*process_error)(zs_scanner_t *),
+	size_t max_count,
+	void *data)
+{
+	if (s == NULL) {
+		return -1;
+	}
+
+	if (process_batch == NULL) {
+		ERR(ZS_EINVAL);
+		return -1;
+	}
+
+	if (max_count == 0) {
+		max_count = BATCH_COUNT;
+	}
+
+	// Allocate the batch storage.
+	if (s->batch.storage == NULL) {
+		s->batch.storage = malloc(BATCH_STORAGE_SIZE);
+		if (s->batch.storage == NULL) {
+			ERR(ZS_ENOMEM);
+			return -1;
+		}
+	}
+	if (s->batch.records == NULL || s->batch.max_count != max_count) {
+		zs_record_t *array = realloc(s->batch.records,
+		                             max_count * sizeof(zs_record_t));
+		if (array == NULL) {
+			ERR(ZS_ENOMEM);
+			return -1;
+		}
+		s->batch.records = array;
+	}
+
+	s->process.record = batch_record;
+	s->process.error = batch_error;
+	s->process.data = data;
+	s->batch.callback = process_batch;
+	s->batch.error = process_error;
+	s->batch.max_count = max_count;
+	s->batch.count = 0;
+	s->batch.storage_used = 0;
 
 	return 0;
 }
 
+/*! \brief Sets the processing of an included zone file as of the parent. */
+static int include_processing(
+	zs_scanner_t *ss,
+	zs_scanner_t *s)
+{
+	if (s->batch.callback == NULL) {
+		return zs_set_processing(ss, s->process.record, s->process.error,
+		                         s->process.data);
+	}
+
+	// Pass the parent records before the included ones.
+	batch_flush(s);
+
+	return zs_set_batch_processing(ss, s->batch.callback, s->batch.error,
+	                               s->batch.max_count, s->process.data);
+}
+
 static void parse(
 	zs_scanner_t *s)
 {
@@ -448,6 +595,11 @@ int zs_parse_all(
 		parse(s);
 	}
 
+	// Pass the remaining records in the batch mode.
+	if (s->batch.callback != NULL) {
+		batch_flush(s);
+	}
+
 	// Check if any errors has occurred.
 	if (s->error.counter > 0) {
 		return -1;
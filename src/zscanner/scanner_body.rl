@@ -745,8 +745,7 @@
 			if (zs_init(ss, (char *)s->buffer, s->default_class,
 			            s->default_ttl) != 0 ||
 			    zs_set_input_file(ss, (char *)(s->include_filename)) != 0 ||
-			    zs_set_processing(ss, s->process.record, s->process.error,
-			                      s->process.data) != 0 ||
+			    include_processing(ss, s) != 0 ||
 			    zs_parse_all(ss) != 0) {
 				// File internal errors are handled by error callback.
 				if (ss->error.counter > 0) {
@@ -16,6 +16,7 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "tests/processing.h"
 #include "scanner.h"
@@ -56,33 +57,53 @@ void debug_process_error(zs_scanner_t *s)
 	fflush(stdout);
 }
 
-void debug_process_record(zs_scanner_t *s)
+static void debug_print_record(uint64_t line, const uint8_t *owner,
+                               uint32_t owner_length, uint16_t rclass,
+                               uint32_t ttl, uint16_t type,
+                               const uint8_t *data, uint32_t data_length)
 {
 	uint32_t i;
 
-	char rclass[32];
-	char rtype[32];
+	char class_str[32];
+	char type_str[32];
 
-	if (knot_rrclass_to_string(s->r_class, rclass, sizeof(rclass)) > 0 &&
-	    knot_rrtype_to_string(s->r_type, rtype, sizeof(rtype)) > 0) {
+	if (knot_rrclass_to_string(rclass, class_str, sizeof(class_str)) > 0 &&
+	    knot_rrtype_to_string(type, type_str, sizeof(type_str)) > 0) {
 		printf("LINE(%03"PRIu64") %s %6u %*s ",
-		       s->line_counter, rclass, s->r_ttl, 5, rtype);
+		       line, class_str, ttl, 5, type_str);
 	} else {
 		printf("LINE(%03"PRIu64") %u %6u %*u ",
-		       s->line_counter, s->r_class, s->r_ttl, 5, s->r_type);
+		       line, rclass, ttl, 5, type);
 	}
 
-	print_wire_dname(s->r_owner, s->r_owner_length);
+	print_wire_dname(owner, owner_length);
 
-	printf(" \\# %u ", s->r_data_length);
+	printf(" \\# %u ", data_length);
 
-	for (i = 0; i < s->r_data_length; i++) {
-		printf("%02X", (s->r_data)[i]);
+	for (i = 0; i < data_length; i++) {
+		printf("%02X", data[i]);
 	}
 	printf("\n");
 	fflush(stdout);
 }
 
+void debug_process_record(zs_scanner_t *s)
+{
+	debug_print_record(s->line_counter, s->r_owner, s->r_owner_length,
+	                   s->r_class, s->r_ttl, s->r_type,
+	                   s->r_data, s->r_data_length);
+}
+
+void debug_process_batch(zs_scanner_t *s)
+{
+	for (size_t i = 0; i < s->batch.count; i++) {
+		const zs_record_t *rr = &s->batch.records[i];
+		debug_print_record(rr->line, rr->owner, rr->owner_length,
+		                   rr->rclass, rr->ttl, rr->type,
+		                   rr->data, rr->data_length);
+	}
+}
+
 void test_process_error(zs_scanner_t *s)
 {
 	if (s->error.fatal) {
@@ -93,22 +114,45 @@ void test_process_error(zs_scanner_t *s)
 	fflush(stdout);
 }
 
-void test_process_record(zs_scanner_t *s)
+static void test_print_record(const uint8_t *owner, uint32_t owner_length,
+                              uint16_t rclass, uint32_t ttl, uint16_t type,
+                              const uint8_t *data, uint32_t data_length)
 {
 	uint32_t i;
 
 	printf("OWNER=");
-	for (i = 0; i < s->r_owner_length; i++) {
-		printf("%02X", s->r_owner[i]);
+	for (i = 0; i < owner_length; i++) {
+		printf("%02X", owner[i]);
 	}
 	printf("\n");
-	printf("CLASS=%04X\n", s->r_class);
-	printf("RRTTL=%08X\n", s->r_ttl);
-	printf("RTYPE=%04X\n", s->r_type);
+	printf("CLASS=%04X\n", rclass);
+	printf("RRTTL=%08X\n", ttl);
+	printf("RTYPE=%04X\n", type);
 	printf("RDATA=");
-	for (i = 0; i < s->r_data_length; i++) {
-		printf("%02X", (s->r_data)[i]);
+	for (i = 0; i < data_length; i++) {
+		printf("%02X", data[i]);
 	}
 	printf("\n%s", separator);
 	fflush(stdout);
 }
+
+void test_process_record(zs_scanner_t *s)
+{
+	test_print_record(s->r_owner, s->r_owner_length, s->r_class, s->r_ttl,
+	                  s->r_type, s->r_data, s->r_data_length);
+}
+
+void test_process_batch(zs_scanner_t *s)
+{
+	for (size_t i = 0; i < s->batch.count; i++) {
+		const zs_record_t *rr = &s->batch.records[i];
+		// Consecutive records with the same owner share it.
+		if (i > 0 && rr->owner_length == rr[-1].owner_length &&
+		    memcmp(rr->owner, rr[-1].owner, rr->owner_length) == 0 &&
+		    rr->owner != rr[-1].owner) {
+			printf("OWNER NOT SHARED\n");
+		}
+		test_print_record(rr->owner, rr->owner_length, rr->rclass,
+		                  rr->ttl, rr->type, rr->data, rr->data_length);
+	}
+}
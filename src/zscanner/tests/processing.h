@@ -32,8 +32,12 @@ void debug_process_error(zs_scanner_t *scanner);
 
 void debug_process_record(zs_scanner_t *scanner);
 
+void debug_process_batch(zs_scanner_t *scanner);
+
 void test_process_error(zs_scanner_t *scanner);
 
 void test_process_record(zs_scanner_t *scanner);
 
+void test_process_batch(zs_scanner_t *scanner);
+
 /*! @} */
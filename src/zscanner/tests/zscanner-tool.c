@@ -27,6 +27,7 @@
 #define DEFAULT_MODE	1
 #define DEFAULT_CLASS	1
 #define DEFAULT_TTL	0
+#define BATCH_COUNT	3
 
 static void *timestamp_worker(void *data)
 {
@@ -46,6 +47,7 @@ static void help(void)
 	       "     1        Debug output (DEFAULT).\n"
 	       "     2        Test output.\n"
 	       " -s           State parsing mode.\n"
+	       " -b           Batch processing mode.\n"
 	       " -t           Launch unit tests.\n"
 	       " -h           Print this help.\n");
 }
@@ -134,12 +136,13 @@ int state_parsing(
 
 int main(int argc, char *argv[])
 {
-	int mode = DEFAULT_MODE, state = 0, test = 0;
+	int mode = DEFAULT_MODE, state = 0, batch = 0, test = 0;
 
 	// Command line long options.
 	struct option opts[] = {
 		{ "mode",  required_argument, NULL, 'm' },
 		{ "state", no_argument,       NULL, 's' },
+		{ "batch", no_argument,       NULL, 'b' },
 		{ "test",  no_argument,       NULL, 't' },
 		{ "help",  no_argument,       NULL, 'h' },
 		{ NULL }
@@ -147,7 +150,7 @@ int main(int argc, char *argv[])
 
 	// Parsed command line arguments.
 	int opt = 0, li = 0;
-	while ((opt = getopt_long(argc, argv, "m:sth", opts, &li)) != -1) {
+	while ((opt = getopt_long(argc, argv, "m:sbth", opts, &li)) != -1) {
 		switch (opt) {
 		case 'm':
 			mode = atoi(optarg);
@@ -155,6 +158,9 @@ int main(int argc, char *argv[])
 		case 's':
 			state = 1;
 			break;
+		case 'b':
+			batch = 1;
+			break;
 		case 't':
 			test = 1;
 			break;
@@ -172,7 +178,7 @@ int main(int argc, char *argv[])
 	}
 
 	// Check if there are 2 remaining non-options.
-	if (argc - optind != 2) {
+	if (argc - optind != 2 || (state && batch)) {
 		help();
 		return EXIT_FAILURE;
 	}
@@ -205,10 +211,22 @@ int main(int argc, char *argv[])
 		ret = 0;
 		break;
 	case 1:
-		ret = zs_set_processing(s, debug_process_record, debug_process_error, NULL);
+		if (batch) {
+			ret = zs_set_batch_processing(s, debug_process_batch,
+			                              debug_process_error, BATCH_COUNT,
+			                              NULL);
+		} else {
+			ret = zs_set_processing(s, debug_process_record, debug_process_error, NULL);
+		}
 		break;
 	case 2:
-		ret = zs_set_processing(s, test_process_record, test_process_error, NULL);
+		if (batch) {
+			ret = zs_set_batch_processing(s, test_process_batch,
+			                              test_process_error, BATCH_COUNT,
+			                              NULL);
+		} else {
+			ret = zs_set_processing(s, test_process_record, test_process_error, NULL);
+		}
 		break;
 	default:
 		printf("Bad mode number!\n");
@@ -14,6 +14,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <tap/basic.h>
@@ -182,6 +183,53 @@ static void test_acl_allowed(void)
 	ret = acl_allowed(conf(), &acl, ACL_ACTION_TRANSFER, &addr, &key0);
 	ok(ret == true, "IPv6 address from range, no key, action match");
 
+	/* Compiled ACL must give the same results. */
+	acl = conf_zone_get(conf(), C_ACL, zone_name);
+	acl_t *compiled = acl_compile(conf(), &acl);
+	ok(compiled != NULL && compiled->count == 6, "Compile zone ACL");
+
+	const struct {
+		int family;
+		const char *addr;
+		knot_tsig_key_t *key;
+		acl_action_t action;
+		bool allowed;
+	} cases[] = {
+		{ AF_INET6, "2001::1",   &key1, ACL_ACTION_NONE,     true },
+		{ AF_INET6, "2001::1",   &key1, ACL_ACTION_TRANSFER, true },
+		{ AF_INET6, "2001::2",   &key1, ACL_ACTION_TRANSFER, false },
+		{ AF_INET6, "2001::1",   &key0, ACL_ACTION_TRANSFER, false },
+		{ AF_INET6, "2001::1",   &key2, ACL_ACTION_TRANSFER, false },
+		{ AF_INET6, "2001::1",   &key1, ACL_ACTION_NOTIFY,   false },
+		{ AF_INET,  "240.0.0.1", &key0, ACL_ACTION_NOTIFY,   true },
+		{ AF_INET,  "240.0.0.1", &key1, ACL_ACTION_NOTIFY,   false },
+		{ AF_INET,  "240.0.0.2", &key0, ACL_ACTION_NOTIFY,   false },
+		{ AF_INET,  "240.0.0.2", &key0, ACL_ACTION_UPDATE,   true },
+		{ AF_INET,  "240.0.0.3", &key0, ACL_ACTION_UPDATE,   false },
+		{ AF_INET,  "1.1.1.1",   &key3, ACL_ACTION_UPDATE,   true },
+		{ AF_INET,  "100.0.0.1", &key0, ACL_ACTION_TRANSFER, true },
+		{ AF_INET6, "::1",       &key0, ACL_ACTION_TRANSFER, true },
+	};
+
+	bool same = true;
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+		sockaddr_set(&addr, cases[i].family, cases[i].addr, 0);
+		knot_tsig_key_t key = *cases[i].key;
+		if (acl_match(compiled, cases[i].action, &addr, &key) != cases[i].allowed) {
+			diag("compiled ACL mismatch for '%s'", cases[i].addr);
+			same = false;
+		}
+	}
+	ok(same, "Compiled ACL matches");
+
+	check_sockaddr_set(&addr, AF_INET, "1.1.1.1", 0);
+	knot_tsig_key_t key = key3;
+	ret = acl_match(compiled, ACL_ACTION_UPDATE, &addr, &key);
+	ok(ret == true && key.secret.size == 2 &&
+	   memcmp(key.secret.data, "fo", 2) == 0, "Compiled ACL key secret");
+
+	acl_free(compiled);
+
 	conf_free(conf());
 	knot_dname_free(&zone_name, NULL);
 	knot_dname_free(&key1_name, NULL);
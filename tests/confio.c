@@ -19,7 +19,11 @@
 #include "test_conf.h"
 #include "knot/conf/confio.h"
 #include "knot/conf/tools.h"
+#include "knot/server/server.h"
+#include "knot/updates/acl.h"
+#include "knot/zone/zonedb-load.h"
 #include "libknot/yparser/yptrafo.h"
+#include "contrib/sockaddr.h"
 #include "contrib/string.h"
 #include "contrib/openbsd/strlcat.h"
 
@@ -894,7 +898,8 @@ static void test_conf_io_list(void)
 	      "server.max-udp-payload\n"
 	      "server.max-ipv4-udp-payload\n"
 	      "server.max-ipv6-udp-payload\n"
-	      "server.rate-limit-slip";
+	      "server.rate-limit-slip\n"
+	      "server.cookies";
 	ok(strcmp(ref, out) == 0, "compare result");
 }
 
@@ -911,6 +916,7 @@ static const yp_item_t desc_server[] = {
 	{ C_MAX_IPV4_UDP_PAYLOAD, YP_TINT,  YP_VNONE },
 	{ C_MAX_IPV6_UDP_PAYLOAD, YP_TINT,  YP_VNONE },
 	{ C_RATE_LIMIT_SLIP,	  YP_TINT,  YP_VNONE },
+	{ C_COOKIES,              YP_TBOOL, YP_VNONE },
 	{ NULL }
 };
 
@@ -953,6 +959,81 @@ const yp_item_t test_scheme[] = {
 	{ NULL }
 };
 
+static bool acl_check(const zone_t *zone, const char *addr_str)
+{
+	struct sockaddr_storage addr;
+	sockaddr_set(&addr, AF_INET, addr_str, 0);
+	knot_tsig_key_t key = { 0 };
+
+	return zone->conf_cache != NULL &&
+	       acl_match(zone->conf_cache->acl, ACL_ACTION_TRANSFER, &addr, &key);
+}
+
+static void test_conf_io_reload_cache(void)
+{
+	const char *conf_str =
+		"acl:\n"
+		"  - id: xfr\n"
+		"    address: 192.0.2.1\n"
+		"    action: transfer\n"
+		"  - id: other\n"
+		"    address: 192.0.2.3\n"
+		"    action: transfer\n"
+		"zone:\n"
+		"  - domain: "ZONE1"\n"
+		"    acl: xfr\n";
+
+	// Replace the test scheme with the server one.
+	ok(test_conf(conf_str, NULL) == KNOT_EOK, "prepare configuration");
+
+	knot_dname_t *name = knot_dname_from_str_alloc(ZONE1);
+	zone_t *zone = zone_new(name);
+	knot_dname_free(&name, NULL);
+	ok(zone != NULL, "create zone");
+	zone_conf_cache_set(zone, zone_conf_cache_create(conf(), zone->name));
+
+	server_t server = { .zone_db = knot_zonedb_new(1) };
+	knot_zonedb_insert(server.zone_db, zone);
+	knot_zonedb_build_index(server.zone_db);
+	ok(acl_check(zone, "192.0.2.1"), "compiled ACL allows the address");
+
+	// Change the referenced ACL.
+	ok(conf_io_begin(false) == KNOT_EOK, "begin txn");
+	ok(conf_io_unset("acl", "address", "xfr", "192.0.2.1") ==
+	   KNOT_EOK, "unset ACL address");
+	ok(conf_io_set("acl", "address", "xfr", "192.0.2.2") ==
+	   KNOT_EOK, "set ACL address");
+	ok(conf_io_commit(false) == KNOT_EOK, "commit txn");
+	ok(conf_refresh_txn(conf()) == KNOT_EOK, "update read-only txn");
+	ok(conf()->io.flags & CONF_IO_FRLD_CACHES, "recompile all zones");
+
+	zonedb_reload(conf(), &server);
+	ok(knot_zonedb_find(server.zone_db, zone->name) == zone, "zone reused");
+	ok(!acl_check(zone, "192.0.2.1"), "old ACL rule rejected");
+	ok(acl_check(zone, "192.0.2.2"), "new ACL rule allowed");
+
+	// Change the zone ACL reference.
+	ok(conf_io_begin(false) == KNOT_EOK, "begin txn");
+	ok(conf_io_set("zone", "acl", ZONE1, "other") ==
+	   KNOT_EOK, "set zone ACL");
+	ok(conf_io_unset("zone", "acl", ZONE1, "xfr") ==
+	   KNOT_EOK, "unset zone ACL");
+	ok(conf_io_set("zone", "disable-any", ZONE1, "on") ==
+	   KNOT_EOK, "set zone disable-any");
+	ok(conf_io_commit(false) == KNOT_EOK, "commit txn");
+	ok(conf_refresh_txn(conf()) == KNOT_EOK, "update read-only txn");
+	ok(!(conf()->io.flags & CONF_IO_FRLD_CACHES) &&
+	   (conf()->io.flags & CONF_IO_FRLD_CACHE), "recompile the zone");
+
+	zonedb_reload(conf(), &server);
+	ok(knot_zonedb_find(server.zone_db, zone->name) == zone, "zone reused");
+	ok(!acl_check(zone, "192.0.2.2"), "old zone ACL rejected");
+	ok(acl_check(zone, "192.0.2.3"), "new zone ACL allowed");
+	ok(zone->conf_cache->disable_any, "new disable-any");
+
+	knot_zonedb_deep_free(&server.zone_db);
+}
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
@@ -986,6 +1067,9 @@ int main(int argc, char *argv[])
 	diag("conf_io_list");
 	test_conf_io_list();
 
+	diag("conf_io reload cache");
+	test_conf_io_reload_cache();
+
 	conf_free(conf());
 
 	return 0;
@@ -0,0 +1,121 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tap/basic.h>
+
+#include "contrib/addrset.h"
+#include "contrib/sockaddr.h"
+#include "libknot/errcode.h"
+
+static struct sockaddr_storage ss[2];
+
+static const struct sockaddr *addr(int i, int family, const char *str)
+{
+	sockaddr_set(&ss[i], family, str, 53);
+	return (struct sockaddr *)&ss[i];
+}
+
+static void add_net(addrset_t *set, int family, const char *str, unsigned prefix)
+{
+	int ret = addrset_add_net(set, addr(0, family, str), prefix);
+	ok(ret == KNOT_EOK, "addrset: add network %s/%u", str, prefix);
+}
+
+static void add_range(addrset_t *set, int family, const char *min, const char *max)
+{
+	int ret = addrset_add_range(set, addr(0, family, min), addr(1, family, max));
+	ok(ret == KNOT_EOK, "addrset: add range %s-%s", min, max);
+}
+
+static void check(const addrset_t *set, int family, const char *str, bool expected)
+{
+	bool match = addrset_match(set, addr(0, family, str));
+	ok(match == expected, "addrset: %s %s", str, expected ? "match" : "no match");
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	addrset_t *set = addrset_new();
+	ok(set != NULL, "addrset: new");
+
+	/* Empty set. */
+	addrset_build(set);
+	check(set, AF_INET, "127.0.0.1", false);
+	is_int(0, addrset_size(set), "addrset: empty size");
+
+	/* Networks and ranges, including overlapping ones. */
+	add_net(set, AF_INET, "10.0.0.0", 8);
+	add_net(set, AF_INET, "10.1.2.3", 16);
+	add_net(set, AF_INET, "192.0.2.1", 32);
+	add_net(set, AF_INET, "192.0.2.2", 40);
+	add_range(set, AF_INET, "1.255.0.0", "2.0.0.255");
+	add_range(set, AF_INET, "172.16.0.10", "172.16.0.5");
+	add_net(set, AF_INET6, "2001:db8::", 32);
+	add_range(set, AF_INET6, "fe80::1", "fe80::ff");
+	add_net(set, AF_INET6, "::", 0);
+
+	int ret = addrset_add_net(set, addr(0, AF_UNIX, "/tmp/sock"), 8);
+	ok(ret == KNOT_EINVAL, "addrset: unsupported family");
+	ret = addrset_add_range(set, addr(0, AF_INET, "1.0.0.0"),
+	                        addr(1, AF_INET6, "::1"));
+	ok(ret == KNOT_EINVAL, "addrset: mixed families");
+
+	addrset_build(set);
+	is_int(5, addrset_size(set), "addrset: merged size");
+
+	check(set, AF_INET, "10.0.0.0", true);
+	check(set, AF_INET, "10.255.255.255", true);
+	check(set, AF_INET, "11.0.0.0", false);
+	check(set, AF_INET, "9.255.255.255", false);
+	check(set, AF_INET, "192.0.2.1", true);
+	check(set, AF_INET, "192.0.2.2", true);
+	check(set, AF_INET, "192.0.2.3", false);
+	check(set, AF_INET, "1.255.0.0", true);
+	check(set, AF_INET, "1.255.255.1", true);
+	check(set, AF_INET, "2.0.0.255", true);
+	check(set, AF_INET, "2.0.1.0", false);
+	check(set, AF_INET, "172.16.0.7", false);
+	check(set, AF_INET, "0.0.0.0", false);
+	check(set, AF_INET, "255.255.255.255", false);
+
+	/* IPv6 covered by the default route. */
+	check(set, AF_INET6, "::", true);
+	check(set, AF_INET6, "ffff::1", true);
+
+	addrset_free(set);
+
+	/* IPv6 only set. */
+	set = addrset_new();
+	add_net(set, AF_INET6, "2001:db8:1::", 48);
+	add_range(set, AF_INET6, "fe80::1", "fe80::ff");
+	addrset_build(set);
+
+	check(set, AF_INET6, "2001:db8:1:ffff::1", true);
+	check(set, AF_INET6, "2001:db8:2::", false);
+	check(set, AF_INET6, "fe80::80", true);
+	check(set, AF_INET6, "fe80::100", false);
+	check(set, AF_INET, "32.1.13.184", false);
+
+	addrset_free(set);
+
+	/* NULL safety. */
+	ok(!addrset_match(NULL, addr(0, AF_INET, "1.2.3.4")), "addrset: match NULL");
+	addrset_free(NULL);
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <tap/basic.h>
+
+#include "libknot/libknot.h"
+#include "contrib/base16.h"
+#include "contrib/cpu.h"
+
+#define BUF_LEN			256
+#define MAX_BIN_DATA_LEN	(INT32_MAX / 2)
+
+/*! \brief Vectorized implementations checked against the scalar one. */
+static const struct {
+	unsigned features;
+	const char *name;
+} levels[] = {
+	{ CPU_SSSE3,            "SSSE3" },
+	{ CPU_SSSE3 | CPU_AVX2, "AVX2" },
+};
+
+#define TEST_DATA_LEN	200
+#define BENCH_DATA_LEN	(1 << 20)
+#define BENCH_ROUNDS	16
+
+static void test_vector(const char *in, const char *ref)
+{
+	uint8_t out[BUF_LEN];
+
+	int32_t ret = base16_encode((const uint8_t *)in, strlen(in), out, sizeof(out));
+	ok(ret == strlen(ref) && memcmp(out, ref, ret) == 0,
+	   "test vector '%s' -> '%s'", in, ref);
+}
+
+static void test_vectorized(const uint8_t *data, unsigned features, const char *name)
+{
+	uint8_t text[2][2 * TEST_DATA_LEN];
+	bool enc_ok = true;
+
+	if ((cpu_features() & features) != features) {
+		diag("%s not supported by the CPU", name);
+	}
+
+	for (uint32_t len = 0; len <= TEST_DATA_LEN; len++) {
+		cpu_features_limit(0);
+		int32_t ref = base16_encode(data, len, text[0], sizeof(text[0]));
+		cpu_features_limit(features);
+		int32_t ret = base16_encode(data, len, text[1], sizeof(text[1]));
+		if (ret != ref || ret != 2 * len || memcmp(text[0], text[1], ret) != 0) {
+			enc_ok = false;
+		}
+	}
+	ok(enc_ok, "%s: encoding of data lengths 0-%u", name, TEST_DATA_LEN);
+
+	cpu_features_limit(~0U);
+}
+
+static void bench(unsigned features, const char *name)
+{
+	uint8_t *data = malloc(BENCH_DATA_LEN);
+	uint8_t *text = malloc(2 * BENCH_DATA_LEN);
+	if (data == NULL || text == NULL) {
+		free(data);
+		free(text);
+		return;
+	}
+
+	for (size_t i = 0; i < BENCH_DATA_LEN; i++) {
+		data[i] = rand();
+	}
+
+	cpu_features_limit(features);
+
+	struct timespec begin, end;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int i = 0; i < BENCH_ROUNDS; i++) {
+		base16_encode(data, BENCH_DATA_LEN, text, 2 * BENCH_DATA_LEN);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	cpu_features_limit(~0U);
+
+	double sec = (end.tv_sec - begin.tv_sec) +
+	             (end.tv_nsec - begin.tv_nsec) / 1e9;
+	diag("%s throughput: encode %.0f MB/s", name,
+	     sec > 0 ? (double)BENCH_ROUNDS * BENCH_DATA_LEN / sec / 1e6 : 0);
+
+	free(data);
+	free(text);
+}
+
+int main(int argc, char *argv[])
+{
+	plan(13);
+
+	int32_t ret;
+	uint8_t in[BUF_LEN], out[BUF_LEN], *out2;
+
+	// Invalid input.
+	ret = base16_encode(NULL, 0, out, BUF_LEN);
+	ok(ret == KNOT_EINVAL, "base16_encode: NULL input buffer");
+	ret = base16_encode(in, BUF_LEN, NULL, 0);
+	ok(ret == KNOT_EINVAL, "base16_encode: NULL output buffer");
+	ret = base16_encode(in, MAX_BIN_DATA_LEN + 1, out, BUF_LEN);
+	ok(ret == KNOT_ERANGE, "base16_encode: input buffer too large");
+	ret = base16_encode(in, BUF_LEN, out, BUF_LEN);
+	ok(ret == KNOT_ERANGE, "base16_encode: output buffer too small");
+
+	ret = base16_encode_alloc(NULL, 0, &out2);
+	ok(ret == KNOT_EINVAL, "base16_encode_alloc: NULL input buffer");
+	ret = base16_encode_alloc(in, MAX_BIN_DATA_LEN + 1, &out2);
+	ok(ret == KNOT_ERANGE, "base16_encode_alloc: input buffer too large");
+	ret = base16_encode_alloc(in, BUF_LEN, NULL);
+	ok(ret == KNOT_EINVAL, "base16_encode_alloc: NULL output buffer");
+
+	// Test vectors (RFC 4648).
+	test_vector("", "");
+	test_vector("f", "66");
+	test_vector("foobar", "666F6F626172");
+	test_vector("\xab\xcd\xef\x01\x23\x45\x67\x89\xff\xfe\xfd\xfc\xfb\xfa\xf9\xf8",
+	            "ABCDEF0123456789FFFEFDFCFBFAF9F8");
+
+	// Vectorized implementations.
+	uint8_t data[TEST_DATA_LEN];
+	srand(1);
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = rand();
+	}
+	for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+		test_vectorized(data, levels[i].features, levels[i].name);
+	}
+
+	// Throughput of the available implementations.
+	bench(0, "Scalar");
+	for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+		if ((cpu_features() & levels[i].features) == levels[i].features) {
+			bench(levels[i].features, levels[i].name);
+		}
+	}
+
+	return 0;
+}
@@ -14,21 +14,137 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <tap/basic.h>
 
 #include "libknot/libknot.h"
 #include "contrib/base64.h"
+#include "contrib/cpu.h"
 #include "contrib/openbsd/strlcpy.h"
 
 #define BUF_LEN			256
 #define MAX_BIN_DATA_LEN	((INT32_MAX / 4) * 3)
 
+/*! \brief Vectorized implementations checked against the scalar one. */
+static const struct {
+	unsigned features;
+	const char *name;
+} levels[] = {
+	{ CPU_SSSE3,            "SSSE3" },
+	{ CPU_SSSE3 | CPU_AVX2, "AVX2" },
+};
+
+#define TEST_DATA_LEN	300
+#define TEST_TEXT_LEN	96
+#define BENCH_DATA_LEN	(3 * 5 * 65536)
+#define BENCH_ROUNDS	16
+
+static void test_vectorized(const uint8_t *data, unsigned features, const char *name)
+{
+	uint8_t text[2][512], bin[2][512];
+	bool enc_ok = true, dec_ok = true, bad_ok = true;
+
+	if ((cpu_features() & features) != features) {
+		diag("%s not supported by the CPU", name);
+	}
+
+	// All data lengths, encoding and decoding.
+	for (uint32_t len = 0; len <= TEST_DATA_LEN; len++) {
+		cpu_features_limit(0);
+		int32_t ref = base64_encode(data, len, text[0], sizeof(text[0]));
+		cpu_features_limit(features);
+		int32_t ret = base64_encode(data, len, text[1], sizeof(text[1]));
+		if (ret != ref || ret < 0 || memcmp(text[0], text[1], ret) != 0) {
+			enc_ok = false;
+			continue;
+		}
+		ret = base64_decode(text[1], ref, bin[1], sizeof(bin[1]));
+		if (ret != len || memcmp(bin[1], data, len) != 0) {
+			dec_ok = false;
+		}
+	}
+	ok(enc_ok, "%s: encoding of data lengths 0-%u", name, TEST_DATA_LEN);
+	ok(dec_ok, "%s: decoding of data lengths 0-%u", name, TEST_DATA_LEN);
+
+	// Every character at every position.
+	cpu_features_limit(0);
+	int32_t text_len = base64_encode(data, TEST_TEXT_LEN / 4 * 3,
+	                                 text[0], sizeof(text[0]));
+	for (int32_t pos = 0; pos < text_len; pos++) {
+		for (int c = 0; c <= UINT8_MAX; c++) {
+			memcpy(text[1], text[0], text_len);
+			text[1][pos] = c;
+			cpu_features_limit(0);
+			int32_t ref = base64_decode(text[1], text_len, bin[0], sizeof(bin[0]));
+			cpu_features_limit(features);
+			int32_t ret = base64_decode(text[1], text_len, bin[1], sizeof(bin[1]));
+			if (ret != ref || (ret > 0 && memcmp(bin[0], bin[1], ret) != 0)) {
+				bad_ok = false;
+			}
+		}
+	}
+	ok(bad_ok, "%s: decoding of all characters at all positions", name);
+
+	cpu_features_limit(~0U);
+}
+
+static double rate(const struct timespec *begin, uint64_t bytes)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double sec = (end.tv_sec - begin->tv_sec) +
+	             (end.tv_nsec - begin->tv_nsec) / 1e9;
+	return sec > 0 ? bytes / sec / 1e6 : 0;
+}
+
+static void bench(unsigned features, const char *name)
+{
+	uint8_t *data = malloc(BENCH_DATA_LEN);
+	uint8_t *text = malloc(BENCH_DATA_LEN / 3 * 4);
+	if (data == NULL || text == NULL) {
+		free(data);
+		free(text);
+		return;
+	}
+
+	for (size_t i = 0; i < BENCH_DATA_LEN; i++) {
+		data[i] = rand();
+	}
+
+	cpu_features_limit(features);
+
+	struct timespec begin;
+	int32_t text_len = 0;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int i = 0; i < BENCH_ROUNDS; i++) {
+		text_len = base64_encode(data, BENCH_DATA_LEN, text,
+		                        BENCH_DATA_LEN / 3 * 4);
+	}
+	double enc_rate = rate(&begin, (uint64_t)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int i = 0; i < BENCH_ROUNDS; i++) {
+		base64_decode(text, text_len, data, BENCH_DATA_LEN);
+	}
+	double dec_rate = rate(&begin, (uint64_t)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+	cpu_features_limit(~0U);
+
+	diag("%s throughput: encode %.0f MB/s, decode %.0f MB/s",
+	     name, enc_rate, dec_rate);
+
+	free(data);
+	free(text);
+}
+
 int main(int argc, char *argv[])
 {
-	plan(52);
+	plan(58);
 
 	int32_t  ret;
 	uint8_t  in[BUF_LEN], ref[BUF_LEN], out[BUF_LEN], out2[BUF_LEN], *out3;
@@ -233,5 +349,24 @@ int main(int argc, char *argv[])
 	ret = base64_decode((uint8_t *)"AAA ", 4, out, BUF_LEN);
 	ok(ret == KNOT_BASE64_ECHAR, "Bad data character space");
 
+
+	// Vectorized implementations.
+	uint8_t data[TEST_DATA_LEN];
+	srand(1);
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = rand();
+	}
+	for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+		test_vectorized(data, levels[i].features, levels[i].name);
+	}
+
+	// Throughput of the available implementations.
+	bench(0, "Scalar");
+	for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+		if ((cpu_features() & levels[i].features) == levels[i].features) {
+			bench(levels[i].features, levels[i].name);
+		}
+	}
+
 	return 0;
 }
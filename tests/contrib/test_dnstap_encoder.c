@@ -0,0 +1,159 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/basic.h>
+
+#include "contrib/dnstap/dnstap.h"
+#include "contrib/dnstap/encoder.h"
+#include "contrib/dnstap/message.h"
+#include "libknot/errcode.h"
+
+static const uint8_t query[] = {
+	0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c', 'o', 'm', 0x00,
+	0x00, 0x01, 0x00, 0x01
+};
+
+static const uint8_t response[] = {
+	0x12, 0x34, 0x85, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+	0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c', 'o', 'm', 0x00,
+	0x00, 0x01, 0x00, 0x01,
+	0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x0E, 0x10, 0x00, 0x04,
+	0xC0, 0x00, 0x02, 0x01
+};
+
+/*! \brief Serializes the frame as the module did before the encoder. */
+static uint8_t *pack(const char *identity, const char *version,
+                     Dnstap__Message__Type type, const struct sockaddr *query_sa,
+                     const struct sockaddr *response_sa, int protocol,
+                     const void *wire, size_t len_wire,
+                     const struct timeval *qtime, const struct timeval *rtime,
+                     size_t *size)
+{
+	Dnstap__Message msg;
+	int ret = dt_message_fill(&msg, type, query_sa, response_sa, protocol,
+	                          wire, len_wire, qtime, rtime);
+	if (ret != KNOT_EOK) {
+		return NULL;
+	}
+
+	Dnstap__Dnstap dnstap = DNSTAP__DNSTAP__INIT;
+	dnstap.type = DNSTAP__DNSTAP__TYPE__MESSAGE;
+	dnstap.message = &msg;
+	if (identity != NULL && *identity != '\0') {
+		dnstap.identity.data = (uint8_t *)identity;
+		dnstap.identity.len = strlen(identity);
+		dnstap.has_identity = 1;
+	}
+	if (version != NULL && *version != '\0') {
+		dnstap.version.data = (uint8_t *)version;
+		dnstap.version.len = strlen(version);
+		dnstap.has_version = 1;
+	}
+
+	uint8_t *frame = NULL;
+	return dt_pack(&dnstap, &frame, size);
+}
+
+static void check(const char *msg, const char *identity, const char *version,
+                  Dnstap__Message__Type type, const struct sockaddr *query_sa,
+                  const struct sockaddr *response_sa, int protocol,
+                  const void *wire, size_t len_wire,
+                  const struct timeval *qtime, const struct timeval *rtime)
+{
+	size_t ref_size = 0;
+	uint8_t *ref = pack(identity, version, type, query_sa, response_sa,
+	                    protocol, wire, len_wire, qtime, rtime, &ref_size);
+
+	dt_encoder_t enc;
+	int ret = dt_encoder_init(&enc, identity, version);
+	size_t size = dt_encoder_max_size(&enc, len_wire);
+	uint8_t *frame = malloc(size);
+	if (ret == KNOT_EOK && frame != NULL) {
+		ret = dt_encode(&enc, frame, &size, type, query_sa, response_sa,
+		                protocol, wire, len_wire, qtime, rtime);
+	}
+
+	ok(ref != NULL && frame != NULL && ret == KNOT_EOK && size == ref_size &&
+	   memcmp(frame, ref, size) == 0, "encoder: %s", msg);
+
+	free(frame);
+	free(ref);
+	dt_encoder_deinit(&enc);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	struct sockaddr_in remote4 = {
+		.sin_family = AF_INET,
+		.sin_port = htons(53000)
+	};
+	inet_pton(AF_INET, "192.0.2.1", &remote4.sin_addr);
+
+	struct sockaddr_in local4 = {
+		.sin_family = AF_INET,
+		.sin_port = htons(53)
+	};
+	inet_pton(AF_INET, "192.0.2.53", &local4.sin_addr);
+
+	struct sockaddr_in6 remote6 = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(5353)
+	};
+	inet_pton(AF_INET6, "2001:db8::1", &remote6.sin6_addr);
+
+	struct timeval qtime = { .tv_sec = 1479000000, .tv_usec = 123456 };
+	struct timeval rtime = { .tv_sec = 1479000001, .tv_usec = 999999 };
+
+	const struct sockaddr *r4 = (const struct sockaddr *)&remote4;
+	const struct sockaddr *l4 = (const struct sockaddr *)&local4;
+	const struct sockaddr *r6 = (const struct sockaddr *)&remote6;
+
+	/* As logged by the module. */
+	check("query, UDP, IPv4", "ns1", "Knot DNS",
+	      DNSTAP__MESSAGE__TYPE__AUTH_QUERY, r4, NULL, IPPROTO_UDP,
+	      query, sizeof(query), &qtime, &qtime);
+	check("response, TCP, IPv6", "ns1", "Knot DNS",
+	      DNSTAP__MESSAGE__TYPE__AUTH_RESPONSE, r6, NULL, IPPROTO_TCP,
+	      response, sizeof(response), &qtime, &qtime);
+
+	/* Both addresses and distinct times. */
+	check("query, both addresses", "ns1", "Knot DNS",
+	      DNSTAP__MESSAGE__TYPE__AUTH_QUERY, r4, l4, IPPROTO_UDP,
+	      query, sizeof(query), &qtime, &rtime);
+	check("response, both addresses", "ns1", "Knot DNS",
+	      DNSTAP__MESSAGE__TYPE__AUTH_RESPONSE, r4, l4, IPPROTO_UDP,
+	      response, sizeof(response), &qtime, &rtime);
+
+	/* Optional fields left out. */
+	check("query, no identity and version", NULL, "",
+	      DNSTAP__MESSAGE__TYPE__AUTH_QUERY, r6, NULL, IPPROTO_TCP,
+	      query, sizeof(query), NULL, NULL);
+	check("response, response time only", "ns1", NULL,
+	      DNSTAP__MESSAGE__TYPE__AUTH_RESPONSE, NULL, l4, IPPROTO_UDP,
+	      response, sizeof(response), NULL, &rtime);
+	check("query, empty message", NULL, NULL,
+	      DNSTAP__MESSAGE__TYPE__AUTH_QUERY, r4, NULL, IPPROTO_UDP,
+	      NULL, 0, &qtime, NULL);
+
+	return 0;
+}
@@ -0,0 +1,244 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "contrib/dnstap/fields.h"
+#include "contrib/dnstap/mmap_reader.h"
+#include "contrib/wire.h"
+#include "libknot/errcode.h"
+
+#define FRAMES	40
+
+/*! \brief Protobuf message: TYPE=1 (varint 300), unknown 7 (fixed64),
+ *         MESSAGE=14 (bytes "abc"), TYPE=1 again (varint 5),
+ *         QUERY_TIME_NSEC=9 (fixed32 0x01020304). */
+static const uint8_t msg[] = {
+	0x08, 0xAC, 0x02,
+	0x39, 1, 2, 3, 4, 5, 6, 7, 8,
+	0x72, 0x03, 'a', 'b', 'c',
+	0x08, 0x05,
+	0x4D, 0x04, 0x03, 0x02, 0x01
+};
+
+static void test_fields(void)
+{
+	dt_field_t f[DT_FIELD_MAX + 1];
+	memset(f, 0, sizeof(f));
+
+	uint32_t mask = DT_FIELD(1) | DT_FIELD(9) | DT_FIELD(14) | DT_FIELD(20);
+	int ret = dt_fields_get(msg, sizeof(msg), mask, f);
+	ok(ret == KNOT_EOK, "fields: decode");
+	ok(f[1].present && f[1].num == 300, "fields: first varint occurrence");
+	ok(f[9].present && f[9].num == 0x01020304, "fields: fixed32");
+	ok(f[14].present && f[14].len == 3 && memcmp(f[14].data, "abc", 3) == 0,
+	   "fields: bytes in place");
+	ok(!f[20].present, "fields: missing field");
+	ok(!f[7].present, "fields: unmasked field ignored");
+
+	ret = dt_fields_get(msg, sizeof(msg), DT_FIELD(7), f);
+	ok(ret == KNOT_EOK && f[7].present && f[7].num == 0x0807060504030201ULL,
+	   "fields: fixed64");
+
+	/* All the truncations of the varint, fixed and bytes fields. */
+	const size_t cuts[] = { 1, 2, 5, 14, 16, 21 };
+	for (size_t i = 0; i < sizeof(cuts) / sizeof(*cuts); i++) {
+		ret = dt_fields_get(msg, cuts[i], DT_FIELD(9), f);
+		ok(ret == KNOT_EMALF, "fields: truncated at %zu", cuts[i]);
+	}
+
+	/* Early stop before the malformed tail. */
+	ret = dt_fields_get(msg, 14, DT_FIELD(1), f);
+	ok(ret == KNOT_EOK && f[1].num == 300, "fields: stop when found");
+
+	const uint8_t bad_type[] = { 0x0B, 0x00 };
+	ret = dt_fields_get(bad_type, sizeof(bad_type), DT_FIELD(1), f);
+	ok(ret == KNOT_EMALF, "fields: unsupported wire type");
+
+	const uint8_t long_varint[] = { 0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	                                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+	ret = dt_fields_get(long_varint, sizeof(long_varint), DT_FIELD(1), f);
+	ok(ret == KNOT_EMALF, "fields: overlong varint");
+
+	ret = dt_fields_get(NULL, 0, DT_FIELD(1), f);
+	ok(ret == KNOT_EINVAL, "fields: invalid");
+}
+
+static uint8_t *put_u32(uint8_t *pos, uint32_t val)
+{
+	wire_write_u32(pos, val);
+	return pos + sizeof(uint32_t);
+}
+
+static uint8_t *put_control(uint8_t *pos, uint32_t type, const char *content)
+{
+	size_t len = (content != NULL) ? strlen(content) : 0;
+	pos = put_u32(pos, 0);
+	pos = put_u32(pos, sizeof(uint32_t) + (len > 0 ? 2 * sizeof(uint32_t) + len : 0));
+	pos = put_u32(pos, type);
+	if (len > 0) {
+		pos = put_u32(pos, 1);
+		pos = put_u32(pos, len);
+		memcpy(pos, content, len);
+		pos += len;
+	}
+	return pos;
+}
+
+/*! \brief Data frame with the frame number in a varint field. */
+static uint8_t *put_frame(uint8_t *pos, unsigned num)
+{
+	pos = put_u32(pos, 2);
+	*pos++ = 0x08;
+	*pos++ = num;
+	return pos;
+}
+
+static size_t make_file(uint8_t *buf, const char *content, bool stop)
+{
+	uint8_t *pos = put_control(buf, 2, content);
+	for (unsigned i = 0; i < FRAMES; i++) {
+		pos = put_frame(pos, i);
+		if (i == FRAMES / 2) {
+			/* Unexpected control frame is skipped. */
+			pos = put_control(pos, 4, NULL);
+		}
+	}
+	if (stop) {
+		pos = put_control(pos, 3, NULL);
+		/* Garbage after the stop frame. */
+		pos = put_u32(pos, 0xFFFFFFFF);
+	}
+	return pos - buf;
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t len)
+{
+	FILE *f = fopen(path, "w");
+	if (f == NULL || fwrite(data, 1, len, f) != len) {
+		bail("failed to write test file");
+	}
+	fclose(f);
+}
+
+/*! \brief Reads the range, checks the frame order, returns the last ret. */
+static int read_range(const dt_mmap_reader_t *reader, size_t begin, size_t end,
+                      unsigned *next)
+{
+	int ret = KNOT_EOK;
+	size_t offset = begin;
+	while (offset < end) {
+		const uint8_t *frame;
+		size_t len;
+		ret = dt_mmap_reader_next(reader, &offset, &frame, &len);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+		dt_field_t f[DT_FIELD_MAX + 1];
+		if (len != 2 || dt_fields_get(frame, len, DT_FIELD(1), f) != KNOT_EOK ||
+		    f[1].num != *next) {
+			return KNOT_ERROR;
+		}
+		(*next)++;
+	}
+	return ret;
+}
+
+static void test_reader(const char *tmpdir)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tmpdir, "test.tap");
+
+	uint8_t buf[1024];
+	dt_mmap_reader_t reader;
+
+	int ret = dt_mmap_reader_open(&reader, path);
+	ok(ret == KNOT_EFILE, "reader: missing file");
+
+	write_file(path, buf, 0);
+	ret = dt_mmap_reader_open(&reader, path);
+	ok(ret == KNOT_EMALF, "reader: empty file");
+
+	size_t len = make_file(buf, "protobuf:other", true);
+	write_file(path, buf, len);
+	ret = dt_mmap_reader_open(&reader, path);
+	ok(ret == KNOT_EMALF, "reader: other content type");
+
+	len = make_file(buf, "protobuf:dnstap.Dnstap", true);
+	write_file(path, buf, len);
+	ret = dt_mmap_reader_open(&reader, path);
+	ok(ret == KNOT_EOK, "reader: open");
+
+	unsigned next = 0;
+	ret = read_range(&reader, reader.start, reader.size, &next);
+	ok(ret == KNOT_EOF && next == FRAMES, "reader: read all frames");
+
+	for (size_t count = 1; count <= FRAMES + 5; count += 4) {
+		size_t bounds[FRAMES + 6];
+		dt_mmap_reader_split(&reader, count, bounds);
+		next = 0;
+		bool valid = (bounds[0] == reader.start && bounds[count] == reader.size);
+		for (size_t i = 0; i < count && valid; i++) {
+			ret = read_range(&reader, bounds[i], bounds[i + 1], &next);
+			valid = (bounds[i] <= bounds[i + 1]) &&
+			        (ret == KNOT_EOK || ret == KNOT_EOF);
+		}
+		ok(valid && next == FRAMES, "reader: split into %zu ranges", count);
+	}
+	dt_mmap_reader_close(&reader);
+
+	/* Truncated file without the stop frame. */
+	len = make_file(buf, "protobuf:dnstap.Dnstap", false);
+	write_file(path, buf, len - 1);
+	ret = dt_mmap_reader_open(&reader, path);
+	ok(ret == KNOT_EOK, "reader: open truncated");
+
+	next = 0;
+	ret = read_range(&reader, reader.start, reader.size, &next);
+	ok(ret == KNOT_EMALF && next == FRAMES - 1, "reader: truncated frame");
+
+	size_t bounds[4];
+	dt_mmap_reader_split(&reader, 3, bounds);
+	next = 0;
+	for (size_t i = 0; i < 3; i++) {
+		ret = read_range(&reader, bounds[i], bounds[i + 1], &next);
+	}
+	ok(ret == KNOT_EMALF && next == FRAMES - 1, "reader: split truncated");
+	dt_mmap_reader_close(&reader);
+
+	remove(path);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	test_fields();
+
+	char *tmpdir = test_mkdtemp();
+	if (tmpdir == NULL) {
+		bail("failed to create temporary directory");
+	}
+	test_reader(tmpdir);
+	test_rm_rf(tmpdir);
+	free(tmpdir);
+
+	return 0;
+}
@@ -0,0 +1,216 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/basic.h>
+
+#include "contrib/lpm.h"
+#include "contrib/sockaddr.h"
+#include "libknot/errcode.h"
+
+#define RANDOM_NETS	300
+#define RANDOM_CHECKS	20000
+
+static struct sockaddr_storage ss;
+
+static const struct sockaddr *addr(int family, const char *str)
+{
+	sockaddr_set(&ss, family, str, 0);
+	return (struct sockaddr *)&ss;
+}
+
+static void add_net(lpm_t *lpm, int family, const char *str, unsigned prefix,
+                    uint16_t value)
+{
+	int ret = lpm_add(lpm, addr(family, str), prefix, value);
+	ok(ret == KNOT_EOK, "lpm: add network %s/%u", str, prefix);
+}
+
+static void check(const lpm_t *lpm, int family, const char *str, unsigned len,
+                  uint16_t value, unsigned scope)
+{
+	uint8_t raw[16];
+	inet_pton(family, str, raw);
+
+	unsigned res_scope = 0;
+	uint16_t res = lpm_lookup(lpm, family, raw, len, &res_scope);
+	ok(res == value && res_scope == scope, "lpm: %s/%u value %u scope %u",
+	   str, len, value, scope);
+}
+
+/*! \brief Reference network for the randomized comparison. */
+typedef struct {
+	uint8_t addr[16];
+	unsigned prefix;
+	uint16_t value;
+} net_t;
+
+static bool net_match(const net_t *net, const uint8_t *addr, unsigned len)
+{
+	if (net->prefix > len) {
+		return false;
+	}
+	for (unsigned i = 0; i < net->prefix; i++) {
+		unsigned bit = 7 - i % 8;
+		if (((net->addr[i / 8] ^ addr[i / 8]) >> bit) & 1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint16_t naive_lookup(const net_t *nets, size_t count,
+                             const uint8_t *addr, unsigned len)
+{
+	uint16_t value = LPM_NONE;
+	unsigned best = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (net_match(&nets[i], addr, len) &&
+		    (value == LPM_NONE || nets[i].prefix > best)) {
+			value = nets[i].value;
+			best = nets[i].prefix;
+		}
+	}
+	return value;
+}
+
+static void random_addr(uint8_t *addr, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		addr[i] = (i < 2) ? (random() & 0x1f) : random();
+	}
+}
+
+static void random_check(int family, size_t size)
+{
+	static net_t nets[RANDOM_NETS];
+	size_t count = 0;
+
+	lpm_t *lpm = lpm_new();
+	while (count < RANDOM_NETS) {
+		net_t *net = &nets[count];
+		random_addr(net->addr, size);
+		net->prefix = random() % (size * 8 + 1);
+		net->value = count + 1;
+
+		struct sockaddr_storage sa;
+		sockaddr_set_raw(&sa, family, net->addr, size);
+		if (lpm_add(lpm, (struct sockaddr *)&sa, net->prefix,
+		            net->value) == KNOT_EOK) {
+			count++;
+		}
+	}
+	lpm_build(lpm);
+
+	bool match = true, scoped = true;
+	for (int i = 0; i < RANDOM_CHECKS; i++) {
+		uint8_t query[16];
+		random_addr(query, size);
+		unsigned len = (i % 2 == 0) ? size * 8 : random() % (size * 8 + 1);
+
+		unsigned scope = 0;
+		uint16_t value = lpm_lookup(lpm, family, query, len, &scope);
+		if (value != naive_lookup(nets, count, query, len) || scope > len) {
+			match = false;
+			break;
+		}
+
+		/* Any address with the same scope bits must give the same result. */
+		uint8_t other[16];
+		random_addr(other, size);
+		for (unsigned b = 0; b < scope; b++) {
+			uint8_t mask = 0x80 >> (b % 8);
+			other[b / 8] = (other[b / 8] & ~mask) | (query[b / 8] & mask);
+		}
+		if (naive_lookup(nets, count, other, len) != value) {
+			scoped = false;
+			break;
+		}
+	}
+	ok(match, "lpm: random %s lookups match", family == AF_INET ? "IPv4" : "IPv6");
+	ok(scoped, "lpm: random %s scopes hold", family == AF_INET ? "IPv4" : "IPv6");
+
+	lpm_free(lpm);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	lpm_t *lpm = lpm_new();
+	ok(lpm != NULL, "lpm: new");
+
+	/* Empty table. */
+	lpm_build(lpm);
+	check(lpm, AF_INET, "192.0.2.1", 32, LPM_NONE, 0);
+	check(lpm, AF_INET6, "2001:db8::1", 128, LPM_NONE, 0);
+
+	/* Invalid additions. */
+	ok(lpm_add(lpm, addr(AF_INET, "10.0.0.0"), 33, 1) == KNOT_EINVAL,
+	   "lpm: too long prefix");
+	ok(lpm_add(lpm, addr(AF_INET, "10.0.0.0"), 8, LPM_NONE) == KNOT_EINVAL,
+	   "lpm: no value");
+
+	add_net(lpm, AF_INET, "10.0.0.0", 8, 1);
+	add_net(lpm, AF_INET, "10.1.0.0", 16, 2);
+	add_net(lpm, AF_INET, "10.1.2.128", 25, 3);
+	add_net(lpm, AF_INET, "192.0.2.1", 32, 4);
+	add_net(lpm, AF_INET6, "2001:db8::", 32, 5);
+	add_net(lpm, AF_INET6, "2001:db8:0:100::", 56, 6);
+	add_net(lpm, AF_INET6, "::", 0, 7);
+	ok(lpm_add(lpm, addr(AF_INET, "10.1.255.255"), 16, 8) == KNOT_EEXIST,
+	   "lpm: duplicate network");
+	ok(lpm_build(lpm) == KNOT_EOK, "lpm: build");
+
+	/* Full addresses. */
+	check(lpm, AF_INET, "10.2.3.4", 32, 1, 15);
+	check(lpm, AF_INET, "10.1.3.4", 32, 2, 24);
+	check(lpm, AF_INET, "10.1.2.4", 32, 2, 25);
+	check(lpm, AF_INET, "10.1.2.200", 32, 3, 25);
+	check(lpm, AF_INET, "11.0.0.1", 32, LPM_NONE, 8);
+	check(lpm, AF_INET, "192.0.2.1", 32, 4, 32);
+	check(lpm, AF_INET, "192.0.2.2", 32, LPM_NONE, 31);
+	check(lpm, AF_INET6, "2001:db8:0:1ff::1", 128, 6, 56);
+	check(lpm, AF_INET6, "2001:db8:1::1", 128, 5, 48);
+	check(lpm, AF_INET6, "2001:db9::1", 128, 7, 32);
+
+	/* Shortened source prefixes. */
+	check(lpm, AF_INET, "10.1.2.0", 24, 2, 24);
+	check(lpm, AF_INET, "10.1.0.0", 12, 1, 12);
+	check(lpm, AF_INET, "10.0.0.0", 7, LPM_NONE, 7);
+	check(lpm, AF_INET, "0.0.0.0", 0, LPM_NONE, 0);
+	check(lpm, AF_INET6, "::", 0, 7, 0);
+	check(lpm, AF_INET6, "2001:db8:0:100::", 56, 6, 56);
+	check(lpm, AF_INET6, "2001:db8:0:100::", 52, 5, 52);
+	check(lpm, AF_INET6, "2001:db8::", 200, 5, 56);
+
+	/* Unknown family. */
+	uint8_t raw[16] = { 0 };
+	unsigned scope = 1;
+	ok(lpm_lookup(lpm, AF_UNIX, raw, 32, &scope) == LPM_NONE && scope == 0,
+	   "lpm: unknown family");
+
+	lpm_free(lpm);
+
+	/* Comparison with a naive implementation. */
+	srandom(1);
+	random_check(AF_INET, 4);
+	random_check(AF_INET6, 16);
+
+	return 0;
+}
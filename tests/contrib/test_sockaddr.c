@@ -177,6 +177,16 @@ static void test_range_match(void)
 	ret = sockaddr_range_match(SA(&t), SA(&min), SA(&max));
 	ok(ret == false, "match: ipv4 middle range - negative far max");
 
+	check_sockaddr_set(&min, AF_INET, "1.0.0.255", 53);
+	check_sockaddr_set(&max, AF_INET, "2.0.0.0", 53);
+
+	check_sockaddr_set(&t, AF_INET, "1.0.1.0", 0);
+	ret = sockaddr_range_match(SA(&t), SA(&min), SA(&max));
+	ok(ret == true, "match: ipv4 byte order range - middle, other port");
+	check_sockaddr_set(&t, AF_INET, "1.0.0.254", 53);
+	ret = sockaddr_range_match(SA(&t), SA(&min), SA(&max));
+	ok(ret == false, "match: ipv4 byte order range - negative min");
+
 	// IPv6 tests.
 
 	check_sockaddr_set(&min, AF_INET6, "::0", 0);
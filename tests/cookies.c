@@ -0,0 +1,93 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tap/basic.h>
+
+#include "dnssec/crypto.h"
+#include "knot/server/cookies.h"
+#include "libknot/errcode.h"
+#include "contrib/sockaddr.h"
+
+#define NOW 1000000
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	dnssec_crypto_init();
+
+	const uint8_t cc[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	uint8_t sc[COOKIE_SRVR_LEN];
+	struct knot_dns_cookies cookies = { .cc = cc, .cc_len = sizeof(cc) };
+
+	struct sockaddr_storage addr, other;
+	sockaddr_set(&addr, AF_INET, "1.2.3.4", 0);
+	sockaddr_set(&other, AF_INET6, "1122:3344:5566:7788::aabb", 0);
+	const struct sockaddr *remote = (struct sockaddr *)&addr;
+
+	/* Create secrets without scheduler. */
+	cookie_secret_t *cs = cookie_secret_create(NULL, 3600);
+	ok(cs != NULL, "cookies: create");
+
+	/* Generate and check. */
+	uint16_t sc_len = cookie_generate(cs, &cookies, remote, NOW, sc, sizeof(sc));
+	is_int(COOKIE_SRVR_LEN, sc_len, "cookies: generate");
+	cookies.sc = sc;
+	cookies.sc_len = sc_len;
+	is_int(KNOT_EOK, cookie_check(cs, &cookies, remote, NOW), "cookies: valid");
+
+	/* Different client. */
+	is_int(KNOT_EINVAL, cookie_check(cs, &cookies, (struct sockaddr *)&other, NOW),
+	       "cookies: different client address");
+
+	/* Tampered timestamp. */
+	sc[7] ^= 0x01;
+	is_int(KNOT_EINVAL, cookie_check(cs, &cookies, remote, NOW),
+	       "cookies: tampered nonce");
+	sc[7] ^= 0x01;
+
+	/* Stale and future cookies. */
+	is_int(KNOT_EINVAL, cookie_check(cs, &cookies, remote, NOW + 3 * 3600),
+	       "cookies: expired timestamp");
+	is_int(KNOT_EINVAL, cookie_check(cs, &cookies, remote, NOW - 3600),
+	       "cookies: timestamp in the future");
+
+	/* Previous secret is accepted after one rotation. */
+	is_int(KNOT_EOK, cookie_secret_rotate(cs), "cookies: rotate");
+	is_int(KNOT_EOK, cookie_check(cs, &cookies, remote, NOW),
+	       "cookies: previous secret valid");
+
+	/* Second rotation invalidates it. */
+	cookie_secret_rotate(cs);
+	is_int(KNOT_EINVAL, cookie_check(cs, &cookies, remote, NOW),
+	       "cookies: discarded secret invalid");
+
+	/* Short server cookie buffer. */
+	is_int(0, cookie_generate(cs, &cookies, remote, NOW, sc, COOKIE_SRVR_LEN - 1),
+	       "cookies: short buffer");
+
+	/* Missing server cookie. */
+	cookies.sc = NULL;
+	cookies.sc_len = 0;
+	is_int(KNOT_EINVAL, cookie_check(cs, &cookies, remote, NOW),
+	       "cookies: missing server cookie");
+
+	cookie_secret_destroy(cs);
+
+	dnssec_crypto_cleanup();
+
+	return 0;
+}
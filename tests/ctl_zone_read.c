@@ -0,0 +1,216 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+#include <urcu.h>
+
+#include "knot/ctl/commands.h"
+#include "knot/zone/zone.h"
+#include "knot/zone/zonedb.h"
+#include "libknot/libknot.h"
+#include "contrib/mempattern.h"
+#include "contrib/ucw/mempool.h"
+#include "contrib/wire_ctx.h"
+
+/* Several socket buffers of records. */
+#define NODES	100000
+
+typedef struct {
+	ctl_args_t args;
+	int ret;
+} reader_t;
+
+static zone_contents_t *create_contents(const knot_dname_t *apex, int nodes)
+{
+	zone_contents_t *contents = zone_contents_new(apex);
+	if (contents == NULL) {
+		return NULL;
+	}
+
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	for (int i = 0; i < nodes; i++) {
+		char owner_str[32];
+		snprintf(owner_str, sizeof(owner_str), "n%i.test.", i);
+		knot_dname_t *owner = knot_dname_from_str_alloc(owner_str);
+		knot_rrset_t *rr = knot_rrset_new(owner, KNOT_RRTYPE_A,
+		                                  KNOT_CLASS_IN, NULL);
+		knot_dname_free(&owner, NULL);
+		knot_rrset_add_rdata(rr, addr, sizeof(addr), 3600, NULL);
+
+		zone_node_t *node = NULL;
+		int ret = zone_contents_add_rr(contents, rr, &node);
+		knot_rrset_free(&rr, NULL);
+		if (ret != KNOT_EOK) {
+			zone_contents_deep_free(&contents);
+			return NULL;
+		}
+	}
+
+	return contents;
+}
+
+static void *reader(void *data)
+{
+	reader_t *r = data;
+
+	rcu_register_thread();
+	r->ret = ctl_exec(CTL_ZONE_READ, &r->args);
+	knot_ctl_send(r->args.ctl, KNOT_CTL_TYPE_BLOCK, NULL);
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+/*! \brief Counts records in bulk units until the end of the block. */
+static int receive_records(knot_ctl_t *ctl, size_t *count)
+{
+	*count = 0;
+
+	while (true) {
+		knot_ctl_type_t type;
+		int ret = knot_ctl_receive(ctl, &type, NULL);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		if (type == KNOT_CTL_TYPE_BLOCK) {
+			return KNOT_EOK;
+		} else if (type != KNOT_CTL_TYPE_BULK) {
+			return KNOT_EMALF;
+		}
+
+		size_t len = 0;
+		const uint8_t *wire = knot_ctl_bulk(ctl, &len);
+		wire_ctx_t ctx = wire_ctx_init_const(wire, len);
+		while (wire_ctx_available(&ctx) > 0) {
+			// Owner, type, class, TTL, and RDATA.
+			int owner_len = knot_dname_size(ctx.position);
+			wire_ctx_skip(&ctx, owner_len + 2 * sizeof(uint16_t) +
+			                    sizeof(uint32_t));
+			wire_ctx_skip(&ctx, wire_ctx_read_u16(&ctx));
+			if (owner_len <= 0 || ctx.error != KNOT_EOK) {
+				return KNOT_EMALF;
+			}
+			(*count)++;
+		}
+	}
+}
+
+static unsigned pins(zone_t *zone)
+{
+	pthread_mutex_lock(&zone->flush.lock);
+	unsigned count = zone->flush.pins;
+	pthread_mutex_unlock(&zone->flush.lock);
+
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	rcu_register_thread();
+
+	char *tmpdir = test_mkdtemp();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tmpdir, "knot.sock");
+
+	/* Server with a zone. */
+	knot_dname_t *apex = knot_dname_from_str_alloc("test.");
+	zone_t *zone = zone_new(apex);
+	zone->contents = create_contents(apex, NODES);
+	ok(zone->contents != NULL, "zone read: create contents");
+
+	server_t server = { .zone_db = knot_zonedb_new(1) };
+	pthread_rwlock_init(&server.ctl_lock, NULL);
+	pthread_mutex_init(&server.ctl_conf_lock, NULL);
+	knot_zonedb_insert(server.zone_db, zone);
+	knot_zonedb_build_index(server.zone_db);
+
+	/* Control connection, the client doesn't read for now. */
+	knot_ctl_t *listener = knot_ctl_alloc();
+	knot_ctl_t *client = knot_ctl_alloc();
+	ok(knot_ctl_bind(listener, path) == KNOT_EOK, "zone read: bind");
+	ok(knot_ctl_connect(client, path) == KNOT_EOK, "zone read: connect");
+	ok(knot_ctl_accept(listener) == KNOT_EOK, "zone read: accept");
+	ok(knot_ctl_send(client, KNOT_CTL_TYPE_BLOCK, NULL) == KNOT_EOK,
+	   "zone read: send request end");
+
+	reader_t r = {
+		.args = {
+			.ctl = listener,
+			.type = KNOT_CTL_TYPE_DATA,
+			.data = {
+				[KNOT_CTL_IDX_ZONE] = "test.",
+				[KNOT_CTL_IDX_FLAGS] = CTL_FLAG_BULK
+			},
+			.server = &server
+		},
+		.ret = KNOT_ERROR
+	};
+	mm_ctx_mempool(&r.args.mm, MM_DEFAULT_BLKSIZE);
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, reader, &r);
+	while (pins(zone) == 0) {
+		sched_yield();
+	}
+
+	/* Replace the contents while the reader is stuck on the client. */
+	zone_contents_t *old = zone_switch_contents(zone, create_contents(apex, 1));
+	synchronize_rcu();
+	zone_contents_retire(zone, &old, NULL);
+	ok(old == NULL, "zone read: replaced contents retired");
+
+	pthread_mutex_lock(&zone->flush.lock);
+	bool deferred = !EMPTY_LIST(zone->flush.retired);
+	pthread_mutex_unlock(&zone->flush.lock);
+	ok(deferred, "zone read: reclamation deferred by the reader");
+
+	/* The client resumes, the reader sends the pinned contents. */
+	size_t count = 0;
+	ok(receive_records(client, &count) == KNOT_EOK, "zone read: receive");
+	pthread_join(thread, NULL);
+	is_int(KNOT_EOK, r.ret, "zone read: sent");
+	ok(count == NODES, "zone read: consistent snapshot");
+
+	pthread_mutex_lock(&zone->flush.lock);
+	ok(zone->flush.pins == 0 && EMPTY_LIST(zone->flush.retired),
+	   "zone read: unpinned and reclaimed");
+	pthread_mutex_unlock(&zone->flush.lock);
+
+	mp_delete(r.args.mm.ctx);
+	knot_ctl_close(client);
+	knot_ctl_free(client);
+	knot_ctl_close(listener);
+	knot_ctl_unbind(listener);
+	knot_ctl_free(listener);
+
+	knot_zonedb_deep_free(&server.zone_db);
+	pthread_mutex_destroy(&server.ctl_conf_lock);
+	pthread_rwlock_destroy(&server.ctl_lock);
+	knot_dname_free(&apex, NULL);
+
+	test_rm_rf(tmpdir);
+	free(tmpdir);
+
+	rcu_unregister_thread();
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <tap/basic.h>
+#include <urcu.h>
+
+#include "knot/server/ddns-batch.h"
+#include "knot/zone/zone.h"
+#include "libknot/libknot.h"
+
+/*! \brief Window not closed by the thread during the test. */
+#define LONG_WINDOW	60000
+#define SHORT_WINDOW	10
+#define TIMEOUT		5
+
+static bool scheduled(zone_t *zone)
+{
+	return zone_events_is_scheduled(zone, ZONE_EVENT_UPDATE);
+}
+
+/*! \brief Wait for the thread to close the window, with a generous timeout. */
+static bool wait_scheduled(zone_t *zone)
+{
+	time_t end = time(NULL) + TIMEOUT;
+	while (!scheduled(zone) && time(NULL) < end) {
+		usleep(1000);
+	}
+
+	return scheduled(zone);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	rcu_register_thread();
+
+	knot_dname_t *name1 = knot_dname_from_str_alloc("one.test.");
+	knot_dname_t *name2 = knot_dname_from_str_alloc("two.test.");
+	knot_dname_t *name3 = knot_dname_from_str_alloc("three.test.");
+	knot_dname_t *missing = knot_dname_from_str_alloc("missing.test.");
+
+	knot_zonedb_t *db = knot_zonedb_new(3);
+	zone_t *zone1 = zone_new(name1);
+	zone_t *zone2 = zone_new(name2);
+	zone_t *zone3 = zone_new(name3);
+	knot_zonedb_insert(db, zone1);
+	knot_zonedb_insert(db, zone2);
+	knot_zonedb_insert(db, zone3);
+	knot_zonedb_build_index(db);
+
+	/* Missing context. */
+	is_int(KNOT_ENOTSUP, ddns_batch_add(NULL, name1), "ddns batch: no context");
+
+	/* Disabled batching. */
+	ddns_batch_t *batch = ddns_batch_create(&db, DDNS_BATCH_OFF);
+	ok(batch != NULL, "ddns batch: create");
+	is_int(KNOT_ENOTSUP, ddns_batch_add(batch, name1), "ddns batch: disabled");
+
+	/* Zones collected in one window. */
+	ddns_batch_set_window(batch, LONG_WINDOW);
+	is_int(KNOT_EOK, ddns_batch_add(batch, name1), "ddns batch: add zone");
+	is_int(KNOT_EOK, ddns_batch_add(batch, name1), "ddns batch: add zone again");
+	is_int(KNOT_EOK, ddns_batch_add(batch, name2), "ddns batch: add other zone");
+	is_int(KNOT_EOK, ddns_batch_add(batch, missing), "ddns batch: add removed zone");
+	ok(!scheduled(zone1) && !scheduled(zone2), "ddns batch: window open");
+
+	ddns_batch_close(batch);
+	ok(scheduled(zone1) && scheduled(zone2), "ddns batch: window closed");
+	ok(!scheduled(zone3), "ddns batch: other zone not planned");
+
+	/* Window closed by the thread. */
+	ddns_batch_set_window(batch, SHORT_WINDOW);
+	is_int(KNOT_EOK, ddns_batch_add(batch, name3), "ddns batch: add to next batch");
+	ok(wait_scheduled(zone3), "ddns batch: window expired");
+
+	ddns_batch_destroy(batch);
+
+	knot_zonedb_deep_free(&db);
+	knot_dname_free(&name1, NULL);
+	knot_dname_free(&name2, NULL);
+	knot_dname_free(&name3, NULL);
+	knot_dname_free(&missing, NULL);
+
+	rcu_unregister_thread();
+
+	return 0;
+}
@@ -25,6 +25,7 @@
 
 #include "libknot/libknot.h"
 #include "knot/server/journal.h"
+#include "knot/updates/apply.h"
 #include "knot/zone/zone.h"
 
 #define RAND_RR_LABEL 16
@@ -147,6 +148,62 @@ static bool changesets_eq(const changeset_t *ch1, changeset_t *ch2)
 	return ret;
 }
 
+static int replay_entry(const uint8_t *data, size_t size, void *ctx)
+{
+	return apply_serialized_directly(ctx, data, size);
+}
+
+/*! \brief Check that in place replay of the stored changeset applies it. */
+static bool changeset_applied(const zone_contents_t *contents, const changeset_t *ch)
+{
+	if (zone_contents_serial(contents) != knot_soa_serial(&ch->soa_to->rrs)) {
+		return false;
+	}
+
+	changeset_iter_t it;
+	changeset_iter_add(&it, ch);
+	knot_rrset_t rr = changeset_iter_next(&it);
+	bool ret = true;
+	while (!knot_rrset_empty(&rr)) {
+		const zone_node_t *node = zone_contents_find_node(contents, rr.owner);
+		knot_rrset_t zone_rr = node_rrset(node, rr.type);
+		if (!knot_rrset_equal(&rr, &zone_rr, KNOT_RRSET_COMPARE_WHOLE)) {
+			ret = false;
+			break;
+		}
+		rr = changeset_iter_next(&it);
+	}
+	changeset_iter_clear(&it);
+
+	return ret;
+}
+
+static void test_replay(const char *jfilename, const changeset_t *ch)
+{
+	zone_contents_t *contents = zone_contents_new(ch->soa_from->owner);
+	zone_node_t *unused = NULL;
+	int ret = zone_contents_add_rr(contents, ch->soa_from, &unused);
+	assert(ret == KNOT_EOK);
+
+	apply_ctx_t a_ctx = { 0 };
+	apply_init_ctx(&a_ctx, contents, 0);
+	ret = journal_read_changesets(jfilename, 0, 1, replay_entry, &a_ctx);
+	is_int(KNOT_EOK, ret, "journal: replay changeset in place");
+	ok(changeset_applied(contents, ch), "journal: replayed changeset applied");
+	update_cleanup(&a_ctx);
+
+	/* Serial mismatch. */
+	apply_init_ctx(&a_ctx, contents, 0);
+	ret = journal_read_changesets(jfilename, 0, 1, replay_entry, &a_ctx);
+	is_int(KNOT_EINVAL, ret, "journal: replay onto different serial");
+	update_cleanup(&a_ctx);
+
+	ret = journal_read_changesets(jfilename, 5, 6, replay_entry, &a_ctx);
+	is_int(KNOT_ENOENT, ret, "journal: replay missing changeset");
+
+	zone_contents_deep_free(&contents);
+}
+
 /*! \brief Journal fillup test with size check. */
 static void test_fillup(journal_t *journal, size_t fsize, unsigned iter, size_t chunk_size)
 {
@@ -231,6 +288,7 @@ static void test_store_load(const char *jfilename)
 	init_list(&l);
 	ret = journal_load_changesets(jfilename, z.name, &l, 0, 1);
 	ok(ret == KNOT_EOK && changesets_eq(TAIL(l), &ch), "journal: load changeset");
+	test_replay(jfilename, &ch);
 	changeset_clear(&ch);
 	changesets_free(&l);
 	init_list(&l);
@@ -251,6 +309,14 @@ static void test_store_load(const char *jfilename)
 	changesets_free(&l);
 	ok(ret == KNOT_EOK, "journal: load changesets");
 
+	/* Partial flush to an unknown serial keeps the journal full. */
+	ret = journal_mark_synced_to(jfilename, serial + 100);
+	ok(ret == KNOT_EOK, "journal: partial flush");
+	init_random_changeset(&ch, serial, serial + 1, 128, apex);
+	ret = journal_store_changeset(&ch, jfilename, filesize);
+	changeset_clear(&ch);
+	ok(ret == KNOT_EBUSY, "journal: store after partial flush");
+
 	/* Flush the journal. */
 	ret = journal_mark_synced(jfilename);
 	ok(ret == KNOT_EOK, "journal: flush");
@@ -268,6 +334,63 @@ static void test_store_load(const char *jfilename)
 	ok(ret == KNOT_EOK, "journal: load changesets after flush");
 }
 
+/*! \brief Test storing changesets into the journal kept open. */
+static void test_reopen(const char *jfilename)
+{
+	const size_t filesize = 100 * 1024;
+	uint8_t *apex = (uint8_t *)"\4test";
+
+	journal_t *journal = NULL;
+	int ret = journal_reopen(&journal, jfilename, filesize);
+	ok(ret == KNOT_EOK && journal != NULL, "journal: open by reopen");
+	journal_unlock(journal);
+	journal_t *kept = journal;
+
+	/* Consecutive stores reuse the open journal. */
+	bool stored = true, reused = true;
+	uint32_t serial = 0;
+	for (; serial < 8; serial++) {
+		changeset_t ch;
+		init_random_changeset(&ch, serial, serial + 1, 16, apex);
+		ret = journal_reopen(&journal, jfilename, filesize);
+		if (ret == KNOT_EOK) {
+			reused = reused && journal == kept;
+			ret = journal_write_changeset(journal, &ch);
+			journal_unlock(journal);
+		}
+		changeset_clear(&ch);
+		stored = stored && ret == KNOT_EOK;
+	}
+	ok(stored && reused, "journal: store into the kept journal");
+
+	list_t l;
+	init_list(&l);
+	ret = journal_load_changesets(jfilename, apex, &l, 0, serial);
+	ok(ret == KNOT_EOK && list_size(&l) == serial,
+	   "journal: load changesets stored into the kept journal");
+	changesets_free(&l);
+
+	/* Replaced journal file is opened again. */
+	remove(jfilename);
+	changeset_t ch;
+	init_random_changeset(&ch, serial, serial + 1, 16, apex);
+	ret = journal_reopen(&journal, jfilename, filesize);
+	if (ret == KNOT_EOK) {
+		ret = journal_write_changeset(journal, &ch);
+		journal_unlock(journal);
+	}
+	changeset_clear(&ch);
+	ok(ret == KNOT_EOK, "journal: store into the replaced journal");
+
+	init_list(&l);
+	ret = journal_load_changesets(jfilename, apex, &l, serial, serial + 1);
+	ok(ret == KNOT_EOK && list_size(&l) == 1,
+	   "journal: load changeset from the replaced journal");
+	changesets_free(&l);
+
+	journal_close(journal);
+}
+
 /*! \brief Test behavior when writing to jurnal and flushing it. */
 static void test_stress(const char *jfilename)
 {
@@ -401,6 +524,9 @@ int main(int argc, char *argv[])
 	test_stress(jfilename);
 	remove(jfilename);
 
+	test_reopen(jfilename);
+	remove(jfilename);
+
 	free(tmpdir);
 
 skip_all:
@@ -0,0 +1,281 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "knot/server/journal-sync.h"
+#include "libknot/errcode.h"
+
+#define CALLS		8
+#define BENCH_ZONES	8
+#define BENCH_WRITERS	16
+#define BENCH_UPDATES	100
+#define ENTRY_SIZE	512
+
+/*! \brief Synchronization result passed to the callback. */
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	unsigned calls;
+	int ret;
+} result_t;
+
+static void result_init(result_t *res)
+{
+	pthread_mutex_init(&res->lock, NULL);
+	pthread_cond_init(&res->done, NULL);
+	res->calls = 0;
+	res->ret = KNOT_EOK;
+}
+
+static void result_deinit(result_t *res)
+{
+	pthread_mutex_destroy(&res->lock);
+	pthread_cond_destroy(&res->done);
+}
+
+static void synced(int ret, void *ctx)
+{
+	result_t *res = ctx;
+
+	pthread_mutex_lock(&res->lock);
+	res->calls += 1;
+	if (ret != KNOT_EOK) {
+		res->ret = ret;
+	}
+	pthread_cond_signal(&res->done);
+	pthread_mutex_unlock(&res->lock);
+}
+
+/*! \brief Wait for the given number of callbacks, return the first error. */
+static int result_wait(result_t *res, unsigned calls)
+{
+	pthread_mutex_lock(&res->lock);
+	while (res->calls < calls) {
+		pthread_cond_wait(&res->done, &res->lock);
+	}
+	int ret = res->ret;
+	res->calls = 0;
+	res->ret = KNOT_EOK;
+	pthread_mutex_unlock(&res->lock);
+
+	return ret;
+}
+
+static int submit_wait(journal_sync_t *js, const char *path, int fd)
+{
+	result_t res;
+	result_init(&res);
+
+	int ret = journal_sync_submit(js, path, fd, synced, &res);
+	if (ret == KNOT_EOK) {
+		ret = result_wait(&res, 1);
+	}
+
+	result_deinit(&res);
+
+	return ret;
+}
+
+static void test_sync(const char *path, const char *missing)
+{
+	/* Missing context. */
+	is_int(KNOT_ENOTSUP, journal_sync_submit(NULL, path, -1, synced, NULL),
+	       "journal sync: no context");
+
+	/* Disabled synchronization. */
+	journal_sync_t *js = journal_sync_create(JOURNAL_SYNC_OFF);
+	ok(js != NULL, "journal sync: create");
+	is_int(KNOT_ENOTSUP, journal_sync_submit(js, missing, -1, synced, NULL),
+	       "journal sync: disabled");
+
+	/* Immediate synchronization. */
+	journal_sync_set_latency(js, 0);
+	is_int(KNOT_EOK, submit_wait(js, path, -1), "journal sync: immediate");
+	ok(submit_wait(js, missing, -1) != KNOT_EOK, "journal sync: missing journal");
+	is_int(KNOT_EOK, submit_wait(js, path, -1), "journal sync: failure not sticky");
+
+	/* The open descriptor is synchronized, the path isn't opened. */
+	int fd = open(path, O_RDONLY);
+	is_int(KNOT_EOK, submit_wait(js, missing, fd), "journal sync: open journal");
+	close(fd);
+
+	/* Writers grouped into one batch. */
+	journal_sync_set_latency(js, 20);
+	result_t res;
+	result_init(&res);
+	bool submitted = true;
+	for (int i = 0; i < CALLS; i++) {
+		int ret = journal_sync_submit(js, path, -1, (i % 2) ? synced : NULL, &res);
+		submitted = submitted && ret == KNOT_EOK;
+	}
+	ok(submitted, "journal sync: submit writers");
+	is_int(KNOT_EOK, result_wait(&res, CALLS / 2), "journal sync: grouped writers");
+
+	/* Pending callbacks are called on destroy. */
+	journal_sync_set_latency(js, 60000);
+	ok(journal_sync_submit(js, path, -1, synced, &res) == KNOT_EOK,
+	   "journal sync: submit before destroy");
+	journal_sync_destroy(js);
+	pthread_mutex_lock(&res.lock);
+	ok(res.calls == 1 && res.ret == KNOT_EOK, "journal sync: synchronized on destroy");
+	pthread_mutex_unlock(&res.lock);
+	result_deinit(&res);
+}
+
+/*! \brief Benchmark writer, each update waits for its acknowledgement. */
+typedef struct {
+	journal_sync_t *js;     /*!< Group commit (or NULL for own fdatasync). */
+	const char *path;
+	int fd;
+	double latency_sum;
+	double latency_max;
+} writer_t;
+
+static double elapsed(const struct timespec *begin)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - begin->tv_sec) + (end.tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+static void *writer(void *data)
+{
+	writer_t *w = data;
+	uint8_t entry[ENTRY_SIZE] = { 0 };
+
+	result_t res;
+	result_init(&res);
+
+	for (int i = 0; i < BENCH_UPDATES; i++) {
+		struct timespec begin;
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+
+		if (write(w->fd, entry, sizeof(entry)) != sizeof(entry)) {
+			break;
+		}
+		if (w->js != NULL) {
+			journal_sync_submit(w->js, w->path, w->fd, synced, &res);
+			result_wait(&res, 1);
+		} else {
+			fdatasync(w->fd);
+		}
+
+		double latency = elapsed(&begin);
+		w->latency_sum += latency;
+		if (latency > w->latency_max) {
+			w->latency_max = latency;
+		}
+	}
+
+	result_deinit(&res);
+
+	return NULL;
+}
+
+/*! \brief Concurrent updates of several zones until acknowledged durable. */
+static void bench(const char *tmpdir, int latency)
+{
+	journal_sync_t *js = NULL;
+	if (latency != JOURNAL_SYNC_OFF) {
+		js = journal_sync_create(latency);
+	}
+
+	char paths[BENCH_ZONES][512];
+	int fds[BENCH_ZONES];
+	for (int i = 0; i < BENCH_ZONES; i++) {
+		snprintf(paths[i], sizeof(paths[i]), "%s/bench%i.db", tmpdir, i);
+		fds[i] = open(paths[i], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+	}
+
+	writer_t writers[BENCH_WRITERS] = { { 0 } };
+	pthread_t threads[BENCH_WRITERS];
+
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	for (int i = 0; i < BENCH_WRITERS; i++) {
+		writers[i].js = js;
+		writers[i].path = paths[i % BENCH_ZONES];
+		writers[i].fd = fds[i % BENCH_ZONES];
+		pthread_create(&threads[i], NULL, writer, &writers[i]);
+	}
+
+	double latency_sum = 0, latency_max = 0;
+	for (int i = 0; i < BENCH_WRITERS; i++) {
+		pthread_join(threads[i], NULL);
+		latency_sum += writers[i].latency_sum;
+		if (writers[i].latency_max > latency_max) {
+			latency_max = writers[i].latency_max;
+		}
+	}
+
+	double sec = elapsed(&begin);
+	const unsigned updates = BENCH_WRITERS * BENCH_UPDATES;
+	if (js != NULL) {
+		diag("journal sync: latency %i ms, %.0f updates/s, ack avg %.2f ms, max %.2f ms",
+		     latency, updates / sec, 1e3 * latency_sum / updates, 1e3 * latency_max);
+	} else {
+		diag("journal sync: fdatasync per update, %.0f updates/s, ack avg %.2f ms, max %.2f ms",
+		     updates / sec, 1e3 * latency_sum / updates, 1e3 * latency_max);
+	}
+
+	journal_sync_destroy(js);
+	for (int i = 0; i < BENCH_ZONES; i++) {
+		close(fds[i]);
+		remove(paths[i]);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	char *tmpdir = test_mkdtemp();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tmpdir, "journal_sync.db");
+	FILE *f = fopen(path, "w");
+	fputs("journal", f);
+	fclose(f);
+
+	char missing[512];
+	snprintf(missing, sizeof(missing), "%s/%s", tmpdir, "missing.db");
+
+	test_sync(path, missing);
+
+	diag("journal sync: %u writers, %u zones, %u updates each",
+	     BENCH_WRITERS, BENCH_ZONES, BENCH_UPDATES);
+	bench(tmpdir, JOURNAL_SYNC_OFF);
+	bench(tmpdir, 0);
+	bench(tmpdir, 1);
+	bench(tmpdir, 5);
+	bench(tmpdir, 20);
+
+	remove(path);
+	test_rm_rf(tmpdir);
+	free(tmpdir);
+
+	return 0;
+}
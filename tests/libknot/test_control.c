@@ -104,19 +104,11 @@ static void ctl_client(const char *socket, size_t argc, knot_ctl_data_t *argv)
 	knot_ctl_free(ctl);
 }
 
-static void ctl_server(const char *socket, size_t argc, knot_ctl_data_t *argv)
+static void ctl_serve(knot_ctl_t *ctl, size_t argc, knot_ctl_data_t *argv)
 {
-	knot_ctl_t *ctl = knot_ctl_alloc();
-	ok(ctl != NULL, "Allocate control");
-
-	int ret = knot_ctl_bind(ctl, socket);
-	ok(ret == KNOT_EOK, "Bind control socket");
-
-	ret = knot_ctl_accept(ctl);
-	ok(ret == KNOT_EOK, "Accept a connection");
-
 	diag("BEGIN: Server <- Client");
 
+	int ret;
 	size_t count = 0;
 	knot_ctl_data_t data;
 	knot_ctl_type_t type;
@@ -167,12 +159,55 @@ static void ctl_server(const char *socket, size_t argc, knot_ctl_data_t *argv)
 	ok(ret == KNOT_EOK, "Server send final data");
 
 	diag("END: Server -> Client");
+}
+
+static void ctl_server(const char *socket, size_t argc, knot_ctl_data_t *argv)
+{
+	knot_ctl_t *ctl = knot_ctl_alloc();
+	ok(ctl != NULL, "Allocate control");
+
+	int ret = knot_ctl_bind(ctl, socket);
+	ok(ret == KNOT_EOK, "Bind control socket");
+
+	ret = knot_ctl_accept(ctl);
+	ok(ret == KNOT_EOK, "Accept a connection");
+
+	ctl_serve(ctl, argc, argv);
 
 	knot_ctl_close(ctl);
 	knot_ctl_unbind(ctl);
 	knot_ctl_free(ctl);
 }
 
+static void ctl_server_clients(const char *socket, size_t argc, knot_ctl_data_t *argv)
+{
+	knot_ctl_t *ctl = knot_ctl_alloc();
+	ok(ctl != NULL, "Allocate control");
+
+	int ret = knot_ctl_bind(ctl, socket);
+	ok(ret == KNOT_EOK, "Bind control socket");
+
+	knot_ctl_set_timeout(ctl, 10000);
+
+	// Accept both clients before serving any of them.
+	knot_ctl_t *clients[2];
+	for (size_t i = 0; i < 2; i++) {
+		clients[i] = knot_ctl_alloc();
+		ret = knot_ctl_accept_client(ctl, clients[i]);
+		ok(ret == KNOT_EOK, "Accept client %zu", i);
+		ok(clients[i]->timeout == 10000, "Client %zu inherits timeout", i);
+	}
+
+	// Serve them in the reverse order.
+	for (size_t i = 2; i > 0; i--) {
+		ctl_serve(clients[i - 1], argc, argv);
+		knot_ctl_free(clients[i - 1]);
+	}
+
+	knot_ctl_unbind(ctl);
+	knot_ctl_free(ctl);
+}
+
 static void test_client_server_client(void)
 {
 	char *socket = test_mktemp();
@@ -197,7 +232,7 @@ static void test_client_server_client(void)
 	if (child_pid == 0) {
 		ctl_client(socket, data_len, data);
 		free(socket);
-		return;
+		exit(0);
 	} else {
 		ctl_server(socket, data_len, data);
 	}
@@ -210,6 +245,187 @@ static void test_client_server_client(void)
 	free(socket);
 }
 
+static void test_concurrent_clients(void)
+{
+	char *socket = test_mktemp();
+	ok(socket != NULL, "Make a temporary socket file '%s'", socket);
+
+	size_t data_len = 2;
+	knot_ctl_data_t data[] = {
+		{ "command", [KNOT_CTL_IDX_ZONE] = "zone" },
+		{ [KNOT_CTL_IDX_CMD] = "\0" }, // This means block end in this test!
+	};
+
+	// Fork two client processes.
+	for (int i = 0; i < 2; i++) {
+		pid_t child_pid = fork();
+		if (child_pid == -1) {
+			ok(child_pid >= 0, "Process fork");
+			return;
+		}
+		if (child_pid == 0) {
+			ctl_client(socket, data_len, data);
+			free(socket);
+			exit(0);
+		}
+	}
+
+	ctl_server_clients(socket, data_len, data);
+
+	for (int i = 0; i < 2; i++) {
+		int status = 0;
+		wait(&status);
+		ok(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Wait for client %i", i);
+	}
+
+	test_rm_rf(socket);
+	free(socket);
+}
+
+#define BULK_COUNT	3
+
+static const size_t bulk_lens[BULK_COUNT] = { 5, 100000, 0 };
+
+static void bulk_fill(uint8_t *data, size_t len, size_t seed)
+{
+	for (size_t i = 0; i < len; i++) {
+		data[i] = (i + seed) % 251;
+	}
+}
+
+static bool bulk_check(knot_ctl_t *ctl, size_t idx)
+{
+	size_t len = 0;
+	const uint8_t *data = knot_ctl_bulk(ctl, &len);
+	if (data == NULL || len != bulk_lens[idx]) {
+		return false;
+	}
+
+	uint8_t expected[len + 1];
+	bulk_fill(expected, len, idx);
+
+	return memcmp(data, expected, len) == 0;
+}
+
+static void bulk_send(knot_ctl_t *ctl)
+{
+	for (size_t i = 0; i < BULK_COUNT; i++) {
+		uint8_t data[bulk_lens[i] + 1];
+		bulk_fill(data, bulk_lens[i], i);
+		int ret = knot_ctl_send_bulk(ctl, data, bulk_lens[i]);
+		fake_ok(ret == KNOT_EOK, "Send bulk %zu", i);
+	}
+}
+
+static void bulk_client(const char *socket)
+{
+	knot_ctl_t *ctl = knot_ctl_alloc();
+	fake_ok(ctl != NULL, "Allocate control");
+
+	int ret;
+	for (int i = 0; i < 20; i++) {
+		ret = knot_ctl_connect(ctl, socket);
+		if (ret == KNOT_EOK) {
+			break;
+		}
+		usleep(100000);
+	}
+	fake_ok(ret == KNOT_EOK, "Connect to socket");
+
+	knot_ctl_data_t data = { [KNOT_CTL_IDX_CMD] = "bulk" };
+	ret = knot_ctl_send(ctl, KNOT_CTL_TYPE_DATA, &data);
+	fake_ok(ret == KNOT_EOK, "Client send data");
+
+	bulk_send(ctl);
+
+	ret = knot_ctl_send(ctl, KNOT_CTL_TYPE_END, NULL);
+	fake_ok(ret == KNOT_EOK, "Client send final data");
+
+	// Receive the echoed units.
+	knot_ctl_type_t type;
+	for (size_t i = 0; i < BULK_COUNT; i++) {
+		ret = knot_ctl_receive(ctl, &type, NULL);
+		fake_ok(ret == KNOT_EOK && type == KNOT_CTL_TYPE_BULK, "Receive bulk %zu", i);
+		fake_ok(bulk_check(ctl, i), "Client compare bulk %zu", i);
+	}
+
+	ret = knot_ctl_receive(ctl, &type, NULL);
+	fake_ok(ret == KNOT_EOK && type == KNOT_CTL_TYPE_END, "Receive EOF type");
+	fake_ok(knot_ctl_bulk(ctl, &(size_t){ 0 }) == NULL, "No bulk after EOF");
+
+	knot_ctl_close(ctl);
+	knot_ctl_free(ctl);
+}
+
+static void bulk_server(const char *socket)
+{
+	knot_ctl_t *ctl = knot_ctl_alloc();
+	ok(ctl != NULL, "Allocate control");
+
+	int ret = knot_ctl_bind(ctl, socket);
+	ok(ret == KNOT_EOK, "Bind control socket");
+
+	ret = knot_ctl_accept(ctl);
+	ok(ret == KNOT_EOK, "Accept a connection");
+
+	knot_ctl_type_t type;
+	knot_ctl_data_t data;
+	ret = knot_ctl_receive(ctl, &type, &data);
+	ok(ret == KNOT_EOK && type == KNOT_CTL_TYPE_DATA, "Receive data");
+	ok(knot_ctl_bulk(ctl, &(size_t){ 0 }) == NULL, "No bulk in data unit");
+
+	for (size_t i = 0; i < BULK_COUNT; i++) {
+		ret = knot_ctl_receive(ctl, &type, &data);
+		ok(ret == KNOT_EOK && type == KNOT_CTL_TYPE_BULK, "Receive bulk %zu", i);
+		ok(bulk_check(ctl, i), "Compare bulk %zu", i);
+		ok(data[KNOT_CTL_IDX_CMD] != NULL &&
+		   strcmp(data[KNOT_CTL_IDX_CMD], "bulk") == 0,
+		   "Bulk %zu keeps data items", i);
+	}
+
+	ret = knot_ctl_receive(ctl, &type, NULL);
+	ok(ret == KNOT_EOK && type == KNOT_CTL_TYPE_END, "Receive EOF type");
+
+	ok(knot_ctl_send(ctl, KNOT_CTL_TYPE_BULK, NULL) == KNOT_EINVAL,
+	   "Reject bulk type in generic send");
+	ok(knot_ctl_send_bulk(ctl, NULL, 1) == KNOT_EINVAL, "Reject missing bulk data");
+
+	// Echo the units back.
+	bulk_send(ctl);
+	ret = knot_ctl_send(ctl, KNOT_CTL_TYPE_END, NULL);
+	ok(ret == KNOT_EOK, "Send final data");
+
+	knot_ctl_close(ctl);
+	knot_ctl_unbind(ctl);
+	knot_ctl_free(ctl);
+}
+
+static void test_bulk(void)
+{
+	char *socket = test_mktemp();
+	ok(socket != NULL, "Make a temporary socket file '%s'", socket);
+
+	pid_t child_pid = fork();
+	if (child_pid == -1) {
+		ok(child_pid >= 0, "Process fork");
+		return;
+	}
+	if (child_pid == 0) {
+		bulk_client(socket);
+		free(socket);
+		exit(0);
+	} else {
+		bulk_server(socket);
+	}
+
+	int status = 0;
+	wait(&status);
+	ok(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Wait for client");
+
+	test_rm_rf(socket);
+	free(socket);
+}
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
@@ -217,5 +433,11 @@ int main(int argc, char *argv[])
 	diag("Client -> Server -> Client");
 	test_client_server_client();
 
+	diag("Concurrent clients");
+	test_concurrent_clients();
+
+	diag("Bulk data");
+	test_bulk();
+
 	return 0;
 }
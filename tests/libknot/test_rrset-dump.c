@@ -0,0 +1,436 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tap/basic.h>
+
+#include "libknot/libknot.h"
+#include "contrib/wire.h"
+#include "zscanner/scanner.h"
+
+#define MAX_RRSETS	64
+#define BENCH_ROUNDS	20000
+
+/*! \brief Records of a signed zone and other record types. */
+static const char *zone_str =
+"rdatacase. 3600 IN SOA dns1.rdatacase. hostmaster.rdatacase. 2010111201 10800 3600 1209600 7200\n"
+"rdatacase. 3600 IN RRSIG SOA 5 1 3600 20500101000000 20140123125439 62775 rdatacase. "
+	"CG1Qm7ZPHZd0EyrMemOTGhKvzco71mEZJvReD/qp/Pdy723LuJbTI9yV lncG1CLb6Hca3es6nLjSjzlIyfofQ1xPfy4AtMfWjMq68GA8x4c0PWlY "
+	"5xmSKyG+HApcrmfjd9xBfLEUk18eLRm6L/NVCA40E0vWWZnqU5iPAXJl yMs=\n"
+"rdatacase. 3600 IN NS dns1.rdatacase.\n"
+"rdatacase. 3600 IN MX 10 mail.rdatacase.\n"
+"rdatacase. 7200 IN NSEC ALL.rdatacase. NS SOA MX RRSIG NSEC DNSKEY\n"
+"rdatacase. 3600 IN DNSKEY 256 3 5 AwEAAZ6AAN4ZMcV/lWIlhSGWcAWRt8nXi9w1mnh1qWbW/OTYyhT8Z104 "
+	"xJVjtBKGkU2R626eRM6moyFc2Pu6EWpXZHdF74j6rdwSoLSM0cv8uh9A TqjL03xkzNEmnBkfl7hn5mfQQgBz/DmPMiv1Mqfw8iFJUP+CAthmzoIO 2Akut6EB\n"
+"rdatacase. 3600 IN DS 62775 5 2 E2D3C916F6DEEAC73294E8268FB5885044A833FC5459588F4A9184CF C41A5766\n"
+"rdatacase. 3600 IN NSEC3PARAM 1 0 10 AABBCCDD\n"
+"q5ihdemagoafuvc8l6kmiqsr6kq8bp3m.rdatacase. 7200 IN NSEC3 1 1 10 AABBCCDD 1J5GEANQLHJ8VG7O6EBGFNNCJUGT4NIL A RRSIG\n"
+"ALL.rdatacase. 3600 IN A 1.1.1.1\n"
+"ALL.rdatacase. 3600 IN RRSIG A 5 2 3600 20500101000000 20140123125439 62775 rdatacase. "
+	"b0AqaH4bX6zsPmv8uVExT4H/R6opnMbOrqrt+rgtql6z1TvlNikoTBPJ nq3bMDZ0auHlNmpBmJa/xXvIhnddAMyVDtSfIj+x4bjGZaYhoLylBU2N "
+	"nmxrs+zqKeGfHz77+gAHh6QKoSW5F1aHihWkZy8Xz46WDHXcB+Mspk+T H+Y=\n"
+"dns1.rdatacase. 3600 IN AAAA 2001:db8::1\n"
+"dns1.rdatacase. 3600 IN AAAA ::ffff:192.0.2.1\n"
+"dns1.rdatacase. 3600 IN AAAA 2001:db8:0:1:0:0:0:1\n"
+"a\\.b\\\"c\\032.rdatacase. 60 IN TXT \"text\" \"with \\\"quotes\\\" and \\\\\" \"\\000\\255\\009~\"\n"
+"rdatacase. 86400 IN SRV 0 65535 4294 srv.rdatacase.\n"
+"rdatacase. 1 IN NAPTR 100 10 \"S\" \"SIP+D2U\" \"!^.*$!sip:info@example.com!\" _sip._udp.example.com.\n"
+"rdatacase. 3600 IN LOC 52 22 23.000 N 4 53 32.000 E -2.00m 0.00m 10000m 10m\n"
+"rdatacase. 3600 IN LOC 0 1 2.345 S 179 59 59.999 W -0.5m 1.5m 90000000m 0.01m\n"
+"rdatacase. 3600 IN TLSA 3 1 1 0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF\n"
+"rdatacase. 3600 IN NID 10 0014:4fff:ff20:ee64\n"
+"rdatacase. 3600 IN EUI48 00-00-5e-00-53-2a\n"
+"rdatacase. 3600 IN TYPE65000 \\# 3 ABCDEF\n";
+
+static const char *ref_default =
+"rdatacase.          \t3600\tSOA\tdns1.rdatacase. hostmaster.rdatacase. 2010111201 10800 3600 1209600 7200\n"
+"rdatacase.          \t3600\tRRSIG\tSOA 5 1 3600 20500101000000 20140123125439 62775 rdatacase. CG1Qm7ZPHZd0EyrMemOTGhKvzco71mEZJvReD/qp/Pdy723LuJbTI9yVlncG1CLb6Hca3es6nLjSjzlIyfofQ1xPfy4AtMfWjMq68GA8x4c0PWlY5xmSKyG+HApcrmfjd9xBfLEUk18eLRm6L/NVCA40E0vWWZnqU5iPAXJlyMs=\n"
+"rdatacase.          \t3600\tNS\tdns1.rdatacase.\n"
+"rdatacase.          \t3600\tMX\t10 mail.rdatacase.\n"
+"rdatacase.          \t7200\tNSEC\tALL.rdatacase. NS SOA MX RRSIG NSEC DNSKEY\n"
+"rdatacase.          \t3600\tDNSKEY\t256 3 5 AwEAAZ6AAN4ZMcV/lWIlhSGWcAWRt8nXi9w1mnh1qWbW/OTYyhT8Z104xJVjtBKGkU2R626eRM6moyFc2Pu6EWpXZHdF74j6rdwSoLSM0cv8uh9ATqjL03xkzNEmnBkfl7hn5mfQQgBz/DmPMiv1Mqfw8iFJUP+CAthmzoIO2Akut6EB\n"
+"rdatacase.          \t3600\tDS\t62775 5 2 E2D3C916F6DEEAC73294E8268FB5885044A833FC5459588F4A9184CFC41A5766\n"
+"rdatacase.          \t3600\tNSEC3PARAM\t1 0 10 AABBCCDD\n"
+"q5ihdemagoafuvc8l6kmiqsr6kq8bp3m.rdatacase. 7200\tNSEC3\t1 1 10 AABBCCDD 1J5GEANQLHJ8VG7O6EBGFNNCJUGT4NIL A RRSIG\n"
+"ALL.rdatacase.      \t3600\tA\t1.1.1.1\n"
+"ALL.rdatacase.      \t3600\tRRSIG\tA 5 2 3600 20500101000000 20140123125439 62775 rdatacase. b0AqaH4bX6zsPmv8uVExT4H/R6opnMbOrqrt+rgtql6z1TvlNikoTBPJnq3bMDZ0auHlNmpBmJa/xXvIhnddAMyVDtSfIj+x4bjGZaYhoLylBU2Nnmxrs+zqKeGfHz77+gAHh6QKoSW5F1aHihWkZy8Xz46WDHXcB+Mspk+TH+Y=\n"
+"dns1.rdatacase.     \t3600\tAAAA\t2001:db8::1\n"
+"dns1.rdatacase.     \t3600\tAAAA\t::ffff:192.0.2.1\n"
+"dns1.rdatacase.     \t3600\tAAAA\t2001:db8:0:1::1\n"
+"a\\.b\\\"c\\032.rdatacase.\t60\tTXT\t\"text\" \"with \\\"quotes\\\" and \\\\\" \"\\000\\255\\009~\"\n"
+"rdatacase.          \t86400\tSRV\t0 65535 4294 srv.rdatacase.\n"
+"rdatacase.          \t1\tNAPTR\t100 10 \"S\" \"SIP+D2U\" \"!^.*$!sip:info@example.com!\" _sip._udp.example.com.\n"
+"rdatacase.          \t3600\tLOC\t52 22 23 N  4 53 32 E  -2m  0m 10000m 10m\n"
+"rdatacase.          \t3600\tLOC\t0 1 2.345 S  179 59 59.999 W  -0.50m  1m 90000000m 0.01m\n"
+"rdatacase.          \t3600\tTLSA\t3 1 1 0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF\n"
+"rdatacase.          \t3600\tNID\t10 0014:4FFF:FF20:EE64\n"
+"rdatacase.          \t3600\tEUI48\t00-00-5E-00-53-2A\n"
+"rdatacase.          \t3600\tTYPE65000\t\\# 3 ABCDEF\n";
+
+static const char *ref_wrap =
+"rdatacase.          \t1h IN SOA dns1.rdatacase. hostmaster.rdatacase. (\n"
+"\t\t\t\t2010111201 ; serial\n"
+"\t\t\t\t3h ; refresh\n"
+"\t\t\t\t1h ; retry\n"
+"\t\t\t\t14d ; expire\n"
+"\t\t\t\t2h ; minimum\n"
+"\t\t\t\t)\n"
+"rdatacase.          \t1h IN RRSIG SOA 5 1 3600 2524608000 (\n"
+"\t\t\t\t1390481679 62775 rdatacase.\n"
+"\t\t\t\tCG1Qm7ZPHZd0EyrMemOTGhKvzco71mEZJvReD/qp\n"
+"\t\t\t\t/Pdy723LuJbTI9yVlncG1CLb6Hca3es6nLjSjzlI\n"
+"\t\t\t\tyfofQ1xPfy4AtMfWjMq68GA8x4c0PWlY5xmSKyG+\n"
+"\t\t\t\tHApcrmfjd9xBfLEUk18eLRm6L/NVCA40E0vWWZnq\n"
+"\t\t\t\tU5iPAXJlyMs=\n"
+"\t\t\t\t)\n"
+"rdatacase.          \t1h IN NS dns1.rdatacase.\n"
+"rdatacase.          \t1h IN MX 10 mail.rdatacase.\n"
+"rdatacase.          \t2h IN NSEC ALL.rdatacase. NS SOA MX RRSIG NSEC DNSKEY\n"
+"rdatacase.          \t1h IN DNSKEY 256 3 5 (\n"
+"\t\t\t\tAwEAAZ6AAN4ZMcV/lWIlhSGWcAWRt8nXi9w1mnh1\n"
+"\t\t\t\tqWbW/OTYyhT8Z104xJVjtBKGkU2R626eRM6moyFc\n"
+"\t\t\t\t2Pu6EWpXZHdF74j6rdwSoLSM0cv8uh9ATqjL03xk\n"
+"\t\t\t\tzNEmnBkfl7hn5mfQQgBz/DmPMiv1Mqfw8iFJUP+C\n"
+"\t\t\t\tAthmzoIO2Akut6EB\n"
+"\t\t\t\t) ; ZSK, RSASHA1 (1024b), id = 62775\n"
+"rdatacase.          \t1h IN DS 62775 5 2 (\n"
+"\t\t\t\tE2D3C916F6DEEAC73294E8268FB5885044A833FC\n"
+"\t\t\t\t5459588F4A9184CFC41A5766\n"
+"\t\t\t\t)\n"
+"rdatacase.          \t1h IN NSEC3PARAM 1 0 10 AABBCCDD\n"
+"q5ihdemagoafuvc8l6kmiqsr6kq8bp3m.rdatacase. 2h IN NSEC3 1 1 10 AABBCCDD (\n"
+"\t\t\t\t1J5GEANQLHJ8VG7O6EBGFNNCJUGT4NIL \n"
+"\t\t\t\tA RRSIG\n"
+"\t\t\t\t)\n"
+"ALL.rdatacase.      \t1h IN A 1.1.1.1\n"
+"ALL.rdatacase.      \t1h IN RRSIG A 5 2 3600 2524608000 (\n"
+"\t\t\t\t1390481679 62775 rdatacase.\n"
+"\t\t\t\tb0AqaH4bX6zsPmv8uVExT4H/R6opnMbOrqrt+rgt\n"
+"\t\t\t\tql6z1TvlNikoTBPJnq3bMDZ0auHlNmpBmJa/xXvI\n"
+"\t\t\t\thnddAMyVDtSfIj+x4bjGZaYhoLylBU2Nnmxrs+zq\n"
+"\t\t\t\tKeGfHz77+gAHh6QKoSW5F1aHihWkZy8Xz46WDHXc\n"
+"\t\t\t\tB+Mspk+TH+Y=\n"
+"\t\t\t\t)\n"
+"dns1.rdatacase.     \t1h IN AAAA 2001:db8::1\n"
+"dns1.rdatacase.     \t1h IN AAAA ::ffff:192.0.2.1\n"
+"dns1.rdatacase.     \t1h IN AAAA 2001:db8:0:1::1\n"
+"a\\.b\\\"c\\032.rdatacase.\t1m IN TXT \"text\" \"with \\\"quotes\\\" and \\\\\" \"\\000\\255\\009~\"\n"
+"rdatacase.          \t1d IN SRV 0 65535 4294 srv.rdatacase.\n"
+"rdatacase.          \t1s IN NAPTR 100 10 \"S\" \"SIP+D2U\" \"!^.*$!sip:info@example.com!\" _sip._udp.example.com.\n"
+"rdatacase.          \t1h IN LOC 52 22 23 N  4 53 32 E  -2m  0m 10000m 10m\n"
+"rdatacase.          \t1h IN LOC 0 1 2.345 S  179 59 59.999 W  -0.50m  1m 90000000m 0.01m\n"
+"rdatacase.          \t1h IN TLSA 3 1 1 (\n"
+"\t\t\t\t0123456789ABCDEF0123456789ABCDEF01234567\n"
+"\t\t\t\t89ABCDEF0123456789ABCDEF\n"
+"\t\t\t\t)\n"
+"rdatacase.          \t1h IN NID 10 0014:4FFF:FF20:EE64\n"
+"rdatacase.          \t1h IN EUI48 00-00-5E-00-53-2A\n"
+"rdatacase.          \t1h IN TYPE65000 (\n"
+"\t\t\t\t\\# 3 \n"
+"\t\t\t\tABCDEF\n"
+"\t\t\t\t)\n";
+
+static knot_rrset_t *rrsets[MAX_RRSETS];
+static size_t rrset_count;
+
+static void process_rr(zs_scanner_t *scanner)
+{
+	if (rrset_count >= MAX_RRSETS) {
+		return;
+	}
+
+	knot_rrset_t *rrset = knot_rrset_new(scanner->r_owner, scanner->r_type,
+	                                     scanner->r_class, NULL);
+	if (rrset == NULL ||
+	    knot_rrset_add_rdata(rrset, scanner->r_data, scanner->r_data_length,
+	                         scanner->r_ttl, NULL) != KNOT_EOK) {
+		knot_rrset_free(&rrset, NULL);
+		return;
+	}
+
+	rrsets[rrset_count++] = rrset;
+}
+
+static int dump_all(const knot_dump_style_t *style, char *out, size_t out_len)
+{
+	size_t len = 0;
+	out[0] = '\0';
+
+	for (size_t i = 0; i < rrset_count; i++) {
+		int ret = knot_rrset_txt_dump_rr(rrsets[i], 0, out + len,
+		                                 out_len - len, style);
+		if (ret < 0) {
+			return ret;
+		}
+		len += ret;
+	}
+
+	return len;
+}
+
+static void test_ipv6(void)
+{
+	static const char *addrs[][2] = {
+		{ "::",                  "::" },
+		{ "::1",                 "::1" },
+		{ "1::",                 "1::" },
+		{ "1:0:0:2::3",          "1:0:0:2::3" },
+		{ "1:0:2:0:0:3:0:4",     "1:0:2::3:0:4" },
+		{ "1:0:2:3:4:5:6:7",     "1:0:2:3:4:5:6:7" },
+		{ "ffff:abcd::",         "ffff:abcd::" },
+		{ "::ffff:10.0.0.1",     "::ffff:10.0.0.1" },
+	};
+
+	uint8_t owner[] = "\x04test";
+	knot_rrset_t *rrset = knot_rrset_new(owner, KNOT_RRTYPE_AAAA,
+	                                     KNOT_CLASS_IN, NULL);
+	if (rrset == NULL) {
+		return;
+	}
+
+	char out[64];
+	uint8_t addr[16];
+
+	// Fixed representations.
+	for (size_t i = 0; i < sizeof(addrs) / sizeof(addrs[0]); i++) {
+		inet_pton(AF_INET6, addrs[i][0], addr);
+		knot_rdataset_clear(&rrset->rrs, NULL);
+		knot_rrset_add_rdata(rrset, addr, sizeof(addr), 0, NULL);
+		int ret = knot_rrset_txt_dump_data(rrset, 0, out, sizeof(out),
+		                                   &KNOT_DUMP_STYLE_DEFAULT);
+		ok(ret > 0 && strcmp(out, addrs[i][1]) == 0,
+		   "IPv6 address %s", addrs[i][1]);
+	}
+
+	// All zero/non-zero word combinations match inet_ntop().
+	bool valid = true;
+	for (unsigned mask = 0; mask < 256; mask++) {
+		for (int w = 0; w < 8; w++) {
+			uint16_t word = (mask & (1 << w)) ? 0x1F * (w + 1) << w : 0;
+			addr[2 * w] = word >> 8;
+			addr[2 * w + 1] = word;
+		}
+		knot_rdataset_clear(&rrset->rrs, NULL);
+		knot_rrset_add_rdata(rrset, addr, sizeof(addr), 0, NULL);
+		char ref[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, addr, ref, sizeof(ref));
+		int ret = knot_rrset_txt_dump_data(rrset, 0, out, sizeof(out),
+		                                   &KNOT_DUMP_STYLE_DEFAULT);
+		if (ret <= 0 || strcmp(out, ref) != 0) {
+			valid = false;
+			diag("IPv6 address %s", out);
+		}
+	}
+	ok(valid, "IPv6 address combinations");
+
+	knot_rrset_free(&rrset, NULL);
+}
+
+static void test_timestamps(void)
+{
+	uint8_t owner[] = "\x04test";
+	knot_rrset_t *rrset = knot_rrset_new(owner, KNOT_RRTYPE_RRSIG,
+	                                     KNOT_CLASS_IN, NULL);
+	if (rrset == NULL) {
+		return;
+	}
+
+	// RRSIG with the expiration and the inception set.
+	uint8_t rdata[] = { 0, 1, 5, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	                    0, 1, 0, 0xAA, 0xBB };
+
+	bool valid = true;
+	uint32_t stamp = 0;
+	for (int i = 0; i < 4096; i++) {
+		wire_write_u32(rdata + 8, stamp);
+		wire_write_u32(rdata + 12, UINT32_MAX - stamp);
+		knot_rdataset_clear(&rrset->rrs, NULL);
+		knot_rrset_add_rdata(rrset, rdata, sizeof(rdata), 0, NULL);
+
+		char out[128], ref[128], expire[16], incept[16];
+		struct tm tm;
+		time_t t = stamp;
+		strftime(expire, sizeof(expire), "%Y%m%d%H%M%S", gmtime_r(&t, &tm));
+		t = UINT32_MAX - stamp;
+		strftime(incept, sizeof(incept), "%Y%m%d%H%M%S", gmtime_r(&t, &tm));
+		snprintf(ref, sizeof(ref), "A 5 1 0 %s %s 1 . qrs=", expire, incept);
+
+		int ret = knot_rrset_txt_dump_data(rrset, 0, out, sizeof(out),
+		                                   &KNOT_DUMP_STYLE_DEFAULT);
+		if (ret <= 0 || strcmp(out, ref) != 0) {
+			valid = false;
+			diag("timestamp %u: %s", stamp, out);
+		}
+
+		stamp = stamp * 1103515245 + 12345 + i;
+	}
+	ok(valid, "timestamps");
+
+	knot_rrset_free(&rrset, NULL);
+}
+
+static void test_escaped_owner(void)
+{
+	// Escapes make the text much longer than the wire name.
+	uint8_t owner[] = "\x04\x01\x01\x01\x01\x1a""abcdefghijklmnopqrstuvwxyz";
+	const char *owner_str = "\\001\\001\\001\\001.abcdefghijklmnopqrstuvwxyz.";
+	size_t owner_len = strlen(owner_str);
+
+	bool valid = true;
+	for (size_t len = knot_dname_size(owner) + 1; len <= owner_len + 1; len++) {
+		char *out = malloc(len);
+		char *ret = knot_dname_to_str(out, owner, len);
+		if ((len <= owner_len && ret != NULL) ||
+		    (len > owner_len && (ret == NULL || strcmp(out, owner_str) != 0))) {
+			valid = false;
+			diag("owner buffer %zu", len);
+		}
+		free(out);
+	}
+	ok(valid, "escaped owner, exact buffer");
+
+	knot_rrset_t *rrset = knot_rrset_new(owner, KNOT_RRTYPE_A, KNOT_CLASS_IN, NULL);
+	if (rrset == NULL) {
+		return;
+	}
+	char *out = malloc(36);
+	int ret = knot_rrset_txt_dump_header(rrset, 3600, out, 36,
+	                                     &KNOT_DUMP_STYLE_DEFAULT);
+	ok(ret == KNOT_ESPACE, "escaped owner, tight buffer");
+	free(out);
+
+	knot_rrset_free(&rrset, NULL);
+}
+
+static void bench(void)
+{
+	static char out[65536];
+	struct timespec begin, end;
+	size_t bytes = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int i = 0; i < BENCH_ROUNDS; i++) {
+		int ret = dump_all(&KNOT_DUMP_STYLE_DEFAULT, out, sizeof(out));
+		if (ret < 0) {
+			return;
+		}
+		bytes += ret;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double sec = (end.tv_sec - begin.tv_sec) +
+	             (end.tv_nsec - begin.tv_nsec) / 1e9;
+	if (sec > 0) {
+		diag("throughput: %.0f records/s, %.0f MB/s",
+		     BENCH_ROUNDS * rrset_count / sec, bytes / sec / 1e6);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	zs_scanner_t sc;
+	if (zs_init(&sc, "rdatacase.", KNOT_CLASS_IN, 3600) != 0 ||
+	    zs_set_processing(&sc, process_rr, NULL, NULL) != 0 ||
+	    zs_set_input_string(&sc, zone_str, strlen(zone_str)) != 0 ||
+	    zs_parse_all(&sc) != 0) {
+		bail("failed to parse the zone");
+	}
+	zs_deinit(&sc);
+
+	static char out[65536];
+
+	// Default style.
+	int ret = dump_all(&KNOT_DUMP_STYLE_DEFAULT, out, sizeof(out));
+	ok(ret == strlen(ref_default), "default style length");
+	is_string(ref_default, out, "default style");
+
+	// Multi-line verbose style.
+	knot_dump_style_t style = {
+		.wrap = true,
+		.show_class = true,
+		.show_ttl = true,
+		.verbose = true,
+		.human_ttl = true,
+		.human_tmstamp = false,
+	};
+	ret = dump_all(&style, out, sizeof(out));
+	ok(ret == strlen(ref_wrap), "multi-line style length");
+	is_string(ref_wrap, out, "multi-line style");
+
+	// Growing buffer, RRset of the AAAA records.
+	knot_rrset_t *aaaa = NULL;
+	for (size_t i = 0; i < rrset_count; i++) {
+		if (rrsets[i]->type != KNOT_RRTYPE_AAAA) {
+			continue;
+		}
+		if (aaaa == NULL) {
+			aaaa = knot_rrset_copy(rrsets[i], NULL);
+		} else {
+			knot_rrset_add_rdata(aaaa, knot_rdata_data(rrsets[i]->rrs.data),
+			                     knot_rdata_rdlen(rrsets[i]->rrs.data),
+			                     knot_rdata_ttl(rrsets[i]->rrs.data), NULL);
+		}
+	}
+	size_t ref_len = 0;
+	for (uint16_t i = 0; i < aaaa->rrs.rr_count; i++) {
+		ret = knot_rrset_txt_dump_rr(aaaa, i, out + ref_len,
+		                             sizeof(out) - ref_len,
+		                             &KNOT_DUMP_STYLE_DEFAULT);
+		ref_len += (ret > 0) ? ret : 0;
+	}
+	size_t buf_len = 1;
+	char *buf = malloc(buf_len);
+	ret = knot_rrset_txt_dump(aaaa, &buf, &buf_len, &KNOT_DUMP_STYLE_DEFAULT);
+	ok(aaaa->rrs.rr_count == 3 && ret == ref_len && strcmp(buf, out) == 0,
+	   "growing buffer");
+	free(buf);
+	knot_rrset_free(&aaaa, NULL);
+
+	// Exact output size, one byte less is not enough.
+	const knot_dump_style_t *styles[] = { &KNOT_DUMP_STYLE_DEFAULT, &style };
+	bool exact = true;
+	for (size_t i = 0; i < 2 * rrset_count; i++) {
+		static char small[65536];
+		const knot_rrset_t *rr = rrsets[i / 2];
+		const knot_dump_style_t *st = styles[i % 2];
+		ret = knot_rrset_txt_dump_rr(rr, 0, out, sizeof(out), st);
+		if (ret <= 0 ||
+		    knot_rrset_txt_dump_rr(rr, 0, small, ret + 1, st) != ret ||
+		    strcmp(small, out) != 0 ||
+		    knot_rrset_txt_dump_rr(rr, 0, small, ret, st) != KNOT_ESPACE) {
+			exact = false;
+			diag("record %zu: %s", i / 2, out);
+		}
+	}
+	ok(exact, "exact output size");
+
+	test_ipv6();
+	test_timestamps();
+	test_escaped_owner();
+
+	bench();
+
+	for (size_t i = 0; i < rrset_count; i++) {
+		knot_rrset_free(&rrsets[i], NULL);
+	}
+
+	return 0;
+}
@@ -0,0 +1,281 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "knot/server/numa.h"
+#include "contrib/macros.h"
+#include "contrib/mempattern.h"
+#include "contrib/ucw/mempool.h"
+#include "libknot/errcode.h"
+
+#define BENCH_BUFSIZE	(8 * 1024 * 1024)
+#define BENCH_ROUNDS	8
+
+static void write_node(const char *sysfs, const char *node, const char *cpulist)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", sysfs, node);
+	mkdir(path, 0700);
+	if (cpulist == NULL) {
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s/cpulist", sysfs, node);
+	FILE *f = fopen(path, "w");
+	if (f == NULL) {
+		bail("failed to write %s", path);
+	}
+	fputs(cpulist, f);
+	fclose(f);
+}
+
+static bool check_cpus(const unsigned *cpus, size_t count,
+                       const unsigned *expected, size_t expected_count)
+{
+	return count == expected_count &&
+	       memcmp(cpus, expected, count * sizeof(unsigned)) == 0;
+}
+
+static void test_topology(const char *tmpdir)
+{
+	char sysfs[512];
+	snprintf(sysfs, sizeof(sysfs), "%s/node", tmpdir);
+	mkdir(sysfs, 0700);
+
+	/* Two sockets with interleaved CPU numbers, a memory-only node. */
+	write_node(sysfs, "node1", "2-3,6-7\n");
+	write_node(sysfs, "node0", "0-1,4-5\n");
+	write_node(sysfs, "node2", "\n");
+	write_node(sysfs, "nodefoo", "8\n");
+	write_node(sysfs, "power", NULL);
+
+	numa_topology_t topo;
+	int ret = numa_topology_load(&topo, sysfs);
+	ok(ret == KNOT_EOK, "numa: load topology");
+	ok(topo.cpu_count == 8 && topo.node_count == 2, "numa: CPU and node count");
+
+	const unsigned order[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+	const unsigned nodes[] = { 0, 4, 8 };
+	ok(check_cpus(topo.cpus, topo.cpu_count, order, 8) &&
+	   memcmp(topo.nodes, nodes, sizeof(nodes)) == 0, "numa: CPUs by node");
+
+	/* Interleaved over the nodes, then over the node CPUs. */
+	unsigned cpus[8];
+	const unsigned numa[] = { 0, 2, 1, 3, 4, 6, 5, 7, 0 };
+	bool valid = true;
+	for (unsigned slot = 0; slot < sizeof(numa) / sizeof(*numa); slot++) {
+		size_t count = numa_thread_cpus(&topo, NUMA_PLACEMENT_NUMA, slot, false, cpus);
+		valid = valid && check_cpus(cpus, count, &numa[slot], 1);
+	}
+	ok(valid, "numa: NUMA placement of single CPU threads");
+
+	size_t count = numa_thread_cpus(&topo, NUMA_PLACEMENT_NUMA, 3, true, cpus);
+	const unsigned node1[] = { 2, 3, 6, 7 };
+	ok(check_cpus(cpus, count, node1, 4), "numa: NUMA placement of node threads");
+
+	valid = true;
+	for (unsigned slot = 0; slot < 10; slot++) {
+		unsigned cpu = slot % 8;
+		count = numa_thread_cpus(&topo, NUMA_PLACEMENT_LINEAR, slot, false, cpus);
+		valid = valid && check_cpus(cpus, count, &cpu, 1);
+	}
+	ok(valid, "numa: linear placement");
+
+	count = numa_thread_cpus(&topo, NUMA_PLACEMENT_LINEAR, 1, true, cpus);
+	ok(count == 0, "numa: linear placement of node threads");
+	count = numa_thread_cpus(&topo, NUMA_PLACEMENT_NONE, 1, false, cpus);
+	ok(count == 0, "numa: no placement");
+
+	numa_topology_free(&topo);
+
+	/* Missing topology, all online CPUs in one node. */
+	snprintf(sysfs, sizeof(sysfs), "%s/missing", tmpdir);
+	ret = numa_topology_load(&topo, sysfs);
+	ok(ret == KNOT_EOK && topo.node_count == 1 &&
+	   topo.cpu_count == MAX(dt_online_cpus(), 1), "numa: missing topology");
+
+	count = numa_thread_cpus(&topo, NUMA_PLACEMENT_NUMA, 1, false, cpus);
+	ok(count == (topo.cpu_count > 1 ? 1 : 0), "numa: single CPU not pinned");
+	numa_topology_free(&topo);
+
+	ret = numa_topology_load(NULL, NULL);
+	ok(ret == KNOT_EINVAL, "numa: load invalid");
+}
+
+static void test_touch_pool(void)
+{
+	knot_mm_t mm;
+	mm_ctx_mempool(&mm, 16 * MM_DEFAULT_BLKSIZE);
+	uint64_t total = mp_total_size(mm.ctx);
+
+	numa_touch_pool(&mm);
+	void *mem = mm_alloc(&mm, 15 * MM_DEFAULT_BLKSIZE / 2);
+	ok(mem != NULL && mp_total_size(mm.ctx) <= 2 * total,
+	   "numa: touched pool usable");
+
+	mp_delete(mm.ctx);
+}
+
+/*! \brief Benchmark thread context. */
+typedef struct {
+	const numa_topology_t *topo;
+	numa_placement_t placement;
+	bool local;              /*!< Memory allocated by the thread. */
+	uint8_t **buffers;
+	double *seconds;         /*!< Time of the memory passes per thread. */
+	volatile uint64_t sum;
+} bench_t;
+
+static double elapsed(const struct timespec *begin)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - begin->tv_sec) + (end.tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+static int bench_run(dthread_t *thread)
+{
+	bench_t *ctx = thread->data;
+	unsigned id = dt_get_id(thread);
+
+	numa_bind_thread(ctx->topo, ctx->placement, false, thread);
+
+	uint8_t *buf = ctx->buffers[id];
+	if (ctx->local) {
+		buf = malloc(BENCH_BUFSIZE);
+		if (buf == NULL) {
+			return KNOT_ENOMEM;
+		}
+		memset(buf, id, BENCH_BUFSIZE);
+	}
+
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	uint64_t sum = 0;
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		for (size_t i = 0; i < BENCH_BUFSIZE; i += sizeof(uint64_t)) {
+			uint64_t *val = (uint64_t *)(buf + i);
+			sum += *val;
+			*val = sum;
+		}
+	}
+	__sync_fetch_and_add(&ctx->sum, sum);
+	ctx->seconds[id] = elapsed(&begin);
+
+	if (ctx->local) {
+		free(buf);
+	}
+
+	return KNOT_EOK;
+}
+
+static void bench(const numa_topology_t *topo, numa_placement_t placement,
+                  bool local, const char *name)
+{
+	unsigned threads = MAX(topo->cpu_count, 2);
+	bench_t ctx = { .topo = topo, .placement = placement, .local = local };
+
+	/* Memory touched by the main thread as with the allocation on start. */
+	ctx.buffers = calloc(threads, sizeof(uint8_t *));
+	ctx.seconds = calloc(threads, sizeof(double));
+	if (ctx.buffers == NULL || ctx.seconds == NULL) {
+		bail("failed to allocate memory");
+	}
+	for (unsigned i = 0; !local && i < threads; i++) {
+		ctx.buffers[i] = malloc(BENCH_BUFSIZE);
+		if (ctx.buffers[i] == NULL) {
+			bail("failed to allocate memory");
+		}
+		memset(ctx.buffers[i], i, BENCH_BUFSIZE);
+	}
+
+	dt_unit_t *unit = dt_create(threads, bench_run, NULL, &ctx);
+	if (unit == NULL) {
+		bail("failed to create threads");
+	}
+
+	dt_start(unit);
+	dt_join(unit);
+	dt_delete(&unit);
+
+	/* Per-thread bandwidth, the allocation isn't measured. */
+	double sec = 0;
+	for (unsigned i = 0; i < threads; i++) {
+		sec += ctx.seconds[i];
+	}
+	double bytes = (double)threads * BENCH_ROUNDS * BENCH_BUFSIZE;
+	diag("numa: %u threads, %s, %.0f MB/s per thread", threads, name,
+	     bytes / sec / 1e6);
+
+	for (unsigned i = 0; !local && i < threads; i++) {
+		free(ctx.buffers[i]);
+	}
+	free(ctx.buffers);
+	free(ctx.seconds);
+}
+
+static void interrupt_handle(int s)
+{
+}
+
+static void bench_placements(void)
+{
+	/* The threads are woken up by a signal. */
+	struct sigaction sa = { .sa_handler = interrupt_handle };
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGALRM, &sa, NULL);
+
+	numa_topology_t topo;
+	if (numa_topology_load(&topo, NULL) != KNOT_EOK) {
+		bail("failed to load topology");
+	}
+	diag("numa: %u CPUs in %u nodes", topo.cpu_count, topo.node_count);
+
+	bench(&topo, NUMA_PLACEMENT_NONE, false, "unpinned, main thread memory");
+	bench(&topo, NUMA_PLACEMENT_LINEAR, false, "linear, main thread memory");
+	bench(&topo, NUMA_PLACEMENT_NUMA, false, "NUMA, main thread memory");
+	bench(&topo, NUMA_PLACEMENT_NUMA, true, "NUMA, local memory");
+
+	numa_topology_free(&topo);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	char *tmpdir = test_mkdtemp();
+	if (tmpdir == NULL) {
+		bail("failed to create temporary directory");
+	}
+	test_topology(tmpdir);
+	test_rm_rf(tmpdir);
+	free(tmpdir);
+
+	test_touch_pool();
+
+	bench_placements();
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/server/reclaim.h"
+#include "knot/zone/contents.h"
+#include "libknot/libknot.h"
+
+#define NODES	100
+#define CHUNK	16
+
+typedef struct {
+	int calls;
+	int chunks;
+} counter_t;
+
+static bool count_cb(void *data)
+{
+	counter_t *counter = data;
+	return ++counter->calls >= counter->chunks;
+}
+
+static zone_contents_t *create_contents(void)
+{
+	knot_dname_t *apex = knot_dname_from_str_alloc("test.");
+	zone_contents_t *contents = zone_contents_new(apex);
+	knot_dname_free(&apex, NULL);
+	if (contents == NULL) {
+		return NULL;
+	}
+
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	for (int i = 0; i < NODES; i++) {
+		char owner_str[32];
+		snprintf(owner_str, sizeof(owner_str), "n%i.test.", i);
+		knot_dname_t *owner = knot_dname_from_str_alloc(owner_str);
+		knot_rrset_t *rr = knot_rrset_new(owner, KNOT_RRTYPE_A,
+		                                  KNOT_CLASS_IN, NULL);
+		knot_dname_free(&owner, NULL);
+		knot_rrset_add_rdata(rr, addr, sizeof(addr), 3600, NULL);
+
+		zone_node_t *node = NULL;
+		int ret = zone_contents_add_rr(contents, rr, &node);
+		knot_rrset_free(&rr, NULL);
+		if (ret != KNOT_EOK) {
+			zone_contents_deep_free(&contents);
+			return NULL;
+		}
+	}
+
+	return contents;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	/* Immediate reclamation without the context. */
+	counter_t counter = { .chunks = 3 };
+	reclaim_defer(NULL, count_cb, &counter);
+	is_int(3, counter.calls, "reclaim: immediate without context");
+
+	/* Deferred reclamations. */
+	reclaim_t *rc = reclaim_create();
+	ok(rc != NULL, "reclaim: create");
+
+	counter_t single = { .chunks = 1 };
+	counter_t chunked = { .chunks = 5 };
+	reclaim_defer(rc, count_cb, &single);
+	reclaim_defer(rc, count_cb, &chunked);
+	reclaim_barrier(rc);
+	is_int(1, single.calls, "reclaim: deferred");
+	is_int(5, chunked.calls, "reclaim: deferred in chunks");
+
+	/* Pending reclamations are finished on destroy. */
+	counter_t pending = { .chunks = 2 };
+	reclaim_defer(rc, count_cb, &pending);
+	reclaim_destroy(rc);
+	is_int(2, pending.calls, "reclaim: finished on destroy");
+
+	/* Zone contents freed in chunks. */
+	zone_contents_t *contents = create_contents();
+	ok(contents != NULL, "reclaim: create contents");
+
+	hattrie_iter_t *it = NULL;
+	int ret = KNOT_EAGAIN;
+	int parts = 0;
+	while (ret == KNOT_EAGAIN && parts <= NODES) {
+		ret = zone_contents_deep_free_part(&contents, &it, CHUNK);
+		parts++;
+	}
+	is_int(KNOT_EOK, ret, "reclaim: contents freed");
+	ok(parts > (NODES / CHUNK), "reclaim: contents freed in chunks");
+	ok(contents == NULL && it == NULL, "reclaim: contents reset");
+
+	ret = zone_contents_deep_free_part(NULL, &it, CHUNK);
+	is_int(KNOT_EINVAL, ret, "reclaim: no contents");
+
+	return 0;
+}
@@ -0,0 +1,201 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <tap/basic.h>
+
+#include "contrib/wire_ctx.h"
+#include "dnssec/kasp.h"
+#include "knot/dnssec/context.h"
+#include "knot/dnssec/rrset-sign.h"
+#include "libknot/libknot.h"
+
+#define DAY	(24 * 3600)
+#define OWNERS	1000
+#define SLICES	16
+
+static const uint32_t NOW = 1479000000;
+
+/*! \brief Creates an A RR set and its RRSIG expiring at the given time. */
+static void create_rrsets(knot_rrset_t *covered, knot_rrset_t *rrsigs,
+                          const char *owner_str, uint32_t expire)
+{
+	knot_dname_t *owner = knot_dname_from_str_alloc(owner_str);
+	knot_rrset_init(covered, owner, KNOT_RRTYPE_A, KNOT_CLASS_IN);
+	knot_rrset_init(rrsigs, owner, KNOT_RRTYPE_RRSIG, KNOT_CLASS_IN);
+
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	knot_rrset_add_rdata(covered, addr, sizeof(addr), 3600, NULL);
+
+	uint8_t rdata[64] = { 0 };
+	wire_ctx_t wire = wire_ctx_init(rdata, sizeof(rdata));
+	wire_ctx_write_u16(&wire, KNOT_RRTYPE_A);	// type covered
+	wire_ctx_write_u8(&wire, 13);			// algorithm
+	wire_ctx_write_u8(&wire, knot_dname_labels(owner, NULL));
+	wire_ctx_write_u32(&wire, 3600);		// original TTL
+	wire_ctx_write_u32(&wire, expire);		// signature expiration
+	wire_ctx_write_u32(&wire, NOW);			// signature inception
+	wire_ctx_write_u16(&wire, 12345);		// key tag
+	wire_ctx_write_u8(&wire, 0);			// signer (root)
+	wire_ctx_write_u32(&wire, 0);			// signature
+	knot_rrset_add_rdata(rrsigs, rdata, wire_ctx_offset(&wire), 3600, NULL);
+}
+
+static void free_rrsets(knot_rrset_t *covered, knot_rrset_t *rrsigs)
+{
+	knot_rdataset_clear(&covered->rrs, NULL);
+	knot_rdataset_clear(&rrsigs->rrs, NULL);
+	knot_dname_free(&covered->owner, NULL);
+}
+
+static uint32_t refresh_at(const kdnssec_ctx_t *ctx, const char *owner,
+                           uint32_t expire)
+{
+	knot_rrset_t covered, rrsigs;
+	create_rrsets(&covered, &rrsigs, owner, expire);
+	uint32_t result = knot_rrsig_refresh_at(&covered, &rrsigs, 0, ctx);
+	free_rrsets(&covered, &rrsigs);
+
+	return result;
+}
+
+static void test_jitter(void)
+{
+	dnssec_kasp_policy_t policy = { 0 };
+
+	ok(knot_rrsig_jitter(NULL) == 0, "jitter: no policy");
+
+	policy.rrsig_lifetime = 30 * DAY;
+	policy.rrsig_refresh_before = 7 * DAY;
+	ok(knot_rrsig_jitter(&policy) == 7 * DAY / 2,
+	   "jitter: half of the refresh interval");
+
+	policy.rrsig_lifetime = 10 * DAY;
+	ok(knot_rrsig_jitter(&policy) == 3 * DAY / 2,
+	   "jitter: half of the rest of the lifetime");
+
+	policy.rrsig_lifetime = 7 * DAY;
+	ok(knot_rrsig_jitter(&policy) == 0, "jitter: lifetime equal to refresh");
+
+	policy.rrsig_lifetime = 1 * DAY;
+	ok(knot_rrsig_jitter(&policy) == 0, "jitter: lifetime below refresh");
+}
+
+static void test_refresh_at(kdnssec_ctx_t *ctx)
+{
+	const dnssec_kasp_policy_t *policy = ctx->policy;
+	uint32_t jitter = knot_rrsig_jitter(policy);
+	uint32_t expire = NOW + policy->rrsig_lifetime;
+	uint32_t earliest = expire - policy->rrsig_refresh_before;
+
+	/* Stable delay within the jitter, spread over the whole interval. */
+	bool in_range = true, stable = true;
+	bool slices[SLICES] = { false };
+	for (int i = 0; i < OWNERS; i++) {
+		char owner[32];
+		snprintf(owner, sizeof(owner), "n%i.test.", i);
+
+		uint32_t at = refresh_at(ctx, owner, expire);
+		if (at < earliest || at >= earliest + jitter) {
+			in_range = false;
+			continue;
+		}
+		if (refresh_at(ctx, owner, expire) != at) {
+			stable = false;
+		}
+		slices[(uint64_t)(at - earliest) * SLICES / jitter] = true;
+	}
+	ok(in_range, "refresh: delayed within the jitter");
+	ok(stable, "refresh: stable for the RR set");
+
+	int hit = 0;
+	for (int i = 0; i < SLICES; i++) {
+		hit += slices[i];
+	}
+	ok(hit == SLICES, "refresh: spread over the jitter");
+
+	/* Enough validity left at the refresh. */
+	bool valid_left = true;
+	for (int i = 0; i < OWNERS; i++) {
+		char owner[32];
+		snprintf(owner, sizeof(owner), "n%i.test.", i);
+		if (expire - refresh_at(ctx, owner, expire) <
+		    policy->rrsig_refresh_before / 2) {
+			valid_left = false;
+		}
+	}
+	ok(valid_left, "refresh: half of the refresh interval left");
+
+	/* Past expiration. */
+	ok(refresh_at(ctx, "test.", 1) == 0, "refresh: clamped to zero");
+
+	/* No jitter. */
+	dnssec_kasp_policy_t fixed = *policy;
+	fixed.rrsig_lifetime = fixed.rrsig_refresh_before;
+	ctx->policy = &fixed;
+	ok(refresh_at(ctx, "test.", expire) == expire - fixed.rrsig_refresh_before,
+	   "refresh: no delay without jitter");
+	ctx->policy = (dnssec_kasp_policy_t *)policy;
+}
+
+static void test_min_refresh_at(kdnssec_ctx_t *ctx)
+{
+	const dnssec_kasp_policy_t *policy = ctx->policy;
+	uint32_t jitter = knot_rrsig_jitter(policy);
+	uint32_t min = knot_rrsig_min_refresh_at(ctx);
+
+	ok(min == NOW + policy->rrsig_lifetime - policy->rrsig_refresh_before - jitter,
+	   "min refresh: lifetime without refresh and jitter");
+
+	/* Signatures created now with the largest random shortening. */
+	uint32_t expire = NOW + policy->rrsig_lifetime - (jitter - 1);
+	bool later = true;
+	for (int i = 0; i < OWNERS; i++) {
+		char owner[32];
+		snprintf(owner, sizeof(owner), "n%i.test.", i);
+		if (refresh_at(ctx, owner, expire) < min) {
+			later = false;
+		}
+	}
+	ok(later, "min refresh: not later than any new signature");
+
+	dnssec_kasp_policy_t short_lived = *policy;
+	short_lived.rrsig_lifetime = 1;
+	ctx->policy = &short_lived;
+	ok(knot_rrsig_min_refresh_at(ctx) == NOW, "min refresh: not in the past");
+	ctx->policy = (dnssec_kasp_policy_t *)policy;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	dnssec_kasp_policy_t policy = {
+		.rrsig_lifetime = 14 * DAY,
+		.rrsig_refresh_before = 7 * DAY
+	};
+	kdnssec_ctx_t ctx = {
+		.now = NOW,
+		.policy = &policy
+	};
+
+	test_jitter();
+	test_refresh_at(&ctx);
+	test_min_refresh_at(&ctx);
+
+	return 0;
+}
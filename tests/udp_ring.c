@@ -0,0 +1,419 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/udp.h>
+#include <sys/syscall.h>
+#include <tap/basic.h>
+
+#include "knot/server/udp-ring.h"
+#include "contrib/net.h"
+#include "contrib/sockaddr.h"
+#include "libknot/errcode.h"
+#include "libknot/packet/wire.h"
+
+#ifdef ENABLE_RECVMMSG
+
+#define QUERY_SIZE	40
+#define ANSWER_SIZE	100
+#define BENCH_QUERIES	200000
+#define BENCH_BURST	32
+#define BENCH_CLIENTS	16
+
+/*! \brief Buffers of the previous implementation, full-size RX and TX slots. */
+#define LEGACY_BATCHLEN	10
+#define LEGACY_MEMSIZE	(2 * LEGACY_BATCHLEN * KNOT_WIRE_MAX_PKTSIZE)
+
+/*! \brief Error of the segmented messages sent by the ring (or 0). */
+static int gso_error;
+
+/*! \brief Fails at the first segmented message with the injected error. */
+int sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+	unsigned count = 0;
+	while (count < vlen && (gso_error == 0 || msgs[count].msg_hdr.msg_iovlen == 1)) {
+		count += 1;
+	}
+	if (count == 0 && vlen > 0) {
+		errno = gso_error;
+		return -1;
+	}
+
+	return syscall(SYS_sendmmsg, fd, msgs, count, flags);
+}
+
+static int server_socket(struct sockaddr_storage *addr)
+{
+	sockaddr_set(addr, AF_INET, "127.0.0.1", 0);
+	int sock = net_bound_socket(SOCK_DGRAM, (struct sockaddr *)addr, 0);
+	if (sock < 0) {
+		bail("failed to create server socket");
+	}
+
+	socklen_t len = sizeof(*addr);
+	getsockname(sock, (struct sockaddr *)addr, &len);
+	return sock;
+}
+
+static int client_socket(const struct sockaddr_storage *server)
+{
+	int sock = net_connected_socket(SOCK_DGRAM, (struct sockaddr *)server, NULL);
+	if (sock < 0) {
+		bail("failed to create client socket");
+	}
+
+	return sock;
+}
+
+static bool wait_readable(int sock)
+{
+	struct pollfd pfd = { .fd = sock, .events = POLLIN };
+	return poll(&pfd, 1, 1000) == 1;
+}
+
+static void send_queries(int sock, unsigned count, size_t size)
+{
+	uint8_t query[KNOT_WIRE_MAX_PKTSIZE];
+	for (unsigned i = 0; i < count; i++) {
+		memset(query, i, size);
+		if (send(sock, query, size, 0) != size) {
+			bail("failed to send query");
+		}
+	}
+}
+
+/*! \brief Answers each query with its first byte repeated. */
+static unsigned answer_all(udp_ring_t *ring, size_t (*answer_size)(unsigned))
+{
+	struct iovec query, answer;
+	struct sockaddr_storage *addr;
+	unsigned count = 0;
+	while (udp_ring_next(ring, &query, &addr, &answer)) {
+		size_t size = answer_size(count++);
+		memset(answer.iov_base, ((uint8_t *)query.iov_base)[0], size);
+		udp_ring_answer(ring, size);
+	}
+
+	return count;
+}
+
+static size_t answer_fixed(unsigned i)
+{
+	return ANSWER_SIZE;
+}
+
+static size_t answer_last_short(unsigned i)
+{
+	return (i < UDP_RING_MINLEN - 1) ? ANSWER_SIZE : ANSWER_SIZE / 2;
+}
+
+/*! \brief Receives the answers, checks their size and content. */
+static unsigned recv_answers(int sock, unsigned count, size_t (*answer_size)(unsigned))
+{
+	uint8_t answer[KNOT_WIRE_MAX_PKTSIZE];
+	unsigned valid = 0;
+	for (unsigned i = 0; i < count && wait_readable(sock); i++) {
+		ssize_t len = recv(sock, answer, sizeof(answer), 0);
+		valid += (len == answer_size(i) && answer[0] == i && answer[len - 1] == i);
+	}
+
+	return valid;
+}
+
+static void test_ring(void)
+{
+	udp_ring_t ring;
+	int ret = udp_ring_init(&ring, 4096);
+	ok(ret == KNOT_EOK, "udp_ring: init");
+	ok(udp_ring_memsize(&ring) < LEGACY_MEMSIZE / 2, "udp_ring: compact buffers");
+	udp_ring_deinit(&ring);
+
+	ok(udp_ring_init(NULL, 4096) == KNOT_EINVAL, "udp_ring: init invalid");
+
+	ret = udp_ring_init(&ring, 0);
+	ok(ret == KNOT_EOK && ring.slot_size == KNOT_WIRE_MIN_PKTSIZE,
+	   "udp_ring: minimal slot size");
+
+	struct sockaddr_storage addr;
+	int server = server_socket(&addr);
+	int client = client_socket(&addr);
+
+	/* Received and answered queries. */
+	send_queries(client, 3, QUERY_SIZE);
+	wait_readable(server);
+	ret = udp_ring_recv(&ring, server, 0);
+	ok(ret == 3, "udp_ring: receive batch");
+	ok(answer_all(&ring, answer_fixed) == 3, "udp_ring: queries");
+	ok(udp_ring_flush(&ring) == 3, "udp_ring: flush");
+	ok(recv_answers(client, 3, answer_fixed) == 3, "udp_ring: answers");
+
+	/* Over the slot size. */
+	send_queries(client, 1, KNOT_WIRE_MIN_PKTSIZE + 1);
+	wait_readable(server);
+	ret = udp_ring_recv(&ring, server, 0);
+	ok(ret == 1 && answer_all(&ring, answer_fixed) == 0,
+	   "udp_ring: oversized query ignored");
+
+	/* Batch length follows the load. */
+	send_queries(client, UDP_RING_MINLEN, QUERY_SIZE);
+	wait_readable(server);
+	udp_ring_recv(&ring, server, 0);
+	ok(ring.batch == 2 * UDP_RING_MINLEN, "udp_ring: batch grows");
+	answer_all(&ring, answer_fixed);
+	udp_ring_flush(&ring);
+	recv_answers(client, UDP_RING_MINLEN, answer_fixed);
+	udp_ring_recv(&ring, server, 0);
+	ok(ring.batch == UDP_RING_MINLEN, "udp_ring: batch shrinks");
+
+	/* Answers to the same client sent as one message. */
+	unsigned offload = udp_offload_setup(server, UDP_OFFLOAD_GSO);
+	send_queries(client, UDP_RING_MINLEN, QUERY_SIZE);
+	wait_readable(server);
+	usleep(10000);
+	udp_ring_recv(&ring, server, offload);
+	answer_all(&ring, answer_last_short);
+	ret = udp_ring_flush(&ring);
+	if (offload & UDP_OFFLOAD_GSO) {
+		ok(ret == 1, "udp_ring: segmented answers");
+	} else {
+		skip("udp_ring: UDP_SEGMENT not supported");
+	}
+	ok(recv_answers(client, UDP_RING_MINLEN, answer_last_short) == UDP_RING_MINLEN,
+	   "udp_ring: answer segments");
+
+	/* Full-size slots with UDP_GRO, a train is split into the queries. */
+	offload = udp_offload_setup(server, UDP_OFFLOAD_ALL);
+	send_queries(client, 5, QUERY_SIZE);
+	wait_readable(server);
+	usleep(10000);
+	udp_ring_recv(&ring, server, offload);
+	ok(answer_all(&ring, answer_fixed) == 5, "udp_ring: queries with offload");
+	udp_ring_flush(&ring);
+	ok(recv_answers(client, 5, answer_fixed) == 5, "udp_ring: answers with offload");
+
+	close(client);
+	close(server);
+	udp_ring_deinit(&ring);
+}
+
+/*! \brief Answers a train of queries with UDP_SEGMENT, returns the sent messages. */
+static int send_train(udp_ring_t *ring, int server, int client)
+{
+	send_queries(client, UDP_RING_MINLEN, QUERY_SIZE);
+	wait_readable(server);
+	usleep(10000);
+	udp_ring_recv(ring, server, UDP_OFFLOAD_GSO);
+	answer_all(ring, answer_last_short);
+	return udp_ring_flush(ring);
+}
+
+static void test_gso_fallback(void)
+{
+#ifdef UDP_SEGMENT
+	udp_ring_t ring;
+	udp_ring_init(&ring, 4096);
+
+	struct sockaddr_storage addr;
+	int server = server_socket(&addr);
+	int client = client_socket(&addr);
+
+	/* Segment size over the path MTU, only the train is resent. */
+	gso_error = EINVAL;
+	int ret = send_train(&ring, server, client);
+	ok(ret == 1 && !ring.gso_failed, "udp_ring: train resent on EINVAL");
+	ok(recv_answers(client, UDP_RING_MINLEN, answer_last_short) == UDP_RING_MINLEN,
+	   "udp_ring: answers resent on EINVAL");
+
+	/* No support on the device, the segmentation is disabled. */
+	gso_error = EIO;
+	ret = send_train(&ring, server, client);
+	ok(ret == 1 && ring.gso_failed, "udp_ring: segmentation disabled on EIO");
+	ok(recv_answers(client, UDP_RING_MINLEN, answer_last_short) == UDP_RING_MINLEN,
+	   "udp_ring: answers resent on EIO");
+
+	ret = send_train(&ring, server, client);
+	ok(ret == UDP_RING_MINLEN, "udp_ring: answers without segmentation");
+	ok(recv_answers(client, UDP_RING_MINLEN, answer_last_short) == UDP_RING_MINLEN,
+	   "udp_ring: answers after disabled segmentation");
+
+	gso_error = 0;
+	close(client);
+	close(server);
+	udp_ring_deinit(&ring);
+#else
+	skip_block(6, "udp_ring: UDP_SEGMENT not available");
+#endif
+}
+
+/*! \brief Batch buffers of the previous implementation. */
+typedef struct {
+	struct sockaddr_storage addrs[LEGACY_BATCHLEN];
+	uint8_t *buf;
+	struct iovec iov[2][LEGACY_BATCHLEN];
+	struct mmsghdr msgs[2][LEGACY_BATCHLEN];
+} legacy_t;
+
+static void legacy_init(legacy_t *ctx)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->buf = malloc(LEGACY_MEMSIZE);
+	if (ctx->buf == NULL) {
+		bail("failed to allocate memory");
+	}
+
+	for (unsigned i = 0; i < 2; i++) {
+		for (unsigned k = 0; k < LEGACY_BATCHLEN; k++) {
+			ctx->iov[i][k].iov_base = ctx->buf + (i * LEGACY_BATCHLEN + k) * KNOT_WIRE_MAX_PKTSIZE;
+			ctx->msgs[i][k].msg_hdr.msg_iov = &ctx->iov[i][k];
+			ctx->msgs[i][k].msg_hdr.msg_iovlen = 1;
+			ctx->msgs[i][k].msg_hdr.msg_name = &ctx->addrs[k];
+		}
+	}
+}
+
+static void legacy_serve(legacy_t *ctx, int sock)
+{
+	for (;;) {
+		for (unsigned k = 0; k < LEGACY_BATCHLEN; k++) {
+			ctx->iov[0][k].iov_len = KNOT_WIRE_MAX_PKTSIZE;
+			ctx->msgs[0][k].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+		}
+		int n = recvmmsg(sock, ctx->msgs[0], LEGACY_BATCHLEN, MSG_DONTWAIT, NULL);
+		if (n <= 0) {
+			return;
+		}
+		for (unsigned k = 0; k < n; k++) {
+			uint8_t *query = ctx->iov[0][k].iov_base;
+			memset(ctx->iov[1][k].iov_base, query[0], ANSWER_SIZE);
+			ctx->iov[1][k].iov_len = ANSWER_SIZE;
+			ctx->msgs[1][k].msg_hdr.msg_namelen = ctx->msgs[0][k].msg_hdr.msg_namelen;
+		}
+		sendmmsg(sock, ctx->msgs[1], n, 0);
+	}
+}
+
+static void ring_serve(udp_ring_t *ring, int sock, unsigned offload)
+{
+	while (udp_ring_recv(ring, sock, offload) > 0) {
+		answer_all(ring, answer_fixed);
+		udp_ring_flush(ring);
+	}
+}
+
+static double elapsed(const struct timespec *begin)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - begin->tv_sec) + (end.tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+/*! \brief Bursts of queries from the clients in turn, answered in batches. */
+static void bench(const char *name, unsigned clients, legacy_t *legacy,
+                  udp_ring_t *ring, unsigned offload)
+{
+	struct sockaddr_storage addr;
+	int server = server_socket(&addr);
+	offload = udp_offload_setup(server, offload);
+	int client[BENCH_CLIENTS];
+	for (unsigned i = 0; i < clients; i++) {
+		client[i] = client_socket(&addr);
+	}
+
+	uint8_t query[QUERY_SIZE] = { 0 };
+	uint8_t answer[KNOT_WIRE_MAX_PKTSIZE];
+	unsigned answered = 0;
+
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	for (unsigned sent = 0; sent < BENCH_QUERIES; sent += BENCH_BURST) {
+		for (unsigned i = 0; i < BENCH_BURST; i++) {
+			send(client[i % clients], query, sizeof(query), 0);
+		}
+		if (legacy != NULL) {
+			legacy_serve(legacy, server);
+		} else {
+			ring_serve(ring, server, offload);
+		}
+		for (unsigned i = 0; i < clients; i++) {
+			while (recv(client[i], answer, sizeof(answer), MSG_DONTWAIT) > 0) {
+				answered += 1;
+			}
+		}
+	}
+
+	double sec = elapsed(&begin);
+	diag("udp_ring: %s, %u clients, %.0f kqps, %.1f%% answered", name, clients,
+	     BENCH_QUERIES / sec / 1e3, 100.0 * answered / BENCH_QUERIES);
+
+	for (unsigned i = 0; i < clients; i++) {
+		close(client[i]);
+	}
+	close(server);
+}
+
+static void bench_paths(void)
+{
+	legacy_t legacy;
+	legacy_init(&legacy);
+
+	udp_ring_t ring;
+	if (udp_ring_init(&ring, 4096) != KNOT_EOK) {
+		bail("failed to initialize ring");
+	}
+
+	diag("udp_ring: buffers %u kB per thread, previously %u kB",
+	     (unsigned)(udp_ring_memsize(&ring) / 1024), LEGACY_MEMSIZE / 1024);
+
+	bench("previous path", 1, &legacy, NULL, 0);
+	bench("compact ring", 1, NULL, &ring, 0);
+	bench("compact ring with offload", 1, NULL, &ring, UDP_OFFLOAD_ALL);
+	bench("previous path", BENCH_CLIENTS, &legacy, NULL, 0);
+	bench("compact ring", BENCH_CLIENTS, NULL, &ring, 0);
+	bench("compact ring with offload", BENCH_CLIENTS, NULL, &ring, UDP_OFFLOAD_ALL);
+
+	diag("udp_ring: buffers %u kB per thread with UDP_GRO",
+	     (unsigned)(udp_ring_memsize(&ring) / 1024));
+
+	udp_ring_deinit(&ring);
+	free(legacy.buf);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	test_ring();
+	test_gso_fallback();
+	bench_paths();
+
+	return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+	skip_all("recvmmsg() not available");
+	return 0;
+}
+
+#endif /* ENABLE_RECVMMSG */
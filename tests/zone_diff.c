@@ -0,0 +1,181 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/zone/zone-diff.h"
+#include "libknot/libknot.h"
+
+/* Every node with these indices differs in the second zone. */
+#define STEP		1000
+#define REMOVED		0
+#define RENAMED		1
+#define CHANGED		2
+#define TTL_CHANGED	3
+
+static int add_rr(zone_contents_t *zone, const char *owner_str, uint16_t type,
+                  const uint8_t *rdata, uint16_t rdata_len, uint32_t ttl)
+{
+	knot_dname_t *owner = knot_dname_from_str_alloc(owner_str);
+	knot_rrset_t *rr = knot_rrset_new(owner, type, KNOT_CLASS_IN, NULL);
+	knot_dname_free(&owner, NULL);
+	if (rr == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = knot_rrset_add_rdata(rr, rdata, rdata_len, ttl, NULL);
+	if (ret == KNOT_EOK) {
+		zone_node_t *node = NULL;
+		ret = zone_contents_add_rr(zone, rr, &node);
+	}
+	knot_rrset_free(&rr, NULL);
+
+	return ret;
+}
+
+static zone_contents_t *create_zone(size_t count, bool second)
+{
+	knot_dname_t *apex = knot_dname_from_str_alloc("test.");
+	zone_contents_t *zone = zone_contents_new(apex);
+	knot_dname_free(&apex, NULL);
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	uint8_t soa[] = "\x02ns\x04test\x00\x01m\x04test\x00"
+	                "\x00\x00\x00\x01\x00\x00\x0e\x10\x00\x00\x0e\x10"
+	                "\x00\x00\x0e\x10\x00\x00\x0e\x10";
+	soa[20] = second ? 2 : 1;
+	int ret = add_rr(zone, "test.", KNOT_RRTYPE_SOA, soa, sizeof(soa) - 1, 3600);
+
+	for (size_t i = 0; ret == KNOT_EOK && i < count; i++) {
+		char owner[64];
+		snprintf(owner, sizeof(owner), "n%zu.test.", i);
+		uint8_t addr[4] = { 192, 0, i / 256 % 256, i % 256 };
+		uint32_t ttl = 300;
+
+		if (second) {
+			switch (i % STEP) {
+			case REMOVED:
+				continue;
+			case RENAMED:
+				snprintf(owner, sizeof(owner), "m%zu.test.", i);
+				break;
+			case CHANGED:
+				addr[0] = 10;
+				break;
+			case TTL_CHANGED:
+				ttl = 600;
+				break;
+			}
+		}
+
+		ret = add_rr(zone, owner, KNOT_RRTYPE_A, addr, sizeof(addr), ttl);
+	}
+
+	if (ret != KNOT_EOK) {
+		zone_contents_deep_free(&zone);
+	}
+
+	return zone;
+}
+
+static size_t rrset_count(const changeset_t *ch, bool add)
+{
+	changeset_iter_t it;
+	if (add) {
+		changeset_iter_add(&it, ch);
+	} else {
+		changeset_iter_rem(&it, ch);
+	}
+
+	size_t count = 0;
+	knot_rrset_t rr = changeset_iter_next(&it);
+	while (!knot_rrset_empty(&rr)) {
+		count++;
+		rr = changeset_iter_next(&it);
+	}
+	changeset_iter_clear(&it);
+
+	return count;
+}
+
+static void test_diff(size_t count)
+{
+	zone_contents_t *zone1 = create_zone(count, false);
+	zone_contents_t *zone2 = create_zone(count, true);
+	ok(zone1 != NULL && zone2 != NULL, "zone diff: create zones (%zu nodes)", count);
+	if (zone1 == NULL || zone2 == NULL) {
+		zone_contents_deep_free(&zone1);
+		zone_contents_deep_free(&zone2);
+		return;
+	}
+
+	changeset_t ch;
+	changeset_init(&ch, zone1->apex->owner);
+	int ret = zone_contents_diff(zone1, zone2, &ch);
+	is_int(KNOT_EOK, ret, "zone diff: diff");
+
+	size_t changes = count / STEP;
+	is_int(4 * changes, rrset_count(&ch, false), "zone diff: removals");
+	is_int(3 * changes, rrset_count(&ch, true), "zone diff: additions");
+	ok(ch.soa_from != NULL && ch.soa_to != NULL &&
+	   knot_soa_serial(&ch.soa_to->rrs) == 2, "zone diff: SOA change");
+
+	/* Differences of single nodes. */
+	zone_node_t *node = NULL;
+	knot_dname_t *owner = knot_dname_from_str_alloc("m1.test.");
+	node = (zone_node_t *)zone_contents_find_node(ch.add, owner);
+	ok(node != NULL && node_rrtype_exists(node, KNOT_RRTYPE_A),
+	   "zone diff: added node");
+	knot_dname_free(&owner, NULL);
+
+	owner = knot_dname_from_str_alloc("n0.test.");
+	node = (zone_node_t *)zone_contents_find_node(ch.remove, owner);
+	ok(node != NULL && node_rrtype_exists(node, KNOT_RRTYPE_A),
+	   "zone diff: removed node");
+	knot_dname_free(&owner, NULL);
+
+	owner = knot_dname_from_str_alloc("n5.test.");
+	node = (zone_node_t *)zone_contents_find_node(ch.remove, owner);
+	ok(node == NULL, "zone diff: unchanged node");
+	knot_dname_free(&owner, NULL);
+
+	changeset_clear(&ch);
+
+	/* Same zones. */
+	changeset_init(&ch, zone1->apex->owner);
+	ret = zone_contents_diff(zone1, zone1, &ch);
+	is_int(KNOT_ENODIFF, ret, "zone diff: same serial");
+	changeset_clear(&ch);
+
+	zone_contents_deep_free(&zone1);
+	zone_contents_deep_free(&zone2);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	/* Sequential merge-join. */
+	test_diff(5 * STEP);
+
+	/* Parallel merge-join (if more CPUs). */
+	test_diff(300 * STEP);
+
+	return 0;
+}
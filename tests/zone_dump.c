@@ -0,0 +1,174 @@
+/*  Copyright (C) 2016 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "knot/zone/zone-dump.h"
+#include "knot/zone/zonefile.h"
+#include "libknot/libknot.h"
+
+static const char *zone_str =
+"test. 600 SOA ns.test. m.test. 2 900 300 4800 900\n"
+"test. 600 NS ns.test.\n"
+"a.test. 600 A 192.0.2.1\n"
+"b.test. 600 A 192.0.2.22\n"
+"b.test. 600 RRSIG A 5 2 600 20300101000000 20160101000000 1 test. CCCC\n"
+"c.test. 600 NSEC d.test. A\n"
+"da.test. 600 TXT \"added\"\n"
+"e.test. 600 A 192.0.2.5\n"
+"e.test. 600 RRSIG A 5 2 600 20300101000000 20160101000000 1 test. BBBB\n"
+"ns.test. 600 A 192.0.2.53\n";
+
+static zone_contents_t *load(const char *path, const char *str)
+{
+	FILE *f = fopen(path, "w");
+	if (f == NULL) {
+		return NULL;
+	}
+	fputs(str, f);
+	fclose(f);
+
+	knot_dname_t *origin = knot_dname_from_str_alloc("test.");
+	zloader_t loader;
+	int ret = zonefile_open(&loader, path, origin, false);
+	knot_dname_free(&origin, NULL);
+	if (ret != KNOT_EOK) {
+		return NULL;
+	}
+
+	err_handler_logger_t handler = { ._cb = { .cb = err_handler_logger } };
+	loader.err_handler = (err_handler_t *)&handler;
+	zone_contents_t *contents = zonefile_load(&loader);
+	zonefile_close(&loader);
+
+	return contents;
+}
+
+static char *read_all(FILE *f)
+{
+	long len = ftell(f);
+	char *buf = calloc(1, len + 1);
+	rewind(f);
+	if (buf != NULL && fread(buf, 1, len, f) != (size_t)len) {
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+static char *dump(zone_contents_t *contents, bool comments)
+{
+	FILE *file = tmpfile();
+	if (file == NULL) {
+		return NULL;
+	}
+
+	char *text = NULL;
+	if (zone_dump_text(contents, file, comments) == KNOT_EOK) {
+		text = read_all(file);
+	}
+	fclose(file);
+
+	return text;
+}
+
+/*! \brief Zone larger than the dump buffer. */
+static char *large_zone_str(int nodes)
+{
+	const char *soa = "test. 600 SOA ns.test. m.test. 1 900 300 4800 900\n";
+	size_t len = strlen(soa) + nodes * 64 + 1;
+	char *str = malloc(len);
+	if (str == NULL) {
+		return NULL;
+	}
+
+	size_t pos = snprintf(str, len, "%s", soa);
+	for (int i = 0; i < nodes; i++) {
+		pos += snprintf(str + pos, len - pos,
+		                "n%i.test. 600 TXT \"%040i\"\n", i, i);
+	}
+
+	return str;
+}
+
+static void test_roundtrip(const char *path, const char *str, const char *msg)
+{
+	zone_contents_t *c1 = load(path, str);
+	char *text1 = (c1 != NULL) ? dump(c1, false) : NULL;
+	zone_contents_t *c2 = (text1 != NULL) ? load(path, text1) : NULL;
+	char *text2 = (c2 != NULL) ? dump(c2, false) : NULL;
+
+	ok(text1 != NULL && text2 != NULL && strcmp(text1, text2) == 0,
+	   "zone dump: %s, dump of the loaded dump is equal", msg);
+	ok(c1 != NULL && c2 != NULL &&
+	   zone_contents_serial(c1) == zone_contents_serial(c2),
+	   "zone dump: %s, serial kept", msg);
+
+	free(text1);
+	free(text2);
+	zone_contents_deep_free(&c1);
+	zone_contents_deep_free(&c2);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	char *tmpdir = test_mkdtemp();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tmpdir, "zone_dump.zone");
+
+	zone_contents_t *contents = load(path, zone_str);
+	ok(contents != NULL, "zone dump: load zone");
+	if (contents == NULL) {
+		goto skip_all;
+	}
+
+	/* Sections and comments. */
+	char *text = dump(contents, true);
+	ok(text != NULL && strncmp(text, ";; Zone dump", 12) == 0,
+	   "zone dump: header comment");
+	const char *first = (text != NULL) ? strchr(text, '\n') + 1 : NULL;
+	ok(first != NULL && strncmp(first, "test.", 5) == 0 &&
+	   strstr(first, "SOA") < strchr(first, '\n'), "zone dump: SOA first");
+	ok(text != NULL && strstr(text, ";; DNSSEC signatures") <
+	   strstr(text, "\tRRSIG\t") && strstr(text, ";; DNSSEC NSEC chain") <
+	   strstr(text, "\tNSEC\t"), "zone dump: DNSSEC sections");
+	ok(text != NULL && strstr(text, ";; Written 10 records") != NULL,
+	   "zone dump: records count");
+	free(text);
+
+	/* Loaded dumps. */
+	test_roundtrip(path, zone_str, "small zone");
+
+	char *large = large_zone_str(50000);
+	test_roundtrip(path, large, "zone larger than the buffer");
+	free(large);
+
+skip_all:
+	zone_contents_deep_free(&contents);
+	remove(path);
+	test_rm_rf(tmpdir);
+	free(tmpdir);
+
+	return 0;
+}
@@ -21,7 +21,9 @@
 #include <tap/basic.h>
 #include <tap/files.h>
 
+#include "contrib/mempattern.h"
 #include "contrib/string.h"
+#include "contrib/ucw/mempool.h"
 #include "libknot/libknot.h"
 #include "knot/events/events.h"
 #include "knot/zone/timers.h"
@@ -107,6 +109,50 @@ int main(int argc, char *argv[])
 	ok(ret == KNOT_EOK &&
 	   memcmp(timers, empty_timers, sizeof(timers)) == 0, "zone timers: read unset");
 
+	// Incremental writer, timers are stored only after the flush.
+	timers_writer_t *writer = timers_writer_create(db, false);
+	ok(writer != NULL, "zone timers: create writer");
+	zone_2->events.timers = writer;
+	zone_events_schedule_at(zone_2, ZONE_EVENT_REFRESH, REFRESH_TIME);
+	ret = read_zone_timers(db, zone_2, timers);
+	ok(ret == KNOT_EOK &&
+	   memcmp(timers, empty_timers, sizeof(timers)) == 0, "zone timers: staged");
+	ret = timers_writer_flush(writer);
+	if (ret == KNOT_EOK) {
+		ret = read_zone_timers(db, zone_2, timers);
+	}
+	ok(ret == KNOT_EOK && timers[ZONE_EVENT_REFRESH] == REFRESH_TIME &&
+	   timers[ZONE_EVENT_EXPIRE] == 0, "zone timers: writer flush");
+
+	// Expiration state stored with the timers.
+	zone_2->flags |= ZONE_EXPIRED;
+	zone_events_store_timers(zone_2);
+	ret = timers_writer_flush(writer);
+	if (ret == KNOT_EOK) {
+		ret = read_zone_timers(db, zone_2, timers);
+	}
+	ok(ret == KNOT_EOK && timers[ZONE_EVENT_EXPIRE] == 1, "zone timers: expired");
+	zone_2->flags &= ~ZONE_EXPIRED;
+
+	// Non-persistent events are not staged.
+	zone_events_schedule_at(zone_2, ZONE_EVENT_NOTIFY, REFRESH_TIME);
+	ok(timers_writer_flush(writer) == KNOT_EOK, "zone timers: empty flush");
+	zone_2->events.timers = NULL;
+
+	// Read all timers with one scan.
+	knot_mm_t mm;
+	mm_ctx_mempool(&mm, MM_DEFAULT_BLKSIZE);
+	hattrie_t *all = NULL;
+	ret = read_timer_db(db, &mm, &all);
+	const time_t *found_1 = timer_db_find(all, zone_1->name);
+	const time_t *found_2 = timer_db_find(all, zone_2->name);
+	ok(ret == KNOT_EOK && hattrie_weight(all) == 2 &&
+	   found_1 != NULL && found_1[ZONE_EVENT_FLUSH] == FLUSH_TIME &&
+	   found_2 != NULL && found_2[ZONE_EVENT_REFRESH] == REFRESH_TIME,
+	   "zone timers: read all");
+	hattrie_free(all);
+	mp_delete(mm.ctx);
+
 	// Remove first zone from db and sweep.
 	ret = knot_zonedb_del(zone_db, zone_1->name);
 	assert(ret == KNOT_EOK);
@@ -118,6 +164,19 @@ int main(int argc, char *argv[])
 	ok(s_ret == KNOT_EOK && ret == KNOT_EOK &&
 	   memcmp(timers, empty_timers, sizeof(timers)) == 0, "zone timers: sweep");
 
+	// Timers staged by the removed zone are dropped.
+	zone_1->events.timers = writer;
+	zone_events_store_timers(zone_1);
+	zone_1->events.timers = NULL;
+	timers_writer_sweep(writer, zone_db);
+	ret = timers_writer_flush(writer);
+	if (ret == KNOT_EOK) {
+		ret = read_zone_timers(db, zone_1, timers);
+	}
+	ok(ret == KNOT_EOK &&
+	   memcmp(timers, empty_timers, sizeof(timers)) == 0, "zone timers: writer sweep");
+	timers_writer_free(writer);
+
 	// Clean up.
 	zone_free(&zone_1);
 	zone_free(&zone_2);